@@ -58,8 +58,32 @@ public:
 	virtual void	setAabb(btBroadphaseProxy* proxy,const btVector3& aabbMin,const btVector3& aabbMax, btDispatcher* dispatcher)=0;
 	virtual void	getAabb(btBroadphaseProxy* proxy,btVector3& aabbMin, btVector3& aabbMax ) const =0;
 
+	///setAabbs updates the aabbs of numProxies proxies at once, the broadphase can batch the work on its structures.
+	///A proxy should appear only once in a call.
+	virtual void	setAabbs(btBroadphaseProxy** proxies,const btVector3* aabbMins,const btVector3* aabbMaxs,int numProxies,btDispatcher* dispatcher)
+	{
+		for (int i=0;i<numProxies;i++)
+		{
+			setAabb(proxies[i],aabbMins[i],aabbMaxs[i],dispatcher);
+		}
+	}
+
 	virtual void	rayTest(const btVector3& rayFrom,const btVector3& rayTo, btBroadphaseRayCallback& rayCallback, const btVector3& aabbMin=btVector3(0,0,0), const btVector3& aabbMax = btVector3(0,0,0)) = 0;
 
+	///rayTestPacket casts numRays rays, the broadphase can traverse its structures once for a whole packet of rays.
+	///A ray stops early once its callback returns false, and a callback can shrink its m_lambda_max to skip what lies behind its closest hit.
+	///aabbMin and aabbMax optionally expand the proxies per ray, like in rayTest, to sweep boxes instead of rays.
+	virtual void	rayTestPacket(const btVector3* rayFrom,const btVector3* rayTo, btBroadphaseRayCallback** rayCallbacks, int numRays, const btVector3* aabbMin=0, const btVector3* aabbMax=0)
+	{
+		for (int i=0;i<numRays;i++)
+		{
+			if (aabbMin)
+				rayTest(rayFrom[i],rayTo[i],*rayCallbacks[i],aabbMin[i],aabbMax[i]);
+			else
+				rayTest(rayFrom[i],rayTo[i],*rayCallbacks[i]);
+		}
+	}
+
 	virtual void	aabbTest(const btVector3& aabbMin, const btVector3& aabbMax, btBroadphaseAabbCallback& callback) = 0;
 
 	///calculateOverlappingPairs is optional: incremental algorithms (sweep and prune) might do it during the set aabb
@@ -210,6 +210,73 @@ static btDbvtNode*				removeleaf(	btDbvt* pdbvt,
 	}
 }
 
+//
+static void						detachleaf(	btDbvt* pdbvt,
+										   btDbvtNode* leaf)
+{
+	/* removeleaf without the refit of the ancestors	*/ 
+	if(leaf==pdbvt->m_root)
+	{
+		pdbvt->m_root=0;
+	}
+	else
+	{
+		btDbvtNode*	parent=leaf->parent;
+		btDbvtNode*	prev=parent->parent;
+		btDbvtNode*	sibling=parent->childs[1-indexof(leaf)];
+		if(prev)
+		{
+			prev->childs[indexof(parent)]=sibling;
+			sibling->parent=prev;
+		}
+		else
+		{
+			pdbvt->m_root=sibling;
+			sibling->parent=0;
+		}
+		deletenode(pdbvt,parent);
+	}
+}
+
+//
+static void						attachleaf(	btDbvt* pdbvt,
+										   btDbvtNode* leaf)
+{
+	/* insertleaf from the root without the refit of the ancestors	*/ 
+	btDbvtNode*	root=pdbvt->m_root;
+	if(!root)
+	{
+		pdbvt->m_root	=	leaf;
+		leaf->parent	=	0;
+		return;
+	}
+	while(root->isinternal())
+	{
+		root=root->childs[Select(	leaf->volume,
+			root->childs[0]->volume,
+			root->childs[1]->volume)];
+	}
+	btDbvtNode*	prev=root->parent;
+	btDbvtNode*	node=createnode(pdbvt,prev,leaf->volume,root->volume,0);
+	if(prev)
+		prev->childs[indexof(root)]=node;
+	else
+		pdbvt->m_root=node;
+	node->childs[0]	=	root;root->parent=node;
+	node->childs[1]	=	leaf;leaf->parent=node;
+}
+
+//
+static void						refit(btDbvtNode* node)
+{
+	if(node->isinternal())
+	{
+		refit(node->childs[0]);
+		refit(node->childs[1]);
+		Merge(node->childs[0]->volume,node->childs[1]->volume,node->volume);
+	}
+}
+
 //
 static void						fetchleaves(btDbvt* pdbvt,
 											btDbvtNode* root,
@@ -553,6 +620,29 @@ bool			btDbvt::update(btDbvtNode* leaf,btDbvtVolume& volume,btScalar margin)
 	return(true);
 }
 
+//
+void			btDbvt::updateLeaves(btDbvtNode* const* leaves,const btDbvtVolume* volumes,int count)
+{
+	if(count*8<m_leaves)
+	{
+		/* few leaves, refitting their ancestors costs less than refitting the whole tree	*/ 
+		for(int i=0;i<count;++i)
+		{
+			btDbvtVolume	volume=volumes[i];
+			update(leaves[i],volume);
+		}
+		return;
+	}
+	/* the leaves are inserted on the stale volumes of the ancestors, then the tree is refitted once	*/ 
+	for(int i=0;i<count;++i)
+	{
+		detachleaf(this,leaves[i]);
+		leaves[i]->volume=volumes[i];
+		attachleaf(this,leaves[i]);
+	}
+	if(m_root) refit(m_root);
+}
+
 //
 void			btDbvt::remove(btDbvtNode* leaf)
 {
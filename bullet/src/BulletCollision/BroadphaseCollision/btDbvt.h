@@ -284,6 +284,9 @@ struct	btDbvt
 	bool			update(btDbvtNode* leaf,btDbvtVolume& volume,const btVector3& velocity,btScalar margin);
 	bool			update(btDbvtNode* leaf,btDbvtVolume& volume,const btVector3& velocity);
 	bool			update(btDbvtNode* leaf,btDbvtVolume& volume,btScalar margin);	
+	///updateLeaves moves count leaves to their new volumes at once. When many leaves move, they are reinserted from the root
+	///without refitting their ancestors each time, then the internal nodes are refitted bottom-up in a single pass.
+	void			updateLeaves(btDbvtNode* const* leaves,const btDbvtVolume* volumes,int count);
 	void			remove(btDbvtNode* leaf);
 	void			write(IWriter* iwriter) const;
 	void			clone(btDbvt& dest,IClone* iclone=0) const;
@@ -358,6 +361,18 @@ struct	btDbvt
 								const btVector3& aabbMin,
 								const btVector3& aabbMax,
 								DBVT_IPOLICY) const;
+	///rayTestInternal with a stack owned by the caller, so several threads can cast rays against the same tree at once
+	DBVT_PREFIX
+		void		rayTestInternal(	const btDbvtNode* root,
+								const btVector3& rayFrom,
+								const btVector3& rayTo,
+								const btVector3& rayDirectionInverse,
+								unsigned int signs[3],
+								btScalar lambda_max,
+								const btVector3& aabbMin,
+								const btVector3& aabbMax,
+								btAlignedObjectArray<const btDbvtNode*>& stack,
+								DBVT_IPOLICY) const;
 
 	DBVT_PREFIX
 		static void		collideKDOP(const btDbvtNode* root,
@@ -1007,6 +1022,22 @@ inline void		btDbvt::rayTestInternal(	const btDbvtNode* root,
 								const btVector3& aabbMin,
 								const btVector3& aabbMax,
 								DBVT_IPOLICY) const
+{
+	rayTestInternal(root,rayFrom,rayTo,rayDirectionInverse,signs,lambda_max,aabbMin,aabbMax,m_rayTestStack,policy);
+}
+
+//
+DBVT_PREFIX
+inline void		btDbvt::rayTestInternal(	const btDbvtNode* root,
+								const btVector3& rayFrom,
+								const btVector3& rayTo,
+								const btVector3& rayDirectionInverse,
+								unsigned int signs[3],
+								btScalar lambda_max,
+								const btVector3& aabbMin,
+								const btVector3& aabbMax,
+								btAlignedObjectArray<const btDbvtNode*>& stack,
+								DBVT_IPOLICY) const
 {
         (void) rayTo;
 	DBVT_CHECKTYPE
@@ -1016,7 +1047,6 @@ inline void		btDbvt::rayTestInternal(	const btDbvtNode* root,
 
 		int								depth=1;
 		int								treshold=DOUBLE_STACKSIZE-2;
-		btAlignedObjectArray<const btDbvtNode*>&	stack = m_rayTestStack;
 		stack.resize(DOUBLE_STACKSIZE);
 		stack[0]=root;
 		btVector3 bounds[2];
@@ -84,6 +84,14 @@ static inline void	clear(T& value)
 	value=zerodummy;
 }
 
+//
+static inline void	fixedchanged(btDbvtBroadphase* pbp)
+{
+	/* the wide copy points to the leafs of the fixed set, drop it before they go away	*/ 
+	pbp->m_fixedwide.clear();
+	pbp->m_fixedchanged=true;
+}
+
 //
 // Colliders
 //
@@ -114,6 +122,84 @@ struct	btDbvtTreeCollider : btDbvt::ICollide
 	}
 };
 
+//
+static void	collidefixed(btDbvtBroadphase* pbp,btDbvtProxy* proxy,btDbvtTreeCollider& collider)
+{
+	/* same pairs, in the same order, as colliding the leaf with the fixed set tree	*/ 
+	if(!pbp->m_fixedwide.empty())
+	{
+		collider.proxy=proxy;
+		pbp->m_fixedwide.collideTV(proxy->leaf->volume,pbp->m_wideStacks[btGetCurrentThreadIndex()],collider);
+	}
+	else
+	{
+		pbp->m_sets[1].collideTTpersistentStack(pbp->m_sets[1].m_root,proxy->leaf,collider);
+	}
+}
+
+/* Pair collector, stores the pairs of a proxy instead of adding them to the pair cache	*/ 
+struct	btDbvtPairCollector : btDbvt::ICollide
+{
+	btDbvtProxyArray&	pairs;
+	btDbvtProxy*		proxy;
+	btDbvtPairCollector(btDbvtProxyArray& p) : pairs(p) {}
+	void	Process(const btDbvtNode* n)
+	{
+		/* same pair order as btDbvtTreeCollider	*/ 
+		if(n!=proxy->leaf)
+		{
+			pairs.push_back((btDbvtProxy*)n->data);
+			pairs.push_back(proxy);
+		}
+	}
+};
+
+/* Collides the proxies moved by setAabbs with both sets, each loop range keeps its pairs apart	*/ 
+struct	btDbvtMovedCollideLoop : btIParallelForBody
+{
+	btDbvtBroadphase*	pbp;
+	btDbvtMovedCollideLoop(btDbvtBroadphase* p) : pbp(p) {}
+	void	forLoop(int iBegin,int iEnd) const
+	{
+		const int				thread=btGetCurrentThreadIndex();
+		btDbvtPairCollector		collector(pbp->m_threadPairs[thread]);
+		btNodeStack&			stack=pbp->m_threadStacks[thread];
+		btAlignedObjectArray<int>&	chunks=pbp->m_threadChunks[thread];
+		chunks.push_back(iBegin);
+		chunks.push_back(collector.pairs.size());
+		for(int i=iBegin;i<iEnd;++i)
+		{
+			collector.proxy=pbp->m_updateProxies[i];
+			const btDbvtVolume&	volume=collector.proxy->leaf->volume;
+			/* collideTV visits the leafs in the order of collideTTpersistentStack with a leaf	*/ 
+			if(!pbp->m_fixedwide.empty())
+				pbp->m_fixedwide.collideTV(volume,pbp->m_wideStacks[thread],collector);
+			else
+				pbp->m_sets[1].collideTVNoStackAlloc(pbp->m_sets[1].m_root,volume,stack,collector);
+			pbp->m_sets[0].collideTVNoStackAlloc(pbp->m_sets[0].m_root,volume,stack,collector);
+		}
+		chunks.push_back(collector.pairs.size());
+	}
+};
+
+/* Loop range of btDbvtMovedCollideLoop	*/ 
+struct	btDbvtPairChunk
+{
+	int		begin;
+	int		thread;
+	int		first;
+	int		last;
+};
+
+//
+struct	btDbvtPairChunkLess
+{
+	bool	operator()(const btDbvtPairChunk& a,const btDbvtPairChunk& b) const
+	{
+		return(a.begin<b.begin);
+	}
+};
+
 //
 // btDbvtBroadphase
 //
@@ -123,6 +209,8 @@ btDbvtBroadphase::btDbvtBroadphase(btOverlappingPairCache* paircache)
 {
 	m_deferedcollide	=	false;
 	m_needcleanup		=	true;
+	m_widequeries		=	true;
+	m_fixedchanged		=	false;
 	m_releasepaircache	=	(paircache!=0)?false:true;
 	m_prediction		=	0;
 	m_stageCurrent		=	0;
@@ -183,7 +271,7 @@ btBroadphaseProxy*				btDbvtBroadphase::createProxy(	const btVector3& aabbMin,
 		btDbvtTreeCollider	collider(this);
 		collider.proxy=proxy;
 		m_sets[0].collideTV(m_sets[0].m_root,aabb,collider);
-		m_sets[1].collideTV(m_sets[1].m_root,aabb,collider);
+		collidefixed(this,proxy,collider);
 	}
 	return(proxy);
 }
@@ -194,7 +282,10 @@ void							btDbvtBroadphase::destroyProxy(	btBroadphaseProxy* absproxy,
 {
 	btDbvtProxy*	proxy=(btDbvtProxy*)absproxy;
 	if(proxy->stage==STAGECOUNT)
+	{
+		fixedchanged(this);
 		m_sets[1].remove(proxy->leaf);
+	}
 	else
 		m_sets[0].remove(proxy->leaf);
 	listremove(proxy,m_stageRoots[proxy->stage]);
@@ -227,6 +318,7 @@ struct	BroadphaseRayTester : btDbvt::ICollide
 void	btDbvtBroadphase::rayTest(const btVector3& rayFrom,const btVector3& rayTo, btBroadphaseRayCallback& rayCallback,const btVector3& aabbMin,const btVector3& aabbMax)
 {
 	BroadphaseRayTester callback(rayCallback);
+	btNodeStack& stack = m_threadStacks[btGetCurrentThreadIndex()];
 
 	m_sets[0].rayTestInternal(	m_sets[0].m_root,
 		rayFrom,
@@ -236,21 +328,167 @@ void	btDbvtBroadphase::rayTest(const btVector3& rayFrom,const btVector3& rayTo,
 		rayCallback.m_lambda_max,
 		aabbMin,
 		aabbMax,
+		stack,
 		callback);
 
-	m_sets[1].rayTestInternal(	m_sets[1].m_root,
-		rayFrom,
-		rayTo,
-		rayCallback.m_rayDirectionInverse,
-		rayCallback.m_signs,
-		rayCallback.m_lambda_max,
-		aabbMin,
-		aabbMax,
-		callback);
+	if(!m_fixedwide.empty())
+	{
+		m_fixedwide.rayTestInternal(	rayFrom,
+			rayCallback.m_rayDirectionInverse,
+			rayCallback.m_signs,
+			rayCallback.m_lambda_max,
+			aabbMin,
+			aabbMax,
+			m_wideStacks[btGetCurrentThreadIndex()],
+			callback);
+	}
+	else
+	{
+		m_sets[1].rayTestInternal(	m_sets[1].m_root,
+			rayFrom,
+			rayTo,
+			rayCallback.m_rayDirectionInverse,
+			rayCallback.m_signs,
+			rayCallback.m_lambda_max,
+			aabbMin,
+			aabbMax,
+			stack,
+			callback);
+	}
 
 }
 
 
+///traverses the tree once for up to 32 rays, the bits of active are the rays that still want hits.
+///aabbMin/aabbMax expand the nodes per ray, if given.
+static unsigned	rayTestPacketInternal(const btDbvtNode* root,const btVector3* rayFrom,btBroadphaseRayCallback** rayCallbacks,const btVector3* aabbMin,const btVector3* aabbMax,unsigned active,btAlignedObjectArray<btDbvt::sStkNP>& stack)
+{
+	if(!root) return active;
+	btAssert(stack.size()==0);
+	stack.push_back(btDbvt::sStkNP(root,active));
+	do
+	{
+		const btDbvt::sStkNP	se=stack[stack.size()-1];
+		stack.pop_back();
+		const unsigned	mask=((unsigned)se.mask)&active;
+		if(!mask) continue;
+		const btDbvtNode*	node=se.node;
+		btVector3	bounds[2];
+		bounds[0]=node->volume.Mins();
+		bounds[1]=node->volume.Maxs();
+		unsigned	hits=0;
+		int			i=0;
+		for(unsigned m=mask;m;m>>=1,++i)
+		{
+			if(!(m&1)) continue;
+			const btBroadphaseRayCallback*	rayCallback=rayCallbacks[i];
+			if(aabbMin)
+			{
+				bounds[0]=node->volume.Mins()-aabbMax[i];
+				bounds[1]=node->volume.Maxs()-aabbMin[i];
+			}
+			btScalar	tmin=1.f;
+			if(btRayAabb2(rayFrom[i],rayCallback->m_rayDirectionInverse,rayCallback->m_signs,bounds,tmin,0.f,rayCallback->m_lambda_max))
+				hits|=1u<<i;
+		}
+		if(!hits) continue;
+		if(node->isinternal())
+		{
+			/* same order as rayTestInternal, so every ray visits the leafs in the same order as rayTest */ 
+			stack.push_back(btDbvt::sStkNP(node->childs[0],hits));
+			stack.push_back(btDbvt::sStkNP(node->childs[1],hits));
+		}
+		else
+		{
+			btDbvtProxy*	proxy=(btDbvtProxy*)node->data;
+			i=0;
+			for(unsigned m=hits;m;m>>=1,++i)
+			{
+				if((m&1) && !rayCallbacks[i]->process(proxy))
+					active&=~(1u<<i);
+			}
+		}
+	} while(stack.size());
+	return active;
+}
+
+///rayTestPacketInternal for the 4-wide copy of the fixed set, the leafs are reported in the same order.
+static unsigned	rayTestPacketWide(const btDbvtWide& wide,const btVector3* rayFrom,btBroadphaseRayCallback** rayCallbacks,const btVector3* aabbMin,const btVector3* aabbMax,unsigned active,btAlignedObjectArray<btDbvtWide::sStkNP>& stack)
+{
+	if(wide.empty()) return active;
+	btAssert(stack.size()==0);
+	const btVector3	zero(0,0,0);
+	stack.push_back(btDbvtWide::sStkNP(0,active));
+	do
+	{
+		const btDbvtWide::sStkNP	se=stack[stack.size()-1];
+		stack.pop_back();
+		const unsigned	mask=se.mask&active;
+		if(!mask) continue;
+		if(se.child<0)
+		{
+			/* retest the leaf against the current lambda_max, as rayTestPacketInternal does on popping it */ 
+			const btDbvtNode*	leaf=wide.m_leaves[~se.child];
+			btDbvtProxy*		proxy=(btDbvtProxy*)leaf->data;
+			int	i=0;
+			for(unsigned m=mask;m;m>>=1,++i)
+			{
+				if(!(m&1)) continue;
+				btBroadphaseRayCallback*	rayCallback=rayCallbacks[i];
+				btVector3	bounds[2];
+				bounds[0]=leaf->volume.Mins();
+				bounds[1]=leaf->volume.Maxs();
+				if(aabbMin)
+				{
+					bounds[0]-=aabbMax[i];
+					bounds[1]-=aabbMin[i];
+				}
+				btScalar	tmin=1.f;
+				if(btRayAabb2(rayFrom[i],rayCallback->m_rayDirectionInverse,rayCallback->m_signs,bounds,tmin,0.f,rayCallback->m_lambda_max) && !rayCallback->process(proxy))
+					active&=~(1u<<i);
+			}
+			continue;
+		}
+		const btDbvtWide::Node&	node=wide.m_nodes[se.child];
+		unsigned	slots[btDbvtWide::WIDTH]={0,0,0,0};
+		int			i=0;
+		for(unsigned m=mask;m;m>>=1,++i)
+		{
+			if(!(m&1)) continue;
+			const btBroadphaseRayCallback*	rayCallback=rayCallbacks[i];
+			int	j=0;
+			for(unsigned h=btDbvtWide::rayTestChilds(node,rayFrom[i],rayCallback->m_rayDirectionInverse,rayCallback->m_signs,rayCallback->m_lambda_max,aabbMin?aabbMin[i]:zero,aabbMax?aabbMax[i]:zero);h;h>>=1,++j)
+			{
+				if(h&1) slots[j]|=1u<<i;
+			}
+		}
+		for(int j=0;j<btDbvtWide::WIDTH;++j)
+		{
+			if(slots[j]) stack.push_back(btDbvtWide::sStkNP(node.childs[j],slots[j]));
+		}
+	} while(stack.size());
+	return active;
+}
+
+void	btDbvtBroadphase::rayTestPacket(const btVector3* rayFrom,const btVector3* rayTo, btBroadphaseRayCallback** rayCallbacks, int numRays, const btVector3* aabbMin, const btVector3* aabbMax)
+{
+	(void) rayTo;
+	btAlignedObjectArray<btDbvt::sStkNP>& stack = m_rayPacketStacks[btGetCurrentThreadIndex()];
+	for(int begin=0;begin<numRays;begin+=32)
+	{
+		const int	count=btMin(numRays-begin,32);
+		unsigned	active=count<32 ? (1u<<count)-1 : ~0u;
+		const btVector3*	packetAabbMin=aabbMin ? aabbMin+begin : 0;
+		const btVector3*	packetAabbMax=aabbMax ? aabbMax+begin : 0;
+		active=rayTestPacketInternal(m_sets[0].m_root,rayFrom+begin,rayCallbacks+begin,packetAabbMin,packetAabbMax,active,stack);
+		if(!m_fixedwide.empty())
+			rayTestPacketWide(m_fixedwide,rayFrom+begin,rayCallbacks+begin,packetAabbMin,packetAabbMax,active,m_widePacketStacks[btGetCurrentThreadIndex()]);
+		else
+			rayTestPacketInternal(m_sets[1].m_root,rayFrom+begin,rayCallbacks+begin,packetAabbMin,packetAabbMax,active,stack);
+	}
+}
+
+
 struct	BroadphaseAabbTester : btDbvt::ICollide
 {
 	btBroadphaseAabbCallback& m_aabbCallback;
@@ -271,8 +509,12 @@ void	btDbvtBroadphase::aabbTest(const btVector3& aabbMin,const btVector3& aabbMa
 
 	const ATTRIBUTE_ALIGNED16(btDbvtVolume)	bounds=btDbvtVolume::FromMM(aabbMin,aabbMax);
 		//process all children, that overlap with  the given AABB bounds
-	m_sets[0].collideTV(m_sets[0].m_root,bounds,callback);
-	m_sets[1].collideTV(m_sets[1].m_root,bounds,callback);
+	btNodeStack& stack = m_threadStacks[btGetCurrentThreadIndex()];
+	m_sets[0].collideTVNoStackAlloc(m_sets[0].m_root,bounds,stack,callback);
+	if(!m_fixedwide.empty())
+		m_fixedwide.collideTV(bounds,m_wideStacks[btGetCurrentThreadIndex()],callback);
+	else
+		m_sets[1].collideTVNoStackAlloc(m_sets[1].m_root,bounds,stack,callback);
 
 }
 
@@ -293,6 +535,7 @@ void							btDbvtBroadphase::setAabb(		btBroadphaseProxy* absproxy,
 		bool	docollide=false;
 		if(proxy->stage==STAGECOUNT)
 		{/* fixed -> dynamic set	*/ 
+			fixedchanged(this);
 			m_sets[1].remove(proxy->leaf);
 			proxy->leaf=m_sets[0].insert(aabb,proxy);
 			docollide=true;
@@ -338,7 +581,7 @@ void							btDbvtBroadphase::setAabb(		btBroadphaseProxy* absproxy,
 			if(!m_deferedcollide)
 			{
 				btDbvtTreeCollider	collider(this);
-				m_sets[1].collideTTpersistentStack(m_sets[1].m_root,proxy->leaf,collider);
+				collidefixed(this,proxy,collider);
 				m_sets[0].collideTTpersistentStack(m_sets[0].m_root,proxy->leaf,collider);
 			}
 		}	
@@ -346,6 +589,118 @@ void							btDbvtBroadphase::setAabb(		btBroadphaseProxy* absproxy,
 }
 
 
+//
+void							btDbvtBroadphase::setAabbs(	btBroadphaseProxy** proxies,
+														   const btVector3* aabbMins,
+														   const btVector3* aabbMaxs,
+														   int numProxies,
+														   btDispatcher* /*dispatcher*/)
+{
+	m_updateLeaves.resize(0);
+	m_updateVolumes.resize(0);
+	m_updateProxies.resize(0);
+	for(int i=0;i<numProxies;++i)
+	{
+		btDbvtProxy*						proxy=(btDbvtProxy*)proxies[i];
+		const btVector3&					aabbMin=aabbMins[i];
+		const btVector3&					aabbMax=aabbMaxs[i];
+		ATTRIBUTE_ALIGNED16(btDbvtVolume)	aabb=btDbvtVolume::FromMM(aabbMin,aabbMax);
+#if DBVT_BP_PREVENTFALSEUPDATE
+		if(!NotEqual(aabb,proxy->leaf->volume)) continue;
+#endif
+		if(proxy->stage==STAGECOUNT)
+		{/* fixed -> dynamic set	*/ 
+			fixedchanged(this);
+			m_sets[1].remove(proxy->leaf);
+			proxy->leaf=m_sets[0].insert(aabb,proxy);
+			m_updateProxies.push_back(proxy);
+		}
+		else
+		{/* dynamic set, same volumes as setAabb	*/ 
+			++m_updates_call;
+			if(Intersect(proxy->leaf->volume,aabb))
+			{/* Moving				*/ 
+				if(!proxy->leaf->volume.Contain(aabb))
+				{
+					const btVector3	delta=aabbMin-proxy->m_aabbMin;
+					btVector3		velocity(((proxy->m_aabbMax-proxy->m_aabbMin)/2)*m_prediction);
+					if(delta[0]<0) velocity[0]=-velocity[0];
+					if(delta[1]<0) velocity[1]=-velocity[1];
+					if(delta[2]<0) velocity[2]=-velocity[2];
+#ifdef DBVT_BP_MARGIN
+					aabb.Expand(btVector3(DBVT_BP_MARGIN,DBVT_BP_MARGIN,DBVT_BP_MARGIN));
+#endif
+					aabb.SignedExpand(velocity);
+					m_updateLeaves.push_back(proxy->leaf);
+					m_updateVolumes.push_back(aabb);
+					m_updateProxies.push_back(proxy);
+					++m_updates_done;
+				}
+			}
+			else
+			{/* Teleporting			*/ 
+				m_updateLeaves.push_back(proxy->leaf);
+				m_updateVolumes.push_back(aabb);
+				m_updateProxies.push_back(proxy);
+				++m_updates_done;
+			}
+		}
+		listremove(proxy,m_stageRoots[proxy->stage]);
+		proxy->m_aabbMin = aabbMin;
+		proxy->m_aabbMax = aabbMax;
+		proxy->stage	=	m_stageCurrent;
+		listappend(proxy,m_stageRoots[m_stageCurrent]);
+	}
+	if(m_updateLeaves.size()>0)
+	{
+		m_sets[0].updateLeaves(&m_updateLeaves[0],&m_updateVolumes[0],m_updateLeaves.size());
+	}
+	if(m_updateProxies.size()>0)
+	{
+		m_needcleanup=true;
+		if(!m_deferedcollide)
+		{
+			/* the pairs are added in the order of the proxies, whatever the number of threads	*/ 
+			for(unsigned int i=0;i<BT_MAX_THREAD_COUNT;++i)
+			{
+				m_threadPairs[i].resize(0);
+				m_threadChunks[i].resize(0);
+			}
+			btParallelFor(0,m_updateProxies.size(),64,btDbvtMovedCollideLoop(this));
+			btAlignedObjectArray<btDbvtPairChunk>	chunks;
+			for(unsigned int i=0;i<BT_MAX_THREAD_COUNT;++i)
+			{
+				const btAlignedObjectArray<int>&	threadChunks=m_threadChunks[i];
+				for(int j=0;j<threadChunks.size();j+=3)
+				{
+					btDbvtPairChunk	chunk;
+					chunk.begin=threadChunks[j];
+					chunk.thread=i;
+					chunk.first=threadChunks[j+1];
+					chunk.last=threadChunks[j+2];
+					chunks.push_back(chunk);
+				}
+			}
+			chunks.quickSort(btDbvtPairChunkLess());
+			for(int i=0;i<chunks.size();++i)
+			{
+				const btDbvtProxyArray&	pairs=m_threadPairs[chunks[i].thread];
+				for(int j=chunks[i].first;j<chunks[i].last;j+=2)
+				{
+					btDbvtProxy*	pa=pairs[j];
+					btDbvtProxy*	pb=pairs[j+1];
+#if DBVT_BP_SORTPAIRS
+					if(pa->m_uniqueId>pb->m_uniqueId) 
+						btSwap(pa,pb);
+#endif
+					m_paircache->addOverlappingPair(pa,pb);
+					++m_newpairs;
+				}
+			}
+		}
+	}
+}
+
 //
 void							btDbvtBroadphase::setAabbForceUpdate(		btBroadphaseProxy* absproxy,
 														  const btVector3& aabbMin,
@@ -357,6 +712,7 @@ void							btDbvtBroadphase::setAabbForceUpdate(		btBroadphaseProxy* absproxy,
 	bool	docollide=false;
 	if(proxy->stage==STAGECOUNT)
 	{/* fixed -> dynamic set	*/ 
+		fixedchanged(this);
 		m_sets[1].remove(proxy->leaf);
 		proxy->leaf=m_sets[0].insert(aabb,proxy);
 		docollide=true;
@@ -380,7 +736,7 @@ void							btDbvtBroadphase::setAabbForceUpdate(		btBroadphaseProxy* absproxy,
 		if(!m_deferedcollide)
 		{
 			btDbvtTreeCollider	collider(this);
-			m_sets[1].collideTTpersistentStack(m_sets[1].m_root,proxy->leaf,collider);
+			collidefixed(this,proxy,collider);
 			m_sets[0].collideTTpersistentStack(m_sets[0].m_root,proxy->leaf,collider);
 		}
 	}	
@@ -521,6 +877,7 @@ void							btDbvtBroadphase::collide(btDispatcher* dispatcher)
 	if(current)
 	{
 		btDbvtTreeCollider	collider(this);
+		fixedchanged(this);
 		do	{
 			btDbvtProxy*	next=current->links[1];
 			listremove(current,m_stageRoots[current->stage]);
@@ -554,6 +911,16 @@ void							btDbvtBroadphase::collide(btDispatcher* dispatcher)
 			m_sets[0].collideTTpersistentStack(m_sets[0].m_root,m_sets[0].m_root,collider);
 		}
 	}
+	/* wide fixed set, built once the fixed set went a whole frame without changes	*/ 
+	if(m_fixedchanged||!m_widequeries)
+	{
+		m_fixedwide.clear();
+		m_fixedchanged=false;
+	}
+	else if(m_fixedwide.empty()&&!m_sets[1].empty())
+	{
+		m_fixedwide.build(m_sets[1]);
+	}
 	/* clean up				*/ 
 	if(m_needcleanup)
 	{
@@ -597,6 +964,7 @@ void							btDbvtBroadphase::optimize()
 {
 	m_sets[0].optimizeTopDown();
 	m_sets[1].optimizeTopDown();
+	fixedchanged(this);
 }
 
 //
@@ -638,6 +1006,8 @@ void btDbvtBroadphase::resetPool(btDispatcher* dispatcher)
 		//reset internal dynamic tree data structures
 		m_sets[0].clear();
 		m_sets[1].clear();
+		m_fixedwide.clear();
+		m_fixedchanged		=	false;
 		
 		m_deferedcollide	=	false;
 		m_needcleanup		=	true;
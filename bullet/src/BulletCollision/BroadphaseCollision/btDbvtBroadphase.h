@@ -18,7 +18,9 @@ subject to the following restrictions:
 #define BT_DBVT_BROADPHASE_H
 
 #include "BulletCollision/BroadphaseCollision/btDbvt.h"
+#include "BulletCollision/BroadphaseCollision/btDbvtWide.h"
 #include "BulletCollision/BroadphaseCollision/btOverlappingPairCache.h"
+#include "LinearMath/btThreads.h"
 
 //
 // Compile time config
@@ -87,6 +89,18 @@ struct	btDbvtBroadphase : btBroadphaseInterface
 	bool					m_releasepaircache;			// Release pair cache on delete
 	bool					m_deferedcollide;			// Defere dynamic/static collision to collide call
 	bool					m_needcleanup;				// Need to run cleanup?
+	bool					m_widequeries;				// Query the fixed set through a 4-wide copy, once it stopped changing
+	bool					m_fixedchanged;				// Fixed set changed since the last collide
+	btDbvtWide				m_fixedwide;				// 4-wide copy of the fixed set, empty while out of date
+	btNodeStack				m_threadStacks[BT_MAX_THREAD_COUNT];	// Ray and aabb test stack per thread
+	btAlignedObjectArray<btDbvt::sStkNP>	m_rayPacketStacks[BT_MAX_THREAD_COUNT];	// Ray packet stack per thread
+	btAlignedObjectArray<int>	m_wideStacks[BT_MAX_THREAD_COUNT];	// Wide query stack per thread
+	btAlignedObjectArray<btDbvtWide::sStkNP>	m_widePacketStacks[BT_MAX_THREAD_COUNT];	// Wide ray packet stack per thread
+	btAlignedObjectArray<btDbvtNode*>	m_updateLeaves;		// Leaves reinserted by setAabbs
+	btAlignedObjectArray<btDbvtVolume>	m_updateVolumes;	// New volumes of m_updateLeaves
+	btDbvtProxyArray		m_updateProxies;			// Proxies setAabbs collides with both sets
+	btDbvtProxyArray		m_threadPairs[BT_MAX_THREAD_COUNT];	// Pairs found by setAabbs per thread
+	btAlignedObjectArray<int>	m_threadChunks[BT_MAX_THREAD_COUNT];	// Loop ranges of setAabbs per thread, with their pairs
 #if DBVT_BP_PROFILE
 	btClock					m_clock;
 	struct	{
@@ -107,7 +121,11 @@ struct	btDbvtBroadphase : btBroadphaseInterface
 	btBroadphaseProxy*				createProxy(const btVector3& aabbMin,const btVector3& aabbMax,int shapeType,void* userPtr,short int collisionFilterGroup,short int collisionFilterMask,btDispatcher* dispatcher,void* multiSapProxy);
 	virtual void					destroyProxy(btBroadphaseProxy* proxy,btDispatcher* dispatcher);
 	virtual void					setAabb(btBroadphaseProxy* proxy,const btVector3& aabbMin,const btVector3& aabbMax,btDispatcher* dispatcher);
+	///setAabbs reinserts only the proxies that left their leaf volume, all at once with btDbvt::updateLeaves,
+	///then it collides the moved proxies with both sets in parallel on btParallelFor, against the updated sets.
+	virtual void					setAabbs(btBroadphaseProxy** proxies,const btVector3* aabbMins,const btVector3* aabbMaxs,int numProxies,btDispatcher* dispatcher);
 	virtual void					rayTest(const btVector3& rayFrom,const btVector3& rayTo, btBroadphaseRayCallback& rayCallback, const btVector3& aabbMin=btVector3(0,0,0), const btVector3& aabbMax = btVector3(0,0,0));
+	virtual void					rayTestPacket(const btVector3* rayFrom,const btVector3* rayTo, btBroadphaseRayCallback** rayCallbacks, int numRays, const btVector3* aabbMin=0, const btVector3* aabbMax=0);
 	virtual void					aabbTest(const btVector3& aabbMin, const btVector3& aabbMax, btBroadphaseAabbCallback& callback);
 
 	virtual void					getAabb(btBroadphaseProxy* proxy,btVector3& aabbMin, btVector3& aabbMax ) const;
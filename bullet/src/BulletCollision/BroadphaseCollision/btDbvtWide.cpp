@@ -0,0 +1,98 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2014 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "btDbvtWide.h"
+
+//
+static btScalar			surfaceArea(const btDbvtVolume& a)
+{
+	const btVector3	edges=a.Lengths();
+	return(edges.x()*edges.y()+edges.y()*edges.z()+edges.z()*edges.x());
+}
+
+//
+static int				buildNode(btDbvtWide& wide,const btDbvtNode* root)
+{
+	/* collapse the binary subtree into up to WIDTH subtrees, opening the largest one first.
+	The subtrees stay in the order of their leaves, so traversals report the leaves in the binary order	*/
+	const btDbvtNode*	childs[btDbvtWide::WIDTH];
+	int					count=0;
+	if(root->isleaf())
+	{
+		childs[count++]=root;
+	}
+	else
+	{
+		childs[count++]=root->childs[0];
+		childs[count++]=root->childs[1];
+		while(count<btDbvtWide::WIDTH)
+		{
+			int			largest=-1;
+			btScalar	largestArea=-1;
+			for(int i=0;i<count;++i)
+			{
+				if(childs[i]->isinternal())
+				{
+					const btScalar	area=surfaceArea(childs[i]->volume);
+					if(area>largestArea) { largest=i;largestArea=area; }
+				}
+			}
+			if(largest<0) break;
+			const btDbvtNode*	opened=childs[largest];
+			for(int i=count;i>largest+1;--i) childs[i]=childs[i-1];
+			childs[largest]=opened->childs[0];
+			childs[largest+1]=opened->childs[1];
+			++count;
+		}
+	}
+	const int	index=wide.m_nodes.size();
+	wide.m_nodes.expandNonInitializing();
+	int			refs[btDbvtWide::WIDTH];
+	for(int i=0;i<count;++i)
+	{
+		if(childs[i]->isleaf())
+		{
+			refs[i]=~wide.m_leaves.size();
+			wide.m_leaves.push_back(childs[i]);
+		}
+		else
+		{
+			refs[i]=buildNode(wide,childs[i]);
+		}
+	}
+	/* m_nodes may have grown during the recursion	*/
+	btDbvtWide::Node&	node=wide.m_nodes[index];
+	for(int i=0;i<btDbvtWide::WIDTH;++i)
+	{
+		for(int axis=0;axis<3;++axis)
+		{
+			node.mins[axis][i]=i<count?childs[i]->volume.Mins()[axis]:btScalar(BT_LARGE_FLOAT);
+			node.maxs[axis][i]=i<count?childs[i]->volume.Maxs()[axis]:btScalar(-BT_LARGE_FLOAT);
+		}
+		node.childs[i]=i<count?refs[i]:0;
+	}
+	node.mask=(1u<<count)-1;
+	return(index);
+}
+
+//
+void			btDbvtWide::build(const btDbvt& tree)
+{
+	clear();
+	if(tree.empty()) return;
+	m_nodes.reserve(tree.m_leaves/2+1);
+	m_leaves.reserve(tree.m_leaves);
+	buildNode(*this,tree.m_root);
+}
@@ -0,0 +1,255 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2014 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_DYNAMIC_BOUNDING_VOLUME_TREE_WIDE_H
+#define BT_DYNAMIC_BOUNDING_VOLUME_TREE_WIDE_H
+
+#include "btDbvt.h"
+
+#if defined (BT_USE_SSE)
+#include <emmintrin.h>
+#endif
+
+///The btDbvtWide class is a read-only copy of a btDbvt with up to 4 children per node.
+///The boxes of the children are stored per axis, so a single SSE comparison tests all children of a node,
+///and a query visits about half the nodes of the binary tree.
+///Queries report the leaves of the btDbvt it was built from, in the same order as the btDbvt queries do.
+///It doesn't follow changes of the btDbvt, call build again after inserting or removing leaves.
+struct	btDbvtWide
+{
+	enum	{ WIDTH = 4 };
+	/* Node, childs are node indices or ~leaf indices, mask holds the slots in use	*/
+	ATTRIBUTE_ALIGNED16(struct)	Node
+	{
+		btScalar	mins[3][WIDTH];
+		btScalar	maxs[3][WIDTH];
+		int			childs[WIDTH];
+		unsigned	mask;
+	};
+	/* Stack element of ray packets	*/
+	struct	sStkNP
+	{
+		int			child;
+		unsigned	mask;
+		sStkNP(int c,unsigned m) : child(c),mask(m) {}
+	};
+
+	// Fields
+	btAlignedObjectArray<Node>				m_nodes;
+	btAlignedObjectArray<const btDbvtNode*>	m_leaves;
+
+	// Methods
+	void			build(const btDbvt& tree);
+	void			clear()			{ m_nodes.resize(0);m_leaves.resize(0); }
+	bool			empty() const	{ return(0==m_nodes.size()); }
+
+	///returns the slots of the children of node whose box intersects volume
+	static SIMD_FORCE_INLINE unsigned	intersectChilds(const Node& node,const btDbvtVolume& volume);
+	///returns the slots of the children of node hit by the ray, with the same result as btRayAabb2 for each child
+	static SIMD_FORCE_INLINE unsigned	rayTestChilds(	const Node& node,
+												const btVector3& rayFrom,
+												const btVector3& rayDirectionInverse,
+												const unsigned int signs[3],
+												btScalar lambda_max,
+												const btVector3& aabbMin,
+												const btVector3& aabbMax);
+
+	///collideTV calls policy.Process for the leaves intersecting volume, like btDbvt::collideTV
+	template <typename T>
+	void		collideTV(	const btDbvtVolume& volume,
+							btAlignedObjectArray<int>& stack,
+							T& policy) const;
+	///rayTestInternal calls policy.Process for the leaves hit by the ray, like btDbvt::rayTestInternal
+	template <typename T>
+	void		rayTestInternal(	const btVector3& rayFrom,
+									const btVector3& rayDirectionInverse,
+									const unsigned int signs[3],
+									btScalar lambda_max,
+									const btVector3& aabbMin,
+									const btVector3& aabbMax,
+									btAlignedObjectArray<int>& stack,
+									T& policy) const;
+	///rayTest is the re-entrant btDbvt::rayTest, it allocates its own stack
+	template <typename T>
+	void		rayTest(	const btVector3& rayFrom,
+							const btVector3& rayTo,
+							T& policy) const;
+};
+
+//
+// Inline's
+//
+
+//
+SIMD_FORCE_INLINE unsigned	btDbvtWide::intersectChilds(const Node& node,const btDbvtVolume& volume)
+{
+	const btVector3&	mi=volume.Mins();
+	const btVector3&	mx=volume.Maxs();
+#if defined (BT_USE_SSE)
+	__m128	r=_mm_and_ps(	_mm_cmple_ps(_mm_load_ps(node.mins[0]),_mm_set1_ps(mx.x())),
+							_mm_cmple_ps(_mm_set1_ps(mi.x()),_mm_load_ps(node.maxs[0])));
+	r=_mm_and_ps(r,_mm_and_ps(	_mm_cmple_ps(_mm_load_ps(node.mins[1]),_mm_set1_ps(mx.y())),
+								_mm_cmple_ps(_mm_set1_ps(mi.y()),_mm_load_ps(node.maxs[1]))));
+	r=_mm_and_ps(r,_mm_and_ps(	_mm_cmple_ps(_mm_load_ps(node.mins[2]),_mm_set1_ps(mx.z())),
+								_mm_cmple_ps(_mm_set1_ps(mi.z()),_mm_load_ps(node.maxs[2]))));
+	return(((unsigned)_mm_movemask_ps(r))&node.mask);
+#else
+	unsigned	hits=0;
+	for(int i=0;i<WIDTH;++i)
+	{
+		if(	(node.mins[0][i]<=mx.x())&&(mi.x()<=node.maxs[0][i])&&
+			(node.mins[1][i]<=mx.y())&&(mi.y()<=node.maxs[1][i])&&
+			(node.mins[2][i]<=mx.z())&&(mi.z()<=node.maxs[2][i]))
+			hits|=1u<<i;
+	}
+	return(hits&node.mask);
+#endif
+}
+
+//
+SIMD_FORCE_INLINE unsigned	btDbvtWide::rayTestChilds(	const Node& node,
+													const btVector3& rayFrom,
+													const btVector3& rayDirectionInverse,
+													const unsigned int signs[3],
+													btScalar lambda_max,
+													const btVector3& aabbMin,
+													const btVector3& aabbMax)
+{
+	/* btRayAabb2 rejects the ray unless the largest entry distance over the axes is at most
+	the smallest exit distance, and the segment [0,lambda_max] overlaps [entry,exit]		*/
+#if defined (BT_USE_SSE)
+	__m128	tmin=_mm_set1_ps(-SIMD_INFINITY);
+	__m128	tmax=_mm_set1_ps(SIMD_INFINITY);
+	for(int axis=0;axis<3;++axis)
+	{
+		const __m128	bmin=_mm_sub_ps(_mm_load_ps(node.mins[axis]),_mm_set1_ps(aabbMax[axis]));
+		const __m128	bmax=_mm_sub_ps(_mm_load_ps(node.maxs[axis]),_mm_set1_ps(aabbMin[axis]));
+		const __m128	from=_mm_set1_ps(rayFrom[axis]);
+		const __m128	inv=_mm_set1_ps(rayDirectionInverse[axis]);
+		const __m128	tnear=_mm_mul_ps(_mm_sub_ps(signs[axis]?bmax:bmin,from),inv);
+		const __m128	tfar=_mm_mul_ps(_mm_sub_ps(signs[axis]?bmin:bmax,from),inv);
+		tmin=_mm_max_ps(tmin,tnear);
+		tmax=_mm_min_ps(tmax,tfar);
+	}
+	const __m128	r=_mm_and_ps(	_mm_cmple_ps(tmin,tmax),
+									_mm_and_ps(	_mm_cmplt_ps(tmin,_mm_set1_ps(lambda_max)),
+												_mm_cmpgt_ps(tmax,_mm_setzero_ps())));
+	return(((unsigned)_mm_movemask_ps(r))&node.mask);
+#else
+	unsigned	hits=0;
+	for(int i=0;i<WIDTH;++i)
+	{
+		btScalar	tmin=-SIMD_INFINITY;
+		btScalar	tmax=SIMD_INFINITY;
+		for(int axis=0;axis<3;++axis)
+		{
+			const btScalar	bmin=node.mins[axis][i]-aabbMax[axis];
+			const btScalar	bmax=node.maxs[axis][i]-aabbMin[axis];
+			const btScalar	tnear=((signs[axis]?bmax:bmin)-rayFrom[axis])*rayDirectionInverse[axis];
+			const btScalar	tfar=((signs[axis]?bmin:bmax)-rayFrom[axis])*rayDirectionInverse[axis];
+			tmin=btMax(tmin,tnear);
+			tmax=btMin(tmax,tfar);
+		}
+		if((tmin<=tmax)&&(tmin<lambda_max)&&(tmax>0))
+			hits|=1u<<i;
+	}
+	return(hits&node.mask);
+#endif
+}
+
+//
+template <typename T>
+inline void		btDbvtWide::collideTV(	const btDbvtVolume& vol,
+										btAlignedObjectArray<int>& stack,
+										T& policy) const
+{
+	if(empty()) return;
+	ATTRIBUTE_ALIGNED16(btDbvtVolume)	volume(vol);
+	/* childs are pushed in slot order and popped in reverse, as btDbvt::collideTV pops childs[1] before childs[0]	*/
+	stack.resize(0);
+	stack.push_back(0);
+	do	{
+		const int	child=stack[stack.size()-1];
+		stack.pop_back();
+		if(child<0)
+		{
+			policy.Process(m_leaves[~child]);
+			continue;
+		}
+		const Node&	node=m_nodes[child];
+		int			i=0;
+		for(unsigned m=intersectChilds(node,volume);m;m>>=1,++i)
+		{
+			if(m&1) stack.push_back(node.childs[i]);
+		}
+	} while(stack.size()>0);
+}
+
+//
+template <typename T>
+inline void		btDbvtWide::rayTestInternal(	const btVector3& rayFrom,
+												const btVector3& rayDirectionInverse,
+												const unsigned int signs[3],
+												btScalar lambda_max,
+												const btVector3& aabbMin,
+												const btVector3& aabbMax,
+												btAlignedObjectArray<int>& stack,
+												T& policy) const
+{
+	if(empty()) return;
+	stack.resize(0);
+	stack.push_back(0);
+	do	{
+		const int	child=stack[stack.size()-1];
+		stack.pop_back();
+		if(child<0)
+		{
+			policy.Process(m_leaves[~child]);
+			continue;
+		}
+		const Node&	node=m_nodes[child];
+		int			i=0;
+		for(unsigned m=rayTestChilds(node,rayFrom,rayDirectionInverse,signs,lambda_max,aabbMin,aabbMax);m;m>>=1,++i)
+		{
+			if(m&1) stack.push_back(node.childs[i]);
+		}
+	} while(stack.size()>0);
+}
+
+//
+template <typename T>
+inline void		btDbvtWide::rayTest(	const btVector3& rayFrom,
+										const btVector3& rayTo,
+										T& policy) const
+{
+	btVector3 rayDir = (rayTo-rayFrom);
+	rayDir.normalize ();
+
+	///what about division by zero? --> just set rayDirection[i] to INF/BT_LARGE_FLOAT
+	btVector3 rayDirectionInverse;
+	rayDirectionInverse[0] = rayDir[0] == btScalar(0.0) ? btScalar(BT_LARGE_FLOAT) : btScalar(1.0) / rayDir[0];
+	rayDirectionInverse[1] = rayDir[1] == btScalar(0.0) ? btScalar(BT_LARGE_FLOAT) : btScalar(1.0) / rayDir[1];
+	rayDirectionInverse[2] = rayDir[2] == btScalar(0.0) ? btScalar(BT_LARGE_FLOAT) : btScalar(1.0) / rayDir[2];
+	unsigned int signs[3] = { rayDirectionInverse[0] < 0.0, rayDirectionInverse[1] < 0.0, rayDirectionInverse[2] < 0.0};
+
+	btScalar lambda_max = rayDir.dot(rayTo-rayFrom);
+
+	btAlignedObjectArray<int>	stack;
+	stack.reserve(btDbvt::SIMPLE_STACKSIZE);
+	const btVector3	zero(0,0,0);
+	rayTestInternal(rayFrom,rayDirectionInverse,signs,lambda_max,zero,zero,stack,policy);
+}
+
+#endif //BT_DYNAMIC_BOUNDING_VOLUME_TREE_WIDE_H
@@ -22,6 +22,9 @@ subject to the following restrictions:
 #include "LinearMath/btAabbUtil2.h"
 
 #include <stdio.h>
+#if defined (BT_USE_SSE)
+#include <xmmintrin.h>
+#endif
 
 int	gOverlappingPairs = 0;
 
@@ -426,6 +429,348 @@ void	btHashedOverlappingPairCache::sortOverlappingPairs(btDispatcher* dispatcher
 }
 
 
+static SIMD_FORCE_INLINE void	btPrefetch(const void* ptr)
+{
+#if defined (BT_USE_SSE)
+	_mm_prefetch(static_cast<const char*>(ptr),_MM_HINT_T0);
+#else
+	(void) ptr;
+#endif
+}
+
+btOpenAddressingPairCache::btOpenAddressingPairCache():
+	m_overlapFilterCallback(0),
+	m_ghostPairCallback(0)
+{
+	int initialAllocatedSize= 2;
+	m_overlappingPairArray.reserve(initialAllocatedSize);
+	growTables(0);
+}
+
+
+
+btOpenAddressingPairCache::~btOpenAddressingPairCache()
+{
+}
+
+
+
+void	btOpenAddressingPairCache::cleanOverlappingPair(btBroadphasePair& pair,btDispatcher* dispatcher)
+{
+	if (pair.m_algorithm && dispatcher)
+	{
+		pair.m_algorithm->~btCollisionAlgorithm();
+		dispatcher->freeCollisionAlgorithm(pair.m_algorithm);
+		pair.m_algorithm=0;
+	}
+}
+
+
+
+void	btOpenAddressingPairCache::cleanProxyFromPairs(btBroadphaseProxy* proxy,btDispatcher* dispatcher)
+{
+	for (int i=0;i<m_overlappingPairArray.size();i++)
+	{
+		btBroadphasePair& pair = m_overlappingPairArray[i];
+		if ((pair.m_pProxy0 == proxy) || (pair.m_pProxy1 == proxy))
+		{
+			cleanOverlappingPair(pair,dispatcher);
+		}
+	}
+}
+
+
+
+void	btOpenAddressingPairCache::removeOverlappingPairsContainingProxy(btBroadphaseProxy* proxy,btDispatcher* dispatcher)
+{
+	// same order of removals as processAllOverlappingPairs with a callback
+	for (int i=0;i<m_overlappingPairArray.size();)
+	{
+		const btBroadphasePair& pair = m_overlappingPairArray[i];
+		if ((pair.m_pProxy0 == proxy) || (pair.m_pProxy1 == proxy))
+		{
+			removeOverlappingPair(pair.m_pProxy0,pair.m_pProxy1,dispatcher);
+			gOverlappingPairs--;
+		} else
+		{
+			i++;
+		}
+	}
+}
+
+
+
+btBroadphasePair* btOpenAddressingPairCache::findPair(btBroadphaseProxy* proxy0, btBroadphaseProxy* proxy1)
+{
+	gFindPairs++;
+	if(proxy0->m_uniqueId>proxy1->m_uniqueId) 
+		btSwap(proxy0,proxy1);
+	const int slot = findSlot(getKey(proxy0,proxy1));
+	if (slot < 0)
+	{
+		return NULL;
+	}
+	return &m_overlappingPairArray[m_pairIndices[slot]];
+}
+
+
+
+void	btOpenAddressingPairCache::growTables(int numPairs)
+{
+	const int needed = m_overlappingPairArray.size()+numPairs;
+	if (needed > m_overlappingPairArray.capacity())
+	{
+		m_overlappingPairArray.reserve(btMax(needed,m_overlappingPairArray.capacity()*2));
+	}
+
+	int newSize = m_keys.size() ? m_keys.size() : 16;
+	while (2*needed > newSize)
+	{
+		newSize *= 2;
+	}
+	if (newSize == m_keys.size())
+	{
+		return;
+	}
+
+	// the pairs know their keys, so the table is filled again from the pair array
+	m_keys.resize(0);
+	m_keys.resize(newSize,0);
+	m_pairIndices.resize(newSize,BT_NULL_PAIR);
+	const int mask = newSize-1;
+	for (int i=0;i<m_overlappingPairArray.size();i++)
+	{
+		const btBroadphasePair& pair = m_overlappingPairArray[i];
+		const unsigned long long key = getKey(pair.m_pProxy0,pair.m_pProxy1);
+		insertSlot(key,i,int(getHash(key)) & mask,0);
+	}
+}
+
+
+
+void	btOpenAddressingPairCache::insertSlot(unsigned long long key,int pairIndex,int slot,int distance)
+{
+	const int mask = m_keys.size()-1;
+	for (;;++distance)
+	{
+		const unsigned long long current = m_keys[slot];
+		if (current == 0)
+		{
+			m_keys[slot] = key;
+			m_pairIndices[slot] = pairIndex;
+			return;
+		}
+		// Robin Hood: the key further from its place takes the slot, the other one moves on
+		const int currentDistance = (slot - int(getHash(current))) & mask;
+		if (currentDistance < distance)
+		{
+			const int currentPairIndex = m_pairIndices[slot];
+			m_keys[slot] = key;
+			m_pairIndices[slot] = pairIndex;
+			key = current;
+			pairIndex = currentPairIndex;
+			distance = currentDistance;
+		}
+		slot = (slot+1) & mask;
+	}
+}
+
+
+
+void	btOpenAddressingPairCache::removeSlot(int slot)
+{
+	// shift the following keys back, so no key is left behind a hole
+	const int mask = m_keys.size()-1;
+	for (;;)
+	{
+		const int next = (slot+1) & mask;
+		const unsigned long long key = m_keys[next];
+		if (key == 0 || ((next - int(getHash(key))) & mask) == 0)
+		{
+			m_keys[slot] = 0;
+			return;
+		}
+		m_keys[slot] = key;
+		m_pairIndices[slot] = m_pairIndices[next];
+		slot = next;
+	}
+}
+
+
+
+btBroadphasePair* btOpenAddressingPairCache::internalAddPair(btBroadphaseProxy* proxy0, btBroadphaseProxy* proxy1)
+{
+	if(proxy0->m_uniqueId>proxy1->m_uniqueId) 
+		btSwap(proxy0,proxy1);
+	const unsigned long long key = getKey(proxy0,proxy1);
+	btAssert(key != 0);
+
+	// look for the pair, and remember where it would go, like findSlot
+	int mask = m_keys.size()-1;
+	int slot = int(getHash(key)) & mask;
+	int distance = 0;
+	for (;;++distance)
+	{
+		const unsigned long long current = m_keys[slot];
+		if (current == key)
+			return &m_overlappingPairArray[m_pairIndices[slot]];
+		if (current == 0 || ((slot - int(getHash(current))) & mask) < distance)
+			break;
+		slot = (slot+1) & mask;
+	}
+
+	int count = m_overlappingPairArray.size();
+	if ((count == m_overlappingPairArray.capacity()) || (2*(count+1) > m_keys.size()))
+	{
+		growTables(1);
+		mask = m_keys.size()-1;
+		slot = int(getHash(key)) & mask;
+		distance = 0;
+	}
+	void* mem = &m_overlappingPairArray.expandNonInitializing();
+
+	//this is where we add an actual pair, so also call the 'ghost'
+	if (m_ghostPairCallback)
+		m_ghostPairCallback->addOverlappingPair(proxy0,proxy1);
+
+	btBroadphasePair* pair = new (mem) btBroadphasePair(*proxy0,*proxy1);
+	pair->m_algorithm = 0;
+	pair->m_internalTmpValue = 0;
+
+	insertSlot(key,count,slot,distance);
+
+	return pair;
+}
+
+
+
+void	btOpenAddressingPairCache::addOverlappingPairs(const btBroadphasePair* pairs,int numPairs)
+{
+	growTables(numPairs);
+	const int ahead = 8;
+	for (int i=0;i<numPairs;i++)
+	{
+		if (i+ahead < numPairs)
+		{
+			const btBroadphasePair& next = pairs[i+ahead];
+			const bool ordered = next.m_pProxy0->m_uniqueId < next.m_pProxy1->m_uniqueId;
+			const unsigned long long key = ordered ? getKey(next.m_pProxy0,next.m_pProxy1) : getKey(next.m_pProxy1,next.m_pProxy0);
+			const int slot = int(getHash(key)) & (m_keys.size()-1);
+			btPrefetch(&m_keys[slot]);
+			btPrefetch(&m_pairIndices[slot]);
+		}
+		addOverlappingPair(pairs[i].m_pProxy0,pairs[i].m_pProxy1);
+	}
+}
+
+
+
+void* btOpenAddressingPairCache::removeOverlappingPair(btBroadphaseProxy* proxy0, btBroadphaseProxy* proxy1,btDispatcher* dispatcher)
+{
+	gRemovePairs++;
+	if(proxy0->m_uniqueId>proxy1->m_uniqueId) 
+		btSwap(proxy0,proxy1);
+
+	const int slot = findSlot(getKey(proxy0,proxy1));
+	if (slot < 0)
+	{
+		return 0;
+	}
+
+	const int pairIndex = m_pairIndices[slot];
+	btBroadphasePair& pair = m_overlappingPairArray[pairIndex];
+	cleanOverlappingPair(pair,dispatcher);
+
+	void* userData = pair.m_internalInfo1;
+
+	removeSlot(slot);
+
+	if (m_ghostPairCallback)
+		m_ghostPairCallback->removeOverlappingPair(proxy0, proxy1,dispatcher);
+
+	// move the last pair into the spot of the removed one, like btHashedOverlappingPairCache
+	const int lastPairIndex = m_overlappingPairArray.size() - 1;
+	if (lastPairIndex != pairIndex)
+	{
+		const btBroadphasePair& last = m_overlappingPairArray[lastPairIndex];
+		const int lastSlot = findSlot(getKey(last.m_pProxy0,last.m_pProxy1));
+		btAssert(lastSlot >= 0);
+		m_pairIndices[lastSlot] = pairIndex;
+		m_overlappingPairArray[pairIndex] = last;
+	}
+	m_overlappingPairArray.pop_back();
+
+	return userData;
+}
+
+
+
+void	btOpenAddressingPairCache::removeOverlappingPairs(const btBroadphasePair* pairs,int numPairs,btDispatcher* dispatcher)
+{
+	const int ahead = 8;
+	for (int i=0;i<numPairs;i++)
+	{
+		if (i+ahead < numPairs)
+		{
+			const btBroadphasePair& next = pairs[i+ahead];
+			const bool ordered = next.m_pProxy0->m_uniqueId < next.m_pProxy1->m_uniqueId;
+			const unsigned long long key = ordered ? getKey(next.m_pProxy0,next.m_pProxy1) : getKey(next.m_pProxy1,next.m_pProxy0);
+			const int slot = int(getHash(key)) & (m_keys.size()-1);
+			btPrefetch(&m_keys[slot]);
+			btPrefetch(&m_pairIndices[slot]);
+		}
+		removeOverlappingPair(pairs[i].m_pProxy0,pairs[i].m_pProxy1,dispatcher);
+	}
+}
+
+
+
+void	btOpenAddressingPairCache::processAllOverlappingPairs(btOverlapCallback* callback,btDispatcher* dispatcher)
+{
+	BT_PROFILE("btOpenAddressingPairCache::processAllOverlappingPairs");
+	int i;
+
+	for (i=0;i<m_overlappingPairArray.size();)
+	{
+		btBroadphasePair* pair = &m_overlappingPairArray[i];
+		if (callback->processOverlap(*pair))
+		{
+			removeOverlappingPair(pair->m_pProxy0,pair->m_pProxy1,dispatcher);
+
+			gOverlappingPairs--;
+		} else
+		{
+			i++;
+		}
+	}
+}
+
+
+
+void	btOpenAddressingPairCache::sortOverlappingPairs(btDispatcher* dispatcher)
+{
+	///remove and add all pairs again like btHashedOverlappingPairCache, so their algorithms are released through the dispatcher
+	btBroadphasePairArray tmpPairs;
+	int i;
+	for (i=0;i<m_overlappingPairArray.size();i++)
+	{
+		tmpPairs.push_back(m_overlappingPairArray[i]);
+	}
+
+	for (i=0;i<tmpPairs.size();i++)
+	{
+		removeOverlappingPair(tmpPairs[i].m_pProxy0,tmpPairs[i].m_pProxy1,dispatcher);
+	}
+
+	tmpPairs.quickSort(btBroadphasePairSortPredicate());
+
+	for (i=0;i<tmpPairs.size();i++)
+	{
+		addOverlappingPair(tmpPairs[i].m_pProxy0,tmpPairs[i].m_pProxy1);
+	}
+}
+
+
 void*	btSortedOverlappingPairCache::removeOverlappingPair(btBroadphaseProxy* proxy0,btBroadphaseProxy* proxy1, btDispatcher* dispatcher )
 {
 	if (!hasDeferredRemoval())
@@ -275,6 +275,167 @@ private:
 
 
 
+///The btOpenAddressingPairCache is a drop-in replacement of the btHashedOverlappingPairCache.
+///It finds pairs in an open addressing table with Robin Hood linear probing, keyed on both proxy uids packed in 64 bits,
+///so a lookup reads a few consecutive keys instead of following the m_hashTable/m_next chain through the pairs and their proxies.
+///The pair array changes in the same way as in the btHashedOverlappingPairCache, so the pairs are in the same order.
+///addOverlappingPairs and removeOverlappingPairs grow the tables once for many pairs, and prefetch the keys ahead.
+///To use it, create one and pass it to the constructor of the broadphase, which leaves deleting it to the caller.
+class btOpenAddressingPairCache : public btOverlappingPairCache
+{
+	btBroadphasePairArray	m_overlappingPairArray;
+	btOverlapFilterCallback* m_overlapFilterCallback;
+
+protected:
+
+	///m_keys and m_pairIndices are the slots of the table, a key of 0 marks an empty slot
+	btAlignedObjectArray<unsigned long long>	m_keys;
+	btAlignedObjectArray<int>	m_pairIndices;
+	btOverlappingPairCallback*	m_ghostPairCallback;
+
+public:
+	btOpenAddressingPairCache();
+	virtual ~btOpenAddressingPairCache();
+
+	void	removeOverlappingPairsContainingProxy(btBroadphaseProxy* proxy,btDispatcher* dispatcher);
+
+	virtual void*	removeOverlappingPair(btBroadphaseProxy* proxy0,btBroadphaseProxy* proxy1,btDispatcher* dispatcher);
+
+	///removes numPairs pairs, the same as calling removeOverlappingPair for each of them in order.
+	///pairs must not point into the overlapping pair array of this cache.
+	void	removeOverlappingPairs(const btBroadphasePair* pairs,int numPairs,btDispatcher* dispatcher);
+
+	SIMD_FORCE_INLINE bool needsBroadphaseCollision(btBroadphaseProxy* proxy0,btBroadphaseProxy* proxy1) const
+	{
+		if (m_overlapFilterCallback)
+			return m_overlapFilterCallback->needBroadphaseCollision(proxy0,proxy1);
+
+		bool collides = (proxy0->m_collisionFilterGroup & proxy1->m_collisionFilterMask) != 0;
+		collides = collides && (proxy1->m_collisionFilterGroup & proxy0->m_collisionFilterMask);
+		
+		return collides;
+	}
+
+	// Add a pair and return the new pair. If the pair already exists,
+	// no new pair is created and the old one is returned.
+	virtual btBroadphasePair* 	addOverlappingPair(btBroadphaseProxy* proxy0,btBroadphaseProxy* proxy1)
+	{
+		gAddedPairs++;
+
+		if (!needsBroadphaseCollision(proxy0,proxy1))
+			return 0;
+
+		return internalAddPair(proxy0,proxy1);
+	}
+
+	///adds numPairs pairs, the same as calling addOverlappingPair for each of them in order.
+	///pairs must not point into the overlapping pair array of this cache.
+	void	addOverlappingPairs(const btBroadphasePair* pairs,int numPairs);
+
+	void	cleanProxyFromPairs(btBroadphaseProxy* proxy,btDispatcher* dispatcher);
+
+	virtual void	processAllOverlappingPairs(btOverlapCallback*,btDispatcher* dispatcher);
+
+	virtual btBroadphasePair*	getOverlappingPairArrayPtr()
+	{
+		return &m_overlappingPairArray[0];
+	}
+
+	const btBroadphasePair*	getOverlappingPairArrayPtr() const
+	{
+		return &m_overlappingPairArray[0];
+	}
+
+	btBroadphasePairArray&	getOverlappingPairArray()
+	{
+		return m_overlappingPairArray;
+	}
+
+	const btBroadphasePairArray&	getOverlappingPairArray() const
+	{
+		return m_overlappingPairArray;
+	}
+
+	void	cleanOverlappingPair(btBroadphasePair& pair,btDispatcher* dispatcher);
+
+	btBroadphasePair* findPair(btBroadphaseProxy* proxy0, btBroadphaseProxy* proxy1);
+
+	btOverlapFilterCallback* getOverlapFilterCallback()
+	{
+		return m_overlapFilterCallback;
+	}
+
+	void setOverlapFilterCallback(btOverlapFilterCallback* callback)
+	{
+		m_overlapFilterCallback = callback;
+	}
+
+	int	getNumOverlappingPairs() const
+	{
+		return m_overlappingPairArray.size();
+	}
+
+	virtual bool	hasDeferredRemoval()
+	{
+		return false;
+	}
+
+	virtual	void	setInternalGhostPairCallback(btOverlappingPairCallback* ghostPairCallback)
+	{
+		m_ghostPairCallback = ghostPairCallback;
+	}
+
+	///sorts the pair array with btBroadphasePairSortPredicate, the pairs are removed and added again, so their collision algorithms are released
+	virtual void	sortOverlappingPairs(btDispatcher* dispatcher);
+
+private:
+
+	btBroadphasePair* 	internalAddPair(btBroadphaseProxy* proxy0,btBroadphaseProxy* proxy1);
+
+	///makes room for numPairs more pairs, keeping the table at most half full
+	void	growTables(int numPairs);
+
+	///inserts from slot on, distance is how far slot is from the place of key
+	void	insertSlot(unsigned long long key,int pairIndex,int slot,int distance);
+
+	void	removeSlot(int slot);
+
+	SIMD_FORCE_INLINE static unsigned long long getKey(const btBroadphaseProxy* proxy0,const btBroadphaseProxy* proxy1)
+	{
+		// proxy0 has the smaller uid, so the key is never 0
+		return (((unsigned long long)(unsigned int)proxy0->getUid())<<32) | (unsigned long long)(unsigned int)proxy1->getUid();
+	}
+
+	SIMD_FORCE_INLINE static unsigned int getHash(unsigned long long key)
+	{
+		// 64 bit finalizer of MurmurHash3
+		key ^= key >> 33;
+		key *= 0xff51afd7ed558ccdULL;
+		key ^= key >> 33;
+		key *= 0xc4ceb9fe1a85ec53ULL;
+		key ^= key >> 33;
+		return static_cast<unsigned int>(key);
+	}
+
+	///returns the slot holding key, or -1
+	SIMD_FORCE_INLINE int	findSlot(unsigned long long key) const
+	{
+		const int mask = m_keys.size()-1;
+		int slot = int(getHash(key)) & mask;
+		for (int distance=0;;++distance)
+		{
+			const unsigned long long current = m_keys[slot];
+			if (current == key)
+				return slot;
+			// a key closer to its own place than we are to ours means the key isn't in the table
+			if (current == 0 || ((slot - int(getHash(current))) & mask) < distance)
+				return -1;
+			slot = (slot+1) & mask;
+		}
+	}
+};
+
+
 
 ///btSortedOverlappingPairCache maintains the objects with overlapping AABB
 ///Typically managed by the Broadphase, Axis3Sweep or btSimpleBroadphase
@@ -70,12 +70,25 @@ btCollisionDispatcher::~btCollisionDispatcher()
 
 btPersistentManifold*	btCollisionDispatcher::getNewManifold(const btCollisionObject* body0,const btCollisionObject* body1) 
 { 
-	gNumManifold++;
-	
 	//btAssert(gNumManifold < 65535);
 	
+	btPersistentManifold* manifold = allocateManifold(body0,body1);
+	if (!manifold)
+		return 0;
+
+	//manifolds added while the array is locked are always on top of the others, and removed again by the same query,
+	//so temporary manifolds of concurrent queries never move the manifolds of the simulation
+	m_manifoldsMutex.lock();
+	gNumManifold++;
+	manifold->m_index1a = m_manifoldsPtr.size();
+	m_manifoldsPtr.push_back(manifold);
+	m_manifoldsMutex.unlock();
 
+	return manifold;
+}
 
+btPersistentManifold*	btCollisionDispatcher::allocateManifold(const btCollisionObject* body0,const btCollisionObject* body1)
+{
 	//optional relative contact breaking threshold, turned on by default (use setDispatcherFlags to switch off feature for improved performance)
 	
 	btScalar contactBreakingThreshold =  (m_dispatcherFlags & btCollisionDispatcher::CD_USE_RELATIVE_CONTACT_BREAKING_THRESHOLD) ? 
@@ -84,12 +97,8 @@ btPersistentManifold*	btCollisionDispatcher::getNewManifold(const btCollisionObj
 
 	btScalar contactProcessingThreshold = btMin(body0->getContactProcessingThreshold(),body1->getContactProcessingThreshold());
 		
- 	void* mem = 0;
-	
-	if (m_persistentManifoldPoolAllocator->getFreeCount())
-	{
-		mem = m_persistentManifoldPoolAllocator->allocate(sizeof(btPersistentManifold));
-	} else
+ 	void* mem = m_persistentManifoldPoolAllocator->allocate(sizeof(btPersistentManifold));
+	if (!mem)
 	{
 		//we got a pool memory overflow, by default we fallback to dynamically allocate memory. If we require a contiguous contact pool then assert.
 		if ((m_dispatcherFlags&CD_DISABLE_CONTACTPOOL_DYNAMIC_ALLOCATION)==0)
@@ -102,11 +111,7 @@ btPersistentManifold*	btCollisionDispatcher::getNewManifold(const btCollisionObj
 			return 0;
 		}
 	}
-	btPersistentManifold* manifold = new(mem) btPersistentManifold (body0,body1,0,contactBreakingThreshold,contactProcessingThreshold);
-	manifold->m_index1a = m_manifoldsPtr.size();
-	m_manifoldsPtr.push_back(manifold);
-
-	return manifold;
+	return new(mem) btPersistentManifold (body0,body1,0,contactBreakingThreshold,contactProcessingThreshold);
 }
 
 void btCollisionDispatcher::clearManifold(btPersistentManifold* manifold)
@@ -118,17 +123,23 @@ void btCollisionDispatcher::clearManifold(btPersistentManifold* manifold)
 void btCollisionDispatcher::releaseManifold(btPersistentManifold* manifold)
 {
 	
-	gNumManifold--;
-
 	//printf("releaseManifold: gNumManifold %d\n",gNumManifold);
 	clearManifold(manifold);
 
+	m_manifoldsMutex.lock();
+	gNumManifold--;
 	int findIndex = manifold->m_index1a;
 	btAssert(findIndex < m_manifoldsPtr.size());
 	m_manifoldsPtr.swap(findIndex,m_manifoldsPtr.size()-1);
 	m_manifoldsPtr[findIndex]->m_index1a = findIndex;
 	m_manifoldsPtr.pop_back();
+	m_manifoldsMutex.unlock();
+
+	freeManifold(manifold);
+}
 
+void btCollisionDispatcher::freeManifold(btPersistentManifold* manifold)
+{
 	manifold->~btPersistentManifold();
 	if (m_persistentManifoldPoolAllocator->validPtr(manifold))
 	{
@@ -137,7 +148,6 @@ void btCollisionDispatcher::releaseManifold(btPersistentManifold* manifold)
 	{
 		btAlignedFree(manifold);
 	}
-	
 }
 
 	
@@ -294,9 +304,10 @@ void btCollisionDispatcher::defaultNearCallback(btBroadphasePair& collisionPair,
 
 void* btCollisionDispatcher::allocateCollisionAlgorithm(int size)
 {
-	if (m_collisionAlgorithmPoolAllocator->getFreeCount())
+	void* mem = m_collisionAlgorithmPoolAllocator->allocate(size);
+	if (mem)
 	{
-		return m_collisionAlgorithmPoolAllocator->allocate(size);
+		return mem;
 	}
 	
 	//warn user for overflow?
@@ -23,6 +23,7 @@ subject to the following restrictions:
 
 #include "BulletCollision/BroadphaseCollision/btBroadphaseProxy.h"
 #include "LinearMath/btAlignedObjectArray.h"
+#include "LinearMath/btThreads.h"
 
 class btIDebugDraw;
 class btOverlappingPairCache;
@@ -49,6 +50,9 @@ protected:
 
 	btAlignedObjectArray<btPersistentManifold*>	m_manifoldsPtr;
 
+	///guards m_manifoldsPtr, so queries like btCollisionWorld::contactTestBatch can create temporary manifolds from several threads
+	btSpinMutex	m_manifoldsMutex;
+
 	btManifoldResult	m_defaultManifoldResult;
 
 	btNearCallback		m_nearCallback;
@@ -61,6 +65,12 @@ protected:
 
 	btCollisionConfiguration*	m_collisionConfiguration;
 
+	///creates a manifold without adding it to the manifold array
+	btPersistentManifold*	allocateManifold(const btCollisionObject* b0,const btCollisionObject* b1);
+
+	///destroys a manifold that isn't in the manifold array
+	void	freeManifold(btPersistentManifold* manifold);
+
 
 public:
 
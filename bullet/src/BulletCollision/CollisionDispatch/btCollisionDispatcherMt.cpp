@@ -0,0 +1,161 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2014 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include "btCollisionDispatcherMt.h"
+#include "BulletCollision/BroadphaseCollision/btOverlappingPairCache.h"
+#include "LinearMath/btQuickprof.h"
+
+extern int gNumManifold;
+
+
+btCollisionDispatcherMt::btCollisionDispatcherMt(btCollisionConfiguration* collisionConfiguration, int grainSize)
+	:btCollisionDispatcher(collisionConfiguration),
+	m_batchUpdating(false),
+	m_grainSize(grainSize)
+{
+	for (unsigned int i = 0; i < BT_MAX_THREAD_COUNT; ++i)
+	{
+		m_threadEvents[i].m_pairIndex = 0;
+		m_threadEvents[i].m_sequence = 0;
+	}
+}
+
+void btCollisionDispatcherMt::addEvent(btPersistentManifold* manifold, bool release)
+{
+	ThreadEvents& thread = m_threadEvents[btGetCurrentThreadIndex()];
+	ManifoldEvent event;
+	event.m_pairIndex = thread.m_pairIndex;
+	event.m_sequence = thread.m_sequence++;
+	event.m_manifold = manifold;
+	event.m_release = release;
+	thread.m_events.push_back(event);
+}
+
+btPersistentManifold* btCollisionDispatcherMt::getNewManifold(const btCollisionObject* body0,const btCollisionObject* body1)
+{
+	if (!m_batchUpdating)
+		return btCollisionDispatcher::getNewManifold(body0,body1);
+
+	btPersistentManifold* manifold = allocateManifold(body0,body1);
+	if (manifold)
+		addEvent(manifold,false);
+	return manifold;
+}
+
+void btCollisionDispatcherMt::releaseManifold(btPersistentManifold* manifold)
+{
+	if (!m_batchUpdating)
+	{
+		btCollisionDispatcher::releaseManifold(manifold);
+		return;
+	}
+	// the manifold stays in the manifold array until the events are applied
+	clearManifold(manifold);
+	addEvent(manifold,true);
+}
+
+
+struct btManifoldEventSortPredicate
+{
+	bool operator() (const btCollisionDispatcherMt::ManifoldEvent& a, const btCollisionDispatcherMt::ManifoldEvent& b) const
+	{
+		if (a.m_pairIndex != b.m_pairIndex)
+			return a.m_pairIndex < b.m_pairIndex;
+		return a.m_sequence < b.m_sequence;
+	}
+};
+
+void btCollisionDispatcherMt::applyEvents()
+{
+	m_sortedEvents.resize(0);
+	for (unsigned int i = 0; i < BT_MAX_THREAD_COUNT; ++i)
+	{
+		btAlignedObjectArray<ManifoldEvent>& events = m_threadEvents[i].m_events;
+		for (int j = 0; j < events.size(); ++j)
+			m_sortedEvents.push_back(events[j]);
+		events.resize(0);
+	}
+	if (m_sortedEvents.size() == 0)
+		return;
+
+	// replaying the events in pair order gives the manifold array of the serial dispatcher
+	m_sortedEvents.quickSort(btManifoldEventSortPredicate());
+	for (int i = 0; i < m_sortedEvents.size(); ++i)
+	{
+		btPersistentManifold* manifold = m_sortedEvents[i].m_manifold;
+		if (!m_sortedEvents[i].m_release)
+		{
+			gNumManifold++;
+			manifold->m_index1a = m_manifoldsPtr.size();
+			m_manifoldsPtr.push_back(manifold);
+		} else
+		{
+			gNumManifold--;
+			int findIndex = manifold->m_index1a;
+			btAssert(findIndex < m_manifoldsPtr.size());
+			m_manifoldsPtr.swap(findIndex,m_manifoldsPtr.size()-1);
+			m_manifoldsPtr[findIndex]->m_index1a = findIndex;
+			m_manifoldsPtr.pop_back();
+			freeManifold(manifold);
+		}
+	}
+}
+
+
+struct btCollisionDispatcherMtNearCallbackLoop : public btIParallelForBody
+{
+	btCollisionDispatcherMt* m_dispatcher;
+	btBroadphasePair* m_pairs;
+	const btDispatcherInfo* m_dispatchInfo;
+
+	void forLoop(int iBegin, int iEnd) const
+	{
+		btCollisionDispatcherMt::ThreadEvents& thread = m_dispatcher->m_threadEvents[btGetCurrentThreadIndex()];
+		btNearCallback nearCallback = m_dispatcher->getNearCallback();
+		for (int i = iBegin; i < iEnd; ++i)
+		{
+			thread.m_pairIndex = i;
+			thread.m_sequence = 0;
+			(*nearCallback)(m_pairs[i],*m_dispatcher,*m_dispatchInfo);
+		}
+	}
+};
+
+void	btCollisionDispatcherMt::dispatchAllCollisionPairs(btOverlappingPairCache* pairCache,const btDispatcherInfo& dispatchInfo,btDispatcher* dispatcher)
+{
+	// the time of impact is a minimum over all pairs, written by the near callback without synchronization
+	if (dispatchInfo.m_dispatchFunc != btDispatcherInfo::DISPATCH_DISCRETE)
+	{
+		btCollisionDispatcher::dispatchAllCollisionPairs(pairCache,dispatchInfo,dispatcher);
+		return;
+	}
+
+	BT_PROFILE("btCollisionDispatcherMt::dispatchAllCollisionPairs");
+	const int numPairs = pairCache->getNumOverlappingPairs();
+	if (numPairs == 0)
+		return;
+
+	btCollisionDispatcherMtNearCallbackLoop loop;
+	loop.m_dispatcher = this;
+	loop.m_pairs = pairCache->getOverlappingPairArrayPtr();
+	loop.m_dispatchInfo = &dispatchInfo;
+
+	m_batchUpdating = true;
+	btParallelFor(0,numPairs,m_grainSize,loop);
+	m_batchUpdating = false;
+
+	applyEvents();
+}
@@ -0,0 +1,80 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2014 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_COLLISION_DISPATCHER_MT_H
+#define BT_COLLISION_DISPATCHER_MT_H
+
+#include "btCollisionDispatcher.h"
+#include "LinearMath/btThreads.h"
+
+
+///btCollisionDispatcherMt runs the near callback of the overlapping pairs in parallel on the task scheduler of btParallelFor.
+///Manifolds created or released by the collision algorithms are recorded per thread and applied to the manifold array
+///in pair order after the loop, so the manifold array, and the simulation, don't depend on the number of threads.
+///The near callback, gContactAddedCallback and friends run on worker threads and must be thread safe,
+///the same holds for custom collision algorithms and shapes (for example btGImpactMeshShape isn't).
+///Continuous dispatch (DISPATCH_CONTINUOUS) runs serially.
+class btCollisionDispatcherMt : public btCollisionDispatcher
+{
+	struct ManifoldEvent
+	{
+		int m_pairIndex;
+		int m_sequence;
+		btPersistentManifold* m_manifold;
+		bool m_release;
+	};
+
+	struct ThreadEvents
+	{
+		btAlignedObjectArray<ManifoldEvent> m_events;
+		int m_pairIndex;
+		int m_sequence;
+		char m_padding[64]; // keeps the threads off each other's cache lines
+	};
+
+	ThreadEvents m_threadEvents[BT_MAX_THREAD_COUNT];
+	btAlignedObjectArray<ManifoldEvent> m_sortedEvents;
+	bool m_batchUpdating;
+	int m_grainSize;
+
+	friend struct btCollisionDispatcherMtNearCallbackLoop;
+	friend struct btManifoldEventSortPredicate;
+
+	void addEvent(btPersistentManifold* manifold, bool release);
+	void applyEvents();
+
+public:
+
+	///grainSize is the smallest number of pairs handed to a thread at once
+	btCollisionDispatcherMt(btCollisionConfiguration* collisionConfiguration, int grainSize = 40);
+
+	virtual btPersistentManifold*	getNewManifold(const btCollisionObject* b0,const btCollisionObject* b1);
+
+	virtual void releaseManifold(btPersistentManifold* manifold);
+
+	virtual void	dispatchAllCollisionPairs(btOverlappingPairCache* pairCache,const btDispatcherInfo& dispatchInfo,btDispatcher* dispatcher);
+
+	int getGrainSize() const
+	{
+		return m_grainSize;
+	}
+
+	void setGrainSize(int grainSize)
+	{
+		m_grainSize = grainSize;
+	}
+};
+
+#endif //BT_COLLISION_DISPATCHER_MT_H
@@ -29,9 +29,11 @@ subject to the following restrictions:
 #include "BulletCollision/BroadphaseCollision/btCollisionAlgorithm.h"
 #include "BulletCollision/BroadphaseCollision/btBroadphaseInterface.h"
 #include "BulletCollision/BroadphaseCollision/btDbvt.h"
+#include "BulletCollision/BroadphaseCollision/btDbvtWide.h"
 #include "LinearMath/btAabbUtil2.h"
 #include "LinearMath/btQuickprof.h"
 #include "LinearMath/btSerializer.h"
+#include "LinearMath/btThreads.h"
 #include "BulletCollision/CollisionShapes/btConvexPolyhedron.h"
 #include "BulletCollision/CollisionDispatch/btCollisionObjectWrapper.h"
 
@@ -66,11 +68,22 @@ subject to the following restrictions:
 
 
 
+///btContactTestBatchScratch holds the contact points each thread found during contactTestBatch, until they are merged in query order
+struct btContactTestBatchScratch
+{
+	btAlignedObjectArray<btCollisionWorld::ContactHit>	m_threadHits[BT_MAX_THREAD_COUNT];
+	btAlignedObjectArray<int>	m_queryThread;
+	btAlignedObjectArray<int>	m_queryBegin;
+	btAlignedObjectArray<int>	m_queryCount;
+};
+
+
 btCollisionWorld::btCollisionWorld(btDispatcher* dispatcher,btBroadphaseInterface* pairCache, btCollisionConfiguration* collisionConfiguration)
 :m_dispatcher1(dispatcher),
 m_broadphasePairCache(pairCache),
 m_debugDrawer(0),
-m_forceUpdateAllAabbs(true)
+m_forceUpdateAllAabbs(true),
+m_contactTestBatchScratch(0)
 {
 }
 
@@ -96,7 +109,11 @@ btCollisionWorld::~btCollisionWorld()
 		}
 	}
 
-
+	if (m_contactTestBatchScratch)
+	{
+		m_contactTestBatchScratch->~btContactTestBatchScratch();
+		btAlignedFree(m_contactTestBatchScratch);
+	}
 }
 
 
@@ -144,16 +161,15 @@ void	btCollisionWorld::addCollisionObject(btCollisionObject* collisionObject,sho
 
 
 
-void	btCollisionWorld::updateSingleAabb(btCollisionObject* colObj)
+static void	computeObjectAabb(const btCollisionObject* colObj, bool useContinuous, btVector3& minAabb, btVector3& maxAabb)
 {
-	btVector3 minAabb,maxAabb;
 	colObj->getCollisionShape()->getAabb(colObj->getWorldTransform(), minAabb,maxAabb);
 	//need to increase the aabb for contact thresholds
 	btVector3 contactThreshold(gContactBreakingThreshold,gContactBreakingThreshold,gContactBreakingThreshold);
 	minAabb -= contactThreshold;
 	maxAabb += contactThreshold;
 
-	if(getDispatchInfo().m_useContinuous && colObj->getInternalType()==btCollisionObject::CO_RIGID_BODY && !colObj->isStaticOrKinematicObject())
+	if(useContinuous && colObj->getInternalType()==btCollisionObject::CO_RIGID_BODY && !colObj->isStaticOrKinematicObject())
 	{
 		btVector3 minAabb2,maxAabb2;
 		colObj->getCollisionShape()->getAabb(colObj->getInterpolationWorldTransform(),minAabb2,maxAabb2);
@@ -162,46 +178,100 @@ void	btCollisionWorld::updateSingleAabb(btCollisionObject* colObj)
 		minAabb.setMin(minAabb2);
 		maxAabb.setMax(maxAabb2);
 	}
+}
+
+//moving objects should be moderately sized, probably something wrong if not
+static bool	checkObjectAabb(btCollisionObject* colObj, const btVector3& minAabb, const btVector3& maxAabb, btIDebugDraw* debugDrawer)
+{
+	if ( colObj->isStaticObject() || ((maxAabb-minAabb).length2() < btScalar(1e12)))
+		return true;
+
+	//something went wrong, investigate
+	//this assert is unwanted in 3D modelers (danger of loosing work)
+	colObj->setActivationState(DISABLE_SIMULATION);
+
+	static bool reportMe = true;
+	if (reportMe && debugDrawer)
+	{
+		reportMe = false;
+		debugDrawer->reportErrorWarning("Overflow in AABB, object removed from simulation");
+		debugDrawer->reportErrorWarning("If you can reproduce this, please email bugs@continuousphysics.com\n");
+		debugDrawer->reportErrorWarning("Please include above information, your Platform, version of OS.\n");
+		debugDrawer->reportErrorWarning("Thanks.\n");
+	}
+	return false;
+}
+
+void	btCollisionWorld::updateSingleAabb(btCollisionObject* colObj)
+{
+	btVector3 minAabb,maxAabb;
+	computeObjectAabb(colObj,getDispatchInfo().m_useContinuous,minAabb,maxAabb);
 
 	btBroadphaseInterface* bp = (btBroadphaseInterface*)m_broadphasePairCache;
 
-	//moving objects should be moderately sized, probably something wrong if not
-	if ( colObj->isStaticObject() || ((maxAabb-minAabb).length2() < btScalar(1e12)))
+	if (checkObjectAabb(colObj,minAabb,maxAabb,m_debugDrawer))
 	{
 		bp->setAabb(colObj->getBroadphaseHandle(),minAabb,maxAabb, m_dispatcher1);
-	} else
-	{
-		//something went wrong, investigate
-		//this assert is unwanted in 3D modelers (danger of loosing work)
-		colObj->setActivationState(DISABLE_SIMULATION);
+	}
+}
 
-		static bool reportMe = true;
-		if (reportMe && m_debugDrawer)
+///computes the aabbs of the collision objects, slot i of the output belongs to object i
+struct btUpdateAabbsLoop : public btIParallelForBody
+{
+	btCollisionObject* const*	m_collisionObjects;
+	btVector3*	m_aabbMins;
+	btVector3*	m_aabbMaxs;
+	bool	m_useContinuous;
+	bool	m_forceUpdateAllAabbs;
+
+	void forLoop(int iBegin, int iEnd) const
+	{
+		for (int i = iBegin; i < iEnd; ++i)
 		{
-			reportMe = false;
-			m_debugDrawer->reportErrorWarning("Overflow in AABB, object removed from simulation");
-			m_debugDrawer->reportErrorWarning("If you can reproduce this, please email bugs@continuousphysics.com\n");
-			m_debugDrawer->reportErrorWarning("Please include above information, your Platform, version of OS.\n");
-			m_debugDrawer->reportErrorWarning("Thanks.\n");
+			const btCollisionObject* colObj = m_collisionObjects[i];
+			if (m_forceUpdateAllAabbs || colObj->isActive())
+			{
+				computeObjectAabb(colObj,m_useContinuous,m_aabbMins[i],m_aabbMaxs[i]);
+			}
 		}
 	}
-}
+};
 
 void	btCollisionWorld::updateAabbs()
 {
 	BT_PROFILE("updateAabbs");
 
-	btTransform predictedTrans;
-	for ( int i=0;i<m_collisionObjects.size();i++)
+	const int numObjects = m_collisionObjects.size();
+	if (numObjects == 0)
+		return;
+	m_updateAabbProxies.resize(numObjects);
+	m_updateAabbMins.resize(numObjects);
+	m_updateAabbMaxs.resize(numObjects);
+
+	btUpdateAabbsLoop loop;
+	loop.m_collisionObjects = &m_collisionObjects[0];
+	loop.m_aabbMins = &m_updateAabbMins[0];
+	loop.m_aabbMaxs = &m_updateAabbMaxs[0];
+	loop.m_useContinuous = getDispatchInfo().m_useContinuous;
+	loop.m_forceUpdateAllAabbs = m_forceUpdateAllAabbs;
+	btParallelFor(0, numObjects, 256, loop);
+
+	//compact the aabbs of the objects to update, in the order of the objects
+	int numProxies = 0;
+	for ( int i=0;i<numObjects;i++)
 	{
 		btCollisionObject* colObj = m_collisionObjects[i];
 
 		//only update aabb of active objects
-		if (m_forceUpdateAllAabbs || colObj->isActive())
+		if ((m_forceUpdateAllAabbs || colObj->isActive()) && checkObjectAabb(colObj,m_updateAabbMins[i],m_updateAabbMaxs[i],m_debugDrawer))
 		{
-			updateSingleAabb(colObj);
+			m_updateAabbProxies[numProxies] = colObj->getBroadphaseHandle();
+			m_updateAabbMins[numProxies] = m_updateAabbMins[i];
+			m_updateAabbMaxs[numProxies] = m_updateAabbMaxs[i];
+			numProxies++;
 		}
 	}
+	m_broadphasePairCache->setAabbs(&m_updateAabbProxies[0],&m_updateAabbMins[0],&m_updateAabbMaxs[0],numProxies,m_dispatcher1);
 }
 
 
@@ -554,7 +624,11 @@ void	btCollisionWorld::rayTestSingleInternal(const btTransform& rayFromTrans,con
 				{
 					btVector3 localRayFrom = colObjWorldTransform.inverseTimes(rayFromTrans).getOrigin();
 					btVector3 localRayTo = colObjWorldTransform.inverseTimes(rayToTrans).getOrigin();
-					btDbvt::rayTest(dbvt->m_root, localRayFrom , localRayTo, rayCB);
+					const btDbvtWide* wideTree = compoundShape->getWideAabbTree();
+					if (wideTree)
+						wideTree->rayTest(localRayFrom , localRayTo, rayCB);
+					else
+						btDbvt::rayTest(dbvt->m_root, localRayFrom , localRayTo, rayCB);
 				}
 				else
 #endif //DISABLE_DBVT_COMPOUNDSHAPE_RAYCAST_ACCELERATION
@@ -891,7 +965,13 @@ void	btCollisionWorld::objectQuerySingleInternal(const btConvexShape* castShape,
 					  allowedPenetration, compoundShape, colObjWorldTransform, resultCallback);
 
 				const btDbvt* tree = compoundShape->getDynamicAabbTree();
-				if (tree) {
+				const btDbvtWide* wideTree = compoundShape->getWideAabbTree();
+				if (wideTree) {
+					const ATTRIBUTE_ALIGNED16(btDbvtVolume)	bounds = btDbvtVolume::FromMM(fromLocalAabbMin, fromLocalAabbMax);
+					btAlignedObjectArray<int> stack;
+					stack.reserve(btDbvt::SIMPLE_STACKSIZE);
+					wideTree->collideTV(bounds, stack, callback);
+				} else if (tree) {
 					const ATTRIBUTE_ALIGNED16(btDbvtVolume)	bounds = btDbvtVolume::FromMM(fromLocalAabbMin, fromLocalAabbMax);
 					tree->collideTV(tree->m_root, bounds, callback);
 				} else {
@@ -1006,6 +1086,161 @@ void	btCollisionWorld::rayTest(const btVector3& rayFromWorld, const btVector3& r
 }
 
 
+///btBatchRayResultCallback stores the closest hit like ClosestRayResultCallback, straight into the results of rayTestBatch
+struct btBatchRayResultCallback : public btCollisionWorld::RayResultCallback
+{
+	btVector3	m_rayFromWorld;
+	btVector3	m_rayToWorld;
+	btCollisionWorld::ClosestRayHit*	m_hit;
+
+	virtual	btScalar	addSingleResult(btCollisionWorld::LocalRayResult& rayResult,bool normalInWorldSpace)
+	{
+		//caller already does the filter on the m_closestHitFraction
+		btAssert(rayResult.m_hitFraction <= m_closestHitFraction);
+
+		m_closestHitFraction = rayResult.m_hitFraction;
+		m_collisionObject = rayResult.m_collisionObject;
+		m_hit->m_collisionObject = m_collisionObject;
+		m_hit->m_hitFraction = m_closestHitFraction;
+		if (normalInWorldSpace)
+		{
+			m_hit->m_hitNormalWorld = rayResult.m_hitNormalLocal;
+		} else
+		{
+			///need to transform normal into worldspace
+			m_hit->m_hitNormalWorld = m_collisionObject->getWorldTransform().getBasis()*rayResult.m_hitNormalLocal;
+		}
+		m_hit->m_hitPointWorld.setInterpolate3(m_rayFromWorld,m_rayToWorld,rayResult.m_hitFraction);
+		return rayResult.m_hitFraction;
+	}
+};
+
+///btBatchRayCallback is the btSingleRayCallback of a ray of rayTestBatch.
+///After each hit it shortens the ray to the closest hit, so the broadphase skips the nodes behind it.
+struct btBatchRayCallback : public btBroadphaseRayCallback
+{
+	btTransform	m_rayFromTrans;
+	btTransform	m_rayToTrans;
+	btScalar	m_rayLength;
+	const btCollisionWorld*	m_world;
+	btBatchRayResultCallback	m_resultCallback;
+
+	void	init(const btVector3& rayFromWorld,const btVector3& rayToWorld,const btCollisionWorld* world,short int collisionFilterGroup,short int collisionFilterMask,btCollisionWorld::ClosestRayHit* hit)
+	{
+		m_rayFromTrans.setIdentity();
+		m_rayFromTrans.setOrigin(rayFromWorld);
+		m_rayToTrans.setIdentity();
+		m_rayToTrans.setOrigin(rayToWorld);
+		m_world = world;
+
+		btVector3 rayDir = (rayToWorld-rayFromWorld);
+
+		rayDir.normalize ();
+		///what about division by zero? --> just set rayDirection[i] to INF/BT_LARGE_FLOAT
+		m_rayDirectionInverse[0] = rayDir[0] == btScalar(0.0) ? btScalar(BT_LARGE_FLOAT) : btScalar(1.0) / rayDir[0];
+		m_rayDirectionInverse[1] = rayDir[1] == btScalar(0.0) ? btScalar(BT_LARGE_FLOAT) : btScalar(1.0) / rayDir[1];
+		m_rayDirectionInverse[2] = rayDir[2] == btScalar(0.0) ? btScalar(BT_LARGE_FLOAT) : btScalar(1.0) / rayDir[2];
+		m_signs[0] = m_rayDirectionInverse[0] < 0.0;
+		m_signs[1] = m_rayDirectionInverse[1] < 0.0;
+		m_signs[2] = m_rayDirectionInverse[2] < 0.0;
+
+		m_lambda_max = rayDir.dot(rayToWorld-rayFromWorld);
+		m_rayLength = m_lambda_max;
+
+		m_resultCallback.m_closestHitFraction = btScalar(1.);
+		m_resultCallback.m_collisionObject = 0;
+		m_resultCallback.m_collisionFilterGroup = collisionFilterGroup;
+		m_resultCallback.m_collisionFilterMask = collisionFilterMask;
+		m_resultCallback.m_rayFromWorld = rayFromWorld;
+		m_resultCallback.m_rayToWorld = rayToWorld;
+		m_resultCallback.m_hit = hit;
+		hit->m_collisionObject = 0;
+		hit->m_hitFraction = btScalar(1.);
+	}
+
+	virtual bool	process(const btBroadphaseProxy* proxy)
+	{
+		///terminate further ray tests, once the closestHitFraction reached zero
+		if (m_resultCallback.m_closestHitFraction == btScalar(0.f))
+			return false;
+
+		btCollisionObject*	collisionObject = (btCollisionObject*)proxy->m_clientObject;
+
+		//only perform raycast if filterMask matches
+		if(m_resultCallback.needsCollision(collisionObject->getBroadphaseHandle()))
+		{
+			m_world->rayTestSingle(m_rayFromTrans,m_rayToTrans,
+				collisionObject,
+				collisionObject->getCollisionShape(),
+				collisionObject->getWorldTransform(),
+				m_resultCallback);
+			m_lambda_max = m_rayLength*m_resultCallback.m_closestHitFraction;
+		}
+		return true;
+	}
+};
+
+///rays of rayTestBatch traversing the broadphase together
+#define BT_RAY_PACKET_SIZE 16
+
+struct btRayTestBatchLoop : public btIParallelForBody
+{
+	const btCollisionWorld* m_world;
+	btBroadphaseInterface* m_broadphase;
+	const btVector3* m_rayFromWorld;
+	const btVector3* m_rayToWorld;
+	const short int* m_collisionFilterMasks;
+	btCollisionWorld::ClosestRayHit* m_results;
+	int m_numRays;
+	short int m_collisionFilterGroup;
+
+	void forLoop(int iBegin, int iEnd) const
+	{
+		btBatchRayCallback rays[BT_RAY_PACKET_SIZE];
+		btBroadphaseRayCallback* rayCallbacks[BT_RAY_PACKET_SIZE];
+		for (int packet = iBegin; packet < iEnd; ++packet)
+		{
+			const int begin = packet*BT_RAY_PACKET_SIZE;
+			const int count = btMin(m_numRays-begin, int(BT_RAY_PACKET_SIZE));
+			for (int i = 0; i < count; ++i)
+			{
+				const short int mask = m_collisionFilterMasks ? m_collisionFilterMasks[begin+i] : short(btBroadphaseProxy::AllFilter);
+				rays[i].init(m_rayFromWorld[begin+i],m_rayToWorld[begin+i],m_world,m_collisionFilterGroup,mask,&m_results[begin+i]);
+				rayCallbacks[i] = &rays[i];
+			}
+#ifndef USE_BRUTEFORCE_RAYBROADPHASE
+			m_broadphase->rayTestPacket(m_rayFromWorld+begin,m_rayToWorld+begin,rayCallbacks,count);
+#else
+			for (int i = 0; i < count; ++i)
+			{
+				for (int j=0;j<m_world->getNumCollisionObjects();j++)
+				{
+					if (!rays[i].process(m_world->getCollisionObjectArray()[j]->getBroadphaseHandle()))
+						break;
+				}
+			}
+#endif //USE_BRUTEFORCE_RAYBROADPHASE
+		}
+	}
+};
+
+void	btCollisionWorld::rayTestBatch(const btVector3* rayFromWorld, const btVector3* rayToWorld, const short int* collisionFilterMasks, ClosestRayHit* results, int numRays, short int collisionFilterGroup) const
+{
+	BT_PROFILE("rayTestBatch");
+	btRayTestBatchLoop loop;
+	loop.m_world = this;
+	loop.m_broadphase = m_broadphasePairCache;
+	loop.m_rayFromWorld = rayFromWorld;
+	loop.m_rayToWorld = rayToWorld;
+	loop.m_collisionFilterMasks = collisionFilterMasks;
+	loop.m_results = results;
+	loop.m_numRays = numRays;
+	loop.m_collisionFilterGroup = collisionFilterGroup;
+	const int numPackets = (numRays+BT_RAY_PACKET_SIZE-1)/BT_RAY_PACKET_SIZE;
+	btParallelFor(0, numPackets, 4, loop);
+}
+
+
 struct btSingleSweepCallback : public btBroadphaseRayCallback
 {
 
@@ -1127,6 +1362,183 @@ void	btCollisionWorld::convexSweepTest(const btConvexShape* castShape, const btT
 }
 
 
+///btBatchConvexResultCallback stores the closest hit like ClosestConvexResultCallback, straight into the results of convexSweepTestBatch
+struct btBatchConvexResultCallback : public btCollisionWorld::ConvexResultCallback
+{
+	btCollisionWorld::ClosestConvexHit*	m_hit;
+
+	virtual	btScalar	addSingleResult(btCollisionWorld::LocalConvexResult& convexResult,bool normalInWorldSpace)
+	{
+		//caller already does the filter on the m_closestHitFraction
+		btAssert(convexResult.m_hitFraction <= m_closestHitFraction);
+
+		m_closestHitFraction = convexResult.m_hitFraction;
+		m_hit->m_collisionObject = convexResult.m_hitCollisionObject;
+		m_hit->m_hitFraction = m_closestHitFraction;
+		if (normalInWorldSpace)
+		{
+			m_hit->m_hitNormalWorld = convexResult.m_hitNormalLocal;
+		} else
+		{
+			///need to transform normal into worldspace
+			m_hit->m_hitNormalWorld = convexResult.m_hitCollisionObject->getWorldTransform().getBasis()*convexResult.m_hitNormalLocal;
+		}
+		m_hit->m_hitPointWorld = convexResult.m_hitPointLocal;
+		return convexResult.m_hitFraction;
+	}
+};
+
+///btBatchSweepCallback is the btSingleSweepCallback of a sweep of convexSweepTestBatch.
+///Unlike btBatchRayCallback it keeps the full sweep length, the same as convexSweepTest.
+struct btBatchSweepCallback : public btBroadphaseRayCallback
+{
+	btTransform	m_convexFromTrans;
+	btTransform	m_convexToTrans;
+	const btCollisionWorld*	m_world;
+	btScalar	m_allowedCcdPenetration;
+	const btConvexShape* m_castShape;
+	btBatchConvexResultCallback	m_resultCallback;
+
+	void	init(const btConvexShape* castShape,const btTransform& convexFromTrans,const btTransform& convexToTrans,const btCollisionWorld* world,short int collisionFilterGroup,short int collisionFilterMask,btScalar allowedPenetration,btCollisionWorld::ClosestConvexHit* hit)
+	{
+		m_convexFromTrans = convexFromTrans;
+		m_convexToTrans = convexToTrans;
+		m_world = world;
+		m_allowedCcdPenetration = allowedPenetration;
+		m_castShape = castShape;
+
+		btVector3 unnormalizedRayDir = (m_convexToTrans.getOrigin()-m_convexFromTrans.getOrigin());
+		btVector3 rayDir = unnormalizedRayDir.normalized();
+		///what about division by zero? --> just set rayDirection[i] to INF/BT_LARGE_FLOAT
+		m_rayDirectionInverse[0] = rayDir[0] == btScalar(0.0) ? btScalar(BT_LARGE_FLOAT) : btScalar(1.0) / rayDir[0];
+		m_rayDirectionInverse[1] = rayDir[1] == btScalar(0.0) ? btScalar(BT_LARGE_FLOAT) : btScalar(1.0) / rayDir[1];
+		m_rayDirectionInverse[2] = rayDir[2] == btScalar(0.0) ? btScalar(BT_LARGE_FLOAT) : btScalar(1.0) / rayDir[2];
+		m_signs[0] = m_rayDirectionInverse[0] < 0.0;
+		m_signs[1] = m_rayDirectionInverse[1] < 0.0;
+		m_signs[2] = m_rayDirectionInverse[2] < 0.0;
+
+		m_lambda_max = rayDir.dot(unnormalizedRayDir);
+
+		m_resultCallback.m_closestHitFraction = btScalar(1.);
+		m_resultCallback.m_collisionFilterGroup = collisionFilterGroup;
+		m_resultCallback.m_collisionFilterMask = collisionFilterMask;
+		m_resultCallback.m_hit = hit;
+		hit->m_collisionObject = 0;
+		hit->m_hitFraction = btScalar(1.);
+	}
+
+	virtual bool	process(const btBroadphaseProxy* proxy)
+	{
+		///terminate further convex sweep tests, once the closestHitFraction reached zero
+		if (m_resultCallback.m_closestHitFraction == btScalar(0.f))
+			return false;
+
+		btCollisionObject*	collisionObject = (btCollisionObject*)proxy->m_clientObject;
+
+		//only perform raycast if filterMask matches
+		if(m_resultCallback.needsCollision(collisionObject->getBroadphaseHandle()))
+		{
+			m_world->objectQuerySingle(m_castShape, m_convexFromTrans,m_convexToTrans,
+				collisionObject,
+				collisionObject->getCollisionShape(),
+				collisionObject->getWorldTransform(),
+				m_resultCallback,
+				m_allowedCcdPenetration);
+		}
+		return true;
+	}
+};
+
+struct btConvexSweepTestBatchLoop : public btIParallelForBody
+{
+	const btCollisionWorld* m_world;
+	btBroadphaseInterface* m_broadphase;
+	const btConvexShape* const* m_castShapes;
+	const btTransform* m_convexFromWorld;
+	const btTransform* m_convexToWorld;
+	const short int* m_collisionFilterMasks;
+	btCollisionWorld::ClosestConvexHit* m_results;
+	int m_numSweeps;
+	btScalar m_allowedCcdPenetration;
+	short int m_collisionFilterGroup;
+
+	void forLoop(int iBegin, int iEnd) const
+	{
+		btBatchSweepCallback sweeps[BT_RAY_PACKET_SIZE];
+		btBroadphaseRayCallback* rayCallbacks[BT_RAY_PACKET_SIZE];
+		btVector3 rayFrom[BT_RAY_PACKET_SIZE];
+		btVector3 rayTo[BT_RAY_PACKET_SIZE];
+		btVector3 castShapeAabbMin[BT_RAY_PACKET_SIZE];
+		btVector3 castShapeAabbMax[BT_RAY_PACKET_SIZE];
+		for (int packet = iBegin; packet < iEnd; ++packet)
+		{
+			const int begin = packet*BT_RAY_PACKET_SIZE;
+			const int count = btMin(m_numSweeps-begin, int(BT_RAY_PACKET_SIZE));
+			for (int i = 0; i < count; ++i)
+			{
+				const btConvexShape* castShape = m_castShapes[begin+i];
+				const btTransform& convexFromTrans = m_convexFromWorld[begin+i];
+				const btTransform& convexToTrans = m_convexToWorld[begin+i];
+				/* Compute AABB that encompasses angular movement, as in convexSweepTest */
+				{
+					btVector3 linVel, angVel;
+					btTransformUtil::calculateVelocity (convexFromTrans, convexToTrans, 1.0f, linVel, angVel);
+					btVector3 zeroLinVel;
+					zeroLinVel.setValue(0,0,0);
+					btTransform R;
+					R.setIdentity ();
+					R.setRotation (convexFromTrans.getRotation());
+					castShape->calculateTemporalAabb (R, zeroLinVel, angVel, 1.0f, castShapeAabbMin[i], castShapeAabbMax[i]);
+				}
+				rayFrom[i] = convexFromTrans.getOrigin();
+				rayTo[i] = convexToTrans.getOrigin();
+				const short int mask = m_collisionFilterMasks ? m_collisionFilterMasks[begin+i] : short(btBroadphaseProxy::AllFilter);
+				sweeps[i].init(castShape,convexFromTrans,convexToTrans,m_world,m_collisionFilterGroup,mask,m_allowedCcdPenetration,&m_results[begin+i]);
+				rayCallbacks[i] = &sweeps[i];
+			}
+#ifndef USE_BRUTEFORCE_RAYBROADPHASE
+			m_broadphase->rayTestPacket(rayFrom,rayTo,rayCallbacks,count,castShapeAabbMin,castShapeAabbMax);
+#else
+			for (int i = 0; i < count; ++i)
+			{
+				for (int j=0;j<m_world->getNumCollisionObjects();j++)
+				{
+					const btCollisionObject* collisionObject = m_world->getCollisionObjectArray()[j];
+					btVector3 collisionObjectAabbMin,collisionObjectAabbMax;
+					collisionObject->getCollisionShape()->getAabb(collisionObject->getWorldTransform(),collisionObjectAabbMin,collisionObjectAabbMax);
+					AabbExpand (collisionObjectAabbMin, collisionObjectAabbMax, castShapeAabbMin[i], castShapeAabbMax[i]);
+					btScalar hitLambda = btScalar(1.);
+					btVector3 hitNormal;
+					if (btRayAabb(rayFrom[i],rayTo[i],collisionObjectAabbMin,collisionObjectAabbMax,hitLambda,hitNormal))
+					{
+						if (!sweeps[i].process(collisionObject->getBroadphaseHandle()))
+							break;
+					}
+				}
+			}
+#endif //USE_BRUTEFORCE_RAYBROADPHASE
+		}
+	}
+};
+
+void	btCollisionWorld::convexSweepTestBatch(const btConvexShape* const* castShapes, const btTransform* convexFromWorld, const btTransform* convexToWorld, const short int* collisionFilterMasks, ClosestConvexHit* results, int numSweeps, btScalar allowedCcdPenetration, short int collisionFilterGroup) const
+{
+	BT_PROFILE("convexSweepTestBatch");
+	btConvexSweepTestBatchLoop loop;
+	loop.m_world = this;
+	loop.m_broadphase = m_broadphasePairCache;
+	loop.m_castShapes = castShapes;
+	loop.m_convexFromWorld = convexFromWorld;
+	loop.m_convexToWorld = convexToWorld;
+	loop.m_collisionFilterMasks = collisionFilterMasks;
+	loop.m_results = results;
+	loop.m_numSweeps = numSweeps;
+	loop.m_allowedCcdPenetration = allowedCcdPenetration;
+	loop.m_collisionFilterGroup = collisionFilterGroup;
+	const int numPackets = (numSweeps+BT_RAY_PACKET_SIZE-1)/BT_RAY_PACKET_SIZE;
+	btParallelFor(0, numPackets, 1, loop);
+}
+
 
 struct btBridgedManifoldResult : public btManifoldResult
 {
@@ -1241,6 +1653,113 @@ void	btCollisionWorld::contactTest( btCollisionObject* colObj, ContactResultCall
 }
 
 
+///btBatchContactResultCallback appends the contact points of a query of contactTestBatch, oriented from the object towards the query
+struct btBatchContactResultCallback : public btCollisionWorld::ContactResultCallback
+{
+	const btCollisionObject*	m_queryObject;
+	int	m_queryIndex;
+	btAlignedObjectArray<btCollisionWorld::ContactHit>*	m_hits;
+
+	virtual	btScalar	addSingleResult(btManifoldPoint& cp,	const btCollisionObjectWrapper* colObj0Wrap,int /*partId0*/,int /*index0*/,const btCollisionObjectWrapper* colObj1Wrap,int /*partId1*/,int /*index1*/)
+	{
+		btCollisionWorld::ContactHit& hit = m_hits->expandNonInitializing();
+		hit.m_queryIndex = m_queryIndex;
+		if (colObj0Wrap->getCollisionObject() == m_queryObject)
+		{
+			hit.m_collisionObject = colObj1Wrap->getCollisionObject();
+			hit.m_positionWorldOnQuery = cp.m_positionWorldOnA;
+			hit.m_positionWorldOnObject = cp.m_positionWorldOnB;
+			hit.m_normalWorldOnObject = cp.m_normalWorldOnB;
+		} else
+		{
+			hit.m_collisionObject = colObj0Wrap->getCollisionObject();
+			hit.m_positionWorldOnQuery = cp.m_positionWorldOnB;
+			hit.m_positionWorldOnObject = cp.m_positionWorldOnA;
+			hit.m_normalWorldOnObject = -cp.m_normalWorldOnB;
+		}
+		hit.m_distance = cp.getDistance();
+		return 0;
+	}
+};
+
+struct btContactTestBatchLoop : public btIParallelForBody
+{
+	btCollisionWorld* m_world;
+	btContactTestBatchScratch* m_scratch;
+	btCollisionShape* const* m_shapes;
+	const btTransform* m_transforms;
+	const short int* m_collisionFilterMasks;
+	short int m_collisionFilterGroup;
+
+	void forLoop(int iBegin, int iEnd) const
+	{
+		const int threadIndex = btGetCurrentThreadIndex();
+		btAlignedObjectArray<btCollisionWorld::ContactHit>& threadHits = m_scratch->m_threadHits[threadIndex];
+		btCollisionObject queryObject;
+		btBatchContactResultCallback resultCallback;
+		resultCallback.m_queryObject = &queryObject;
+		resultCallback.m_hits = &threadHits;
+		resultCallback.m_collisionFilterGroup = m_collisionFilterGroup;
+		for (int i = iBegin; i < iEnd; ++i)
+		{
+			queryObject.setCollisionShape(m_shapes[i]);
+			queryObject.setWorldTransform(m_transforms[i]);
+			resultCallback.m_queryIndex = i;
+			resultCallback.m_collisionFilterMask = m_collisionFilterMasks ? m_collisionFilterMasks[i] : short(btBroadphaseProxy::AllFilter);
+			m_scratch->m_queryThread[i] = threadIndex;
+			m_scratch->m_queryBegin[i] = threadHits.size();
+			m_world->contactTest(&queryObject,resultCallback);
+			m_scratch->m_queryCount[i] = threadHits.size()-m_scratch->m_queryBegin[i];
+		}
+	}
+};
+
+void	btCollisionWorld::contactTestBatch(btCollisionShape* const* shapes, const btTransform* transforms, const short int* collisionFilterMasks, int numQueries, btAlignedObjectArray<ContactHit>& hits, short int collisionFilterGroup)
+{
+	BT_PROFILE("contactTestBatch");
+	if (!m_contactTestBatchScratch)
+	{
+		void* mem = btAlignedAlloc(sizeof(btContactTestBatchScratch),16);
+		m_contactTestBatchScratch = new (mem) btContactTestBatchScratch();
+	}
+	btContactTestBatchScratch* scratch = m_contactTestBatchScratch;
+	for (unsigned int t = 0; t < BT_MAX_THREAD_COUNT; ++t)
+	{
+		scratch->m_threadHits[t].resize(0);
+	}
+	scratch->m_queryThread.resize(numQueries);
+	scratch->m_queryBegin.resize(numQueries);
+	scratch->m_queryCount.resize(numQueries);
+
+	btContactTestBatchLoop loop;
+	loop.m_world = this;
+	loop.m_scratch = scratch;
+	loop.m_shapes = shapes;
+	loop.m_transforms = transforms;
+	loop.m_collisionFilterMasks = collisionFilterMasks;
+	loop.m_collisionFilterGroup = collisionFilterGroup;
+	btParallelFor(0, numQueries, 16, loop);
+
+	//merge the per thread contact points in query order, so the result doesn't depend on the number of threads
+	int numHits = 0;
+	for (int i = 0; i < numQueries; ++i)
+	{
+		numHits += scratch->m_queryCount[i];
+	}
+	hits.resize(numHits);
+	int hitIndex = 0;
+	for (int i = 0; i < numQueries; ++i)
+	{
+		const btAlignedObjectArray<ContactHit>& threadHits = scratch->m_threadHits[scratch->m_queryThread[i]];
+		const int begin = scratch->m_queryBegin[i];
+		for (int j = 0; j < scratch->m_queryCount[i]; ++j)
+		{
+			hits[hitIndex++] = threadHits[begin+j];
+		}
+	}
+}
+
+
 ///contactTest performs a discrete collision test between two collision objects and calls the resultCallback if overlap if detected.
 ///it reports one or more contact points (including the one with deepest penetration)
 void	btCollisionWorld::contactPairTest(btCollisionObject* colObjA, btCollisionObject* colObjB, ContactResultCallback& resultCallback)
@@ -76,6 +76,7 @@ class btCollisionShape;
 class btConvexShape;
 class btBroadphaseInterface;
 class btSerializer;
+struct btContactTestBatchScratch;
 
 #include "LinearMath/btVector3.h"
 #include "LinearMath/btTransform.h"
@@ -105,6 +106,14 @@ protected:
 	///it is true by default, because it is error-prone (setting the position of static objects wouldn't update their AABB)
 	bool m_forceUpdateAllAabbs;
 
+	///per thread contact points of contactTestBatch, allocated by its first call
+	btContactTestBatchScratch*	m_contactTestBatchScratch;
+
+	///proxies and aabbs updateAabbs hands to the broadphase at once
+	btAlignedObjectArray<btBroadphaseProxy*>	m_updateAabbProxies;
+	btAlignedObjectArray<btVector3>	m_updateAabbMins;
+	btAlignedObjectArray<btVector3>	m_updateAabbMaxs;
+
 	void	serializeCollisionObjects(btSerializer* serializer);
 
 public:
@@ -147,6 +156,7 @@ public:
 
 	void	updateSingleAabb(btCollisionObject* colObj);
 
+	///updateAabbs computes the aabbs of the objects in parallel on btParallelFor, then updates the broadphase with a single setAabbs call
 	virtual void	updateAabbs();
 
 	///the computeOverlappingPairs is usually already called by performDiscreteCollisionDetection (or stepSimulation)
@@ -273,6 +283,16 @@ public:
 		}
 	};
 
+	///ClosestRayHit is the closest hit of a ray of rayTestBatch, the same as a ClosestRayResultCallback would report.
+	///m_collisionObject is 0 and m_hitFraction is 1 if the ray didn't hit anything.
+	struct	ClosestRayHit
+	{
+		const btCollisionObject*	m_collisionObject;
+		btScalar	m_hitFraction;
+		btVector3	m_hitNormalWorld;
+		btVector3	m_hitPointWorld;
+	};
+
 	struct	AllHitsRayResultCallback : public RayResultCallback
 	{
 		AllHitsRayResultCallback(const btVector3&	rayFromWorld,const btVector3&	rayToWorld)
@@ -407,6 +427,16 @@ public:
 		}
 	};
 
+	///ClosestConvexHit is the closest hit of a sweep of convexSweepTestBatch, the same as a ClosestConvexResultCallback would report.
+	///m_collisionObject is 0 and m_hitFraction is 1 if the sweep didn't hit anything.
+	struct	ClosestConvexHit
+	{
+		const btCollisionObject*	m_collisionObject;
+		btScalar	m_hitFraction;
+		btVector3	m_hitNormalWorld;
+		btVector3	m_hitPointWorld;
+	};
+
 	///ContactResultCallback is used to report contact points
 	struct	ContactResultCallback
 	{
@@ -433,6 +463,18 @@ public:
 		virtual	btScalar	addSingleResult(btManifoldPoint& cp,	const btCollisionObjectWrapper* colObj0Wrap,int partId0,int index0,const btCollisionObjectWrapper* colObj1Wrap,int partId1,int index1) = 0;
 	};
 
+	///ContactHit is a contact point of contactTestBatch between the shape of query m_queryIndex and m_collisionObject.
+	///m_normalWorldOnObject points from the object towards the query shape, m_distance is negative for penetrations.
+	struct	ContactHit
+	{
+		int	m_queryIndex;
+		const btCollisionObject*	m_collisionObject;
+		btVector3	m_positionWorldOnQuery;
+		btVector3	m_positionWorldOnObject;
+		btVector3	m_normalWorldOnObject;
+		btScalar	m_distance;
+	};
+
 
 
 	int	getNumCollisionObjects() const
@@ -444,14 +486,28 @@ public:
 	/// This allows for several queries: first hit, all hits, any hit, dependent on the value returned by the callback.
 	virtual void rayTest(const btVector3& rayFromWorld, const btVector3& rayToWorld, RayResultCallback& resultCallback) const; 
 
+	/// rayTestBatch finds the closest hit of numRays rays from rayFromWorld[i] to rayToWorld[i] and stores it in results[i].
+	/// A ray only hits objects whose group matches collisionFilterMasks[i] (all groups if collisionFilterMasks is 0) and whose mask matches collisionFilterGroup.
+	/// The rays are cast in packets sharing the broadphase traversal, and the packets run in parallel on btParallelFor.
+	void	rayTestBatch(const btVector3* rayFromWorld, const btVector3* rayToWorld, const short int* collisionFilterMasks, ClosestRayHit* results, int numRays, short int collisionFilterGroup = btBroadphaseProxy::DefaultFilter) const;
+
 	/// convexTest performs a swept convex cast on all objects in the btCollisionWorld, and calls the resultCallback
 	/// This allows for several queries: first hit, all hits, any hit, dependent on the value return by the callback.
 	void    convexSweepTest (const btConvexShape* castShape, const btTransform& from, const btTransform& to, ConvexResultCallback& resultCallback,  btScalar allowedCcdPenetration = btScalar(0.)) const;
 
+	/// convexSweepTestBatch finds the closest hit of numSweeps sweeps of castShapes[i] from convexFromWorld[i] to convexToWorld[i] and stores it in results[i].
+	/// Filtering works like in rayTestBatch. The sweeps share the broadphase traversal in packets, and the packets run in parallel on btParallelFor.
+	void	convexSweepTestBatch(const btConvexShape* const* castShapes, const btTransform* convexFromWorld, const btTransform* convexToWorld, const short int* collisionFilterMasks, ClosestConvexHit* results, int numSweeps, btScalar allowedCcdPenetration = btScalar(0.), short int collisionFilterGroup = btBroadphaseProxy::DefaultFilter) const;
+
 	///contactTest performs a discrete collision test between colObj against all objects in the btCollisionWorld, and calls the resultCallback.
 	///it reports one or more contact points for every overlapping object (including the one with deepest penetration)
 	void	contactTest(btCollisionObject* colObj, ContactResultCallback& resultCallback);
 
+	///contactTestBatch runs contactTest for numQueries shapes at the given transforms, in parallel on btParallelFor.
+	///hits receives the contact points of all queries, sorted by query and otherwise in the order of contactTest. Filtering works like in rayTestBatch.
+	///The dispatcher must be able to create manifolds from several threads at once, like btCollisionDispatcher.
+	void	contactTestBatch(btCollisionShape* const* shapes, const btTransform* transforms, const short int* collisionFilterMasks, int numQueries, btAlignedObjectArray<ContactHit>& hits, short int collisionFilterGroup = btBroadphaseProxy::DefaultFilter);
+
 	///contactTest performs a discrete collision test between two collision objects and calls the resultCallback if overlap if detected.
 	///it reports one or more contact points (including the one with deepest penetration)
 	void	contactPairTest(btCollisionObject* colObjA, btCollisionObject* colObjB, ContactResultCallback& resultCallback);
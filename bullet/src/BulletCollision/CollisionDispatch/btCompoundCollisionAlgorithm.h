@@ -38,6 +38,7 @@ extern btShapePairCallback gCompoundChildShapePairCallback;
 class btCompoundCollisionAlgorithm  : public btActivatingCollisionAlgorithm
 {
 	btNodeStack stack2;
+	btAlignedObjectArray<int> wideStack;
 	btManifoldArray manifoldArray;
 
 protected:
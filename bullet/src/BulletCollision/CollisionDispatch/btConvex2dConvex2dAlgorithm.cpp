@@ -118,7 +118,10 @@ void btConvex2dConvex2dAlgorithm ::processCollision (const btCollisionObjectWrap
 
 		btGjkPairDetector::ClosestPointInput input;
 
-		btGjkPairDetector	gjkPairDetector(min0,min1,m_simplexSolver,m_pdSolver);
+		//the configured simplex solver only provides the settings, every query needs its own simplex so pairs can be processed concurrently
+		btVoronoiSimplexSolver simplexSolver;
+		simplexSolver.setEqualVertexThreshold(m_simplexSolver->getEqualVertexThreshold());
+		btGjkPairDetector	gjkPairDetector(min0,min1,&simplexSolver,m_pdSolver);
 		//TODO: if (dispatchInfo.m_useContinuous)
 		gjkPairDetector.setMinkowskiA(min0);
 		gjkPairDetector.setMinkowskiB(min1);
@@ -20,6 +20,7 @@ subject to the following restrictions:
 
 #include <stdio.h>
 
+///statistics kept for compatibility, no longer updated since the pair cache may be used from several threads
 int	gOverlappingSimplePairs = 0;
 int gRemoveSimplePairs =0;
 int gAddedSimplePairs =0;
@@ -61,7 +62,6 @@ void btHashedSimplePairCache::removeAllPairs()
 
 btSimplePair* btHashedSimplePairCache::findPair(int indexA, int indexB)
 {
-	gFindSimplePairs++;
 	
 	
 	/*if (indexA > indexB) 
@@ -172,7 +172,6 @@ btSimplePair* btHashedSimplePairCache::internalAddPair(int indexA, int indexB)
 
 void* btHashedSimplePairCache::removeOverlappingPair(int indexA, int indexB)
 {
-	gRemoveSimplePairs++;
 	
 
 	/*if (indexA > indexB) 
@@ -44,6 +44,7 @@ typedef btAlignedObjectArray<btSimplePair>	btSimplePairArray;
 
 
 
+///no longer updated
 extern int gOverlappingSimplePairs;
 extern int gRemoveSimplePairs;
 extern int gAddedSimplePairs;
@@ -75,7 +76,6 @@ public:
 	// no new pair is created and the old one is returned.
 	virtual btSimplePair* 	addOverlappingPair(int indexA,int indexB)
 	{
-		gAddedSimplePairs++;
 
 		return internalAddPair(indexA,indexB);
 	}
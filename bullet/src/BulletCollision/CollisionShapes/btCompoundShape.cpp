@@ -16,12 +16,14 @@ subject to the following restrictions:
 #include "btCompoundShape.h"
 #include "btCollisionShape.h"
 #include "BulletCollision/BroadphaseCollision/btDbvt.h"
+#include "BulletCollision/BroadphaseCollision/btDbvtWide.h"
 #include "LinearMath/btSerializer.h"
 
 btCompoundShape::btCompoundShape(bool enableDynamicAabbTree, const int initialChildCapacity)
 : m_localAabbMin(btScalar(BT_LARGE_FLOAT),btScalar(BT_LARGE_FLOAT),btScalar(BT_LARGE_FLOAT)),
 m_localAabbMax(btScalar(-BT_LARGE_FLOAT),btScalar(-BT_LARGE_FLOAT),btScalar(-BT_LARGE_FLOAT)),
 m_dynamicAabbTree(0),
+m_wideAabbTree(0),
 m_updateRevision(1),
 m_collisionMargin(btScalar(0.)),
 m_localScaling(btScalar(1.),btScalar(1.),btScalar(1.))
@@ -46,6 +48,11 @@ btCompoundShape::~btCompoundShape()
 		m_dynamicAabbTree->~btDbvt();
 		btAlignedFree(m_dynamicAabbTree);
 	}
+	if (m_wideAabbTree)
+	{
+		m_wideAabbTree->~btDbvtWide();
+		btAlignedFree(m_wideAabbTree);
+	}
 }
 
 void	btCompoundShape::addChildShape(const btTransform& localTransform,btCollisionShape* shape)
@@ -76,6 +83,8 @@ void	btCompoundShape::addChildShape(const btTransform& localTransform,btCollisio
 		}
 
 	}
+	if (m_wideAabbTree)
+		m_wideAabbTree->clear();
 	if (m_dynamicAabbTree)
 	{
 		const btDbvtVolume	bounds=btDbvtVolume::FromMM(localAabbMin,localAabbMax);
@@ -91,6 +100,8 @@ void	btCompoundShape::updateChildTransform(int childIndex, const btTransform& ne
 {
 	m_children[childIndex].m_transform = newChildTransform;
 
+	if (m_wideAabbTree)
+		m_wideAabbTree->clear();
 	if (m_dynamicAabbTree)
 	{
 		///update the dynamic aabb tree
@@ -111,6 +122,8 @@ void btCompoundShape::removeChildShapeByIndex(int childShapeIndex)
 {
 	m_updateRevision++;
 	btAssert(childShapeIndex >=0 && childShapeIndex < m_children.size());
+	if (m_wideAabbTree)
+		m_wideAabbTree->clear();
 	if (m_dynamicAabbTree)
 	{
 		m_dynamicAabbTree->remove(m_children[childShapeIndex].m_node);
@@ -320,6 +333,23 @@ void btCompoundShape::createAabbTreeFromChildren()
     }
 }
 
+void btCompoundShape::createWideAabbTree()
+{
+	createAabbTreeFromChildren();
+	if (!m_wideAabbTree)
+	{
+		void* mem = btAlignedAlloc(sizeof(btDbvtWide),16);
+		m_wideAabbTree = new(mem) btDbvtWide();
+		btAssert(mem==m_wideAabbTree);
+	}
+	m_wideAabbTree->build(*m_dynamicAabbTree);
+}
+
+const btDbvtWide* btCompoundShape::getWideAabbTree() const
+{
+	return (m_wideAabbTree && !m_wideAabbTree->empty()) ? m_wideAabbTree : 0;
+}
+
 
 ///fills the dataBuffer and returns the struct name (and 0 on failure)
 const char*	btCompoundShape::serialize(void* dataBuffer, btSerializer* serializer) const
@@ -26,6 +26,7 @@ subject to the following restrictions:
 
 //class btOptimizedBvh;
 struct btDbvt;
+struct btDbvtWide;
 
 ATTRIBUTE_ALIGNED16(struct) btCompoundShapeChild
 {
@@ -60,6 +61,9 @@ protected:
 
 	btDbvt*							m_dynamicAabbTree;
 
+	///4-wide copy of m_dynamicAabbTree, see createWideAabbTree
+	btDbvtWide*						m_wideAabbTree;
+
 	///increment m_updateRevision when adding/removing/replacing child shapes, so that some caches can be updated
 	int								m_updateRevision;
 
@@ -155,6 +159,13 @@ public:
 
 	void createAabbTreeFromChildren();
 
+	///builds a 4-wide copy of the dynamic aabb tree, that collision queries use instead of it.
+	///Adding, removing or moving a child shape drops the copy, call this again once the children are in place.
+	void createWideAabbTree();
+
+	///returns 0 unless the wide copy is up to date
+	const btDbvtWide*	getWideAabbTree() const;
+
 	///computes the exact moment of inertia and the transform from the coordinate system defined by the principal axes of the moment of inertia
 	///and the center of mass to the current coordinate system. "masses" points to an array of masses of the children. The resulting transform
 	///"principal" has to be applied inversely to all children transforms in order for the local coordinate system of the compound
@@ -37,6 +37,7 @@ subject to the following restrictions:
 #endif
 
 //temp globals, to improve GJK/EPA/penetration calculations
+///gNumDeepPenetrationChecks and gNumGjkChecks are no longer updated, GJK may run on several threads
 int gNumDeepPenetrationChecks = 0;
 int gNumGjkChecks = 0;
 btScalar gGjkEpaPenetrationTolerance = 0.001;
@@ -104,7 +105,6 @@ void btGjkPairDetector::getClosestPointsNonVirtual(const ClosestPointInput& inpu
 	btScalar marginA = m_marginA;
 	btScalar marginB = m_marginB;
 
-	gNumGjkChecks++;
 
 	//for CCD we don't use margins
 	if (m_ignoreMargin)
@@ -317,7 +317,6 @@ void btGjkPairDetector::getClosestPointsNonVirtual(const ClosestPointInput& inpu
 				// Penetration depth case.
 				btVector3 tmpPointOnA,tmpPointOnB;
 				
-				gNumDeepPenetrationChecks++;
 				m_cachedSeparatingAxis.setZero();
 
 				bool isValid2 = m_penetrationDepthSolver->calcPenDepth( 
@@ -75,6 +75,10 @@ bool btMinkowskiPenetrationDepthSolver::calcPenDepth(btSimplexSolverInterface& s
 #ifndef __SPU__
 #define USE_BATCHED_SUPPORT 1
 #endif
+
+	//the preferred directions are kept on the stack, the shared direction table is only read so several threads can use the solver
+	btVector3	preferredDirections[MAX_PREFERRED_PENETRATION_DIRECTIONS*2];
+
 #ifdef USE_BATCHED_SUPPORT
 
 	btVector3	supportVerticesABatch[NUM_UNITSPHERE_POINTS+MAX_PREFERRED_PENETRATION_DIRECTIONS*2];
@@ -101,7 +105,7 @@ bool btMinkowskiPenetrationDepthSolver::calcPenDepth(btSimplexSolverInterface& s
 				btVector3 norm;
 				convexA->getPreferredPenetrationDirection(i,norm);
 				norm  = transA.getBasis() * norm;
-				getPenetrationDirections()[numSampleDirections] = norm;
+				preferredDirections[numSampleDirections-NUM_UNITSPHERE_POINTS] = norm;
 				seperatingAxisInABatch[numSampleDirections] = (-norm) * transA.getBasis();
 				seperatingAxisInBBatch[numSampleDirections] = norm * transB.getBasis();
 				numSampleDirections++;
@@ -118,7 +122,7 @@ bool btMinkowskiPenetrationDepthSolver::calcPenDepth(btSimplexSolverInterface& s
 				btVector3 norm;
 				convexB->getPreferredPenetrationDirection(i,norm);
 				norm  = transB.getBasis() * norm;
-				getPenetrationDirections()[numSampleDirections] = norm;
+				preferredDirections[numSampleDirections-NUM_UNITSPHERE_POINTS] = norm;
 				seperatingAxisInABatch[numSampleDirections] = (-norm) * transA.getBasis();
 				seperatingAxisInBBatch[numSampleDirections] = norm * transB.getBasis();
 				numSampleDirections++;
@@ -134,7 +138,7 @@ bool btMinkowskiPenetrationDepthSolver::calcPenDepth(btSimplexSolverInterface& s
 
 	for (i=0;i<numSampleDirections;i++)
 	{
-		btVector3 norm = getPenetrationDirections()[i];
+		btVector3 norm = i<NUM_UNITSPHERE_POINTS ? getPenetrationDirections()[i] : preferredDirections[i-NUM_UNITSPHERE_POINTS];
 		if (check2d)
 		{
 			norm[2] = 0.f;
@@ -182,7 +186,7 @@ bool btMinkowskiPenetrationDepthSolver::calcPenDepth(btSimplexSolverInterface& s
 				btVector3 norm;
 				convexA->getPreferredPenetrationDirection(i,norm);
 				norm  = transA.getBasis() * norm;
-				getPenetrationDirections()[numSampleDirections] = norm;
+				preferredDirections[numSampleDirections-NUM_UNITSPHERE_POINTS] = norm;
 				numSampleDirections++;
 			}
 		}
@@ -197,7 +201,7 @@ bool btMinkowskiPenetrationDepthSolver::calcPenDepth(btSimplexSolverInterface& s
 				btVector3 norm;
 				convexB->getPreferredPenetrationDirection(i,norm);
 				norm  = transB.getBasis() * norm;
-				getPenetrationDirections()[numSampleDirections] = norm;
+				preferredDirections[numSampleDirections-NUM_UNITSPHERE_POINTS] = norm;
 				numSampleDirections++;
 			}
 		}
@@ -206,7 +210,7 @@ bool btMinkowskiPenetrationDepthSolver::calcPenDepth(btSimplexSolverInterface& s
 
 	for (int i=0;i<numSampleDirections;i++)
 	{
-		const btVector3& norm = getPenetrationDirections()[i];
+		const btVector3& norm = i<NUM_UNITSPHERE_POINTS ? getPenetrationDirections()[i] : preferredDirections[i-NUM_UNITSPHERE_POINTS];
 		seperatingAxisInA = (-norm)* transA.getBasis();
 		seperatingAxisInB = norm* transB.getBasis();
 		pInA = convexA->localGetSupportVertexWithoutMarginNonVirtual(seperatingAxisInA);
@@ -24,6 +24,7 @@ subject to the following restrictions:
 
 #include <float.h> //for FLT_MAX
 
+///gExpectedNbTests and gActualNbTests are no longer updated, SAT may run on several threads
 int gExpectedNbTests=0;
 int gActualNbTests = 0;
 bool gUseInternalObject = true;
@@ -112,7 +113,6 @@ static bool TestSepAxis(const btConvexPolyhedron& hullA, const btConvexPolyhedro
 
 
 
-static int gActualSATPairTests=0;
 
 inline bool IsAlmostZero(const btVector3& v)
 {
@@ -239,7 +239,6 @@ void InverseTransformPoint3x3(btVector3& out, const btVector3& in, const btTrans
 
 bool btPolyhedralContactClipping::findSeparatingAxis(	const btConvexPolyhedron& hullA, const btConvexPolyhedron& hullB, const btTransform& transA,const btTransform& transB, btVector3& sep, btDiscreteCollisionDetectorInterface::Result& resultOut)
 {
-	gActualSATPairTests++;
 
 //#ifdef TEST_INTERNAL_OBJECTS
 	const btVector3 c0 = transA * hullA.m_localCenter;
@@ -261,10 +260,8 @@ bool btPolyhedralContactClipping::findSeparatingAxis(	const btConvexPolyhedron&
 
 		curPlaneTests++;
 #ifdef TEST_INTERNAL_OBJECTS
-		gExpectedNbTests++;
 		if(gUseInternalObject && !TestInternalObjects(transA,transB, DeltaC2, faceANormalWS, hullA, hullB, dmin))
 			continue;
-		gActualNbTests++;
 #endif
 
 		btScalar d;
@@ -290,10 +287,8 @@ bool btPolyhedralContactClipping::findSeparatingAxis(	const btConvexPolyhedron&
 
 		curPlaneTests++;
 #ifdef TEST_INTERNAL_OBJECTS
-		gExpectedNbTests++;
 		if(gUseInternalObject && !TestInternalObjects(transA,transB,DeltaC2, WorldNormal, hullA, hullB, dmin))
 			continue;
-		gActualNbTests++;
 #endif
 
 		btScalar d;
@@ -337,10 +332,8 @@ bool btPolyhedralContactClipping::findSeparatingAxis(	const btConvexPolyhedron&
 
 
 #ifdef TEST_INTERNAL_OBJECTS
-				gExpectedNbTests++;
 				if(gUseInternalObject && !TestInternalObjects(transA,transB,DeltaC2, Cross, hullA, hullB, dmin))
 					continue;
-				gActualNbTests++;
 #endif
 
 				btScalar dist;
@@ -990,8 +990,7 @@ btQuaternion btKinematicCharacterController::getRotation(btVector3& v0, btVector
 {
 	if (v0.length2() == 0.0f || v1.length2() == 0.0f)
 	{
-		btQuaternion q;
-		return q;
+		return btQuaternion::getIdentity();
 	}
 
 	return shortestArcQuatNormalize2(v0, v1);
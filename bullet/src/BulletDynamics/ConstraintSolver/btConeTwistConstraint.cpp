@@ -383,7 +383,7 @@ void	btConeTwistConstraint::solveConstraintObsolete(btSolverBody& bodyA,btSolver
 			btVector3 dOmegaB = omegaBDes - omegaB;
 
 			// compute weighted avg axis of dOmega (weighting based on inertias)
-			btVector3 axisA, axisB;
+			btVector3 axisA(0,0,0), axisB(0,0,0); //stay zero when not set below, they are scaled by zero weights then
 			btScalar kAxisAInv = 0, kAxisBInv = 0;
 
 			if (dOmegaA.length2() > SIMD_EPSILON)
@@ -35,7 +35,7 @@ subject to the following restrictions:
 #include "LinearMath/btAlignedObjectArray.h"
 #include <string.h> //for memset
 
-int		gNumSplitImpulseRecoveries = 0;
+int		gNumSplitImpulseRecoveries = 0; //no longer counted, islands can be solved concurrently
 
 #include "BulletDynamics/Dynamics/btRigidBody.h"
 
@@ -305,7 +305,6 @@ void	btSequentialImpulseConstraintSolver::resolveSplitPenetrationImpulseCacheFri
 {
 		if (c.m_rhsPenetration)
         {
-			gNumSplitImpulseRecoveries++;
 			btScalar deltaImpulse = c.m_rhsPenetration-btScalar(c.m_appliedPushImpulse)*c.m_cfm;
 			const btScalar deltaVel1Dotn	=	c.m_contactNormal1.dot(body1.internalGetPushVelocity()) 	+ c.m_relpos1CrossNormal.dot(body1.internalGetTurnVelocity());
 			const btScalar deltaVel2Dotn	=	c.m_contactNormal2.dot(body2.internalGetPushVelocity())		+ c.m_relpos2CrossNormal.dot(body2.internalGetTurnVelocity());
@@ -333,8 +332,6 @@ void	btSequentialImpulseConstraintSolver::resolveSplitPenetrationImpulseCacheFri
 	if (!c.m_rhsPenetration)
 		return;
 
-	gNumSplitImpulseRecoveries++;
-
 	__m128 cpAppliedImp = _mm_set1_ps(c.m_appliedPushImpulse);
 	__m128	lowerLimit1 = _mm_set1_ps(c.m_lowerLimit);
 	__m128	upperLimit1 = _mm_set1_ps(c.m_upperLimit);
@@ -719,6 +716,21 @@ int	btSequentialImpulseConstraintSolver::getOrInitSolverBody(btCollisionObject&
 
 	int solverBodyIdA = -1;
 
+	btRigidBody* kinematicBody = btRigidBody::upcast(&body);
+	if (kinematicBody && kinematicBody->isKinematicObject())
+	{
+		//kinematic bodies can be shared by islands that are solved concurrently,
+		//so their solver bodies are looked up per solver instead of the companion id
+		const int* found = m_kinematicSolverBodies.find(btHashPtr(&body));
+		if (found)
+			return *found;
+		solverBodyIdA = m_tmpSolverBodyPool.size();
+		btSolverBody& solverBody = m_tmpSolverBodyPool.expand();
+		initSolverBody(&solverBody,&body,timeStep);
+		m_kinematicSolverBodies.insert(btHashPtr(&body),solverBodyIdA);
+		return solverBodyIdA;
+	}
+
 	if (body.getCompanionId() >= 0)
 	{
 		//body has already been converted
@@ -1267,6 +1279,7 @@ btScalar btSequentialImpulseConstraintSolver::solveGroupCacheFriendlySetup(btCol
 
 	m_tmpSolverBodyPool.reserve(numBodies+1);
 	m_tmpSolverBodyPool.resize(0);
+	m_kinematicSolverBodies.clear();
 
 	//btSolverBody& fixedBody = m_tmpSolverBodyPool.expand();
     //initSolverBody(&fixedBody,0);
@@ -1888,7 +1901,8 @@ btScalar btSequentialImpulseConstraintSolver::solveGroupCacheFriendlyFinish(btCo
 	for ( i=0;i<m_tmpSolverBodyPool.size();i++)
 	{
 		btRigidBody* body = m_tmpSolverBodyPool[i].m_originalBody;
-		if (body)
+		//the solver doesn't change kinematic bodies, so they are left untouched for the other islands
+		if (body && !body->isKinematicObject())
 		{
 			if (infoGlobal.m_splitImpulse)
 				m_tmpSolverBodyPool[i].writebackVelocityAndTransform(infoGlobal.m_timeStep, infoGlobal.m_splitImpulseTurnErp);
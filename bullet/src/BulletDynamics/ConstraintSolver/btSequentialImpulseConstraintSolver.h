@@ -26,6 +26,7 @@ class btCollisionObject;
 #include "BulletDynamics/ConstraintSolver/btSolverConstraint.h"
 #include "BulletCollision/NarrowPhaseCollision/btManifoldPoint.h"
 #include "BulletDynamics/ConstraintSolver/btConstraintSolver.h"
+#include "LinearMath/btHashMap.h"
 
 typedef btSimdScalar(*btSingleConstraintRowSolver)(btSolverBody&, btSolverBody&, const btSolverConstraint&);
 
@@ -45,6 +46,7 @@ protected:
 	btAlignedObjectArray<btTypedConstraint::btConstraintInfo1> m_tmpConstraintSizesPool;
 	int							m_maxOverrideNumSolverIterations;
 	int m_fixedBodyId;
+	btHashMap<btHashPtr,int>	m_kinematicSolverBodies;	//solver bodies of kinematic objects
 
 	btSingleConstraintRowSolver m_resolveSingleConstraintRowGeneric;
 	btSingleConstraintRowSolver m_resolveSingleConstraintRowLowerLimit;
@@ -159,6 +161,7 @@ public:
 	}
 
 	///Various implementations of solving a single constraint row using a generic equality constraint, using scalar reference, SSE2 or SSE4
+	///The SSE2 rows are the default when USE_SIMD is defined. The SSE4 rows are only compiled with BT_ALLOW_SSE4 (Visual Studio 2012 and later), otherwise they are the SSE2 rows.
 	btSingleConstraintRowSolver	getScalarConstraintRowSolverGeneric();
 	btSingleConstraintRowSolver	getSSE2ConstraintRowSolverGeneric();
 	btSingleConstraintRowSolver	getSSE4_1ConstraintRowSolverGeneric();
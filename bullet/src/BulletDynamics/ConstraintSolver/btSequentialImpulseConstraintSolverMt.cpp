@@ -0,0 +1,367 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2014 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include "btSequentialImpulseConstraintSolverMt.h"
+#include "BulletDynamics/Dynamics/btRigidBody.h"
+#include "BulletCollision/NarrowPhaseCollision/btPersistentManifold.h"
+#include "LinearMath/btQuickprof.h"
+
+
+enum btBatchedSolverPass
+{
+	BT_BATCH_PASS_ROWS,	// joint rows and contact rows
+	BT_BATCH_PASS_FRICTION,	// friction and rolling friction rows, they need the contact impulses of the iteration
+	BT_BATCH_PASS_SPLIT_IMPULSE
+};
+
+struct btBatchedSolverLoop : public btIParallelForBody
+{
+	btSequentialImpulseConstraintSolverMt* m_solver;
+	const btContactSolverInfo* m_infoGlobal;
+	int m_pass;
+	int m_iteration;
+
+	void forLoop(int iBegin, int iEnd) const
+	{
+		m_solver->solveGroups(m_pass,m_iteration,*m_infoGlobal,iBegin,iEnd);
+	}
+};
+
+
+btSequentialImpulseConstraintSolverMt::btSequentialImpulseConstraintSolverMt()
+	:m_numParallelBatches(0),
+	m_useBatches(false),
+	m_minimumBatchedConstraints(100),
+	m_grainSize(8)
+{
+}
+
+btSequentialImpulseConstraintSolverMt::~btSequentialImpulseConstraintSolverMt()
+{
+}
+
+int btSequentialImpulseConstraintSolverMt::getColorIndex(const btCollisionObject* body)
+{
+	const btRigidBody* rb = btRigidBody::upcast(body);
+	if (!rb || (rb->getInvMass() == btScalar(0) && rb->getInvInertiaDiagLocal().isZero()))
+		return -1;
+	int index = body->getCompanionId();
+	if (index >= 0 && index < m_coloredBodies.size() && m_coloredBodies[index] == body)
+		return index;
+	index = m_coloredBodies.size();
+	const_cast<btCollisionObject*>(body)->setCompanionId(index);
+	m_coloredBodies.push_back(body);
+	m_bodyColors.push_back(0);
+	return index;
+}
+
+int btSequentialImpulseConstraintSolverMt::colorBodies(const btCollisionObject* body0, const btCollisionObject* body1)
+{
+	// greedy coloring, take the first color that none of the dynamic bodies uses yet
+	const int index0 = getColorIndex(body0);
+	const int index1 = getColorIndex(body1);
+	unsigned long long usedColors = 0;
+	if (index0 >= 0)
+		usedColors |= m_bodyColors[index0];
+	if (index1 >= 0)
+		usedColors |= m_bodyColors[index1];
+	int color = 0;
+	while (color < MAX_COLORS && (usedColors >> color) & 1)
+		color++;
+	if (color < MAX_COLORS)
+	{
+		const unsigned long long bit = 1ULL << color;
+		if (index0 >= 0)
+			m_bodyColors[index0] |= bit;
+		if (index1 >= 0)
+			m_bodyColors[index1] |= bit;
+	}
+	return color;
+}
+
+void btSequentialImpulseConstraintSolverMt::sortByColor(btPersistentManifold** manifoldPtr, int numManifolds, btTypedConstraint** constraints, int numConstraints)
+{
+	BT_PROFILE("sortByColor");
+	m_coloredBodies.resize(0);
+	m_bodyColors.resize(0);
+	int constraintCounts[MAX_COLORS + 1];
+	int manifoldCounts[MAX_COLORS + 1];
+	for (int i = 0; i <= MAX_COLORS; ++i)
+		constraintCounts[i] = manifoldCounts[i] = 0;
+
+	m_constraintColors.resizeNoInitialize(numConstraints);
+	for (int i = 0; i < numConstraints; ++i)
+	{
+		// disabled constraints have no rows
+		const int color = constraints[i]->isEnabled() ? colorBodies(&constraints[i]->getRigidBodyA(),&constraints[i]->getRigidBodyB()) : 0;
+		m_constraintColors[i] = color;
+		constraintCounts[color]++;
+	}
+	m_manifoldColors.resizeNoInitialize(numManifolds);
+	for (int i = 0; i < numManifolds; ++i)
+	{
+		const int color = colorBodies(manifoldPtr[i]->getBody0(),manifoldPtr[i]->getBody1());
+		m_manifoldColors[i] = color;
+		manifoldCounts[color]++;
+	}
+	for (int i = 0; i < m_coloredBodies.size(); ++i)
+		const_cast<btCollisionObject*>(m_coloredBodies[i])->setCompanionId(-1);
+
+	// greedy colors are used without gaps, the ones that found no color form the last batch
+	m_numParallelBatches = 0;
+	while (m_numParallelBatches < MAX_COLORS && (constraintCounts[m_numParallelBatches] || manifoldCounts[m_numParallelBatches]))
+		m_numParallelBatches++;
+	constraintCounts[m_numParallelBatches] = constraintCounts[MAX_COLORS];
+	manifoldCounts[m_numParallelBatches] = manifoldCounts[MAX_COLORS];
+	m_constraintBatchBegin[0] = 0;
+	m_manifoldBatchBegin[0] = 0;
+	for (int i = 0; i <= m_numParallelBatches; ++i)
+	{
+		m_constraintBatchBegin[i + 1] = m_constraintBatchBegin[i] + constraintCounts[i];
+		m_manifoldBatchBegin[i + 1] = m_manifoldBatchBegin[i] + manifoldCounts[i];
+	}
+
+	// sort by batch, the ones of the same batch keep their order
+	int fill[MAX_COLORS + 1];
+	for (int i = 0; i <= m_numParallelBatches; ++i)
+		fill[i] = m_constraintBatchBegin[i];
+	m_sortedConstraints.resizeNoInitialize(numConstraints);
+	for (int i = 0; i < numConstraints; ++i)
+		m_sortedConstraints[fill[btMin(m_constraintColors[i],m_numParallelBatches)]++] = constraints[i];
+	for (int i = 0; i <= m_numParallelBatches; ++i)
+		fill[i] = m_manifoldBatchBegin[i];
+	m_sortedManifolds.resizeNoInitialize(numManifolds);
+	for (int i = 0; i < numManifolds; ++i)
+		m_sortedManifolds[fill[btMin(m_manifoldColors[i],m_numParallelBatches)]++] = manifoldPtr[i];
+}
+
+void btSequentialImpulseConstraintSolverMt::convertContacts(btPersistentManifold** manifoldPtr, int numManifolds, const btContactSolverInfo& infoGlobal)
+{
+	if (!m_useBatches)
+	{
+		btSequentialImpulseConstraintSolver::convertContacts(manifoldPtr,numManifolds,infoGlobal);
+		return;
+	}
+	// the manifolds come sorted by batch, remember where the rows of each one went
+	m_manifoldGroups.resizeNoInitialize(numManifolds);
+	for (int i = 0; i < numManifolds; ++i)
+	{
+		RowGroup& group = m_manifoldGroups[i];
+		group.m_rowBegin = m_tmpSolverContactConstraintPool.size();
+		group.m_frictionBegin = m_tmpSolverContactFrictionConstraintPool.size();
+		group.m_rollingFrictionBegin = m_tmpSolverContactRollingFrictionConstraintPool.size();
+		convertContact(manifoldPtr[i],infoGlobal);
+		group.m_rowEnd = m_tmpSolverContactConstraintPool.size();
+		group.m_frictionEnd = m_tmpSolverContactFrictionConstraintPool.size();
+		group.m_rollingFrictionEnd = m_tmpSolverContactRollingFrictionConstraintPool.size();
+		group.m_isContact = true;
+	}
+}
+
+void btSequentialImpulseConstraintSolverMt::buildBatches(const btContactSolverInfo& infoGlobal)
+{
+	const int numBodies = m_tmpSolverBodyPool.size();
+	m_staticBodies.resizeNoInitialize(numBodies);
+	for (int i = 0; i < numBodies; ++i)
+	{
+		const btRigidBody* body = m_tmpSolverBodyPool[i].m_originalBody;
+		m_staticBodies[i] = !body || (body->getInvMass() == btScalar(0) && body->getInvInertiaDiagLocal().isZero());
+	}
+	m_threadFixedBodies.resize(BT_MAX_THREAD_COUNT);
+	for (int i = 0; i < m_threadFixedBodies.size(); ++i)
+		initSolverBody(&m_threadFixedBodies[i],0,infoGlobal.m_timeStep);
+
+	// the rows of the constraints follow each other in the order of the sorted constraints
+	m_groups.resize(0);
+	int row = 0;
+	for (int batch = 0; batch <= m_numParallelBatches; ++batch)
+	{
+		m_batchBegin[batch] = m_groups.size();
+		for (int i = m_constraintBatchBegin[batch]; i < m_constraintBatchBegin[batch + 1]; ++i)
+		{
+			const int numRows = m_tmpConstraintSizesPool[i].m_numConstraintRows;
+			if (!numRows)
+				continue;
+			RowGroup group;
+			group.m_rowBegin = row;
+			group.m_rowEnd = row + numRows;
+			group.m_frictionBegin = group.m_frictionEnd = 0;
+			group.m_rollingFrictionBegin = group.m_rollingFrictionEnd = 0;
+			group.m_isContact = false;
+			m_groups.push_back(group);
+			row += numRows;
+		}
+		for (int i = m_manifoldBatchBegin[batch]; i < m_manifoldBatchBegin[batch + 1]; ++i)
+		{
+			if (m_manifoldGroups[i].m_rowBegin != m_manifoldGroups[i].m_rowEnd)
+				m_groups.push_back(m_manifoldGroups[i]);
+		}
+	}
+	m_batchBegin[m_numParallelBatches + 1] = m_groups.size();
+}
+
+btScalar btSequentialImpulseConstraintSolverMt::solveGroupCacheFriendlySetup(btCollisionObject** bodies,int numBodies,btPersistentManifold** manifoldPtr, int numManifolds,btTypedConstraint** constraints,int numConstraints,const btContactSolverInfo& infoGlobal,btIDebugDraw* debugDrawer)
+{
+	m_useBatches = numManifolds + numConstraints >= m_minimumBatchedConstraints && (infoGlobal.m_solverMode & SOLVER_RANDMIZE_ORDER) == 0;
+	if (!m_useBatches)
+		return btSequentialImpulseConstraintSolver::solveGroupCacheFriendlySetup(bodies,numBodies,manifoldPtr,numManifolds,constraints,numConstraints,infoGlobal,debugDrawer);
+
+	sortByColor(manifoldPtr,numManifolds,constraints,numConstraints);
+	btSequentialImpulseConstraintSolver::solveGroupCacheFriendlySetup(bodies,numBodies,
+		numManifolds ? &m_sortedManifolds[0] : 0,numManifolds,
+		numConstraints ? &m_sortedConstraints[0] : 0,numConstraints,infoGlobal,debugDrawer);
+	buildBatches(infoGlobal);
+	return 0.f;
+}
+
+void btSequentialImpulseConstraintSolverMt::solveGroups(int pass, int iteration, const btContactSolverInfo& infoGlobal, int iBegin, int iEnd)
+{
+	btSolverBody& fixedBody = m_threadFixedBodies[btGetCurrentThreadIndex()];
+	const bool simd = (infoGlobal.m_solverMode & SOLVER_SIMD) != 0;
+
+	for (int i = iBegin; i < iEnd; ++i)
+	{
+		const RowGroup& group = m_groups[i];
+		if (pass == BT_BATCH_PASS_ROWS)
+		{
+			if (!group.m_isContact)
+			{
+				for (int j = group.m_rowBegin; j < group.m_rowEnd; ++j)
+				{
+					btSolverConstraint& constraint = m_tmpSolverNonContactConstraintPool[j];
+					if (iteration < constraint.m_overrideNumSolverIterations)
+					{
+						if (simd)
+							resolveSingleConstraintRowGenericSIMD(getBatchBody(constraint.m_solverBodyIdA,fixedBody),getBatchBody(constraint.m_solverBodyIdB,fixedBody),constraint);
+						else
+							resolveSingleConstraintRowGeneric(getBatchBody(constraint.m_solverBodyIdA,fixedBody),getBatchBody(constraint.m_solverBodyIdB,fixedBody),constraint);
+					}
+				}
+			}
+			else if (iteration < infoGlobal.m_numIterations)
+			{
+				for (int j = group.m_rowBegin; j < group.m_rowEnd; ++j)
+				{
+					const btSolverConstraint& solveManifold = m_tmpSolverContactConstraintPool[j];
+					if (simd)
+						resolveSingleConstraintRowLowerLimitSIMD(getBatchBody(solveManifold.m_solverBodyIdA,fixedBody),getBatchBody(solveManifold.m_solverBodyIdB,fixedBody),solveManifold);
+					else
+						resolveSingleConstraintRowLowerLimit(getBatchBody(solveManifold.m_solverBodyIdA,fixedBody),getBatchBody(solveManifold.m_solverBodyIdB,fixedBody),solveManifold);
+				}
+			}
+		}
+		else if (pass == BT_BATCH_PASS_FRICTION)
+		{
+			for (int j = group.m_frictionBegin; j < group.m_frictionEnd; ++j)
+			{
+				btSolverConstraint& solveManifold = m_tmpSolverContactFrictionConstraintPool[j];
+				btScalar totalImpulse = m_tmpSolverContactConstraintPool[solveManifold.m_frictionIndex].m_appliedImpulse;
+				if (totalImpulse>btScalar(0))
+				{
+					solveManifold.m_lowerLimit = -(solveManifold.m_friction*totalImpulse);
+					solveManifold.m_upperLimit = solveManifold.m_friction*totalImpulse;
+					if (simd)
+						resolveSingleConstraintRowGenericSIMD(getBatchBody(solveManifold.m_solverBodyIdA,fixedBody),getBatchBody(solveManifold.m_solverBodyIdB,fixedBody),solveManifold);
+					else
+						resolveSingleConstraintRowGeneric(getBatchBody(solveManifold.m_solverBodyIdA,fixedBody),getBatchBody(solveManifold.m_solverBodyIdB,fixedBody),solveManifold);
+				}
+			}
+			for (int j = group.m_rollingFrictionBegin; j < group.m_rollingFrictionEnd; ++j)
+			{
+				btSolverConstraint& rollingFrictionConstraint = m_tmpSolverContactRollingFrictionConstraintPool[j];
+				btScalar totalImpulse = m_tmpSolverContactConstraintPool[rollingFrictionConstraint.m_frictionIndex].m_appliedImpulse;
+				if (totalImpulse>btScalar(0))
+				{
+					btScalar rollingFrictionMagnitude = rollingFrictionConstraint.m_friction*totalImpulse;
+					if (rollingFrictionMagnitude>rollingFrictionConstraint.m_friction)
+						rollingFrictionMagnitude = rollingFrictionConstraint.m_friction;
+
+					rollingFrictionConstraint.m_lowerLimit = -rollingFrictionMagnitude;
+					rollingFrictionConstraint.m_upperLimit = rollingFrictionMagnitude;
+					if (simd)
+						resolveSingleConstraintRowGenericSIMD(getBatchBody(rollingFrictionConstraint.m_solverBodyIdA,fixedBody),getBatchBody(rollingFrictionConstraint.m_solverBodyIdB,fixedBody),rollingFrictionConstraint);
+					else
+						resolveSingleConstraintRowGeneric(getBatchBody(rollingFrictionConstraint.m_solverBodyIdA,fixedBody),getBatchBody(rollingFrictionConstraint.m_solverBodyIdB,fixedBody),rollingFrictionConstraint);
+				}
+			}
+		}
+		else if (group.m_isContact)
+		{
+			for (int j = group.m_rowBegin; j < group.m_rowEnd; ++j)
+			{
+				const btSolverConstraint& solveManifold = m_tmpSolverContactConstraintPool[j];
+				if (simd)
+					resolveSplitPenetrationSIMD(getBatchBody(solveManifold.m_solverBodyIdA,fixedBody),getBatchBody(solveManifold.m_solverBodyIdB,fixedBody),solveManifold);
+				else
+					resolveSplitPenetrationImpulseCacheFriendly(getBatchBody(solveManifold.m_solverBodyIdA,fixedBody),getBatchBody(solveManifold.m_solverBodyIdB,fixedBody),solveManifold);
+			}
+		}
+	}
+}
+
+void btSequentialImpulseConstraintSolverMt::solveBatches(int pass, int iteration, const btContactSolverInfo& infoGlobal)
+{
+	btBatchedSolverLoop loop;
+	loop.m_solver = this;
+	loop.m_infoGlobal = &infoGlobal;
+	loop.m_pass = pass;
+	loop.m_iteration = iteration;
+	for (int i = 0; i < m_numParallelBatches; ++i)
+		btParallelFor(m_batchBegin[i],m_batchBegin[i+1],m_grainSize,loop);
+	// groups without a color share bodies, they are solved on this thread
+	solveGroups(pass,iteration,infoGlobal,m_batchBegin[m_numParallelBatches],m_batchBegin[m_numParallelBatches+1]);
+}
+
+void btSequentialImpulseConstraintSolverMt::solveGroupCacheFriendlySplitImpulseIterations(btCollisionObject** bodies,int numBodies,btPersistentManifold** manifoldPtr, int numManifolds,btTypedConstraint** constraints,int numConstraints,const btContactSolverInfo& infoGlobal,btIDebugDraw* debugDrawer)
+{
+	if (!m_useBatches)
+	{
+		btSequentialImpulseConstraintSolver::solveGroupCacheFriendlySplitImpulseIterations(bodies,numBodies,manifoldPtr,numManifolds,constraints,numConstraints,infoGlobal,debugDrawer);
+		return;
+	}
+	if (infoGlobal.m_splitImpulse)
+	{
+		for (int iteration = 0; iteration < infoGlobal.m_numIterations; iteration++)
+			solveBatches(BT_BATCH_PASS_SPLIT_IMPULSE,iteration,infoGlobal);
+	}
+}
+
+btScalar btSequentialImpulseConstraintSolverMt::solveSingleIteration(int iteration, btCollisionObject** bodies ,int numBodies,btPersistentManifold** manifoldPtr, int numManifolds,btTypedConstraint** constraints,int numConstraints,const btContactSolverInfo& infoGlobal,btIDebugDraw* debugDrawer)
+{
+	if (!m_useBatches)
+		return btSequentialImpulseConstraintSolver::solveSingleIteration(iteration,bodies,numBodies,manifoldPtr,numManifolds,constraints,numConstraints,infoGlobal,debugDrawer);
+
+	if (iteration < infoGlobal.m_numIterations)
+	{
+		// constraints that still solve themselves, they can't be batched
+		for (int j=0;j<numConstraints;j++)
+		{
+			if (constraints[j]->isEnabled())
+			{
+				int bodyAid = getOrInitSolverBody(constraints[j]->getRigidBodyA(),infoGlobal.m_timeStep);
+				int bodyBid = getOrInitSolverBody(constraints[j]->getRigidBodyB(),infoGlobal.m_timeStep);
+				btSolverBody& bodyA = m_tmpSolverBodyPool[bodyAid];
+				btSolverBody& bodyB = m_tmpSolverBodyPool[bodyBid];
+				constraints[j]->solveConstraintObsolete(bodyA,bodyB,infoGlobal.m_timeStep);
+			}
+		}
+	}
+
+	solveBatches(BT_BATCH_PASS_ROWS,iteration,infoGlobal);
+	if (iteration < infoGlobal.m_numIterations)
+		solveBatches(BT_BATCH_PASS_FRICTION,iteration,infoGlobal);
+	return 0.f;
+}
@@ -0,0 +1,118 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2014 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_SEQUENTIAL_IMPULSE_CONSTRAINT_SOLVER_MT_H
+#define BT_SEQUENTIAL_IMPULSE_CONSTRAINT_SOLVER_MT_H
+
+#include "btSequentialImpulseConstraintSolver.h"
+#include "LinearMath/btThreads.h"
+
+struct btBatchedSolverLoop;
+
+
+///btSequentialImpulseConstraintSolverMt solves the rows of one island in parallel on the task scheduler of btParallelFor.
+///The manifolds and constraints are graph colored into batches that don't share a dynamic body and handed to the
+///setup of the base solver sorted by batch, so the rows of a batch are contiguous. The batches are solved one after
+///the other, the manifolds and constraints of a batch in parallel.
+///Static and kinematic bodies don't take part in the coloring, so a large pile on the ground still gives large batches.
+///The order of the rows differs from btSequentialImpulseConstraintSolver, which changes the results slightly but not the convergence.
+///Results don't depend on the number of threads. Small islands (see setMinimumBatchedConstraints) and SOLVER_RANDMIZE_ORDER use the serial solver.
+ATTRIBUTE_ALIGNED16(class) btSequentialImpulseConstraintSolverMt : public btSequentialImpulseConstraintSolver
+{
+	///rows of one constraint or one manifold, they share the same two solver bodies
+	struct RowGroup
+	{
+		int m_rowBegin;
+		int m_rowEnd;
+		int m_frictionBegin;
+		int m_frictionEnd;
+		int m_rollingFrictionBegin;
+		int m_rollingFrictionEnd;
+		bool m_isContact;
+	};
+
+	enum { MAX_COLORS = 64 };	// manifolds and constraints that don't find a free color end up in a last batch that is solved serially
+
+	btAlignedObjectArray<btPersistentManifold*> m_sortedManifolds;
+	btAlignedObjectArray<btTypedConstraint*> m_sortedConstraints;
+	btAlignedObjectArray<int> m_manifoldColors;
+	btAlignedObjectArray<int> m_constraintColors;
+	int m_manifoldBatchBegin[MAX_COLORS + 2];	// m_manifoldBatchBegin[i]..m_manifoldBatchBegin[i+1] are the manifolds of batch i in m_sortedManifolds
+	int m_constraintBatchBegin[MAX_COLORS + 2];
+	btAlignedObjectArray<const btCollisionObject*> m_coloredBodies;	// the companion id of a colored body is its index here while coloring
+	btAlignedObjectArray<unsigned long long> m_bodyColors;	// colors used by each colored body
+
+	btAlignedObjectArray<RowGroup> m_manifoldGroups;	// rows of each sorted manifold, filled by convertContacts
+	btAlignedObjectArray<RowGroup> m_groups;	// rows of the batches, sorted by batch
+	int m_batchBegin[MAX_COLORS + 2];	// m_batchBegin[i]..m_batchBegin[i+1] are the groups of batch i
+	int m_numParallelBatches;
+	btAlignedObjectArray<char> m_staticBodies;	// solver bodies that never move, they are shared by all batches
+	btAlignedObjectArray<btSolverBody> m_threadFixedBodies;	// stand in for the static bodies, one per thread
+
+	bool m_useBatches;
+	int m_minimumBatchedConstraints;
+	int m_grainSize;
+
+	friend struct btBatchedSolverLoop;
+
+	int getColorIndex(const btCollisionObject* body);
+	int colorBodies(const btCollisionObject* body0, const btCollisionObject* body1);
+	void sortByColor(btPersistentManifold** manifoldPtr, int numManifolds, btTypedConstraint** constraints, int numConstraints);
+	void buildBatches(const btContactSolverInfo& infoGlobal);
+	void solveBatches(int pass, int iteration, const btContactSolverInfo& infoGlobal);
+	///static bodies are touched by the groups of every batch, the rows see the fixed body of their thread instead.
+	///its velocity stays zero just like the one of the static body
+	btSolverBody& getBatchBody(int solverBodyId, btSolverBody& fixedBody)
+	{
+		return m_staticBodies[solverBodyId] ? fixedBody : m_tmpSolverBodyPool[solverBodyId];
+	}
+	void solveGroups(int pass, int iteration, const btContactSolverInfo& infoGlobal, int iBegin, int iEnd);
+
+protected:
+
+	virtual void convertContacts(btPersistentManifold** manifoldPtr, int numManifolds, const btContactSolverInfo& infoGlobal);
+	virtual btScalar solveGroupCacheFriendlySetup(btCollisionObject** bodies,int numBodies,btPersistentManifold** manifoldPtr, int numManifolds,btTypedConstraint** constraints,int numConstraints,const btContactSolverInfo& infoGlobal,btIDebugDraw* debugDrawer);
+	virtual void solveGroupCacheFriendlySplitImpulseIterations(btCollisionObject** bodies,int numBodies,btPersistentManifold** manifoldPtr, int numManifolds,btTypedConstraint** constraints,int numConstraints,const btContactSolverInfo& infoGlobal,btIDebugDraw* debugDrawer);
+	virtual btScalar solveSingleIteration(int iteration, btCollisionObject** bodies ,int numBodies,btPersistentManifold** manifoldPtr, int numManifolds,btTypedConstraint** constraints,int numConstraints,const btContactSolverInfo& infoGlobal,btIDebugDraw* debugDrawer);
+
+public:
+
+	BT_DECLARE_ALIGNED_ALLOCATOR();
+
+	btSequentialImpulseConstraintSolverMt();
+	virtual ~btSequentialImpulseConstraintSolverMt();
+
+	///islands with fewer manifolds and constraints are solved serially
+	void setMinimumBatchedConstraints(int numConstraints)
+	{
+		m_minimumBatchedConstraints = numConstraints;
+	}
+	int getMinimumBatchedConstraints() const
+	{
+		return m_minimumBatchedConstraints;
+	}
+
+	///smallest number of manifolds and constraints handed to a thread at once
+	void setGrainSize(int grainSize)
+	{
+		m_grainSize = grainSize;
+	}
+	int getGrainSize() const
+	{
+		return m_grainSize;
+	}
+};
+
+#endif //BT_SEQUENTIAL_IMPULSE_CONSTRAINT_SOLVER_MT_H
@@ -878,208 +878,226 @@ public:
 int gNumClampedCcdMotions=0;
 
 
-void	btDiscreteDynamicsWorld::createPredictiveContacts(btScalar timeStep)
+void	btDiscreteDynamicsWorld::releasePredictiveContacts()
 {
-	BT_PROFILE("createPredictiveContacts");
+	BT_PROFILE("release predictive contact manifolds");
 
+	for (int i=0;i<m_predictiveManifolds.size();i++)
 	{
-		BT_PROFILE("release predictive contact manifolds");
-
-		for (int i=0;i<m_predictiveManifolds.size();i++)
-		{
-			btPersistentManifold* manifold = m_predictiveManifolds[i];
-			this->m_dispatcher1->releaseManifold(manifold);
-		}
-		m_predictiveManifolds.clear();
+		btPersistentManifold* manifold = m_predictiveManifolds[i];
+		this->m_dispatcher1->releaseManifold(manifold);
 	}
+	m_predictiveManifolds.clear();
+}
 
-	btTransform predictedTrans;
-	for ( int i=0;i<m_nonStaticRigidBodies.size();i++)
-	{
-		btRigidBody* body = m_nonStaticRigidBodies[i];
-		body->setHitFraction(1.f);
+bool	btDiscreteDynamicsWorld::needsCcdSweep(const btRigidBody* body, const btTransform& predictedTrans) const
+{
+	btScalar squareMotion = (predictedTrans.getOrigin()-body->getWorldTransform().getOrigin()).length2();
 
-		if (body->isActive() && (!body->isStaticOrKinematicObject()))
-		{
+	return getDispatchInfo().m_useContinuous && body->getCcdSquareMotionThreshold() && body->getCcdSquareMotionThreshold() < squareMotion
+		&& body->getCollisionShape()->isConvex();
+}
 
-			body->predictIntegratedTransform(timeStep, predictedTrans);
+void	btDiscreteDynamicsWorld::sweepPredictiveContact(btRigidBody* body, btScalar timeStep, PredictiveContactSweep& sweep)
+{
+	sweep.m_hitObject = 0;
+	sweep.m_swept = false;
+
+	body->setHitFraction(1.f);
 
-			btScalar squareMotion = (predictedTrans.getOrigin()-body->getWorldTransform().getOrigin()).length2();
+	if (body->isActive() && (!body->isStaticOrKinematicObject()))
+	{
+		btTransform predictedTrans;
+		body->predictIntegratedTransform(timeStep, predictedTrans);
 
-			if (getDispatchInfo().m_useContinuous && body->getCcdSquareMotionThreshold() && body->getCcdSquareMotionThreshold() < squareMotion)
+		if (needsCcdSweep(body, predictedTrans))
+		{
+			BT_PROFILE("predictive convexSweepTest");
+			sweep.m_swept = true;
+#ifdef PREDICTIVE_CONTACT_USE_STATIC_ONLY
+			class StaticOnlyCallback : public btClosestNotMeConvexResultCallback
 			{
-				BT_PROFILE("predictive convexSweepTest");
-				if (body->getCollisionShape()->isConvex())
+			public:
+
+				StaticOnlyCallback (btCollisionObject* me,const btVector3& fromA,const btVector3& toA,btOverlappingPairCache* pairCache,btDispatcher* dispatcher) :
+				  btClosestNotMeConvexResultCallback(me,fromA,toA,pairCache,dispatcher)
 				{
-					gNumClampedCcdMotions++;
-#ifdef PREDICTIVE_CONTACT_USE_STATIC_ONLY
-					class StaticOnlyCallback : public btClosestNotMeConvexResultCallback
-					{
-					public:
-
-						StaticOnlyCallback (btCollisionObject* me,const btVector3& fromA,const btVector3& toA,btOverlappingPairCache* pairCache,btDispatcher* dispatcher) :
-						  btClosestNotMeConvexResultCallback(me,fromA,toA,pairCache,dispatcher)
-						{
-						}
-
-					  	virtual bool needsCollision(btBroadphaseProxy* proxy0) const
-						{
-							btCollisionObject* otherObj = (btCollisionObject*) proxy0->m_clientObject;
-							if (!otherObj->isStaticOrKinematicObject())
-								return false;
-							return btClosestNotMeConvexResultCallback::needsCollision(proxy0);
-						}
-					};
-
-					StaticOnlyCallback sweepResults(body,body->getWorldTransform().getOrigin(),predictedTrans.getOrigin(),getBroadphase()->getOverlappingPairCache(),getDispatcher());
+				}
+
+			  	virtual bool needsCollision(btBroadphaseProxy* proxy0) const
+				{
+					btCollisionObject* otherObj = (btCollisionObject*) proxy0->m_clientObject;
+					if (!otherObj->isStaticOrKinematicObject())
+						return false;
+					return btClosestNotMeConvexResultCallback::needsCollision(proxy0);
+				}
+			};
+
+			StaticOnlyCallback sweepResults(body,body->getWorldTransform().getOrigin(),predictedTrans.getOrigin(),getBroadphase()->getOverlappingPairCache(),getDispatcher());
 #else
-					btClosestNotMeConvexResultCallback sweepResults(body,body->getWorldTransform().getOrigin(),predictedTrans.getOrigin(),getBroadphase()->getOverlappingPairCache(),getDispatcher());
+			btClosestNotMeConvexResultCallback sweepResults(body,body->getWorldTransform().getOrigin(),predictedTrans.getOrigin(),getBroadphase()->getOverlappingPairCache(),getDispatcher());
 #endif
-					//btConvexShape* convexShape = static_cast<btConvexShape*>(body->getCollisionShape());
-					btSphereShape tmpSphere(body->getCcdSweptSphereRadius());//btConvexShape* convexShape = static_cast<btConvexShape*>(body->getCollisionShape());
-					sweepResults.m_allowedPenetration=getDispatchInfo().m_allowedCcdPenetration;
+			//btConvexShape* convexShape = static_cast<btConvexShape*>(body->getCollisionShape());
+			btSphereShape tmpSphere(body->getCcdSweptSphereRadius());//btConvexShape* convexShape = static_cast<btConvexShape*>(body->getCollisionShape());
+			sweepResults.m_allowedPenetration=getDispatchInfo().m_allowedCcdPenetration;
 
-					sweepResults.m_collisionFilterGroup = body->getBroadphaseProxy()->m_collisionFilterGroup;
-					sweepResults.m_collisionFilterMask  = body->getBroadphaseProxy()->m_collisionFilterMask;
-					btTransform modifiedPredictedTrans = predictedTrans;
-					modifiedPredictedTrans.setBasis(body->getWorldTransform().getBasis());
+			sweepResults.m_collisionFilterGroup = body->getBroadphaseProxy()->m_collisionFilterGroup;
+			sweepResults.m_collisionFilterMask  = body->getBroadphaseProxy()->m_collisionFilterMask;
+			btTransform modifiedPredictedTrans = predictedTrans;
+			modifiedPredictedTrans.setBasis(body->getWorldTransform().getBasis());
 
-					convexSweepTest(&tmpSphere,body->getWorldTransform(),modifiedPredictedTrans,sweepResults);
-					if (sweepResults.hasHit() && (sweepResults.m_closestHitFraction < 1.f))
-					{
-
-						btVector3 distVec = (predictedTrans.getOrigin()-body->getWorldTransform().getOrigin())*sweepResults.m_closestHitFraction;
-						btScalar distance = distVec.dot(-sweepResults.m_hitNormalWorld);
+			convexSweepTest(&tmpSphere,body->getWorldTransform(),modifiedPredictedTrans,sweepResults);
+			if (sweepResults.hasHit() && (sweepResults.m_closestHitFraction < 1.f))
+			{
+				sweep.m_hitObject = sweepResults.m_hitCollisionObject;
+				sweep.m_hitMotion = (predictedTrans.getOrigin()-body->getWorldTransform().getOrigin())*sweepResults.m_closestHitFraction;
+				sweep.m_hitNormalWorld = sweepResults.m_hitNormalWorld;
+			}
+		}
+	}
+}
 
+void	btDiscreteDynamicsWorld::addPredictiveContact(btRigidBody* body, const PredictiveContactSweep& sweep)
+{
+	if (sweep.m_swept)
+		gNumClampedCcdMotions++;
 
-						btPersistentManifold* manifold = m_dispatcher1->getNewManifold(body,sweepResults.m_hitCollisionObject);
-						m_predictiveManifolds.push_back(manifold);
+	if (sweep.m_hitObject)
+	{
+		btScalar distance = sweep.m_hitMotion.dot(-sweep.m_hitNormalWorld);
 
-						btVector3 worldPointB = body->getWorldTransform().getOrigin()+distVec;
-						btVector3 localPointB = sweepResults.m_hitCollisionObject->getWorldTransform().inverse()*worldPointB;
+		btPersistentManifold* manifold = m_dispatcher1->getNewManifold(body,sweep.m_hitObject);
+		m_predictiveManifolds.push_back(manifold);
 
-						btManifoldPoint newPoint(btVector3(0,0,0), localPointB,sweepResults.m_hitNormalWorld,distance);
+		btVector3 worldPointB = body->getWorldTransform().getOrigin()+sweep.m_hitMotion;
+		btVector3 localPointB = sweep.m_hitObject->getWorldTransform().inverse()*worldPointB;
 
-						bool isPredictive = true;
-						int index = manifold->addManifoldPoint(newPoint, isPredictive);
-						btManifoldPoint& pt = manifold->getContactPoint(index);
-						pt.m_combinedRestitution = 0;
-						pt.m_combinedFriction = btManifoldResult::calculateCombinedFriction(body,sweepResults.m_hitCollisionObject);
-						pt.m_positionWorldOnA = body->getWorldTransform().getOrigin();
-						pt.m_positionWorldOnB = worldPointB;
+		btManifoldPoint newPoint(btVector3(0,0,0), localPointB,sweep.m_hitNormalWorld,distance);
 
-					}
-				}
-			}
-		}
+		bool isPredictive = true;
+		int index = manifold->addManifoldPoint(newPoint, isPredictive);
+		btManifoldPoint& pt = manifold->getContactPoint(index);
+		pt.m_combinedRestitution = 0;
+		pt.m_combinedFriction = btManifoldResult::calculateCombinedFriction(body,sweep.m_hitObject);
+		pt.m_positionWorldOnA = body->getWorldTransform().getOrigin();
+		pt.m_positionWorldOnB = worldPointB;
 	}
 }
-void	btDiscreteDynamicsWorld::integrateTransforms(btScalar timeStep)
+
+void	btDiscreteDynamicsWorld::createPredictiveContacts(btScalar timeStep)
 {
-	BT_PROFILE("integrateTransforms");
-	btTransform predictedTrans;
+	BT_PROFILE("createPredictiveContacts");
+
+	releasePredictiveContacts();
+
+	PredictiveContactSweep sweep;
 	for ( int i=0;i<m_nonStaticRigidBodies.size();i++)
 	{
 		btRigidBody* body = m_nonStaticRigidBodies[i];
-		body->setHitFraction(1.f);
-
-		if (body->isActive() && (!body->isStaticOrKinematicObject()))
-		{
+		sweepPredictiveContact(body, timeStep, sweep);
+		addPredictiveContact(body, sweep);
+	}
+}
 
-			body->predictIntegratedTransform(timeStep, predictedTrans);
+void	btDiscreteDynamicsWorld::integrateTransformCcd(btRigidBody* body, const btTransform& predictedTrans, btScalar timeStep)
+{
+	BT_PROFILE("CCD motion clamping");
+	gNumClampedCcdMotions++;
+	applyCcdMotion(body, predictedTrans, sweepCcdMotion(body, predictedTrans), timeStep);
+}
 
-			btScalar squareMotion = (predictedTrans.getOrigin()-body->getWorldTransform().getOrigin()).length2();
+btScalar	btDiscreteDynamicsWorld::sweepCcdMotion(btRigidBody* body, const btTransform& predictedTrans)
+{
+#ifdef USE_STATIC_ONLY
+	class StaticOnlyCallback : public btClosestNotMeConvexResultCallback
+	{
+	public:
 
+		StaticOnlyCallback (btCollisionObject* me,const btVector3& fromA,const btVector3& toA,btOverlappingPairCache* pairCache,btDispatcher* dispatcher) :
+		  btClosestNotMeConvexResultCallback(me,fromA,toA,pairCache,dispatcher)
+		{
+		}
 
+	  	virtual bool needsCollision(btBroadphaseProxy* proxy0) const
+		{
+			btCollisionObject* otherObj = (btCollisionObject*) proxy0->m_clientObject;
+			if (!otherObj->isStaticOrKinematicObject())
+				return false;
+			return btClosestNotMeConvexResultCallback::needsCollision(proxy0);
+		}
+	};
 
-			if (getDispatchInfo().m_useContinuous && body->getCcdSquareMotionThreshold() && body->getCcdSquareMotionThreshold() < squareMotion)
-			{
-				BT_PROFILE("CCD motion clamping");
-				if (body->getCollisionShape()->isConvex())
-				{
-					gNumClampedCcdMotions++;
-#ifdef USE_STATIC_ONLY
-					class StaticOnlyCallback : public btClosestNotMeConvexResultCallback
-					{
-					public:
-
-						StaticOnlyCallback (btCollisionObject* me,const btVector3& fromA,const btVector3& toA,btOverlappingPairCache* pairCache,btDispatcher* dispatcher) :
-						  btClosestNotMeConvexResultCallback(me,fromA,toA,pairCache,dispatcher)
-						{
-						}
-
-					  	virtual bool needsCollision(btBroadphaseProxy* proxy0) const
-						{
-							btCollisionObject* otherObj = (btCollisionObject*) proxy0->m_clientObject;
-							if (!otherObj->isStaticOrKinematicObject())
-								return false;
-							return btClosestNotMeConvexResultCallback::needsCollision(proxy0);
-						}
-					};
-
-					StaticOnlyCallback sweepResults(body,body->getWorldTransform().getOrigin(),predictedTrans.getOrigin(),getBroadphase()->getOverlappingPairCache(),getDispatcher());
+	StaticOnlyCallback sweepResults(body,body->getWorldTransform().getOrigin(),predictedTrans.getOrigin(),getBroadphase()->getOverlappingPairCache(),getDispatcher());
 #else
-					btClosestNotMeConvexResultCallback sweepResults(body,body->getWorldTransform().getOrigin(),predictedTrans.getOrigin(),getBroadphase()->getOverlappingPairCache(),getDispatcher());
+	btClosestNotMeConvexResultCallback sweepResults(body,body->getWorldTransform().getOrigin(),predictedTrans.getOrigin(),getBroadphase()->getOverlappingPairCache(),getDispatcher());
 #endif
-					//btConvexShape* convexShape = static_cast<btConvexShape*>(body->getCollisionShape());
-					btSphereShape tmpSphere(body->getCcdSweptSphereRadius());//btConvexShape* convexShape = static_cast<btConvexShape*>(body->getCollisionShape());
-					sweepResults.m_allowedPenetration=getDispatchInfo().m_allowedCcdPenetration;
+	//btConvexShape* convexShape = static_cast<btConvexShape*>(body->getCollisionShape());
+	btSphereShape tmpSphere(body->getCcdSweptSphereRadius());//btConvexShape* convexShape = static_cast<btConvexShape*>(body->getCollisionShape());
+	sweepResults.m_allowedPenetration=getDispatchInfo().m_allowedCcdPenetration;
 
-					sweepResults.m_collisionFilterGroup = body->getBroadphaseProxy()->m_collisionFilterGroup;
-					sweepResults.m_collisionFilterMask  = body->getBroadphaseProxy()->m_collisionFilterMask;
-					btTransform modifiedPredictedTrans = predictedTrans;
-					modifiedPredictedTrans.setBasis(body->getWorldTransform().getBasis());
+	sweepResults.m_collisionFilterGroup = body->getBroadphaseProxy()->m_collisionFilterGroup;
+	sweepResults.m_collisionFilterMask  = body->getBroadphaseProxy()->m_collisionFilterMask;
+	btTransform modifiedPredictedTrans = predictedTrans;
+	modifiedPredictedTrans.setBasis(body->getWorldTransform().getBasis());
 
-					convexSweepTest(&tmpSphere,body->getWorldTransform(),modifiedPredictedTrans,sweepResults);
-					if (sweepResults.hasHit() && (sweepResults.m_closestHitFraction < 1.f))
-					{
+	convexSweepTest(&tmpSphere,body->getWorldTransform(),modifiedPredictedTrans,sweepResults);
+	if (sweepResults.hasHit() && (sweepResults.m_closestHitFraction < 1.f))
+		return sweepResults.m_closestHitFraction;
 
-						//printf("clamped integration to hit fraction = %f\n",fraction);
-						body->setHitFraction(sweepResults.m_closestHitFraction);
-						body->predictIntegratedTransform(timeStep*body->getHitFraction(), predictedTrans);
-						body->setHitFraction(0.f);
-						body->proceedToTransform( predictedTrans);
+	return btScalar(1.);
+}
 
-#if 0
-						btVector3 linVel = body->getLinearVelocity();
-
-						btScalar maxSpeed = body->getCcdMotionThreshold()/getSolverInfo().m_timeStep;
-						btScalar maxSpeedSqr = maxSpeed*maxSpeed;
-						if (linVel.length2()>maxSpeedSqr)
-						{
-							linVel.normalize();
-							linVel*= maxSpeed;
-							body->setLinearVelocity(linVel);
-							btScalar ms2 = body->getLinearVelocity().length2();
-							body->predictIntegratedTransform(timeStep, predictedTrans);
-
-							btScalar sm2 = (predictedTrans.getOrigin()-body->getWorldTransform().getOrigin()).length2();
-							btScalar smt = body->getCcdSquareMotionThreshold();
-							printf("sm2=%f\n",sm2);
-						}
-#else
+void	btDiscreteDynamicsWorld::applyCcdMotion(btRigidBody* body, const btTransform& predictedTrans, btScalar hitFraction, btScalar timeStep)
+{
+	if (hitFraction < 1.f)
+	{
 
-						//don't apply the collision response right now, it will happen next frame
-						//if you really need to, you can uncomment next 3 lines. Note that is uses zero restitution.
-						//btScalar appliedImpulse = 0.f;
-						//btScalar depth = 0.f;
-						//appliedImpulse = resolveSingleCollision(body,(btCollisionObject*)sweepResults.m_hitCollisionObject,sweepResults.m_hitPointWorld,sweepResults.m_hitNormalWorld,getSolverInfo(), depth);
+		//printf("clamped integration to hit fraction = %f\n",fraction);
+		body->setHitFraction(hitFraction);
+		btTransform clampedTrans;
+		body->predictIntegratedTransform(timeStep*body->getHitFraction(), clampedTrans);
+		body->setHitFraction(0.f);
+		body->proceedToTransform( clampedTrans);
+
+		//don't apply the collision response right now, it will happen next frame
+		//if you really need to, you can uncomment next 3 lines. Note that is uses zero restitution.
+		//btScalar appliedImpulse = 0.f;
+		//btScalar depth = 0.f;
+		//appliedImpulse = resolveSingleCollision(body,(btCollisionObject*)sweepResults.m_hitCollisionObject,sweepResults.m_hitPointWorld,sweepResults.m_hitNormalWorld,getSolverInfo(), depth);
+		return;
+	}
 
+	body->proceedToTransform( predictedTrans);
+}
 
-#endif
+void	btDiscreteDynamicsWorld::integrateTransforms(btScalar timeStep)
+{
+	BT_PROFILE("integrateTransforms");
+	btTransform predictedTrans;
+	for ( int i=0;i<m_nonStaticRigidBodies.size();i++)
+	{
+		btRigidBody* body = m_nonStaticRigidBodies[i];
+		body->setHitFraction(1.f);
 
-        				continue;
-					}
-				}
-			}
+		if (body->isActive() && (!body->isStaticOrKinematicObject()))
+		{
 
+			body->predictIntegratedTransform(timeStep, predictedTrans);
 
-			body->proceedToTransform( predictedTrans);
+			if (needsCcdSweep(body, predictedTrans))
+				integrateTransformCcd(body, predictedTrans, timeStep);
+			else
+				body->proceedToTransform( predictedTrans);
 
 		}
 
 	}
 
+	applySpeculativeContactRestitution();
+}
+
+void	btDiscreteDynamicsWorld::applySpeculativeContactRestitution()
+{
 	///this should probably be switched on by default, but it is not well tested yet
 	if (m_applySpeculativeContactRestitution)
 	{
@@ -1125,9 +1143,15 @@ void	btDiscreteDynamicsWorld::integrateTransforms(btScalar timeStep)
 void	btDiscreteDynamicsWorld::predictUnconstraintMotion(btScalar timeStep)
 {
 	BT_PROFILE("predictUnconstraintMotion");
-	for ( int i=0;i<m_nonStaticRigidBodies.size();i++)
+	if (m_nonStaticRigidBodies.size())
+		predictUnconstraintMotionInternal(&m_nonStaticRigidBodies[0], m_nonStaticRigidBodies.size(), timeStep);
+}
+
+void	btDiscreteDynamicsWorld::predictUnconstraintMotionInternal(btRigidBody** bodies, int numBodies, btScalar timeStep)
+{
+	for ( int i=0;i<numBodies;i++)
 	{
-		btRigidBody* body = m_nonStaticRigidBodies[i];
+		btRigidBody* body = bodies[i];
 		if (!body->isStaticOrKinematicObject())
 		{
 			//don't integrate/update velocities here, it happens in the constraint solver
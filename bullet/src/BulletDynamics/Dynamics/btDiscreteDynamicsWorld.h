@@ -69,9 +69,35 @@ protected:
 
 	btAlignedObjectArray<btPersistentManifold*>	m_predictiveManifolds;
 
+	///PredictiveContactSweep is the closest hit of the CCD sweep of a body, addPredictiveContact turns it into a predictive contact
+	struct	PredictiveContactSweep
+	{
+		const btCollisionObject*	m_hitObject;
+		btVector3	m_hitMotion;
+		btVector3	m_hitNormalWorld;
+		bool	m_swept;
+	};
+
 	virtual void	predictUnconstraintMotion(btScalar timeStep);
+
+	void	predictUnconstraintMotionInternal(btRigidBody** bodies, int numBodies, btScalar timeStep);
 	
 	virtual void	integrateTransforms(btScalar timeStep);
+
+	///returns true if the motion of the body to predictedTrans is large enough to be swept for continuous collision detection
+	bool	needsCcdSweep(const btRigidBody* body, const btTransform& predictedTrans) const;
+
+	///moves the body to predictedTrans, or to the first hit of its CCD sweep. The sweep reads the current transforms of the other bodies.
+	void	integrateTransformCcd(btRigidBody* body, const btTransform& predictedTrans, btScalar timeStep);
+
+	///returns the fraction of the motion of the body to predictedTrans before the first hit of its CCD sweep, or 1 if nothing is hit.
+	///It only reads the world, so bodies can be swept in parallel as long as none of them moves.
+	btScalar	sweepCcdMotion(btRigidBody* body, const btTransform& predictedTrans);
+
+	///moves the body to predictedTrans, clamped to hitFraction of the motion as returned by sweepCcdMotion
+	void	applyCcdMotion(btRigidBody* body, const btTransform& predictedTrans, btScalar hitFraction, btScalar timeStep);
+
+	void	applySpeculativeContactRestitution();
 		
 	virtual void	calculateSimulationIslands();
 
@@ -85,7 +111,14 @@ protected:
 
 	virtual void	internalSingleStepSimulation( btScalar timeStep);
 
-	void	createPredictiveContacts(btScalar timeStep);
+	virtual void	createPredictiveContacts(btScalar timeStep);
+
+	void	releasePredictiveContacts();
+
+	///sweeps the body for a predictive contact. It only writes to the body and sweep, so bodies can be swept in parallel.
+	void	sweepPredictiveContact(btRigidBody* body, btScalar timeStep, PredictiveContactSweep& sweep);
+
+	void	addPredictiveContact(btRigidBody* body, const PredictiveContactSweep& sweep);
 
 	virtual void	saveKinematicState(btScalar timeStep);
 
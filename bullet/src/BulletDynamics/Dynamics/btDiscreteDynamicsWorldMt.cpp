@@ -0,0 +1,562 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2009 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include "btDiscreteDynamicsWorldMt.h"
+
+#include "BulletCollision/CollisionDispatch/btSimulationIslandManager.h"
+#include "BulletCollision/CollisionShapes/btSphereShape.h"
+#include "BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolver.h"
+#include "BulletDynamics/ConstraintSolver/btTypedConstraint.h"
+#include "BulletDynamics/Dynamics/btRigidBody.h"
+#include "LinearMath/btQuickprof.h"
+
+extern int gNumClampedCcdMotions;
+
+
+void btConstraintSolverPoolMt::init(btConstraintSolver** solvers, int numSolvers)
+{
+	btAssert(numSolvers > 0);
+	m_solvers.resize(numSolvers);
+	for (int i = 0; i < numSolvers; ++i)
+	{
+		btAssert(solvers[i]->getSolverType() == solvers[0]->getSolverType());
+		m_solvers[i].m_solver = solvers[i];
+	}
+	m_solverType = solvers[0]->getSolverType();
+}
+
+btConstraintSolverPoolMt::btConstraintSolverPoolMt(int numSolvers)
+{
+	btAlignedObjectArray<btConstraintSolver*> solvers;
+	solvers.reserve(numSolvers);
+	for (int i = 0; i < numSolvers; ++i)
+		solvers.push_back(new btSequentialImpulseConstraintSolver());
+	init(&solvers[0], numSolvers);
+}
+
+btConstraintSolverPoolMt::btConstraintSolverPoolMt(btConstraintSolver** solvers, int numSolvers)
+{
+	init(solvers, numSolvers);
+}
+
+btConstraintSolverPoolMt::~btConstraintSolverPoolMt()
+{
+	for (int i = 0; i < m_solvers.size(); ++i)
+		delete m_solvers[i].m_solver;
+}
+
+btConstraintSolverPoolMt::ThreadSolver* btConstraintSolverPoolMt::getAndLockThreadSolver()
+{
+	const int start = btGetCurrentThreadIndex() % m_solvers.size();
+	for (;;)
+	{
+		for (int i = 0; i < m_solvers.size(); ++i)
+		{
+			ThreadSolver* solver = &m_solvers[(start + i) % m_solvers.size()];
+			if (solver->m_mutex.tryLock())
+				return solver;
+		}
+	}
+}
+
+void btConstraintSolverPoolMt::prepareSolve(int numBodies, int numManifolds)
+{
+	for (int i = 0; i < m_solvers.size(); ++i)
+		m_solvers[i].m_solver->prepareSolve(numBodies, numManifolds);
+}
+
+btScalar btConstraintSolverPoolMt::solveGroup(btCollisionObject** bodies,int numBodies,btPersistentManifold** manifolds,int numManifolds,btTypedConstraint** constraints,int numConstraints,const btContactSolverInfo& info,btIDebugDraw* debugDrawer,btDispatcher* dispatcher)
+{
+	ThreadSolver* solver = getAndLockThreadSolver();
+	solver->m_solver->solveGroup(bodies, numBodies, manifolds, numManifolds, constraints, numConstraints, info, debugDrawer, dispatcher);
+	solver->m_mutex.unlock();
+	return 0.f;
+}
+
+void btConstraintSolverPoolMt::allSolved(const btContactSolverInfo& info,btIDebugDraw* debugDrawer)
+{
+	for (int i = 0; i < m_solvers.size(); ++i)
+		m_solvers[i].m_solver->allSolved(info, debugDrawer);
+}
+
+void btConstraintSolverPoolMt::reset()
+{
+	for (int i = 0; i < m_solvers.size(); ++i)
+		m_solvers[i].m_solver->reset();
+}
+
+
+SIMD_FORCE_INLINE	int	btGetConstraintIslandIdMt(const btTypedConstraint* lhs)
+{
+	const btCollisionObject& rcolObj0 = lhs->getRigidBodyA();
+	const btCollisionObject& rcolObj1 = lhs->getRigidBodyB();
+	return rcolObj0.getIslandTag()>=0?rcolObj0.getIslandTag():rcolObj1.getIslandTag();
+}
+
+///same order as the constraints of btDiscreteDynamicsWorld, so the islands are solved the same way
+class btSortConstraintOnIslandPredicateMt
+{
+	public:
+
+		bool operator() ( const btTypedConstraint* lhs, const btTypedConstraint* rhs ) const
+		{
+			return btGetConstraintIslandIdMt(lhs) < btGetConstraintIslandIdMt(rhs);
+		}
+};
+
+
+///btIslandBatchCallbackMt gathers the islands into batches like InplaceSolverIslandCallback, but solves them after all islands are known.
+///Batches don't share dynamic bodies, so they can be solved in any order on any thread.
+struct btIslandBatchCallbackMt : public btSimulationIslandManager::IslandCallback
+{
+	struct Batch
+	{
+		int m_bodyBegin, m_bodyEnd;
+		int m_manifoldBegin, m_manifoldEnd;
+		int m_constraintBegin, m_constraintEnd;
+
+		int getCost() const
+		{
+			return (m_manifoldEnd - m_manifoldBegin) + (m_constraintEnd - m_constraintBegin) + (m_bodyEnd - m_bodyBegin);
+		}
+	};
+
+	///larger batches are started first, so they don't end up last on a single thread
+	class SortBatchPredicate
+	{
+		const btAlignedObjectArray<Batch>* m_batches;
+	public:
+		SortBatchPredicate(const btAlignedObjectArray<Batch>& batches)
+			:m_batches(&batches)
+		{
+		}
+		bool operator() (int lhs, int rhs) const
+		{
+			const int lhsCost = (*m_batches)[lhs].getCost();
+			const int rhsCost = (*m_batches)[rhs].getCost();
+			return lhsCost != rhsCost ? lhsCost > rhsCost : lhs < rhs;
+		}
+	};
+
+	struct SolveLoop : public btIParallelForBody
+	{
+		const btIslandBatchCallbackMt* m_batches;
+
+		SolveLoop(const btIslandBatchCallbackMt* batches)
+			:m_batches(batches)
+		{
+		}
+		void forLoop(int iBegin, int iEnd) const
+		{
+			for (int i = iBegin; i < iEnd; ++i)
+				m_batches->solveBatch(m_batches->m_batches[m_batches->m_order[i]]);
+		}
+	};
+
+	btContactSolverInfo*	m_solverInfo;
+	btConstraintSolver*		m_solver;
+	btTypedConstraint**		m_sortedConstraints;
+	int						m_numConstraints;
+	int						m_nextConstraint;
+	btIDebugDraw*			m_debugDrawer;
+	btDispatcher*			m_dispatcher;
+
+	btAlignedObjectArray<btCollisionObject*> m_bodies;
+	btAlignedObjectArray<btPersistentManifold*> m_manifolds;
+	btAlignedObjectArray<btTypedConstraint*> m_constraints;
+	btAlignedObjectArray<Batch> m_batches;
+	btAlignedObjectArray<int> m_order;
+	Batch m_openBatch;
+
+	btIslandBatchCallbackMt()
+		:m_solverInfo(NULL),
+		m_solver(NULL),
+		m_sortedConstraints(NULL),
+		m_numConstraints(0),
+		m_nextConstraint(0),
+		m_debugDrawer(NULL),
+		m_dispatcher(NULL)
+	{
+	}
+
+	void setup(btContactSolverInfo* solverInfo, btConstraintSolver* solver, btTypedConstraint** sortedConstraints, int numConstraints, btIDebugDraw* debugDrawer, btDispatcher* dispatcher)
+	{
+		btAssert(solverInfo);
+		m_solverInfo = solverInfo;
+		m_solver = solver;
+		m_sortedConstraints = sortedConstraints;
+		m_numConstraints = numConstraints;
+		m_nextConstraint = 0;
+		m_debugDrawer = debugDrawer;
+		m_dispatcher = dispatcher;
+		m_bodies.resize(0);
+		m_manifolds.resize(0);
+		m_constraints.resize(0);
+		m_batches.resize(0);
+		openBatch();
+	}
+
+	void openBatch()
+	{
+		m_openBatch.m_bodyBegin = m_openBatch.m_bodyEnd = m_bodies.size();
+		m_openBatch.m_manifoldBegin = m_openBatch.m_manifoldEnd = m_manifolds.size();
+		m_openBatch.m_constraintBegin = m_openBatch.m_constraintEnd = m_constraints.size();
+	}
+
+	void closeBatch()
+	{
+		m_openBatch.m_bodyEnd = m_bodies.size();
+		m_openBatch.m_manifoldEnd = m_manifolds.size();
+		m_openBatch.m_constraintEnd = m_constraints.size();
+		if (m_openBatch.getCost())
+			m_batches.push_back(m_openBatch);
+		openBatch();
+	}
+
+	virtual	void	processIsland(btCollisionObject** bodies,int numBodies,btPersistentManifold**	manifolds,int numManifolds, int islandId)
+	{
+		int i;
+		if (islandId<0)
+		{
+			///we don't split islands, so all constraints/contact manifolds/bodies are solved as a single batch
+			for (i=0;i<numBodies;i++)
+				m_bodies.push_back(bodies[i]);
+			for (i=0;i<numManifolds;i++)
+				m_manifolds.push_back(manifolds[i]);
+			for (i=0;i<m_numConstraints;i++)
+				m_constraints.push_back(m_sortedConstraints[i]);
+			closeBatch();
+			return;
+		}
+
+		//islands come in increasing id order, like the sorted constraints
+		while (m_nextConstraint<m_numConstraints && btGetConstraintIslandIdMt(m_sortedConstraints[m_nextConstraint])<islandId)
+			m_nextConstraint++;
+		for (;m_nextConstraint<m_numConstraints && btGetConstraintIslandIdMt(m_sortedConstraints[m_nextConstraint])==islandId;m_nextConstraint++)
+			m_constraints.push_back(m_sortedConstraints[m_nextConstraint]);
+
+		//static and kinematic objects form islands on their own, but they can touch any number of islands,
+		//so they are left to the solvers, which don't write to them
+		for (i=0;i<numBodies;i++)
+		{
+			if (!bodies[i]->isStaticOrKinematicObject())
+				m_bodies.push_back(bodies[i]);
+		}
+		for (i=0;i<numManifolds;i++)
+			m_manifolds.push_back(manifolds[i]);
+
+		const int numBatchConstraints = (m_constraints.size()-m_openBatch.m_constraintBegin)+(m_manifolds.size()-m_openBatch.m_manifoldBegin);
+		if (m_solverInfo->m_minimumSolverBatchSize<=1 || numBatchConstraints>m_solverInfo->m_minimumSolverBatchSize)
+			closeBatch();
+	}
+
+	void	solveBatch(const Batch& batch) const
+	{
+		btCollisionObject** bodies = batch.m_bodyEnd>batch.m_bodyBegin ? const_cast<btCollisionObject**>(&m_bodies[batch.m_bodyBegin]) : 0;
+		btPersistentManifold** manifolds = batch.m_manifoldEnd>batch.m_manifoldBegin ? const_cast<btPersistentManifold**>(&m_manifolds[batch.m_manifoldBegin]) : 0;
+		btTypedConstraint** constraints = batch.m_constraintEnd>batch.m_constraintBegin ? const_cast<btTypedConstraint**>(&m_constraints[batch.m_constraintBegin]) : 0;
+		m_solver->solveGroup(bodies,batch.m_bodyEnd-batch.m_bodyBegin,manifolds,batch.m_manifoldEnd-batch.m_manifoldBegin,
+			constraints,batch.m_constraintEnd-batch.m_constraintBegin,*m_solverInfo,m_debugDrawer,m_dispatcher);
+	}
+
+	void	solveBatches()
+	{
+		closeBatch();
+		m_order.resize(m_batches.size());
+		for (int i=0;i<m_batches.size();i++)
+			m_order[i] = i;
+		m_order.quickSort(SortBatchPredicate(m_batches));
+
+		BT_PROFILE("solveBatches");
+		btParallelFor(0, m_batches.size(), 1, SolveLoop(this));
+	}
+};
+
+
+///what integrateTransforms does with a body, decided in parallel before any body is moved
+enum btIntegrateMode
+{
+	BT_INTEGRATE_NONE,
+	BT_INTEGRATE_MOVE,
+	BT_INTEGRATE_CCD,		///< swept in body order, after the bodies before it are moved
+	BT_INTEGRATE_CCD_SWEPT	///< swept ahead, its hit fraction is in m_ccdHitFractions
+};
+
+enum btIntegratePass
+{
+	BT_INTEGRATE_PASS_PREDICT,
+	BT_INTEGRATE_PASS_SWEEP,
+	BT_INTEGRATE_PASS_MOVE
+};
+
+struct btIntegrateTransformsLoop : public btIParallelForBody
+{
+	btDiscreteDynamicsWorldMt* m_world;
+	btRigidBody** m_bodies;
+	btScalar m_timeStep;
+	btIntegratePass m_pass;
+
+	btIntegrateTransformsLoop(btDiscreteDynamicsWorldMt* world, btRigidBody** bodies, btScalar timeStep, btIntegratePass pass)
+		:m_world(world),
+		m_bodies(bodies),
+		m_timeStep(timeStep),
+		m_pass(pass)
+	{
+	}
+	void forLoop(int iBegin, int iEnd) const
+	{
+		for (int i = iBegin; i < iEnd; ++i)
+		{
+			btRigidBody* body = m_bodies[i];
+			btTransform& predictedTrans = m_world->m_predictedTransforms[i];
+			if (m_pass == BT_INTEGRATE_PASS_SWEEP)
+			{
+				if (m_world->m_integrateModes[i] == BT_INTEGRATE_CCD && !m_world->ccdSweepSeesMovedBody(i))
+				{
+					m_world->m_ccdHitFractions[i] = m_world->sweepCcdMotion(body, predictedTrans);
+					m_world->m_integrateModes[i] = BT_INTEGRATE_CCD_SWEPT;
+				}
+				continue;
+			}
+			if (m_pass == BT_INTEGRATE_PASS_MOVE)
+			{
+				if (m_world->m_integrateModes[i] == BT_INTEGRATE_MOVE)
+					body->proceedToTransform(predictedTrans);
+				else if (m_world->m_integrateModes[i] == BT_INTEGRATE_CCD_SWEPT)
+					m_world->applyCcdMotion(body, predictedTrans, m_world->m_ccdHitFractions[i], m_timeStep);
+				continue;
+			}
+
+			char mode = BT_INTEGRATE_NONE;
+			body->setHitFraction(1.f);
+			if (body->isActive() && (!body->isStaticOrKinematicObject()))
+			{
+				body->predictIntegratedTransform(m_timeStep, predictedTrans);
+				mode = m_world->needsCcdSweep(body, predictedTrans) ? BT_INTEGRATE_CCD : BT_INTEGRATE_MOVE;
+			}
+			m_world->m_integrateModes[i] = mode;
+		}
+	}
+};
+
+///finds a moving body before the swept one among the broadphase candidates of its CCD sweep
+struct btCcdMovedBodyCallback : public btBroadphaseAabbCallback
+{
+	const btHashMap<btHashPtr, int>& m_movingBodies;
+	const btCollisionObject* m_body;
+	int m_bodyIndex;
+	bool m_found;
+
+	btCcdMovedBodyCallback(const btHashMap<btHashPtr, int>& movingBodies, const btCollisionObject* body, int bodyIndex)
+		:m_movingBodies(movingBodies),
+		m_body(body),
+		m_bodyIndex(bodyIndex),
+		m_found(false)
+	{
+	}
+	virtual bool process(const btBroadphaseProxy* proxy)
+	{
+		const btCollisionObject* object = (const btCollisionObject*)proxy->m_clientObject;
+		if (object != m_body)
+		{
+			const int* index = m_movingBodies.find(btHashPtr(object));
+			if (index && *index < m_bodyIndex)
+				m_found = true;
+		}
+		return true;
+	}
+};
+
+struct btPredictiveContactsLoop : public btIParallelForBody
+{
+	btDiscreteDynamicsWorldMt* m_world;
+	btRigidBody** m_bodies;
+	btScalar m_timeStep;
+
+	btPredictiveContactsLoop(btDiscreteDynamicsWorldMt* world, btRigidBody** bodies, btScalar timeStep)
+		:m_world(world),
+		m_bodies(bodies),
+		m_timeStep(timeStep)
+	{
+	}
+	void forLoop(int iBegin, int iEnd) const
+	{
+		for (int i = iBegin; i < iEnd; ++i)
+			m_world->sweepPredictiveContact(m_bodies[i], m_timeStep, m_world->m_predictiveSweeps[i]);
+	}
+};
+
+struct btPredictUnconstraintMotionLoop : public btIParallelForBody
+{
+	btDiscreteDynamicsWorldMt* m_world;
+	btRigidBody** m_bodies;
+	btScalar m_timeStep;
+
+	btPredictUnconstraintMotionLoop(btDiscreteDynamicsWorldMt* world, btRigidBody** bodies, btScalar timeStep)
+		:m_world(world),
+		m_bodies(bodies),
+		m_timeStep(timeStep)
+	{
+	}
+	void forLoop(int iBegin, int iEnd) const
+	{
+		m_world->predictUnconstraintMotionInternal(m_bodies + iBegin, iEnd - iBegin, m_timeStep);
+	}
+};
+
+
+btDiscreteDynamicsWorldMt::btDiscreteDynamicsWorldMt(btDispatcher* dispatcher,btBroadphaseInterface* pairCache,btConstraintSolverPoolMt* constraintSolver,btCollisionConfiguration* collisionConfiguration)
+:btDiscreteDynamicsWorld(dispatcher,pairCache,constraintSolver,collisionConfiguration),
+m_grainSize(64)
+{
+	void* mem = btAlignedAlloc(sizeof(btIslandBatchCallbackMt),16);
+	m_islandBatches = new (mem) btIslandBatchCallbackMt();
+}
+
+btDiscreteDynamicsWorldMt::~btDiscreteDynamicsWorldMt()
+{
+	m_islandBatches->~btIslandBatchCallbackMt();
+	btAlignedFree(m_islandBatches);
+}
+
+void	btDiscreteDynamicsWorldMt::solveConstraints(btContactSolverInfo& solverInfo)
+{
+	BT_PROFILE("solveConstraints");
+
+	m_sortedConstraints.resize( m_constraints.size());
+	int i;
+	for (i=0;i<getNumConstraints();i++)
+	{
+		m_sortedConstraints[i] = m_constraints[i];
+	}
+	m_sortedConstraints.quickSort(btSortConstraintOnIslandPredicateMt());
+
+	btTypedConstraint** constraintsPtr = getNumConstraints() ? &m_sortedConstraints[0] : 0;
+
+	m_islandBatches->setup(&solverInfo,m_constraintSolver,constraintsPtr,m_sortedConstraints.size(),getDebugDrawer(),getCollisionWorld()->getDispatcher());
+	m_constraintSolver->prepareSolve(getCollisionWorld()->getNumCollisionObjects(), getCollisionWorld()->getDispatcher()->getNumManifolds());
+
+	/// gather the islands into batches and solve them in parallel
+	m_islandManager->buildAndProcessIslands(getCollisionWorld()->getDispatcher(),getCollisionWorld(),m_islandBatches);
+
+	m_islandBatches->solveBatches();
+
+	m_constraintSolver->allSolved(solverInfo, m_debugDrawer);
+}
+
+void	btDiscreteDynamicsWorldMt::predictUnconstraintMotion(btScalar timeStep)
+{
+	BT_PROFILE("predictUnconstraintMotion");
+	if (m_nonStaticRigidBodies.size())
+		btParallelFor(0, m_nonStaticRigidBodies.size(), m_grainSize, btPredictUnconstraintMotionLoop(this, &m_nonStaticRigidBodies[0], timeStep));
+}
+
+void	btDiscreteDynamicsWorldMt::createPredictiveContacts(btScalar timeStep)
+{
+	BT_PROFILE("createPredictiveContacts");
+
+	releasePredictiveContacts();
+
+	const int numBodies = m_nonStaticRigidBodies.size();
+	if (!numBodies)
+		return;
+
+	///the sweeps only read the world, the manifolds are created afterwards in body order, like in btDiscreteDynamicsWorld
+	m_predictiveSweeps.resize(numBodies);
+	btParallelFor(0, numBodies, m_grainSize, btPredictiveContactsLoop(this, &m_nonStaticRigidBodies[0], timeStep));
+
+	for (int i=0;i<numBodies;i++)
+		addPredictiveContact(m_nonStaticRigidBodies[i], m_predictiveSweeps[i]);
+}
+
+bool	btDiscreteDynamicsWorldMt::ccdSweepSeesMovedBody(int bodyIndex) const
+{
+	///the broadphase aabbs don't change during integrateTransforms, so the sweep can only hit the objects overlapping its swept aabb
+	const btRigidBody* body = m_nonStaticRigidBodies[bodyIndex];
+	const btVector3& from = body->getWorldTransform().getOrigin();
+	const btVector3& to = m_predictedTransforms[bodyIndex].getOrigin();
+	btSphereShape tmpSphere(body->getCcdSweptSphereRadius());
+	btTransform identity;
+	identity.setIdentity();
+	btVector3 sphereMin, sphereMax;
+	tmpSphere.getAabb(identity, sphereMin, sphereMax);
+	btVector3 aabbMin = from;
+	btVector3 aabbMax = from;
+	aabbMin.setMin(to);
+	aabbMax.setMax(to);
+	aabbMin += sphereMin;
+	aabbMax += sphereMax;
+	///grow it a little, so rounding of the ray test of the sweep can't reach past it
+	btVector3 extent = aabbMin.absolute();
+	extent.setMax(aabbMax.absolute());
+	const btScalar slack = btScalar(1e-4) * (btScalar(1.) + btMax(btMax(extent.getX(), extent.getY()), extent.getZ()));
+	aabbMin -= btVector3(slack, slack, slack);
+	aabbMax += btVector3(slack, slack, slack);
+
+	btCcdMovedBodyCallback callback(m_movingBodies, body, bodyIndex);
+	m_broadphasePairCache->aabbTest(aabbMin, aabbMax, callback);
+	return callback.m_found;
+}
+
+void	btDiscreteDynamicsWorldMt::integrateTransforms(btScalar timeStep)
+{
+	BT_PROFILE("integrateTransforms");
+
+	const int numBodies = m_nonStaticRigidBodies.size();
+	if (numBodies)
+	{
+		btRigidBody** bodies = &m_nonStaticRigidBodies[0];
+		m_predictedTransforms.resize(numBodies);
+		m_integrateModes.resize(numBodies);
+		m_ccdHitFractions.resize(numBodies);
+		btParallelFor(0, numBodies, m_grainSize, btIntegrateTransformsLoop(this, bodies, timeStep, BT_INTEGRATE_PASS_PREDICT));
+
+		int numCcdBodies = 0;
+		for (int i=0;i<numBodies;i++)
+			numCcdBodies += m_integrateModes[i] == BT_INTEGRATE_CCD;
+
+		///a CCD sweep sees the bodies before it moved and the bodies after it not yet moved, as in btDiscreteDynamicsWorld.
+		///Sweeps that can't reach a moving body before them see the same world before any body is moved, so they run ahead in parallel.
+		if (numCcdBodies)
+		{
+			BT_PROFILE("CCD motion clamping");
+			gNumClampedCcdMotions += numCcdBodies;
+			m_movingBodies.clear();
+			for (int i=0;i<numBodies;i++)
+			{
+				if (m_integrateModes[i] != BT_INTEGRATE_NONE)
+					m_movingBodies.insert(btHashPtr(bodies[i]), i);
+			}
+			btParallelFor(0, numBodies, m_grainSize, btIntegrateTransformsLoop(this, bodies, timeStep, BT_INTEGRATE_PASS_SWEEP));
+		}
+
+		///the other CCD bodies are swept in body order, only the bodies between two of them are moved in parallel
+		btIntegrateTransformsLoop moveLoop(this, bodies, timeStep, BT_INTEGRATE_PASS_MOVE);
+		int begin = 0;
+		for (int i=0;i<=numBodies;i++)
+		{
+			if (i<numBodies && m_integrateModes[i] != BT_INTEGRATE_CCD)
+				continue;
+			if (i>begin)
+				btParallelFor(begin, i, m_grainSize, moveLoop);
+			if (i<numBodies)
+				applyCcdMotion(bodies[i], m_predictedTransforms[i], sweepCcdMotion(bodies[i], m_predictedTransforms[i]), timeStep);
+			begin = i+1;
+		}
+	}
+
+	applySpeculativeContactRestitution();
+}
@@ -0,0 +1,130 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2009 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#ifndef BT_DISCRETE_DYNAMICS_WORLD_MT_H
+#define BT_DISCRETE_DYNAMICS_WORLD_MT_H
+
+#include "btDiscreteDynamicsWorld.h"
+#include "BulletDynamics/ConstraintSolver/btConstraintSolver.h"
+#include "LinearMath/btHashMap.h"
+#include "LinearMath/btThreads.h"
+
+struct btIslandBatchCallbackMt;
+
+
+///btConstraintSolverPoolMt holds a solver per thread, so independent islands can be solved concurrently.
+///A call of solveGroup locks the first free solver, starting with the one of the calling thread.
+class btConstraintSolverPoolMt : public btConstraintSolver
+{
+	struct ThreadSolver
+	{
+		btConstraintSolver* m_solver;
+		btSpinMutex m_mutex;
+	};
+
+	btAlignedObjectArray<ThreadSolver> m_solvers;
+	btConstraintSolverType m_solverType;
+
+	void init(btConstraintSolver** solvers, int numSolvers);
+	ThreadSolver* getAndLockThreadSolver();
+
+public:
+
+	///creates numSolvers btSequentialImpulseConstraintSolver, one per thread of the task scheduler is enough
+	btConstraintSolverPoolMt(int numSolvers);
+
+	///takes ownership of the solvers, they must be of the same type
+	btConstraintSolverPoolMt(btConstraintSolver** solvers, int numSolvers);
+
+	virtual ~btConstraintSolverPoolMt();
+
+	virtual void prepareSolve(int numBodies, int numManifolds);
+
+	virtual btScalar solveGroup(btCollisionObject** bodies,int numBodies,btPersistentManifold** manifolds,int numManifolds,btTypedConstraint** constraints,int numConstraints,const btContactSolverInfo& info,btIDebugDraw* debugDrawer,btDispatcher* dispatcher);
+
+	virtual void allSolved(const btContactSolverInfo& info,btIDebugDraw* debugDrawer);
+
+	virtual void reset();
+
+	virtual btConstraintSolverType getSolverType() const
+	{
+		return m_solverType;
+	}
+
+	int getNumSolvers() const
+	{
+		return m_solvers.size();
+	}
+};
+
+
+///btDiscreteDynamicsWorldMt solves the simulation islands in parallel on the task scheduler of btParallelFor.
+///Islands are batched the same way as in btDiscreteDynamicsWorld, so both worlds give the same results,
+///unless the solver randomizes the order of the constraints (SOLVER_RANDMIZE_ORDER).
+///The per body stages (predictUnconstraintMotion, createPredictiveContacts and integrateTransforms) run in parallel as well,
+///predictive contacts are still created and CCD motion is still clamped in body order, so they match the serial world bit for bit.
+///Only the CCD sweeps that can't reach a moving body before them are run ahead in parallel.
+///The constraint solver of the world must be a btConstraintSolverPoolMt.
+ATTRIBUTE_ALIGNED16(class) btDiscreteDynamicsWorldMt : public btDiscreteDynamicsWorld
+{
+protected:
+
+	btIslandBatchCallbackMt* m_islandBatches;
+
+	btAlignedObjectArray<PredictiveContactSweep>	m_predictiveSweeps;
+	btAlignedObjectArray<btTransform>	m_predictedTransforms;
+	btAlignedObjectArray<char>	m_integrateModes;
+	btAlignedObjectArray<btScalar>	m_ccdHitFractions;
+	btHashMap<btHashPtr, int>	m_movingBodies;	///< index of every body moved by integrateTransforms
+
+	int	m_grainSize;
+
+	friend struct btIntegrateTransformsLoop;
+	friend struct btPredictiveContactsLoop;
+	friend struct btPredictUnconstraintMotionLoop;
+
+	virtual void	predictUnconstraintMotion(btScalar timeStep);
+
+	virtual void	createPredictiveContacts(btScalar timeStep);
+
+	virtual void	integrateTransforms(btScalar timeStep);
+
+	///returns true if the CCD sweep of the body may hit a body before it that is moved by integrateTransforms
+	bool	ccdSweepSeesMovedBody(int bodyIndex) const;
+
+	virtual void	solveConstraints(btContactSolverInfo& solverInfo);
+
+public:
+
+	BT_DECLARE_ALIGNED_ALLOCATOR();
+
+	btDiscreteDynamicsWorldMt(btDispatcher* dispatcher,btBroadphaseInterface* pairCache,btConstraintSolverPoolMt* constraintSolver,btCollisionConfiguration* collisionConfiguration);
+
+	virtual ~btDiscreteDynamicsWorldMt();
+
+	///grainSize is the smallest number of bodies handed to a thread at once by the per body stages
+	int	getGrainSize() const
+	{
+		return m_grainSize;
+	}
+
+	void	setGrainSize(int grainSize)
+	{
+		m_grainSize = grainSize;
+	}
+};
+
+#endif //BT_DISCRETE_DYNAMICS_WORLD_MT_H
@@ -15,6 +15,7 @@ subject to the following restrictions:
 
 #include "btAlignedAllocator.h"
 
+//only updated with BT_DEBUG_MEMORY_ALLOCATIONS, defined in all builds so readers still link
 int gNumAlignedAllocs = 0;
 int gNumAlignedFree = 0;
 int gTotalBytesAlignedAllocs = 0;//detect memory leaks
@@ -244,9 +245,9 @@ void    btAlignedFreeInternal   (void* ptr,int line,char* filename)
 
 #else //BT_DEBUG_MEMORY_ALLOCATIONS
 
+//allocations aren't counted here, the counters would be shared by all threads
 void*	btAlignedAllocInternal	(size_t size, int alignment)
 {
-	gNumAlignedAllocs++;
 	void* ptr;
 	ptr = sAlignedAllocFunc(size, alignment);
 //	printf("btAlignedAllocInternal %d, %x\n",size,ptr);
@@ -260,7 +261,6 @@ void	btAlignedFreeInternal	(void* ptr)
 		return;
 	}
 
-	gNumAlignedFree++;
 //	printf("btAlignedFreeInternal %x\n",ptr);
 	sAlignedFreeFunc(ptr);
 }
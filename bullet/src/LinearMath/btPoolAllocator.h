@@ -18,8 +18,10 @@ subject to the following restrictions:
 
 #include "btScalar.h"
 #include "btAlignedAllocator.h"
+#include "btThreads.h"
 
 ///The btPoolAllocator class allows to efficiently allocate a large pool of objects, instead of dynamically allocating them separately.
+///allocate and freeMemory can be called from several threads at once.
 class btPoolAllocator
 {
 	int				m_elemSize;
@@ -27,6 +29,7 @@ class btPoolAllocator
 	int				m_freeCount;
 	void*			m_firstFree;
 	unsigned char*	m_pool;
+	btSpinMutex		m_mutex;	// protects the free list
 
 public:
 
@@ -67,16 +70,21 @@ public:
 		return m_maxElements;
 	}
 
+	///returns 0 if the pool is exhausted
 	void*	allocate(int size)
 	{
 		// release mode fix
 		(void)size;
 		btAssert(!size || size<=m_elemSize);
-		btAssert(m_freeCount>0);
-        void* result = m_firstFree;
-        m_firstFree = *(void**)m_firstFree;
-        --m_freeCount;
-        return result;
+		m_mutex.lock();
+		void* result = m_firstFree;
+		if (result)
+		{
+			m_firstFree = *(void**)m_firstFree;
+			--m_freeCount;
+		}
+		m_mutex.unlock();
+		return result;
 	}
 
 	bool validPtr(void* ptr)
@@ -95,9 +103,11 @@ public:
 		 if (ptr) {
             btAssert((unsigned char*)ptr >= m_pool && (unsigned char*)ptr < m_pool + m_maxElements * m_elemSize);
 
+            m_mutex.lock();
             *(void**)ptr = m_firstFree;
             m_firstFree = ptr;
             ++m_freeCount;
+            m_mutex.unlock();
         }
 	}
 
@@ -66,8 +66,8 @@ public:
 
 	// Copy constructor
 	SIMD_FORCE_INLINE btQuaternion(const btQuaternion& rhs)
+		: btQuadWord(rhs)
 	{
-		mVec128 = rhs.mVec128;
 	}
 
 	// Assignment Operator
@@ -14,6 +14,7 @@
 // Ogre (www.ogre3d.org).
 
 #include "btQuickprof.h"
+#include "btThreads.h"
 
 
 
@@ -455,6 +456,9 @@ unsigned long int			CProfileManager::ResetTime = 0;
  *=============================================================================================*/
 void	CProfileManager::Start_Profile( const char * name )
 {
+	// the profile tree isn't thread safe, samples of the worker threads are dropped
+	if (!btIsMainThread())
+		return;
 	if (name != CurrentNode->Get_Name()) {
 		CurrentNode = CurrentNode->Get_Sub_Node( name );
 	}
@@ -468,6 +472,8 @@ void	CProfileManager::Start_Profile( const char * name )
  *=============================================================================================*/
 void	CProfileManager::Stop_Profile( void )
 {
+	if (!btIsMainThread())
+		return;
 	// Return will indicate whether we should back up to our parent (we may
 	// be profiling a recursive function)
 	if (CurrentNode->Return()) {
@@ -238,6 +238,30 @@ inline int	btGetVersion()
 
 #else
 
+#if defined (__x86_64__) && (!defined (BT_USE_DOUBLE_PRECISION)) && (!defined (BT_NO_SSE))
+		//SSE2 is a part of x86-64, so it is enabled by default (define BT_NO_SSE to use scalar math)
+		#define BT_USE_SIMD_VECTOR3
+		#define BT_USE_SSE
+		//BT_USE_SSE_IN_API is enabled on x86-64 by default, because malloc returns memory aligned on 16-byte boundaries
+		#define BT_USE_SSE_IN_API
+		//GCC -Wmaybe-uninitialized reports on mVec128 copies come from default constructed fill values (btAlignedObjectArray::resize/push_back),
+		//which are left uninitialized on purpose, as in the scalar build
+		// include appropriate SSE level
+		#if defined (__SSE4_1__)
+			#include <smmintrin.h>
+		#elif defined (__SSSE3__)
+			#include <tmmintrin.h>
+		#elif defined (__SSE3__)
+			#include <pmmintrin.h>
+		#else
+			#include <emmintrin.h>
+		#endif
+
+		#define SIMD_FORCE_INLINE inline __attribute__ ((always_inline))
+		#define ATTRIBUTE_ALIGNED16(a) a __attribute__ ((aligned (16)))
+		#define ATTRIBUTE_ALIGNED64(a) a __attribute__ ((aligned (64)))
+		#define ATTRIBUTE_ALIGNED128(a) a __attribute__ ((aligned (128)))
+#else
 		#define SIMD_FORCE_INLINE inline
 		///@todo: check out alignment methods for other platforms/compilers
 		///#define ATTRIBUTE_ALIGNED16(a) a __attribute__ ((aligned (16)))
@@ -246,6 +270,7 @@ inline int	btGetVersion()
 		#define ATTRIBUTE_ALIGNED16(a) a
 		#define ATTRIBUTE_ALIGNED64(a) a
 		#define ATTRIBUTE_ALIGNED128(a) a
+#endif //__x86_64__
 		#ifndef assert
 		#include <assert.h>
 		#endif
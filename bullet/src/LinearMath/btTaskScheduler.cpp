@@ -0,0 +1,246 @@
+/*
+Copyright (c) 2003-2014 Erwin Coumans  http://bullet.googlecode.com
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include "btThreads.h"
+#include "btMinMax.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+void btSetCurrentThreadIndex(unsigned int index);
+
+
+///btTaskSchedulerDefault is a work stealing thread pool.
+///A loop is cut into chunks and every thread gets a contiguous range of them, so neighbouring iterations
+///stay on the same thread. Threads take chunks from the front of their own range and steal from the back
+///of the ranges of other threads once they run out of work.
+class btTaskSchedulerDefault : public btITaskScheduler
+{
+	///range of chunk indices [head, tail) packed in one word, so owner and thieves agree with a single compare and swap
+	struct ChunkQueue
+	{
+		std::atomic<unsigned long long> m_range;
+		char m_padding[64 - sizeof(std::atomic<unsigned long long>)]; // keeps the queues on separate cache lines
+
+		static unsigned long long pack(unsigned int head, unsigned int tail) { return (unsigned long long)tail << 32 | head; }
+
+		void reset(unsigned int head, unsigned int tail)
+		{
+			m_range.store(pack(head, tail), std::memory_order_relaxed);
+		}
+		bool popFront(int& chunk)
+		{
+			unsigned long long range = m_range.load(std::memory_order_relaxed);
+			for (;;)
+			{
+				const unsigned int head = (unsigned int)range;
+				const unsigned int tail = (unsigned int)(range >> 32);
+				if (head >= tail)
+					return false;
+				if (m_range.compare_exchange_weak(range, pack(head + 1, tail), std::memory_order_acquire, std::memory_order_relaxed))
+				{
+					chunk = head;
+					return true;
+				}
+			}
+		}
+		bool popBack(int& chunk)
+		{
+			unsigned long long range = m_range.load(std::memory_order_relaxed);
+			for (;;)
+			{
+				const unsigned int head = (unsigned int)range;
+				const unsigned int tail = (unsigned int)(range >> 32);
+				if (head >= tail)
+					return false;
+				if (m_range.compare_exchange_weak(range, pack(head, tail - 1), std::memory_order_acquire, std::memory_order_relaxed))
+				{
+					chunk = tail - 1;
+					return true;
+				}
+			}
+		}
+	};
+
+	// chunks per thread, more of them balance uneven loops better but cost more synchronization
+	enum { CHUNKS_PER_THREAD = 4 };
+	// spins of an idle worker before it goes to sleep, so back to back loops don't wait for a wake up
+	enum { WORKER_SPIN_COUNT = 1000 };
+
+	std::vector<std::thread> m_threads;
+	int m_numThreads;
+	ChunkQueue m_queues[BT_MAX_THREAD_COUNT];
+
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+	std::atomic<unsigned int> m_generation;	// incremented for every loop, workers compare it with the last loop they have seen
+	bool m_exit;
+
+	// current loop, changed under the mutex while no worker is busy
+	const btIParallelForBody* m_body;
+	int m_begin;
+	int m_end;
+	int m_chunkSize;
+	int m_loopThreads;
+	std::atomic<int> m_remainingChunks;
+	std::atomic<int> m_busyWorkers;
+
+	void runChunks(int threadIndex)
+	{
+		int chunk;
+		for (;;)
+		{
+			if (!m_queues[threadIndex].popFront(chunk))
+			{
+				bool stolen = false;
+				for (int i = 1; i < m_loopThreads && !stolen; ++i)
+					stolen = m_queues[(threadIndex + i) % m_loopThreads].popBack(chunk);
+				if (!stolen)
+					return;
+			}
+			const int iBegin = m_begin + chunk * m_chunkSize;
+			const int iEnd = btMin(iBegin + m_chunkSize, m_end);
+			m_body->forLoop(iBegin, iEnd);
+			m_remainingChunks.fetch_sub(1, std::memory_order_release);
+		}
+	}
+
+	void workerMain(int threadIndex, unsigned int seen)
+	{
+		btSetCurrentThreadIndex(threadIndex);
+		for (;;)
+		{
+			for (int i = 0; i < WORKER_SPIN_COUNT && m_generation.load(std::memory_order_relaxed) == seen; ++i)
+				std::this_thread::yield();
+			{
+				// joining a loop under the mutex, so the loop can't be replaced while the worker reads it
+				std::unique_lock<std::mutex> lock(m_mutex);
+				while (!m_exit && m_generation.load(std::memory_order_relaxed) == seen)
+					m_wake.wait(lock);
+				if (m_exit)
+					return;
+				seen = m_generation.load(std::memory_order_relaxed);
+				if (threadIndex >= m_loopThreads)
+					continue;
+				m_busyWorkers.fetch_add(1);
+			}
+			runChunks(threadIndex);
+			m_busyWorkers.fetch_sub(1, std::memory_order_release);
+		}
+	}
+
+	void waitForWorkers()
+	{
+		while (m_busyWorkers.load(std::memory_order_acquire) != 0)
+			std::this_thread::yield();
+	}
+
+	void stopThreads()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_exit = true;
+		}
+		m_wake.notify_all();
+		for (size_t i = 0; i < m_threads.size(); ++i)
+			m_threads[i].join();
+		m_threads.clear();
+		m_exit = false;
+	}
+
+	void startThreads()
+	{
+		for (int i = 1; i < m_numThreads; ++i)
+			m_threads.push_back(std::thread(&btTaskSchedulerDefault::workerMain, this, i, m_generation.load()));
+	}
+
+public:
+	btTaskSchedulerDefault()
+		:btITaskScheduler("Default"),
+		m_numThreads(1),
+		m_generation(0),
+		m_exit(false),
+		m_body(0),
+		m_begin(0),
+		m_end(0),
+		m_chunkSize(1),
+		m_loopThreads(1),
+		m_remainingChunks(0),
+		m_busyWorkers(0)
+	{
+		for (int i = 0; i < int(BT_MAX_THREAD_COUNT); ++i)
+			m_queues[i].reset(0, 0);
+		setNumThreads(int(std::thread::hardware_concurrency()));
+	}
+	virtual ~btTaskSchedulerDefault()
+	{
+		stopThreads();
+	}
+
+	virtual int getMaxNumThreads() const { return BT_MAX_THREAD_COUNT; }
+	virtual int getNumThreads() const { return m_numThreads; }
+	virtual void setNumThreads(int numThreads)
+	{
+		btAssert(btIsMainThread() && !btThreadsAreRunning());
+		numThreads = btMax(1, btMin(numThreads, int(BT_MAX_THREAD_COUNT)));
+		if (numThreads == m_numThreads && int(m_threads.size()) == numThreads - 1)
+			return;
+		stopThreads();
+		m_numThreads = numThreads;
+		startThreads();
+	}
+
+	virtual void parallelFor(int iBegin, int iEnd, int grainSize, const btIParallelForBody& body)
+	{
+		const int count = iEnd - iBegin;
+		grainSize = btMax(grainSize, 1);
+		if (m_numThreads == 1 || count <= grainSize)
+		{
+			body.forLoop(iBegin, iEnd);
+			return;
+		}
+		const int chunkSize = btMax(grainSize, (count + m_numThreads * CHUNKS_PER_THREAD - 1) / (m_numThreads * CHUNKS_PER_THREAD));
+		const int numChunks = (count + chunkSize - 1) / chunkSize;
+		const int loopThreads = btMin(m_numThreads, numChunks);
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			// late workers of the previous loop may still look at it
+			waitForWorkers();
+			m_body = &body;
+			m_begin = iBegin;
+			m_end = iEnd;
+			m_chunkSize = chunkSize;
+			m_loopThreads = loopThreads;
+			m_remainingChunks.store(numChunks, std::memory_order_relaxed);
+			for (int i = 0; i < loopThreads; ++i)
+				m_queues[i].reset(i * numChunks / loopThreads, (i + 1) * numChunks / loopThreads);
+			m_generation.fetch_add(1, std::memory_order_release);
+		}
+		m_wake.notify_all();
+
+		runChunks(0);
+		while (m_remainingChunks.load(std::memory_order_acquire) != 0)
+			std::this_thread::yield();
+		waitForWorkers();
+	}
+};
+
+btITaskScheduler* btCreateDefaultTaskScheduler()
+{
+	return new btTaskSchedulerDefault();
+}
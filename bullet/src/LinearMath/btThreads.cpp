@@ -0,0 +1,135 @@
+/*
+Copyright (c) 2003-2014 Erwin Coumans  http://bullet.googlecode.com
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include "btThreads.h"
+
+#include <atomic>
+#include <thread>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+
+static thread_local unsigned int gThreadIndex = 0;
+static std::atomic<int> gParallelForDepth(0);
+
+///called by the worker threads of the task schedulers
+void btSetCurrentThreadIndex(unsigned int index)
+{
+	btAssert(index < BT_MAX_THREAD_COUNT);
+	gThreadIndex = index;
+}
+
+unsigned int btGetCurrentThreadIndex()
+{
+	return gThreadIndex;
+}
+
+bool btIsMainThread()
+{
+	return gThreadIndex == 0;
+}
+
+bool btThreadsAreRunning()
+{
+	return gParallelForDepth.load(std::memory_order_relaxed) != 0;
+}
+
+
+void btSpinMutex::lock()
+{
+	while (!tryLock())
+	{
+		// wait for the lock to look free before trying again, so the cache line isn't bounced
+#if defined(_MSC_VER)
+		while (*(volatile long*)&m_lock)
+#else
+		while (__atomic_load_n(&m_lock, __ATOMIC_RELAXED))
+#endif
+			std::this_thread::yield();
+	}
+}
+
+void btSpinMutex::unlock()
+{
+#if defined(_MSC_VER)
+	_InterlockedExchange((volatile long*)&m_lock, 0);
+#else
+	__sync_lock_release(&m_lock);
+#endif
+}
+
+bool btSpinMutex::tryLock()
+{
+#if defined(_MSC_VER)
+	return _InterlockedExchange((volatile long*)&m_lock, 1) == 0;
+#else
+	return __sync_lock_test_and_set(&m_lock, 1) == 0;
+#endif
+}
+
+
+///btTaskSchedulerSequential runs the loops on the calling thread
+class btTaskSchedulerSequential : public btITaskScheduler
+{
+public:
+	btTaskSchedulerSequential()
+		:btITaskScheduler("Sequential")
+	{
+	}
+	virtual int getMaxNumThreads() const { return 1; }
+	virtual int getNumThreads() const { return 1; }
+	virtual void setNumThreads(int numThreads) { (void)numThreads; }
+	virtual void parallelFor(int iBegin, int iEnd, int grainSize, const btIParallelForBody& body)
+	{
+		(void)grainSize;
+		body.forLoop(iBegin, iEnd);
+	}
+};
+
+btITaskScheduler* btGetSequentialTaskScheduler()
+{
+	static btTaskSchedulerSequential sequentialScheduler;
+	return &sequentialScheduler;
+}
+
+static btITaskScheduler* gTaskScheduler = 0;
+
+void btSetTaskScheduler(btITaskScheduler* ts)
+{
+	btAssert(btIsMainThread() && !btThreadsAreRunning());
+	gTaskScheduler = ts;
+}
+
+btITaskScheduler* btGetTaskScheduler()
+{
+	return gTaskScheduler ? gTaskScheduler : btGetSequentialTaskScheduler();
+}
+
+void btParallelFor(int iBegin, int iEnd, int grainSize, const btIParallelForBody& body)
+{
+	if (iBegin >= iEnd)
+		return;
+	if (!btIsMainThread() || btThreadsAreRunning())
+	{
+		// loops inside of a parallel loop use the threads that are already busy
+		body.forLoop(iBegin, iEnd);
+		return;
+	}
+	gParallelForDepth.fetch_add(1);
+	btGetTaskScheduler()->parallelFor(iBegin, iEnd, grainSize, body);
+	gParallelForDepth.fetch_sub(1);
+}
@@ -0,0 +1,89 @@
+/*
+Copyright (c) 2003-2014 Erwin Coumans  http://bullet.googlecode.com
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+
+#ifndef BT_THREADS_H
+#define BT_THREADS_H
+
+#include "btScalar.h" // has definitions like SIMD_FORCE_INLINE
+
+///maximum number of threads a task scheduler can run, including the main thread
+const unsigned int BT_MAX_THREAD_COUNT = 64;
+
+///the main thread has index 0, worker threads of the task scheduler have indices 1..BT_MAX_THREAD_COUNT-1
+unsigned int btGetCurrentThreadIndex();
+bool btIsMainThread();
+///true while a parallelFor is running
+bool btThreadsAreRunning();
+
+///btSpinMutex is a lightweight lock for short critical sections, it busy-waits instead of sleeping
+class btSpinMutex
+{
+	int m_lock;
+
+public:
+	btSpinMutex()
+		:m_lock(0)
+	{
+	}
+	void lock();
+	void unlock();
+	bool tryLock();
+};
+
+///btIParallelForBody is the loop body of btParallelFor, forLoop is called with subranges of the loop, possibly from several threads at once
+class btIParallelForBody
+{
+public:
+	virtual ~btIParallelForBody() {}
+	virtual void forLoop(int iBegin, int iEnd) const = 0;
+};
+
+///btITaskScheduler is the interface of the task scheduler used by btParallelFor.
+///Implement it to run the parallel loops of Bullet on the thread pool of the application.
+class btITaskScheduler
+{
+protected:
+	const char* m_name;
+
+public:
+	btITaskScheduler(const char* name)
+		:m_name(name)
+	{
+	}
+	virtual ~btITaskScheduler() {}
+	const char* getName() const { return m_name; }
+
+	virtual int getMaxNumThreads() const = 0;
+	virtual int getNumThreads() const = 0;
+	virtual void setNumThreads(int numThreads) = 0;
+	///calls body.forLoop for subranges covering [iBegin, iEnd), subranges hold at least grainSize iterations except for the last one
+	virtual void parallelFor(int iBegin, int iEnd, int grainSize, const btIParallelForBody& body) = 0;
+};
+
+///sets the task scheduler used by btParallelFor, it must be called from the main thread while no parallelFor is running.
+///the scheduler isn't owned, the sequential scheduler is used by default
+void btSetTaskScheduler(btITaskScheduler* ts);
+btITaskScheduler* btGetTaskScheduler();
+
+///runs the loops on the calling thread
+btITaskScheduler* btGetSequentialTaskScheduler();
+///creates the built-in work stealing thread pool with one thread per hardware thread, the caller owns it and must delete it after use
+btITaskScheduler* btCreateDefaultTaskScheduler();
+
+///runs the loop on the current task scheduler, nested loops run sequentially on the calling thread
+void btParallelFor(int iBegin, int iEnd, int grainSize, const btIParallelForBody& body);
+
+#endif //BT_THREADS_H
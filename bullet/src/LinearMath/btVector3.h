@@ -681,7 +681,7 @@ public:
 	void setZero()
 	{
 #if defined(BT_USE_SSE_IN_API) && defined (BT_USE_SSE)
-		mVec128 = (__m128)_mm_xor_ps(mVec128, mVec128);
+		mVec128 = _mm_setzero_ps();
 #elif defined(BT_USE_NEON)
 		int32x4_t vi = vdupq_n_s32(0); 
 		mVec128 = vreinterpretq_f32_s32(vi);
@@ -0,0 +1,1197 @@
+/*
+Benchmark of the Bullet simulation steps on typical scenes.
+
+Usage: bench [scene] [steps]
+	stack	pyramid of boxes on the ground, once per constraint row solver
+	islands	separate towers of boxes, serial world and multithreaded world over thread counts
+	narrowphase	heap of mixed convex shapes, serial dispatcher and multithreaded dispatcher over thread counts
+	giant	one block of boxes forming a single island, serial solver and batched solver over thread counts
+	integrate	100k fast spheres with continuous collision detection crossing each other, serial world and multithreaded world over thread counts
+	rays	line of sight ray casts between the towers, rayTest one by one and rayTestBatch over thread counts
+	queries	agents sweeping and testing for contacts between the towers, convexSweepTest/contactTest one by one and the batches over thread counts
+	wide	100k broadphase proxies, pair finding and ray casts through the binary and the 4-wide fixed set
+	paircache	add/find/remove of 100k pairs and broadphase frames, btHashedOverlappingPairCache and btOpenAddressingPairCache
+	aabbs	100k moving collision objects, updateSingleAabb one by one and the bulk updateAabbs over thread counts
+*/
+#include "btBulletDynamicsCommon.h"
+#include "LinearMath/btCpuFeatureUtility.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+static double Now()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// World with its own broadphase, dispatcher and solver
+struct Scene
+{
+	btDefaultCollisionConfiguration* m_configuration;
+	btCollisionDispatcher* m_dispatcher;
+	btBroadphaseInterface* m_broadphase;
+	btSequentialImpulseConstraintSolver* m_solver;	// serial world only
+	btConstraintSolverPoolMt* m_solverPool;			// multithreaded world only
+	btDiscreteDynamicsWorld* m_world;
+	btAlignedObjectArray<btCollisionShape*> m_shapes;
+
+	//! Multithreaded world and dispatcher run on the current task scheduler
+	explicit Scene(bool multithreaded = false, bool multithreadedDispatcher = false)
+		: m_solver(0)
+		, m_solverPool(0)
+	{
+		m_configuration = new btDefaultCollisionConfiguration();
+		if (multithreadedDispatcher)
+			m_dispatcher = new btCollisionDispatcherMt(m_configuration);
+		else
+			m_dispatcher = new btCollisionDispatcher(m_configuration);
+		m_broadphase = new btDbvtBroadphase();
+		if (multithreaded)
+		{
+			m_solverPool = new btConstraintSolverPoolMt(btGetTaskScheduler()->getNumThreads());
+			m_world = new btDiscreteDynamicsWorldMt(m_dispatcher, m_broadphase, m_solverPool, m_configuration);
+		}
+		else
+		{
+			m_solver = new btSequentialImpulseConstraintSolver();
+			m_world = new btDiscreteDynamicsWorld(m_dispatcher, m_broadphase, m_solver, m_configuration);
+		}
+		m_world->setGravity(btVector3(0, -10, 0));
+	}
+	~Scene()
+	{
+		for (int i = m_world->getNumCollisionObjects() - 1; i >= 0; --i)
+		{
+			btCollisionObject* object = m_world->getCollisionObjectArray()[i];
+			btRigidBody* body = btRigidBody::upcast(object);
+			if (body && body->getMotionState())
+				delete body->getMotionState();
+			m_world->removeCollisionObject(object);
+			delete object;
+		}
+		for (int i = 0; i < m_shapes.size(); ++i)
+			delete m_shapes[i];
+		delete m_world;
+		delete m_solver;
+		delete m_solverPool;
+		delete m_broadphase;
+		delete m_dispatcher;
+		delete m_configuration;
+	}
+
+	btCollisionShape* addShape(btCollisionShape* shape)
+	{
+		m_shapes.push_back(shape);
+		return shape;
+	}
+	btRigidBody* addBody(btCollisionShape* shape, btScalar mass, const btVector3& origin)
+	{
+		btVector3 inertia(0, 0, 0);
+		if (mass != btScalar(0))
+			shape->calculateLocalInertia(mass, inertia);
+		btTransform transform;
+		transform.setIdentity();
+		transform.setOrigin(origin);
+		btRigidBody::btRigidBodyConstructionInfo info(mass, new btDefaultMotionState(transform), shape, inertia);
+		btRigidBody* body = new btRigidBody(info);
+		m_world->addRigidBody(body);
+		return body;
+	}
+	void addGround()
+	{
+		btCollisionShape* ground = addShape(new btBoxShape(btVector3(200, 1, 200)));
+		addBody(ground, 0, btVector3(0, -1, 0));
+	}
+
+	//! Returns milliseconds per step
+	double run(int steps)
+	{
+		const double start = Now();
+		for (int i = 0; i < steps; ++i)
+			m_world->stepSimulation(btScalar(1.) / btScalar(60.), 0);
+		return (Now() - start) * 1e3 / steps;
+	}
+	//! Mean speed of the dynamic bodies, how well the solver brought a resting scene to rest
+	btScalar meanSpeed() const
+	{
+		btScalar sum = 0;
+		int count = 0;
+		for (int i = 0; i < m_world->getNumCollisionObjects(); ++i)
+		{
+			const btRigidBody* body = btRigidBody::upcast(m_world->getCollisionObjectArray()[i]);
+			if (body && body->getInvMass() != btScalar(0))
+			{
+				sum += body->getLinearVelocity().length();
+				count++;
+			}
+		}
+		return count ? sum / count : btScalar(0);
+	}
+	//! Sum of body heights, shows that the scene behaves the same way
+	btScalar heights() const
+	{
+		btScalar sum = 0;
+		for (int i = 0; i < m_world->getNumCollisionObjects(); ++i)
+			sum += m_world->getCollisionObjectArray()[i]->getWorldTransform().getOrigin().getY();
+		return sum;
+	}
+	//! Bodies whose motion was clamped by CCD in the last step
+	int clampedBodies() const
+	{
+		int count = 0;
+		for (int i = 0; i < m_world->getNumCollisionObjects(); ++i)
+			count += m_world->getCollisionObjectArray()[i]->getHitFraction() == btScalar(0);
+		return count;
+	}
+	//! World transforms of all objects, to compare worlds bit for bit
+	void transforms(btAlignedObjectArray<btTransform>& result) const
+	{
+		result.resize(m_world->getNumCollisionObjects());
+		for (int i = 0; i < result.size(); ++i)
+			result[i] = m_world->getCollisionObjectArray()[i]->getWorldTransform();
+	}
+};
+
+static int countMismatches(const btAlignedObjectArray<btTransform>& a, const btAlignedObjectArray<btTransform>& b)
+{
+	if (a.size() != b.size())
+		return btMax(a.size(), b.size());
+	int mismatches = 0;
+	for (int i = 0; i < a.size(); ++i)
+		mismatches += memcmp(&a[i], &b[i], sizeof(btTransform)) != 0;
+	return mismatches;
+}
+
+static void buildPyramid(Scene& scene, int layers, const btVector3& center = btVector3(0, 0, 0))
+{
+	const btScalar size = btScalar(0.5);
+	btCollisionShape* box = scene.addShape(new btBoxShape(btVector3(size, size, size)));
+	for (int layer = 0; layer < layers; ++layer)
+	{
+		const int count = layers - layer;
+		for (int i = 0; i < count; ++i)
+			for (int k = 0; k < count; ++k)
+			{
+				btVector3 origin(
+					(i - btScalar(0.5) * (count - 1)) * 2 * size,
+					size + layer * 2 * size,
+					(k - btScalar(0.5) * (count - 1)) * 2 * size);
+				scene.addBody(box, 1, center + origin);
+			}
+	}
+}
+
+static void benchStack(int steps)
+{
+#ifdef BT_USE_SSE
+	printf("stack: btVector3 uses SSE\n");
+#else
+	printf("stack: btVector3 uses scalar math\n");
+#endif
+	enum { kScalar, kSSE2, kSSE4_1, kNumSolvers };
+	static const char* const names[kNumSolvers] = { "scalar", "sse2", "sse4.1+fma3" };
+	for (int kind = 0; kind < kNumSolvers; ++kind)
+	{
+		Scene scene;
+		btSequentialImpulseConstraintSolver* solver = scene.m_solver;
+		if (kind == kScalar)
+		{
+			solver->setConstraintRowSolverGeneric(solver->getScalarConstraintRowSolverGeneric());
+			solver->setConstraintRowSolverLowerLimit(solver->getScalarConstraintRowSolverLowerLimit());
+		}
+#ifdef USE_SIMD
+		else if (kind == kSSE2)
+		{
+			solver->setConstraintRowSolverGeneric(solver->getSSE2ConstraintRowSolverGeneric());
+			solver->setConstraintRowSolverLowerLimit(solver->getSSE2ConstraintRowSolverLowerLimit());
+		}
+#ifdef BT_ALLOW_SSE4
+		else if (kind == kSSE4_1)
+		{
+			const int features = btCpuFeatureUtility::getCpuFeatures();
+			if (!(features & btCpuFeatureUtility::CPU_FEATURE_SSE4_1) || !(features & btCpuFeatureUtility::CPU_FEATURE_FMA3))
+				continue;
+			solver->setConstraintRowSolverGeneric(solver->getSSE4_1ConstraintRowSolverGeneric());
+			solver->setConstraintRowSolverLowerLimit(solver->getSSE4_1ConstraintRowSolverLowerLimit());
+		}
+#endif //BT_ALLOW_SSE4
+#endif //USE_SIMD
+		else
+			continue;
+		scene.addGround();
+		buildPyramid(scene, 12);
+		const double ms = scene.run(steps);
+		printf("  %-12s %4d bodies %8.3f ms/step, heights %.3f\n", names[kind],
+			scene.m_world->getNumCollisionObjects(), ms, scene.heights());
+	}
+}
+
+// Grid of pyramids far enough apart to be separate simulation islands
+static void buildTowers(Scene& scene)
+{
+	const int grid = 12;
+	const btScalar spacing = 8;
+	scene.addGround();
+	for (int i = 0; i < grid; ++i)
+		for (int k = 0; k < grid; ++k)
+			buildPyramid(scene, 4, btVector3((i - btScalar(0.5) * (grid - 1)) * spacing, 0, (k - btScalar(0.5) * (grid - 1)) * spacing));
+}
+
+static void benchIslands(int steps)
+{
+	const int hardwareThreads = int(std::thread::hardware_concurrency());
+	printf("islands: %d hardware threads\n", hardwareThreads);
+	double serial;
+	{
+		Scene scene;
+		buildTowers(scene);
+		serial = scene.run(steps);
+		printf("  %-12s %4d bodies %8.3f ms/step, heights %.3f\n", "serial",
+			scene.m_world->getNumCollisionObjects(), serial, scene.heights());
+	}
+	btITaskScheduler* scheduler = btCreateDefaultTaskScheduler();
+	btSetTaskScheduler(scheduler);
+	const int maxThreads = btMax(hardwareThreads, 2);
+	for (int threads = 1;; threads = btMin(threads * 2, maxThreads))
+	{
+		scheduler->setNumThreads(threads);
+		Scene scene(true);
+		buildTowers(scene);
+		const double ms = scene.run(steps);
+		char name[32];
+		snprintf(name, sizeof(name), "%d threads", threads);
+		printf("  %-12s %4d bodies %8.3f ms/step, heights %.3f, speedup %.2f\n", name,
+			scene.m_world->getNumCollisionObjects(), ms, scene.heights(), serial / ms);
+		if (threads == maxThreads)
+			break;
+	}
+	btSetTaskScheduler(0);
+	delete scheduler;
+}
+
+// Heap of spheres, boxes, cylinders and hulls dropped on each other, most of the step is spent in the narrowphase
+static void buildHeap(Scene& scene)
+{
+	const int grid = 14;
+	const int layers = 8;
+	scene.addGround();
+	btCollisionShape* shapes[4];
+	shapes[0] = scene.addShape(new btSphereShape(btScalar(0.5)));
+	shapes[1] = scene.addShape(new btBoxShape(btVector3(btScalar(0.4), btScalar(0.4), btScalar(0.4))));
+	shapes[2] = scene.addShape(new btCylinderShape(btVector3(btScalar(0.4), btScalar(0.5), btScalar(0.4))));
+	btConvexHullShape* hull = new btConvexHullShape();
+	for (int i = 0; i < 12; ++i)
+	{
+		const btScalar angle = i * SIMD_2_PI / 12;
+		hull->addPoint(btVector3(btCos(angle) * btScalar(0.5), (i & 1) ? btScalar(0.4) : btScalar(-0.4), btSin(angle) * btScalar(0.5)));
+	}
+	shapes[3] = scene.addShape(hull);
+	for (int layer = 0; layer < layers; ++layer)
+		for (int i = 0; i < grid; ++i)
+			for (int k = 0; k < grid; ++k)
+			{
+				// odd layers are shifted so the bodies fall into the gaps
+				const btScalar shift = (layer & 1) ? btScalar(0.5) : btScalar(0);
+				btVector3 origin((i - btScalar(0.5) * (grid - 1) + shift) * btScalar(1.05), btScalar(0.6) + layer * btScalar(1.05),
+					(k - btScalar(0.5) * (grid - 1) + shift) * btScalar(1.05));
+				scene.addBody(shapes[(i + k + layer) % 4], 1, origin);
+			}
+}
+
+static void benchNarrowphase(int steps)
+{
+	const int hardwareThreads = int(std::thread::hardware_concurrency());
+	printf("narrowphase: %d hardware threads\n", hardwareThreads);
+	double serial;
+	{
+		Scene scene;
+		buildHeap(scene);
+		serial = scene.run(steps);
+		printf("  %-12s %4d bodies %5d manifolds %8.3f ms/step, heights %.3f\n", "serial",
+			scene.m_world->getNumCollisionObjects(), scene.m_dispatcher->getNumManifolds(), serial, scene.heights());
+	}
+	btITaskScheduler* scheduler = btCreateDefaultTaskScheduler();
+	btSetTaskScheduler(scheduler);
+	const int maxThreads = btMax(hardwareThreads, 2);
+	for (int threads = 1;; threads = btMin(threads * 2, maxThreads))
+	{
+		scheduler->setNumThreads(threads);
+		Scene scene(false, true);
+		buildHeap(scene);
+		const double ms = scene.run(steps);
+		char name[32];
+		snprintf(name, sizeof(name), "%d threads", threads);
+		printf("  %-12s %4d bodies %5d manifolds %8.3f ms/step, heights %.3f, speedup %.2f\n", name,
+			scene.m_world->getNumCollisionObjects(), scene.m_dispatcher->getNumManifolds(), ms, scene.heights(), serial / ms);
+		if (threads == maxThreads)
+			break;
+	}
+	btSetTaskScheduler(0);
+	delete scheduler;
+}
+
+// Block of boxes resting on each other, all of them end up in one simulation island
+static void buildBlock(Scene& scene)
+{
+	const int grid = 16;
+	const int layers = 12;
+	const btScalar size = btScalar(0.5);
+	scene.addGround();
+	btCollisionShape* box = scene.addShape(new btBoxShape(btVector3(size, size, size)));
+	for (int layer = 0; layer < layers; ++layer)
+		for (int i = 0; i < grid; ++i)
+			for (int k = 0; k < grid; ++k)
+			{
+				// bricks of odd layers are shifted so every box rests on four others
+				const btScalar shift = (layer & 1) ? size : btScalar(0);
+				btVector3 origin((i - btScalar(0.5) * (grid - 1)) * 2 * size + shift, size + layer * 2 * size,
+					(k - btScalar(0.5) * (grid - 1)) * 2 * size + shift);
+				scene.addBody(box, 1, origin);
+			}
+}
+
+static void benchGiantIsland(int steps)
+{
+	const int hardwareThreads = int(std::thread::hardware_concurrency());
+	printf("giant: %d hardware threads\n", hardwareThreads);
+	double serial;
+	{
+		Scene scene;
+		buildBlock(scene);
+		serial = scene.run(steps);
+		printf("  %-12s %4d bodies %8.3f ms/step, mean speed %.5f, heights %.3f\n", "serial",
+			scene.m_world->getNumCollisionObjects(), serial, scene.meanSpeed(), scene.heights());
+	}
+	btITaskScheduler* scheduler = btCreateDefaultTaskScheduler();
+	btSetTaskScheduler(scheduler);
+	const int maxThreads = btMax(hardwareThreads, 2);
+	for (int threads = 1;; threads = btMin(threads * 2, maxThreads))
+	{
+		scheduler->setNumThreads(threads);
+		Scene scene;
+		btSequentialImpulseConstraintSolverMt* solver = new btSequentialImpulseConstraintSolverMt();
+		scene.m_world->setConstraintSolver(solver);
+		delete scene.m_solver;
+		scene.m_solver = solver;
+		buildBlock(scene);
+		const double ms = scene.run(steps);
+		char name[32];
+		snprintf(name, sizeof(name), "%d threads", threads);
+		printf("  %-12s %4d bodies %8.3f ms/step, mean speed %.5f, heights %.3f, speedup %.2f\n", name,
+			scene.m_world->getNumCollisionObjects(), ms, scene.meanSpeed(), scene.heights(), serial / ms);
+		if (threads == maxThreads)
+			break;
+	}
+	btSetTaskScheduler(0);
+	delete scheduler;
+}
+
+// Cloud of fast spheres with CCD, most of the step is spent in the per body stages and their sweeps.
+// Even layers fly up and odd layers sideways, their spheres reach the crossings in the same step,
+// so they miss each other in the predictive sweeps and CCD clamps them against the spheres moved before them.
+static void buildCloud(Scene& scene)
+{
+	const int grid = 50;
+	const int layers = 40;
+	btCollisionShape* sphere = scene.addShape(new btSphereShape(btScalar(0.2)));
+	for (int layer = 0; layer < layers; ++layer)
+		for (int i = 0; i < grid; ++i)
+			for (int k = 0; k < grid; ++k)
+			{
+				btRigidBody* body = scene.addBody(sphere, 1, btVector3((i - btScalar(0.5) * (grid - 1)) * 2, layer * 2, (k - btScalar(0.5) * (grid - 1)) * 2));
+				body->setLinearVelocity((layer & 1) ? btVector3(30, 0, 0) : btVector3(0, 30, 0));
+				body->setCcdMotionThreshold(btScalar(0.1));
+				body->setCcdSweptSphereRadius(btScalar(0.15));
+			}
+}
+
+static void benchIntegrate(int steps)
+{
+	const int hardwareThreads = int(std::thread::hardware_concurrency());
+	steps = btMax(steps / 30, 1);
+	printf("integrate: %d hardware threads\n", hardwareThreads);
+	double serial;
+	btAlignedObjectArray<btTransform> expected, transforms;
+	{
+		Scene scene;
+		buildCloud(scene);
+		int clamped = 0;
+		serial = 0;
+		for (int i = 0; i < steps; ++i)
+		{
+			serial += scene.run(1) / steps;
+			clamped += scene.clampedBodies();
+		}
+		scene.transforms(expected);
+		printf("  %-12s %6d bodies %6d clamped %8.3f ms/step, heights %.3f\n", "serial",
+			scene.m_world->getNumCollisionObjects(), clamped, serial, scene.heights());
+	}
+	btITaskScheduler* scheduler = btCreateDefaultTaskScheduler();
+	btSetTaskScheduler(scheduler);
+	const int maxThreads = btMax(hardwareThreads, 2);
+	for (int threads = 1;; threads = btMin(threads * 2, maxThreads))
+	{
+		scheduler->setNumThreads(threads);
+		Scene scene(true);
+		buildCloud(scene);
+		int clamped = 0;
+		double ms = 0;
+		for (int i = 0; i < steps; ++i)
+		{
+			ms += scene.run(1) / steps;
+			clamped += scene.clampedBodies();
+		}
+		scene.transforms(transforms);
+		char name[32];
+		snprintf(name, sizeof(name), "%d threads", threads);
+		printf("  %-12s %6d bodies %6d clamped %8.3f ms/step, heights %.3f, %d mismatches, speedup %.2f\n", name,
+			scene.m_world->getNumCollisionObjects(), clamped, ms, scene.heights(), countMismatches(expected, transforms), serial / ms);
+		if (threads == maxThreads)
+			break;
+	}
+	btSetTaskScheduler(0);
+	delete scheduler;
+}
+
+static void benchRays(int steps)
+{
+	const int hardwareThreads = int(std::thread::hardware_concurrency());
+	const int numRays = 100000;
+	printf("rays: %d hardware threads\n", hardwareThreads);
+	Scene scene;
+	buildTowers(scene);
+	scene.run(60);
+
+	// line of sight rays, each agent looks at 16 random points around it
+	btAlignedObjectArray<btVector3> from, to;
+	btAlignedObjectArray<btCollisionWorld::ClosestRayHit> expected, results;
+	from.resize(numRays);
+	to.resize(numRays);
+	expected.resize(numRays);
+	results.resize(numRays);
+	unsigned seed = 12345;
+	btScalar coords[3];
+	btVector3 eye(0, 0, 0);
+	for (int i = 0; i < numRays; ++i)
+	{
+		for (int k = 0; k < 3; ++k)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			coords[k] = btScalar(seed >> 8) / btScalar(1 << 24) - btScalar(0.5);
+		}
+		if (i % 16 == 0)
+			eye.setValue(coords[0] * 100, btScalar(1.7), coords[2] * 100);
+		from[i] = eye;
+		to[i] = eye + btVector3(coords[0] * 40, coords[1] * 3, coords[2] * 40);
+	}
+
+	const int repeats = btMax(steps / 100, 1);
+	double start = Now();
+	int hits = 0;
+	for (int r = 0; r < repeats; ++r)
+	{
+		hits = 0;
+		for (int i = 0; i < numRays; ++i)
+		{
+			btCollisionWorld::ClosestRayResultCallback callback(from[i], to[i]);
+			scene.m_world->rayTest(from[i], to[i], callback);
+			expected[i].m_collisionObject = callback.m_collisionObject;
+			expected[i].m_hitFraction = callback.m_closestHitFraction;
+			hits += callback.hasHit();
+		}
+	}
+	const double serial = (Now() - start) / (repeats * numRays);
+	printf("  %-12s %6d rays %6d hits %8.3f Mrays/s\n", "rayTest", numRays, hits, 1e-6 / serial);
+
+	btITaskScheduler* scheduler = btCreateDefaultTaskScheduler();
+	btSetTaskScheduler(scheduler);
+	const int maxThreads = btMax(hardwareThreads, 2);
+	for (int threads = 1;; threads = btMin(threads * 2, maxThreads))
+	{
+		scheduler->setNumThreads(threads);
+		start = Now();
+		for (int r = 0; r < repeats; ++r)
+			scene.m_world->rayTestBatch(&from[0], &to[0], 0, &results[0], numRays);
+		const double seconds = (Now() - start) / (repeats * numRays);
+		int mismatches = 0;
+		for (int i = 0; i < numRays; ++i)
+		{
+			if (results[i].m_collisionObject != expected[i].m_collisionObject || results[i].m_hitFraction != expected[i].m_hitFraction)
+				mismatches++;
+		}
+		char name[32];
+		snprintf(name, sizeof(name), "%d threads", threads);
+		printf("  %-12s %6d rays %6d mismatches %8.3f Mrays/s, speedup %.2f\n", name, numRays, mismatches, 1e-6 / seconds, serial / seconds);
+		if (threads == maxThreads)
+			break;
+	}
+	btSetTaskScheduler(0);
+	delete scheduler;
+}
+
+// Collects the contact points of contactTest one query at a time, to compare against contactTestBatch
+struct ContactCollector : public btCollisionWorld::ContactResultCallback
+{
+	const btCollisionObject* m_query;
+	int m_queryIndex;
+	btAlignedObjectArray<btCollisionWorld::ContactHit>* m_hits;
+
+	virtual btScalar addSingleResult(btManifoldPoint& cp, const btCollisionObjectWrapper* colObj0Wrap, int, int, const btCollisionObjectWrapper* colObj1Wrap, int, int)
+	{
+		btCollisionWorld::ContactHit& hit = m_hits->expandNonInitializing();
+		hit.m_queryIndex = m_queryIndex;
+		hit.m_collisionObject = (colObj0Wrap->getCollisionObject() == m_query) ? colObj1Wrap->getCollisionObject() : colObj0Wrap->getCollisionObject();
+		hit.m_distance = cp.getDistance();
+		return 0;
+	}
+};
+
+static void benchQueries(int steps)
+{
+	const int hardwareThreads = int(std::thread::hardware_concurrency());
+	const int numQueries = 20000;
+	printf("queries: %d hardware threads\n", hardwareThreads);
+	Scene scene;
+	buildTowers(scene);
+	scene.run(60);
+
+	// agents sweep their shape towards a random point around them, then test for contacts where they would stand
+	btSphereShape sphere(btScalar(0.4));
+	btBoxShape box(btVector3(btScalar(0.4), btScalar(0.9), btScalar(0.4)));
+	btCapsuleShape capsule(btScalar(0.3), btScalar(1.2));
+	btConvexShape* agentShapes[3] = {&sphere, &box, &capsule};
+	btAlignedObjectArray<const btConvexShape*> castShapes;
+	btAlignedObjectArray<btCollisionShape*> shapes;
+	btAlignedObjectArray<btTransform> from, to;
+	btAlignedObjectArray<btCollisionWorld::ClosestConvexHit> expected, results;
+	castShapes.resize(numQueries);
+	shapes.resize(numQueries);
+	from.resize(numQueries);
+	to.resize(numQueries);
+	expected.resize(numQueries);
+	results.resize(numQueries);
+	unsigned seed = 54321;
+	btScalar coords[3];
+	for (int i = 0; i < numQueries; ++i)
+	{
+		for (int k = 0; k < 3; ++k)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			coords[k] = btScalar(seed >> 8) / btScalar(1 << 24) - btScalar(0.5);
+		}
+		castShapes[i] = agentShapes[i % 3];
+		shapes[i] = agentShapes[i % 3];
+		btQuaternion rotation(btVector3(0, 1, 0), coords[1] * SIMD_2_PI);
+		const btVector3 origin(coords[0] * 100, btScalar(1.), coords[2] * 100);
+		from[i] = btTransform(rotation, origin);
+		to[i] = btTransform(rotation, origin + btVector3(coords[2] * 10, 0, coords[0] * 10));
+	}
+
+	const int repeats = btMax(steps / 100, 1);
+	double start = Now();
+	int hits = 0;
+	for (int r = 0; r < repeats; ++r)
+	{
+		hits = 0;
+		for (int i = 0; i < numQueries; ++i)
+		{
+			btCollisionWorld::ClosestConvexResultCallback callback(from[i].getOrigin(), to[i].getOrigin());
+			scene.m_world->convexSweepTest(castShapes[i], from[i], to[i], callback);
+			expected[i].m_collisionObject = callback.m_hitCollisionObject;
+			expected[i].m_hitFraction = callback.m_closestHitFraction;
+			hits += callback.hasHit();
+		}
+	}
+	const double serialSweeps = (Now() - start) / (repeats * numQueries);
+
+	btAlignedObjectArray<btCollisionWorld::ContactHit> expectedContacts, contacts;
+	start = Now();
+	for (int r = 0; r < repeats; ++r)
+	{
+		expectedContacts.resize(0);
+		for (int i = 0; i < numQueries; ++i)
+		{
+			btCollisionObject query;
+			query.setCollisionShape(shapes[i]);
+			query.setWorldTransform(to[i]);
+			ContactCollector collector;
+			collector.m_query = &query;
+			collector.m_queryIndex = i;
+			collector.m_hits = &expectedContacts;
+			scene.m_world->contactTest(&query, collector);
+		}
+	}
+	const double serialContacts = (Now() - start) / (repeats * numQueries);
+	printf("  %-12s %6d queries %6d hits %8.3f Msweeps/s %6d contacts %8.3f Mcontacttests/s\n", "serial", numQueries, hits,
+		1e-6 / serialSweeps, expectedContacts.size(), 1e-6 / serialContacts);
+
+	btITaskScheduler* scheduler = btCreateDefaultTaskScheduler();
+	btSetTaskScheduler(scheduler);
+	const int maxThreads = btMax(hardwareThreads, 2);
+	for (int threads = 1;; threads = btMin(threads * 2, maxThreads))
+	{
+		scheduler->setNumThreads(threads);
+		start = Now();
+		for (int r = 0; r < repeats; ++r)
+			scene.m_world->convexSweepTestBatch(&castShapes[0], &from[0], &to[0], 0, &results[0], numQueries);
+		const double sweeps = (Now() - start) / (repeats * numQueries);
+		start = Now();
+		for (int r = 0; r < repeats; ++r)
+			scene.m_world->contactTestBatch(&shapes[0], &to[0], 0, numQueries, contacts);
+		const double contactTests = (Now() - start) / (repeats * numQueries);
+		int mismatches = 0;
+		for (int i = 0; i < numQueries; ++i)
+		{
+			if (results[i].m_collisionObject != expected[i].m_collisionObject || results[i].m_hitFraction != expected[i].m_hitFraction)
+				mismatches++;
+		}
+		if (contacts.size() != expectedContacts.size())
+			mismatches += btMax(contacts.size(), expectedContacts.size());
+		else
+		{
+			for (int i = 0; i < contacts.size(); ++i)
+			{
+				if (contacts[i].m_queryIndex != expectedContacts[i].m_queryIndex || contacts[i].m_collisionObject != expectedContacts[i].m_collisionObject ||
+					contacts[i].m_distance != expectedContacts[i].m_distance)
+					mismatches++;
+			}
+		}
+		char name[32];
+		snprintf(name, sizeof(name), "%d threads", threads);
+		printf("  %-12s %6d mismatches %8.3f Msweeps/s, speedup %.2f %8.3f Mcontacttests/s, speedup %.2f\n", name, mismatches,
+			1e-6 / sweeps, serialSweeps / sweeps, 1e-6 / contactTests, serialContacts / contactTests);
+		if (threads == maxThreads)
+			break;
+	}
+	btSetTaskScheduler(0);
+	delete scheduler;
+}
+
+// Counts the proxies a broadphase ray reaches, with an order independent hash of them
+struct ProxyRayCounter : public btBroadphaseRayCallback
+{
+	int m_count;
+	unsigned m_hash;
+	ProxyRayCounter(const btVector3& from, const btVector3& to)
+		: m_count(0)
+		, m_hash(0)
+	{
+		btVector3 direction = (to - from).normalized();
+		for (int k = 0; k < 3; ++k)
+		{
+			m_rayDirectionInverse[k] = direction[k] == btScalar(0) ? btScalar(BT_LARGE_FLOAT) : btScalar(1) / direction[k];
+			m_signs[k] = m_rayDirectionInverse[k] < btScalar(0);
+		}
+		m_lambda_max = direction.dot(to - from);
+	}
+	virtual bool process(const btBroadphaseProxy* proxy)
+	{
+		m_count++;
+		const unsigned h = unsigned(proxy->m_uniqueId) * 2654435761u;
+		m_hash += h ^ (h >> 15);
+		return true;
+	}
+};
+
+// Broadphase only, a grid of fixed boxes and boxes moving over it
+struct ProxyField
+{
+	btDefaultCollisionConfiguration m_configuration;
+	btCollisionDispatcher m_dispatcher;
+	btDbvtBroadphase m_broadphase;
+	btAlignedObjectArray<btBroadphaseProxy*> m_fixed;
+	btAlignedObjectArray<btBroadphaseProxy*> m_moving;
+	int m_side;
+	btScalar m_movingExtent;
+
+	//! The broadphase uses paircache if given, its own btHashedOverlappingPairCache otherwise
+	ProxyField(int numFixed, int numMoving, bool wide, btOverlappingPairCache* paircache = 0, btScalar movingExtent = 1)
+		: m_dispatcher(&m_configuration)
+		, m_broadphase(paircache)
+		, m_movingExtent(movingExtent)
+	{
+		m_broadphase.m_widequeries = wide;
+		m_side = int(btSqrt(btScalar(numFixed)));
+		for (int i = 0; i < numFixed; ++i)
+		{
+			const btVector3 center(btScalar(i % m_side) * 2 - m_side, btScalar((i * 7) % 5), btScalar(i / m_side) * 2 - m_side);
+			const btVector3 extents(btScalar(0.8), btScalar(0.8), btScalar(0.8));
+			m_fixed.push_back(m_broadphase.createProxy(center - extents, center + extents, BOX_SHAPE_PROXYTYPE, 0, 1, -1, &m_dispatcher, 0));
+		}
+		for (int i = 0; i < numMoving; ++i)
+			m_moving.push_back(m_broadphase.createProxy(btVector3(0, 0, 0), btVector3(0, 0, 0), BOX_SHAPE_PROXYTYPE, 0, 1, -1, &m_dispatcher, 0));
+	}
+	~ProxyField()
+	{
+		for (int i = 0; i < m_moving.size(); ++i)
+			m_broadphase.destroyProxy(m_moving[i], &m_dispatcher);
+		for (int i = 0; i < m_fixed.size(); ++i)
+			m_broadphase.destroyProxy(m_fixed[i], &m_dispatcher);
+	}
+	//! Moves the moving boxes along circles and finds the pairs
+	void step(int frame)
+	{
+		for (int i = 0; i < m_moving.size(); ++i)
+		{
+			const btScalar angle = btScalar(frame) * btScalar(0.05) + btScalar(i);
+			const btVector3 center(btScalar((i * 37) % m_side) * 2 - m_side + 4 * btCos(angle), btScalar(2), btScalar((i * 91) % m_side) * 2 - m_side + 4 * btSin(angle));
+			const btVector3 extents(m_movingExtent, m_movingExtent, m_movingExtent);
+			m_broadphase.setAabb(m_moving[i], center - extents, center + extents, &m_dispatcher);
+		}
+		m_broadphase.calculateOverlappingPairs(&m_dispatcher);
+	}
+	//! Order independent hash of the pairs
+	unsigned pairHash()
+	{
+		btBroadphasePairArray& pairs = m_broadphase.getOverlappingPairCache()->getOverlappingPairArray();
+		unsigned hash = 0;
+		for (int i = 0; i < pairs.size(); ++i)
+		{
+			unsigned h = unsigned(pairs[i].m_pProxy0->m_uniqueId) * 2654435761u ^ unsigned(pairs[i].m_pProxy1->m_uniqueId) * 40503u;
+			hash += h ^ (h >> 15);
+		}
+		return hash;
+	}
+};
+
+static void benchWide(int steps)
+{
+	const int numFixed = 90000;
+	const int numMoving = 10000;
+	const int numRays = 100000;
+	printf("wide: %d fixed and %d moving proxies\n", numFixed, numMoving);
+
+	// rays from above the field down through it
+	btAlignedObjectArray<btVector3> from, to;
+	from.resize(numRays);
+	to.resize(numRays);
+	unsigned seed = 12345;
+	btScalar coords[4];
+	for (int i = 0; i < numRays; ++i)
+	{
+		for (int k = 0; k < 4; ++k)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			coords[k] = btScalar(seed >> 8) / btScalar(1 << 24) - btScalar(0.5);
+		}
+		from[i].setValue(coords[0] * 600, 20, coords[1] * 600);
+		to[i] = from[i] + btVector3(coords[2] * 40, -30, coords[3] * 40);
+	}
+
+	int expectedPairs = 0, expectedHits = 0;
+	unsigned expectedPairHash = 0, expectedRayHash = 0;
+	for (int wide = 0; wide < 2; ++wide)
+	{
+		ProxyField field(numFixed, numMoving, wide != 0);
+		// let the fixed set settle, then rebuild both trees, the wide copy follows a frame later
+		for (int frame = 0; frame < 4; ++frame)
+			field.step(frame);
+		field.m_broadphase.optimize();
+		for (int frame = 4; frame < 6; ++frame)
+			field.step(frame);
+		double start = Now();
+		for (int frame = 0; frame < steps; ++frame)
+			field.step(6 + frame);
+		const double frameTime = (Now() - start) * 1e3 / steps;
+		const int pairs = field.m_broadphase.getOverlappingPairCache()->getNumOverlappingPairs();
+		const unsigned pairHash = field.pairHash();
+
+		const int repeats = btMax(steps / 100, 1);
+		int hits = 0;
+		unsigned rayHash = 0;
+		start = Now();
+		for (int r = 0; r < repeats; ++r)
+		{
+			hits = 0;
+			rayHash = 0;
+			for (int i = 0; i < numRays; ++i)
+			{
+				ProxyRayCounter callback(from[i], to[i]);
+				field.m_broadphase.rayTest(from[i], to[i], callback);
+				hits += callback.m_count;
+				rayHash = rayHash * 31u + callback.m_hash;
+			}
+		}
+		const double rays = (Now() - start) / (repeats * numRays);
+
+		// the same rays, 32 at a time
+		btAlignedObjectArray<ProxyRayCounter> callbacks;
+		btAlignedObjectArray<btBroadphaseRayCallback*> packet;
+		callbacks.reserve(numRays);
+		packet.resize(numRays);
+		for (int i = 0; i < numRays; ++i)
+		{
+			callbacks.push_back(ProxyRayCounter(from[i], to[i]));
+			packet[i] = &callbacks[i];
+		}
+		start = Now();
+		for (int r = 0; r < repeats; ++r)
+		{
+			for (int i = 0; i < numRays; ++i)
+			{
+				callbacks[i].m_count = 0;
+				callbacks[i].m_hash = 0;
+			}
+			field.m_broadphase.rayTestPacket(&from[0], &to[0], &packet[0], numRays);
+		}
+		const double packets = (Now() - start) / (repeats * numRays);
+		int packetHits = 0;
+		unsigned packetHash = 0;
+		for (int i = 0; i < numRays; ++i)
+		{
+			packetHits += callbacks[i].m_count;
+			packetHash = packetHash * 31u + callbacks[i].m_hash;
+		}
+
+		if (!wide)
+		{
+			expectedPairs = pairs;
+			expectedPairHash = pairHash;
+			expectedHits = hits;
+			expectedRayHash = rayHash;
+		}
+		const int mismatches = (pairs != expectedPairs) + (pairHash != expectedPairHash) + (hits != expectedHits) + (rayHash != expectedRayHash) +
+							   (packetHits != expectedHits) + (packetHash != expectedRayHash);
+		printf("  %-12s %8.3f ms/frame %6d pairs %8d proxy hits %d mismatches %8.3f Mrays/s, packets %8.3f Mrays/s\n", wide ? "4-wide" : "binary",
+			frameTime, pairs, hits, mismatches, 1e-6 / rays, 1e-6 / packets);
+	}
+}
+
+// Order dependent hash of the pair array, the same for caches that keep the pairs in the same order
+static unsigned pairArrayHash(const btBroadphasePairArray& pairs)
+{
+	unsigned hash = 0;
+	for (int i = 0; i < pairs.size(); ++i)
+		hash = hash * 31u + unsigned(pairs[i].m_pProxy0->m_uniqueId) * 65599u + unsigned(pairs[i].m_pProxy1->m_uniqueId);
+	return hash;
+}
+
+static void benchPairCache(int steps)
+{
+	const int numProxies = 20000;
+	const int numPairs = 100000;
+	printf("paircache: %d pairs between %d proxies\n", numPairs, numProxies);
+	btAlignedObjectArray<btBroadphaseProxy> proxies;
+	proxies.resize(numProxies);
+	for (int i = 0; i < numProxies; ++i)
+	{
+		proxies[i].m_uniqueId = i + 2;
+		proxies[i].m_collisionFilterGroup = 1;
+		proxies[i].m_collisionFilterMask = -1;
+	}
+	// every proxy pairs with 5 others at distinct offsets, the misses use an offset no pair has
+	const int offsets[6] = {1, 17, 293, 4099, 7919, 3};
+	btAlignedObjectArray<btBroadphasePair> pairs, misses;
+	for (int n = 0; n < numPairs; ++n)
+	{
+		const int a = n % numProxies;
+		pairs.push_back(btBroadphasePair(proxies[a], proxies[(a + offsets[n / numProxies]) % numProxies]));
+		misses.push_back(btBroadphasePair(proxies[a], proxies[(a + offsets[5]) % numProxies]));
+	}
+	// added in one random order, removed in another
+	btAlignedObjectArray<btBroadphasePair> removals;
+	unsigned seed = 12345;
+	for (int pass = 0; pass < 2; ++pass)
+	{
+		for (int i = numPairs - 1; i > 0; --i)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			const int j = int((seed >> 8) % unsigned(i + 1));
+			const btBroadphasePair swap = pairs[i];
+			pairs[i] = pairs[j];
+			pairs[j] = swap;
+		}
+		if (pass == 0)
+			removals.copyFromArray(pairs);
+	}
+
+	const int repeats = btMax(steps / 30, 1);
+	unsigned expectedHash = 0;
+	for (int type = 0; type < 3; ++type)
+	{
+		const bool batched = type == 2;
+		// best of the repeats, the others may have shared the cpu
+		double add = 1e30, find = 1e30, remove = 1e30;
+		int found = 0;
+		unsigned hash = 0;
+		btOverlappingPairCache* cache;
+		if (type == 0)
+			cache = new btHashedOverlappingPairCache();
+		else
+			cache = new btOpenAddressingPairCache();
+		btOpenAddressingPairCache* openCache = static_cast<btOpenAddressingPairCache*>(cache);
+		// the tables keep their size, as in a broadphase running for a while
+		for (int i = 0; i < numPairs; ++i)
+			cache->addOverlappingPair(pairs[i].m_pProxy0, pairs[i].m_pProxy1);
+		for (int i = 0; i < numPairs; ++i)
+			cache->removeOverlappingPair(pairs[i].m_pProxy0, pairs[i].m_pProxy1, 0);
+		for (int r = 0; r < repeats; ++r)
+		{
+			double start = Now();
+			if (batched)
+				openCache->addOverlappingPairs(&pairs[0], numPairs);
+			else
+			{
+				for (int i = 0; i < numPairs; ++i)
+					cache->addOverlappingPair(pairs[i].m_pProxy0, pairs[i].m_pProxy1);
+			}
+			add = btMin(add, Now() - start);
+
+			start = Now();
+			found = 0;
+			for (int i = 0; i < numPairs; ++i)
+			{
+				found += cache->findPair(removals[i].m_pProxy0, removals[i].m_pProxy1) != 0;
+				found += cache->findPair(misses[i].m_pProxy0, misses[i].m_pProxy1) != 0;
+			}
+			find = btMin(find, Now() - start);
+
+			// the order of the pairs after removing half of them shows the caches stay interchangeable
+			start = Now();
+			if (batched)
+				openCache->removeOverlappingPairs(&removals[0], numPairs / 2, 0);
+			else
+			{
+				for (int i = 0; i < numPairs / 2; ++i)
+					cache->removeOverlappingPair(removals[i].m_pProxy0, removals[i].m_pProxy1, 0);
+			}
+			double removeTime = Now() - start;
+			hash = pairArrayHash(cache->getOverlappingPairArray());
+			start = Now();
+			if (batched)
+				openCache->removeOverlappingPairs(&removals[numPairs / 2], numPairs - numPairs / 2, 0);
+			else
+			{
+				for (int i = numPairs / 2; i < numPairs; ++i)
+					cache->removeOverlappingPair(removals[i].m_pProxy0, removals[i].m_pProxy1, 0);
+			}
+			remove = btMin(remove, removeTime + Now() - start);
+			if (cache->getNumOverlappingPairs())
+				found = -1;
+		}
+		delete cache;
+		if (type == 0)
+			expectedHash = hash;
+		const double ops = numPairs;
+		printf("  %-12s %6d found %d mismatches %8.3f Madds/s %8.3f Mfinds/s %8.3f Mremoves/s\n",
+			type == 0 ? "hashed" : batched ? "open batched" : "open", found, hash != expectedHash, 1e-6 * ops / add, 1e-6 * 2 * ops / find, 1e-6 * ops / remove);
+	}
+
+	// broadphase frames, boxes moving over a grid with about 100k pairs, the caches take turns so both see the same load
+	btOverlappingPairCache* caches[2] = {new btHashedOverlappingPairCache(), new btOpenAddressingPairCache()};
+	ProxyField* fields[2];
+	double frameTimes[2] = {0, 0};
+	for (int type = 0; type < 2; ++type)
+	{
+		fields[type] = new ProxyField(90000, 10000, true, caches[type], btScalar(1.6));
+		for (int frame = 0; frame < 6; ++frame)
+			fields[type]->step(frame);
+	}
+	for (int frame = 0; frame < steps; ++frame)
+	{
+		for (int type = 0; type < 2; ++type)
+		{
+			const double start = Now();
+			fields[type]->step(6 + frame);
+			frameTimes[type] += Now() - start;
+		}
+	}
+	for (int type = 0; type < 2; ++type)
+	{
+		const int numFramePairs = caches[type]->getNumOverlappingPairs();
+		const int mismatches = (numFramePairs != caches[0]->getNumOverlappingPairs()) +
+							   (pairArrayHash(caches[type]->getOverlappingPairArray()) != pairArrayHash(caches[0]->getOverlappingPairArray()));
+		printf("  %-12s %8.3f ms/frame %6d pairs %d mismatches\n", type == 0 ? "hashed" : "open", frameTimes[type] * 1e3 / steps, numFramePairs, mismatches);
+	}
+	for (int type = 0; type < 2; ++type)
+	{
+		delete fields[type];
+		delete caches[type];
+	}
+}
+
+// Collision world of moving boxes and spheres, placed by hand every frame
+struct MovingField
+{
+	btDefaultCollisionConfiguration m_configuration;
+	btCollisionDispatcher m_dispatcher;
+	btDbvtBroadphase m_broadphase;
+	btCollisionWorld m_world;
+	btBoxShape m_box;
+	btSphereShape m_sphere;
+	btAlignedObjectArray<btCollisionObject*> m_objects;
+	int m_side;
+
+	explicit MovingField(int numObjects)
+		: m_dispatcher(&m_configuration)
+		, m_world(&m_dispatcher, &m_broadphase, &m_configuration)
+		, m_box(btVector3(btScalar(0.5), btScalar(0.5), btScalar(0.5)))
+		, m_sphere(btScalar(0.6))
+	{
+		m_side = int(btSqrt(btScalar(numObjects)));
+		for (int i = 0; i < numObjects; ++i)
+		{
+			btCollisionObject* object = new btCollisionObject();
+			object->setCollisionShape(i % 3 ? static_cast<btCollisionShape*>(&m_box) : &m_sphere);
+			object->setWorldTransform(transform(i, 0));
+			m_objects.push_back(object);
+			m_world.addCollisionObject(object);
+		}
+	}
+	~MovingField()
+	{
+		for (int i = 0; i < m_objects.size(); ++i)
+		{
+			m_world.removeCollisionObject(m_objects[i]);
+			delete m_objects[i];
+		}
+	}
+	//! Every other object drifts slowly and mostly stays inside its leaf volume, the others leave it every frame
+	btTransform transform(int i, int frame) const
+	{
+		const btScalar speed = i % 2 ? btScalar(0.004) : btScalar(0.08);
+		const btScalar angle = btScalar(frame) * speed + btScalar(i);
+		btTransform t;
+		t.setIdentity();
+		t.setOrigin(btVector3(btScalar(i % m_side) * btScalar(2.5) + 3 * btCos(angle), btScalar((i * 7) % 3), btScalar(i / m_side) * btScalar(2.5) + 3 * btSin(angle)));
+		t.setRotation(btQuaternion(btVector3(0, 1, 0), angle));
+		return t;
+	}
+	//! Returns the seconds spent updating the aabbs
+	double step(int frame, bool bulk)
+	{
+		for (int i = 0; i < m_objects.size(); ++i)
+			m_objects[i]->setWorldTransform(transform(i, frame));
+		const double start = Now();
+		if (bulk)
+			m_world.updateAabbs();
+		else
+		{
+			for (int i = 0; i < m_objects.size(); ++i)
+				m_world.updateSingleAabb(m_objects[i]);
+		}
+		const double seconds = Now() - start;
+		m_world.computeOverlappingPairs();
+		return seconds;
+	}
+	//! Order independent hash of the pairs whose aabbs overlap, the others only wait for the incremental cleanup
+	unsigned overlapHash(int& count)
+	{
+		btBroadphasePairArray& pairs = m_broadphase.getOverlappingPairCache()->getOverlappingPairArray();
+		unsigned hash = 0;
+		count = 0;
+		for (int i = 0; i < pairs.size(); ++i)
+		{
+			const btBroadphaseProxy* a = pairs[i].m_pProxy0;
+			const btBroadphaseProxy* b = pairs[i].m_pProxy1;
+			if (!TestAabbAgainstAabb2(a->m_aabbMin, a->m_aabbMax, b->m_aabbMin, b->m_aabbMax))
+				continue;
+			unsigned h = unsigned(btMin(a->m_uniqueId, b->m_uniqueId)) * 2654435761u ^ unsigned(btMax(a->m_uniqueId, b->m_uniqueId)) * 40503u;
+			hash += h ^ (h >> 15);
+			count++;
+		}
+		return hash;
+	}
+};
+
+static void benchAabbs(int steps)
+{
+	const int hardwareThreads = int(std::thread::hardware_concurrency());
+	const int numObjects = 100000;
+	steps = btMax(steps / 10, 1);
+	printf("aabbs: %d moving objects, %d hardware threads\n", numObjects, hardwareThreads);
+	btITaskScheduler* scheduler = btCreateDefaultTaskScheduler();
+	btSetTaskScheduler(scheduler);
+	// one by one, then the bulk update over thread counts, taking turns so all see the same load
+	btAlignedObjectArray<int> threadCounts;
+	threadCounts.push_back(1);
+	threadCounts.push_back(1);
+	const int maxThreads = btMax(hardwareThreads, 2);
+	for (int threads = 2;; threads = btMin(threads * 2, maxThreads))
+	{
+		threadCounts.push_back(threads);
+		if (threads == maxThreads)
+			break;
+	}
+	btAlignedObjectArray<MovingField*> fields;
+	btAlignedObjectArray<double> updateTimes, frameTimes;
+	for (int v = 0; v < threadCounts.size(); ++v)
+	{
+		fields.push_back(new MovingField(numObjects));
+		updateTimes.push_back(0);
+		frameTimes.push_back(0);
+	}
+	for (int frame = 0; frame < steps + 2; ++frame)
+	{
+		for (int v = 0; v < fields.size(); ++v)
+		{
+			scheduler->setNumThreads(threadCounts[v]);
+			const double start = Now();
+			const double update = fields[v]->step(frame, v > 0);
+			// the first frames insert the objects
+			if (frame >= 2)
+			{
+				updateTimes[v] += update;
+				frameTimes[v] += Now() - start;
+			}
+		}
+	}
+	// the bulk updates also keep the pairs in the same order whatever the number of threads
+	int expectedPairs = 0;
+	unsigned expectedHash = 0, expectedOrder = 0;
+	for (int v = 0; v < fields.size(); ++v)
+	{
+		int pairs;
+		const unsigned hash = fields[v]->overlapHash(pairs);
+		const unsigned order = pairArrayHash(fields[v]->m_broadphase.getOverlappingPairCache()->getOverlappingPairArray());
+		if (v == 0)
+		{
+			expectedPairs = pairs;
+			expectedHash = hash;
+		}
+		if (v == 1)
+			expectedOrder = order;
+		char name[32];
+		if (v == 0)
+			snprintf(name, sizeof(name), "one by one");
+		else
+			snprintf(name, sizeof(name), "bulk %d thr", threadCounts[v]);
+		printf("  %-12s %8.3f ms updateAabbs %8.3f ms/frame %6d overlaps %d mismatches, speedup %.2f\n", name,
+			updateTimes[v] * 1e3 / steps, frameTimes[v] * 1e3 / steps, pairs, (pairs != expectedPairs) + (hash != expectedHash) + (v > 0 && order != expectedOrder),
+			updateTimes[0] / updateTimes[v]);
+		delete fields[v];
+	}
+	btSetTaskScheduler(0);
+	delete scheduler;
+}
+
+int main(int argc, char* argv[])
+{
+	const char* scene = (argc > 1) ? argv[1] : "all";
+	const int steps = (argc > 2) ? atoi(argv[2]) : 300;
+	const bool all = strcmp(scene, "all") == 0;
+	if (all || strcmp(scene, "stack") == 0)
+		benchStack(steps);
+	if (all || strcmp(scene, "islands") == 0)
+		benchIslands(steps);
+	if (all || strcmp(scene, "narrowphase") == 0)
+		benchNarrowphase(steps);
+	if (all || strcmp(scene, "giant") == 0)
+		benchGiantIsland(steps);
+	if (all || strcmp(scene, "integrate") == 0)
+		benchIntegrate(steps);
+	if (all || strcmp(scene, "rays") == 0)
+		benchRays(steps);
+	if (all || strcmp(scene, "queries") == 0)
+		benchQueries(steps);
+	if (all || strcmp(scene, "wide") == 0)
+		benchWide(steps);
+	if (all || strcmp(scene, "paircache") == 0)
+		benchPairCache(steps);
+	if (all || strcmp(scene, "aabbs") == 0)
+		benchAabbs(steps);
+	return EXIT_SUCCESS;
+}
@@ -6,6 +6,7 @@
 /* Interface header
 	Define PARSER_HIGHP_FLOAT before including this file 
 	to make double precision floating point numbers.
+	Define PARSER_PROFILE to collect execution statistics of programs.
 */
 #pragma once
 #ifndef __CONSOLE_SCRIPT_H__
@@ -14,18 +15,24 @@
 #include "script_defines.h"
 #include "script_lexem.h"
 #include "script_base.h"
+#include "script_program.h"
+#include "script_batch.h"
+#include "script_cache.h"
 
 namespace console_script {
 
 	class Parser {
-		typedef std::list<Lexem*> LexemList;
+		typedef std::vector<Lexem*> LexemVector;
 
 	public:
 		Parser();
+		//! Creates parser with its own overlay on top of shared registry (which must outlive the parser)
+		explicit Parser(const Base * shared_base);
 		~Parser();
 
 		bool Compile(const String& str);
-		void Execute();
+		void Execute();		//!< runs compiled program, may be called many times (only dirty part of it in reactive mode)
+		void ExecuteTree();	//!< reference evaluation by the tree traversal
 		bool Evaluate(const String& str, int* val);
 		bool Evaluate(const String& str, Float* val);
 		bool Evaluate(const String& str, String* val);
@@ -35,30 +42,87 @@ namespace console_script {
 		void AddVariable(const String& str, Float* ptr);
 		void AddVariable(const String& str, String* ptr);
 
+		//! Binds registered variable to the array of values (one per entity) for ExecuteBatch, nullptr unbinds it
+		bool BindArray(const String& str, const int* data);
+		bool BindArray(const String& str, const Float* data);
+		//! Evaluates compiled expression for count entities, output shouldn't overlap inputs
+		bool ExecuteBatch(size_t count, int* output);
+		bool ExecuteBatch(size_t count, Float* output);
+
+		//! Pure functions (no side effects) with constant arguments are evaluated at compile time
 		template <typename R, typename... Args>
-		void AddFunction(const String& str, R(*func)(Args...)) {
-			Base& base = Base::GetInstance();
-			base.AddFunction<R, Args...>(str, func);
+		void AddFunction(const String& str, R(*func)(Args...), bool pure = false) {
+			base_->AddFunction<R, Args...>(str, func, pure);
 		}
 		template <typename R, typename C, typename... Args>
-		void AddClassFunction(const String& str, R(C::*func)(Args...), C * object) {
-			Base& base = Base::GetInstance();
-			base.AddClassFunction<R, C, Args...>(str, func, object);
+		void AddClassFunction(const String& str, R(C::*func)(Args...), C * object, bool pure = false) {
+			base_->AddClassFunction<R, C, Args...>(str, func, object, pure);
 		}
 
 		const String& error() const { return error_; }
+		Base& base() { return *base_; }
+		const Program& program() const { return *program_; }
+		const Batch& batch() const { return batch_; }
+
+		//! Compiled programs of the last used expressions are reused by Compile and Evaluate (0 disables cache).
+		//! Tree of the cached expression isn't rebuilt, so ExecuteTree shouldn't be used with the cache.
+		//! Current program stays valid when the cache drops it (on shrinking, clearing or loading).
+		void SetCacheCapacity(size_t capacity) { cache_.set_capacity(capacity); }
+		void ClearCache() { cache_.Clear(); }
+		const ProgramCache& cache() const { return cache_; }
+		//! Precompiled programs image (may be stored to file and memory-mapped on the next run),
+		//! loading relinks symbols against the current registry and does no lexing nor tree building
+		void SaveCache(std::vector<unsigned char>& image) const { cache_.Save(image); }
+		bool LoadCache(const void * image, size_t size) { return cache_.Load(image, size, *base_, error_); }
+
+		//! In reactive mode Execute recomputes only the parts of the program reading variables marked dirty,
+		//! so host should mark every variable it has changed since the last execution
+		void SetReactive(bool reactive) { reactive_ = reactive; }
+		bool MarkDirty(const String& str);
+		void MarkAllDirty() { program_->MarkAllDirty(); }
+
+		//! Constant subtrees are folded at compile time unless disabled (for reference evaluation of the tree as written)
+		void SetFolding(bool folding) { folding_ = folding; }
+
+		//! Programs executed more than threshold times are compiled to native code where supported (0 disables it)
+		void SetJitThreshold(size_t threshold);
+
+#ifdef PARSER_PROFILE
+		//! Statistics of the own program and cached ones, native functions are summed over all of them
+		void GetProfile(std::vector<ProgramStats>& programs, std::vector<FunctionStats>& functions) const;
+		//! Text report of programs, instructions and native functions sorted by time
+		String DumpProfile() const;
+		void ResetProfile();
+#endif
 
 	private:
 		void Clear();
 		void AddLexem(const String& str, Lexem::Type type, int pos);
+		void AddOperator(const String& str, int pos, const OperatorInfo * info);
 		bool ParseLexems(const String& str);
 		bool RecognizeLexems();
 		bool BuildTree();
+		class Node * ParseExpression(size_t& pos, int min_priority, size_t depth);
+		class Node * ParseOperand(size_t& pos, size_t depth);
+		class Node * ParseFunction(size_t& pos, size_t depth);
+		class Node * TooDeep();
 		bool CheckTree();
+		void OptimizeTree();
+		bool BindArray(const String& str, Value::Type type, const void* data);
 
-		LexemList elements_;	//!< elements list
+		std::unique_ptr<Base> base_;	//!< own registry (overlay if parser is created with shared one)
+		Arena arena_;			//!< per-compile storage for lexems, nodes and temporary lists
+		LexemVector elements_;	//!< elements list
 		String error_;		//!< error message of parsed text
 		class Node * root_;
+		Program own_program_;	//!< program compiled from the tree when cache is disabled
+		Program * program_;		//!< current program (own or cached one)
+		std::shared_ptr<Program> cached_program_;	//!< keeps current cached program alive when cache drops it
+		ProgramCache cache_;	//!< compiled programs of the last used expressions
+		Batch batch_;			//!< structure-of-arrays execution of the program
+		size_t jit_threshold_;	//!< executions before native code compilation of the program
+		bool reactive_;			//!< execute dirty instructions only
+		bool folding_;			//!< fold constant subtrees of the tree
 	};
 
 } // namespace console_script
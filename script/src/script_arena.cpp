@@ -0,0 +1,57 @@
+#include "script_arena.h"
+
+#include <cstdint>
+#include <assert.h>
+
+namespace console_script {
+
+	Arena::Arena(size_t block_size) :
+		block_size_(block_size), current_(0), offset_(0), finalizers_(nullptr)
+	{
+	}
+	Arena::~Arena()
+	{
+		Reset();
+		for (auto it = blocks_.begin(); it != blocks_.end(); ++it)
+			delete[] it->data;
+	}
+	void * Arena::Allocate(size_t size, size_t alignment)
+	{
+		assert((alignment & (alignment - 1)) == 0 && "alignment should be a power of two");
+		while (current_ < blocks_.size())
+		{
+			Block& block = blocks_[current_];
+			uintptr_t base = reinterpret_cast<uintptr_t>(block.data);
+			uintptr_t ptr = (base + offset_ + alignment - 1) & ~(uintptr_t)(alignment - 1);
+			if (ptr + size <= base + block.size)
+			{
+				offset_ = ptr + size - base;
+				return reinterpret_cast<void*>(ptr);
+			}
+			// Doesn't fit, try the next one
+			++current_;
+			offset_ = 0;
+		}
+		// Allocate a new block
+		Block block;
+		block.size = (size + alignment > block_size_) ? size + alignment : block_size_;
+		block.data = new char[block.size];
+		blocks_.push_back(block);
+		current_ = blocks_.size() - 1;
+		offset_ = 0;
+		return Allocate(size, alignment);
+	}
+	void Arena::Reset()
+	{
+		// Destroy objects in reverse creation order
+		while (finalizers_)
+		{
+			Finalizer * finalizer = finalizers_;
+			finalizers_ = finalizer->next;
+			finalizer->destroy(finalizer->object);
+		}
+		current_ = 0;
+		offset_ = 0;
+	}
+
+} // namespace console_script
@@ -0,0 +1,99 @@
+#pragma once
+#ifndef __CONSOLE_SCRIPT_ARENA_H__
+#define __CONSOLE_SCRIPT_ARENA_H__
+
+#include <vector>
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <type_traits>
+
+namespace console_script {
+
+	/*
+	Per-compile bump allocator.
+	Memory blocks are kept between resets, so after the first few compiles
+	there are no heap allocations for lexems, nodes and temporary lists.
+	Objects with non-trivial destructors are registered on creation and
+	destroyed in reverse order on Reset.
+	*/
+	class Arena {
+	public:
+		explicit Arena(size_t block_size = 4096);
+		~Arena();
+
+		void * Allocate(size_t size, size_t alignment);
+
+		template <typename T, typename... Args>
+		T * Create(Args&&... args) {
+			if (std::is_trivially_destructible<T>::value)
+				return new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+			Finalizer * finalizer = static_cast<Finalizer*>(Allocate(sizeof(Finalizer), alignof(Finalizer)));
+			T * object = new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+			finalizer->destroy = &Destroy<T>;
+			finalizer->object = object;
+			finalizer->next = finalizers_;
+			finalizers_ = finalizer;
+			return object;
+		}
+
+		void Reset();
+
+		size_t num_blocks() const { return blocks_.size(); }
+
+	private:
+		// Don't allow to copy
+		Arena(const Arena&);
+		void operator =(const Arena&);
+
+		struct Block {
+			char * data;
+			size_t size;
+		};
+		struct Finalizer {
+			void (*destroy)(void*);
+			void * object;
+			Finalizer * next;
+		};
+
+		template <typename T>
+		static void Destroy(void * object) {
+			static_cast<T*>(object)->~T();
+		}
+
+		std::vector<Block> blocks_;
+		size_t block_size_;
+		size_t current_;	//!< current block index
+		size_t offset_;		//!< offset in current block
+		Finalizer * finalizers_;
+	};
+
+	// Allocator for standard containers, memory is reclaimed on arena reset only
+	template <typename T>
+	class ArenaAllocator {
+	public:
+		typedef T value_type;
+
+		ArenaAllocator(Arena * arena) : arena_(arena) {}
+		template <typename U>
+		ArenaAllocator(const ArenaAllocator<U>& other) : arena_(other.arena()) {}
+
+		T * allocate(size_t n) {
+			return static_cast<T*>(arena_->Allocate(n * sizeof(T), alignof(T)));
+		}
+		void deallocate(T *, size_t) {} // released with the arena
+
+		Arena * arena() const { return arena_; }
+
+	private:
+		Arena * arena_;
+	};
+
+	template <typename T, typename U>
+	bool operator == (const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) { return a.arena() == b.arena(); }
+	template <typename T, typename U>
+	bool operator != (const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) { return a.arena() != b.arena(); }
+
+} // namespace console_script
+
+#endif
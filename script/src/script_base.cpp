@@ -6,29 +6,29 @@
 
 namespace console_script {
 
-	Base * Base::instance_ = nullptr;
-
-	void Base::AddInstance()
-	{
-		instance_ = new Base();
-	}
-	void Base::RemoveInstance()
-	{
-		delete instance_;
-	}
-	Base& Base::GetInstance()
+	Base::Base() :
+		Base(nullptr)
 	{
-		assert(instance_);
-		return *instance_;
 	}
-	Base::Base()
+	Base::Base(const Base * parent) :
+		parent_(parent), version_(0)
 	{
-		FillOperatorsInfo();
-		FillOperatorPtrs();
+		// Overlay has no operators, they are taken from the parent
+		if (parent_ == nullptr)
+		{
+			FillOperatorsInfo();
+			FillOperatorPtrs();
+			// Resolve operation functions once
+			for (auto it = operators_info_.begin(); it != operators_info_.end(); ++it)
+			{
+				auto it_ptr = operator_ptrs_.find(it->second.type_);
+				it->second.func_ = (it_ptr != operator_ptrs_.end()) ? it_ptr->second : nullptr;
+			}
+			operator_trie_.Build(operators_info_);
+		}
 	}
 	void Base::AddOperatorInfo(const String& str, int priority, Operator::Type type, int value_types, int form, Value::Type return_type, bool associativity)
 	{
-		operator_list_.push_back(str);
 		OperatorInfo& info = operators_info_[str];
 		info.priority_ = priority;
 		info.type_ = type;
@@ -40,7 +40,6 @@ namespace console_script {
 	void Base::FillOperatorsInfo() // based on http://msdn.microsoft.com/en-us/library/x04xhy0h%28v=vs.80%29.aspx and http://en.cppreference.com/w/cpp/language/operator_precedence
 	{
 		const size_t expected_operators_count = 40;
-		operator_list_.reserve(expected_operators_count);
 		operators_info_.reserve(expected_operators_count);
 		// Additive:
 		AddOperatorInfo(CS_TEXT("+"), 12, Operator::kAddition, Value::kInteger | Value::kFloat | Value::kString, Operator::kBinary | Operator::kUnaryPrefix);
@@ -137,79 +136,159 @@ namespace console_script {
 		operator_ptrs_[Operator::kLeftShiftAssignment]			= &FuncLeftShiftAssignment;
 		operator_ptrs_[Operator::kRightShiftAssignment]			= &FuncRightShiftAssignment;
 	}
-	void Base::CountOperatorMatches(const String& str, MatchInfo& match)
+	const OperatorInfo* Base::MatchOperator(const CS_CHAR* text, size_t size, size_t& length) const
 	{
-		match.count = 0;
-		match.full_match = false;
-		size_t n_operators = operator_list_.size();
-		for (size_t i = 0u; i < n_operators; ++i)
-		{
-			const CS_CHAR* s1 = operator_list_[i].c_str();
-			const CS_CHAR* s2 = str.c_str();
-			size_t c = str.size();
-#ifndef PARSER_WIDE_STRING
-			if (strncmp(s1, s2, c) == 0)
-#else
-			if (wcsncmp(s1, s2, c) == 0)
-#endif
-			{
-				++match.count;
-				match.full_match = match.full_match || (operator_list_[i] == str);
-			}
-		}
+		if (parent_)
+			return parent_->MatchOperator(text, size, length);
+		return operator_trie_.Match(text, size, length);
 	}
-	bool Base::OperatorExists(const String& str)
+	bool Base::OperatorExists(const String& str) const
 	{
-		return operators_info_.find(str) != operators_info_.end();
+		return GetOperatorInfo(str) != nullptr;
 	}
-	bool Base::FunctionExists(const String& str)
+	bool Base::FunctionExists(const String& str) const
 	{
-		return function_ptrs_.find(str) != function_ptrs_.end();
+		return GetFunctionInfo(str) != nullptr;
 	}
-	bool Base::VariableExists(const String& str)
+	bool Base::VariableExists(const String& str) const
 	{
-		return variable_ptrs_.find(str) != variable_ptrs_.end();
+		return GetVariableInfo(str) != nullptr;
 	}
 	void Base::AddVariable(const String& str, void* ptr, Value::Type type)
 	{
-		variable_ptrs_[str] = VariableInfo(ptr, type);
+		SymbolInfo& symbol = symbols_[str];
+		symbol.variable = VariableInfo(ptr, type);
+		symbol.has_variable = true;
+		++version_;
+	}
+	size_t Base::version() const
+	{
+		// Both counters only grow, so the sum changes on any registration
+		return version_ + (parent_ ? parent_->version() : 0);
 	}
-	OperatorInfo* Base::GetOperatorInfo(const String& str)
+	const OperatorInfo* Base::GetOperatorInfo(const String& str) const
 	{
+		if (parent_)
+			return parent_->GetOperatorInfo(str);
 		auto it = operators_info_.find(str);
 		if (it != operators_info_.end())
 			return &(it->second);
 		else
 			return nullptr;
 	}
-	VariableInfo* Base::GetVariableInfo(const String& str)
+	const VariableInfo* Base::GetVariableInfo(const String& str) const
 	{
-		auto it = variable_ptrs_.find(str);
-		if (it != variable_ptrs_.end())
-			return &(it->second);
+		auto it = symbols_.find(str);
+		if (it != symbols_.end() && it->second.has_variable)
+			return &(it->second.variable);
+		else if (parent_)
+			return parent_->GetVariableInfo(str);
 		else
 			return nullptr;
 	}
-	FunctionInfo* Base::GetFunctionInfo(const String& str)
+	const FunctionInfo* Base::GetFunctionInfo(const String& str) const
 	{
-		auto it = function_ptrs_.find(str);
-		if (it != function_ptrs_.end())
-			return &(it->second);
+		auto it = symbols_.find(str);
+		if (it != symbols_.end() && it->second.has_function)
+			return &(it->second.function);
+		else if (parent_)
+			return parent_->GetFunctionInfo(str);
 		else
 			return nullptr;
 	}
-	OperatorPtr Base::GetOperatorPtr(Operator::Type type)
+	void Base::GetSymbolInfo(const String& str, const FunctionInfo*& function, const VariableInfo*& variable) const
 	{
+		function = nullptr;
+		variable = nullptr;
+		for (const Base * base = this; base != nullptr && (!function || !variable); base = base->parent_)
+		{
+			auto it = base->symbols_.find(str);
+			if (it == base->symbols_.end())
+				continue;
+			// Overlay symbols hide the parent ones of the same kind
+			if (!function && it->second.has_function)
+				function = &(it->second.function);
+			if (!variable && it->second.has_variable)
+				variable = &(it->second.variable);
+		}
+	}
+	OperatorPtr Base::GetOperatorPtr(Operator::Type type) const
+	{
+		if (parent_)
+			return parent_->GetOperatorPtr(type);
 		auto it = operator_ptrs_.find(type);
 		assert(it != operator_ptrs_.end());
 		return it->second;
 	}
-	void Base::CallFunction(const String& func_name, std::vector<Variant>& args_vec, Value* ret)
+	OperatorTrie::OperatorTrie() :
+		alphabet_size_(0)
+	{
+		memset(alphabet_, 0, sizeof(alphabet_));
+	}
+	int OperatorTrie::Symbol(CS_CHAR c) const
+	{
+		unsigned int code = static_cast<unsigned int>(c);
+		return (code < static_cast<unsigned int>(kMaxSymbols)) ? alphabet_[code] - 1 : -1;
+	}
+	void OperatorTrie::Build(const std::unordered_map<String, OperatorInfo>& operators)
+	{
+		// Collect the alphabet first, so every node has the same number of transitions
+		for (auto it = operators.begin(); it != operators.end(); ++it)
+			for (CS_CHAR c : it->first)
+			{
+				unsigned int code = static_cast<unsigned int>(c);
+				assert(code < static_cast<unsigned int>(kMaxSymbols));
+				if (alphabet_[code] == 0)
+					alphabet_[code] = static_cast<unsigned char>(++alphabet_size_);
+			}
+		nodes_.clear();
+		transitions_.clear();
+		nodes_.push_back(Node{ nullptr, 0 }); // root
+		transitions_.resize(alphabet_size_, 0);
+		for (auto it = operators.begin(); it != operators.end(); ++it)
+		{
+			int node = 0;
+			for (CS_CHAR c : it->first)
+			{
+				int& child = transitions_[nodes_[node].first_child + Symbol(c)];
+				if (child == 0) // root is never a child, so 0 means no transition
+				{
+					child = static_cast<int>(nodes_.size());
+					nodes_.push_back(Node{ nullptr, static_cast<int>(transitions_.size()) });
+					transitions_.resize(transitions_.size() + alphabet_size_, 0);
+				}
+				node = transitions_[nodes_[node].first_child + Symbol(c)]; // reference may be invalidated by resize
+			}
+			nodes_[node].info = &(it->second);
+		}
+	}
+	const OperatorInfo* OperatorTrie::Match(const CS_CHAR* text, size_t size, size_t& length) const
+	{
+		const OperatorInfo * match = nullptr;
+		length = 0;
+		int node = 0;
+		for (size_t i = 0; i < size; ++i)
+		{
+			int symbol = Symbol(text[i]);
+			if (symbol < 0)
+				break;
+			node = transitions_[nodes_[node].first_child + symbol];
+			if (node == 0)
+				break;
+			if (nodes_[node].info)
+			{
+				match = nodes_[node].info;
+				length = i + 1;
+			}
+		}
+		return match;
+	}
+	void Base::CallFunction(const String& func_name, const Value * const * args, Value* ret) const
 	{
-		auto it = function_ptrs_.find(func_name);
-		if (it != function_ptrs_.end())
+		const FunctionInfo * info = GetFunctionInfo(func_name);
+		if (info)
 		{
-			it->second.func_->Call(ret, args_vec);
+			info->Call(ret, args);
 		}
 	}
 
@@ -4,7 +4,6 @@
 
 #include "script_lexem.h"
 #include "script_node.h"
-#include "variant.h" // using own variant class, since standart one is from C++17
 
 #include <unordered_map>
 #include <vector>
@@ -15,19 +14,10 @@
 namespace console_script {
 
 	const int kLowestPriority = 0;
+	const int kMaxFunctionArguments = 8;
+	const size_t kMaxTreeDepth = 1024; //!< deeper expressions are rejected, since tree passes and code emission are recursive
 
-	typedef void (*OperatorPtr)(const std::list<Node*>& list, Value* value);
-	typedef console_script::variant<bool, int, Float, String> Variant;
-
-	struct MatchInfo {
-		int count;
-		bool full_match;
-
-		void clear() {
-			count = 0;
-			full_match = false;
-		}
-	};
+	typedef void (*OperatorPtr)(const NodeList& list, Value* value);
 
 	class OperatorInfo {
 		friend class Base;
@@ -35,12 +25,13 @@ namespace console_script {
 	public:
 		OperatorInfo() {}
 
-		int priority() { return priority_; }
-		Operator::Type type() { return type_; }
-		int form() { return form_; }
-		int value_types() { return value_types_; }
-		Value::Type return_type() { return return_type_; }
-		bool associativity() { return associativity_; }
+		int priority() const { return priority_; }
+		Operator::Type type() const { return type_; }
+		int form() const { return form_; }
+		int value_types() const { return value_types_; }
+		Value::Type return_type() const { return return_type_; }
+		bool associativity() const { return associativity_; }
+		OperatorPtr func() const { return func_; }
 
 	private:
 		int priority_;			//!< operation priority
@@ -49,38 +40,40 @@ namespace console_script {
 		Value::Type return_type_; //!< return value type (if kAll then use same value type)
 		bool associativity_;	//!< is left-to-right (right-to-left otherwise)
 		Operator::Type type_;	//!< operation type
+		OperatorPtr func_;		//!< operation function (resolved once at registry creation)
 	};
 
 	class VariableInfo {
 		friend class Base;
 
 	public:
-		VariableInfo() {}
+		VariableInfo() : ptr_(nullptr), type_(Value::kUnknown) {}
 		VariableInfo(void * ptr, Value::Type type) :
 			ptr_(ptr), type_(type)
 		{}
 
-		void * ptr() { return ptr_; }
-		Value::Type type() { return type_; }
+		void * ptr() const { return ptr_; }
+		Value::Type type() const { return type_; }
 	private:
 		void * ptr_;
 		Value::Type type_;
 	};
 
+	// Arguments types are checked at compile stage, so values are unpacked directly
 	template <typename R, typename... Args>
 	class FunctionCaller {
 	public:
 		template <std::size_t ... Is>
-		static void Call(Value* ret, std::vector<Variant>& args_vec, std::index_sequence<Is...>, R(*f)(Args...)) {
-			*ret = f(args_vec.at(Is).get<Args>()...);
+		static void Call(Value* ret, const Value * const * args, std::index_sequence<Is...>, R(*f)(Args...)) {
+			*ret = f(ValueGetter<Args>::Get(*args[Is])...);
 		}
 	};
 	template <typename... Args>
 	class FunctionCaller <void, Args...> {
 	public:
 		template <std::size_t ... Is>
-		static void Call(Value* ret, std::vector<Variant>& args_vec, std::index_sequence<Is...>, void(*f)(Args...)) {
-			f(args_vec.at(Is).get<Args>()...);
+		static void Call(Value* ret, const Value * const * args, std::index_sequence<Is...>, void(*f)(Args...)) {
+			f(ValueGetter<Args>::Get(*args[Is])...);
 		}
 	};
 
@@ -88,16 +81,16 @@ namespace console_script {
 	class ClassFunctionCaller {
 	public:
 		template <std::size_t ... Is>
-		static void Call(Value* ret, std::vector<Variant>& args_vec, std::index_sequence<Is...>, R(C::*f)(Args...), C * obj) {
-			*ret = (obj->*f)(args_vec.at(Is).get<Args>()...);
+		static void Call(Value* ret, const Value * const * args, std::index_sequence<Is...>, R(C::*f)(Args...), C * obj) {
+			*ret = (obj->*f)(ValueGetter<Args>::Get(*args[Is])...);
 		}
 	};
 	template <typename C, typename... Args>
 	class ClassFunctionCaller <void, C, Args...> {
 	public:
 		template <std::size_t ... Is>
-		static void Call(Value* ret, std::vector<Variant>& args_vec, std::index_sequence<Is...>, void(C::*f)(Args...), C * obj) {
-			(obj->*f)(args_vec.at(Is).get<Args>()...);
+		static void Call(Value* ret, const Value * const * args, std::index_sequence<Is...>, void(C::*f)(Args...), C * obj) {
+			(obj->*f)(ValueGetter<Args>::Get(*args[Is])...);
 		}
 	};
 
@@ -140,7 +133,8 @@ namespace console_script {
 	public:
 		virtual ~BaseFunc() = default;
 
-		virtual void Call(Value* ret, std::vector<Variant>& args_vec) const = 0;
+		//! args is an array of arguments count values
+		virtual void Call(Value* ret, const Value * const * args) const = 0;
 	};
 
 	template <typename R, typename... Args>
@@ -148,9 +142,9 @@ namespace console_script {
 	{
 	public:
 		Function(R(*f)(Args...)) : f(f) {}
-		void Call(Value* ret, std::vector<Variant>& args_vec) const override
+		void Call(Value* ret, const Value * const * args) const override
 		{
-			FunctionCaller<R, Args...>::Call(ret, args_vec, std::make_index_sequence<sizeof...(Args)>{}, f);
+			FunctionCaller<R, Args...>::Call(ret, args, std::make_index_sequence<sizeof...(Args)>{}, f);
 		}
 
 	private:
@@ -162,9 +156,9 @@ namespace console_script {
 	{
 	public:
 		ClassFunction(R(C::*f)(Args...), C * object) : f(f), object(object) {}
-		void Call(Value* ret, std::vector<Variant>& args_vec) const override
+		void Call(Value* ret, const Value * const * args) const override
 		{
-			ClassFunctionCaller<R, C, Args...>::Call(ret, args_vec, std::make_index_sequence<sizeof...(Args)>{}, f, object);
+			ClassFunctionCaller<R, C, Args...>::Call(ret, args, std::make_index_sequence<sizeof...(Args)>{}, f, object);
 		}
 
 	private:
@@ -175,53 +169,119 @@ namespace console_script {
 	class FunctionInfo {
 		friend class Base;
 	public:
-		Value::Type& return_type() { return return_type_; }
-		std::vector<Value::Type>& arguments_type() { return arguments_type_; }
+		Value::Type return_type() const { return return_type_; }
+		const std::vector<Value::Type>& arguments_type() const { return arguments_type_; }
+		bool pure() const { return pure_; }
+		const BaseFunc * func() const { return func_.get(); }
+		void Call(Value* ret, const Value * const * args) const { func_->Call(ret, args); }
 	private:
 		std::unique_ptr<BaseFunc> func_;
 		Value::Type return_type_;
 		std::vector<Value::Type> arguments_type_;
+		bool pure_; //!< has no side effects and result depends on arguments only (may be folded)
+	};
+
+	//! Function and variable registered under the same name (either may be missing)
+	struct SymbolInfo {
+		FunctionInfo function;
+		VariableInfo variable;
+		bool has_function;
+		bool has_variable;
+
+		SymbolInfo() : has_function(false), has_variable(false) {}
 	};
 
+	/*
+	Trie of operator strings, built once from the operators table.
+	Symbols used by operators are mapped to a small alphabet and every node keeps
+	child indices for the whole alphabet, so the longest operator at some position
+	is found by a single walk over the input without any string hashing.
+	*/
+	class OperatorTrie {
+		static const int kMaxSymbols = 128; //!< operators consist of ASCII symbols only
+
+	public:
+		OperatorTrie();
+
+		void Build(const std::unordered_map<String, OperatorInfo>& operators);
+		//! Returns the longest operator at the beginning of the text (nullptr if there is none)
+		const OperatorInfo* Match(const CS_CHAR* text, size_t size, size_t& length) const;
+
+	private:
+		int Symbol(CS_CHAR c) const;
+
+		struct Node {
+			const OperatorInfo * info;	//!< operator ending at this node (nullptr if none)
+			int first_child;			//!< index of the first child transition in transitions_
+		};
+		std::vector<Node> nodes_;
+		std::vector<int> transitions_;		//!< alphabet_size_ child indices per node (0 for no child)
+		unsigned char alphabet_[kMaxSymbols];	//!< symbol to alphabet index + 1 (0 if not used)
+		int alphabet_size_;
+	};
+
+	/*
+	Registry of operators, functions and variables.
+	Base may be created as an overlay on top of another (parent) registry.
+	Lookups search the overlay first and then the parent, and the parent is only
+	accessed through const methods. So a single shared registry may be filled once
+	and then used by any number of threads, each having its own overlay (and parser),
+	without any locks. Registration itself is not synchronized and should be done
+	on the owning thread only.
+	*/
 	class Base {
 		typedef std::unordered_map<String, OperatorInfo> OperatorInfoMap;
 		typedef std::unordered_map<Operator::Type, OperatorPtr> OperatorMap;
-		typedef std::unordered_map<String, FunctionInfo> FunctionMap;
-		typedef std::unordered_map<String, VariableInfo> VariableMap;
-		// Iteration thru hash map is very slow, so I've decided to use another container
-		typedef std::vector<String> OperatorList;
+		typedef std::unordered_map<String, SymbolInfo> SymbolMap;
 
 	public:
-		static void AddInstance();
-		static void RemoveInstance();
-		static Base& GetInstance();
+		Base();
+		explicit Base(const Base * parent);
+		~Base() = default;
 
-		void CountOperatorMatches(const String& str, MatchInfo& match);
-		bool OperatorExists(const String& str);
-		bool FunctionExists(const String& str);
-		bool VariableExists(const String& str);
+		//! Returns the longest operator at the beginning of the text, length receives its size
+		const OperatorInfo* MatchOperator(const CS_CHAR* text, size_t size, size_t& length) const;
+		bool OperatorExists(const String& str) const;
+		bool FunctionExists(const String& str) const;
+		bool VariableExists(const String& str) const;
 
 		void AddVariable(const String& str, void* ptr, Value::Type type);
 
 		template <typename R, typename... Args>
-		void AddFunction(const String& str, R(*f)(Args...)) {
-			FunctionInfo& info = function_ptrs_[str];
+		void AddFunction(const String& str, R(*f)(Args...), bool pure = false) {
+			static_assert(sizeof...(Args) <= kMaxFunctionArguments, "too many function arguments");
+			SymbolInfo& symbol = symbols_[str];
+			FunctionInfo& info = symbol.function;
+			symbol.has_function = true;
+			++version_;
 			info.func_ = std::make_unique< Function<R, Args...> >(f);
+			info.pure_ = pure;
 			FunctionTypeObtainer<R, Args...>::Get(info.return_type_, info.arguments_type_);
 		}
 		template <typename R, typename C, typename... Args>
-		void AddClassFunction(const String& str, R(C::*f)(Args...), C * object) {
-			FunctionInfo& info = function_ptrs_[str];
+		void AddClassFunction(const String& str, R(C::*f)(Args...), C * object, bool pure = false) {
+			static_assert(sizeof...(Args) <= kMaxFunctionArguments, "too many function arguments");
+			SymbolInfo& symbol = symbols_[str];
+			FunctionInfo& info = symbol.function;
+			symbol.has_function = true;
+			++version_;
 			info.func_ = std::make_unique< ClassFunction<R, C, Args...> >(f, object);
+			info.pure_ = pure;
 			FunctionTypeObtainer<R, Args...>::Get(info.return_type_, info.arguments_type_);
 		}
-		void CallFunction(const String& func_name, std::vector<Variant>& args_vec, Value* ret);
+		void CallFunction(const String& func_name, const Value * const * args, Value* ret) const;
+
+		const OperatorInfo* GetOperatorInfo(const String& str) const;
+		const VariableInfo* GetVariableInfo(const String& str) const;
+		const FunctionInfo* GetFunctionInfo(const String& str) const;
+		//! Finds both function and variable with a single lookup per registry
+		void GetSymbolInfo(const String& str, const FunctionInfo*& function, const VariableInfo*& variable) const;
 
-		OperatorInfo* GetOperatorInfo(const String& str);
-		VariableInfo* GetVariableInfo(const String& str);
-		FunctionInfo* GetFunctionInfo(const String& str);
+		OperatorPtr GetOperatorPtr(Operator::Type type) const;
 
-		OperatorPtr GetOperatorPtr(Operator::Type type);
+		const Base * parent() const { return parent_; }
+		//! Changes on every symbol registration here or in the parent registry
+		size_t version() const;
 
 	protected:
 		void FillOperatorsInfo();
@@ -230,19 +290,17 @@ namespace console_script {
 			int form = Operator::kBinary, Value::Type return_type = Value::kAll, bool associativity = true);
 
 	private:
-		Base();
-		~Base() = default;
 		// Don't allow to copy
 		Base(const Base&);
 		void operator =(const Base&);
 
-		static Base * instance_;
+		const Base * parent_;	//!< shared registry (operators are stored in the root one)
+		size_t version_;		//!< number of symbol registrations
 
 		OperatorInfoMap operators_info_;
-		OperatorList operator_list_;
+		OperatorTrie operator_trie_;	//!< operators recognition by the lexer
 		OperatorMap operator_ptrs_;
-		FunctionMap function_ptrs_;
-		VariableMap variable_ptrs_;
+		SymbolMap symbols_;		//!< functions and variables by name
 	};
 
 } // namespace console_script
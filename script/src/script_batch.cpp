@@ -0,0 +1,359 @@
+#include "script_batch.h"
+#include "script_program.h"
+
+#include <algorithm>
+#include <assert.h>
+
+namespace console_script {
+
+	/*
+	Loops take restrict pointers as parameters (compilers ignore restrict on local variables),
+	so there is no aliasing check and fixed length loops are vectorized even at -O2.
+	*/
+
+#define BINARY_COLUMN(name, op) \
+	template <typename T> \
+	static inline void name##Block(T * __restrict value, const T * __restrict first, const T * __restrict second) \
+	{ \
+		for (size_t i = 0; i < Batch::kBlockSize; ++i) \
+			value[i] = first[i] op second[i]; \
+	} \
+	template <typename T> \
+	static void name(void** columns, const Instruction& instruction) \
+	{ \
+		name##Block(static_cast<T*>(columns[instruction.value]), \
+			static_cast<const T*>(columns[instruction.first]), \
+			static_cast<const T*>(columns[instruction.second])); \
+	}
+
+	BINARY_COLUMN(ColumnAddition, +)
+	BINARY_COLUMN(ColumnSubtraction, -)
+	BINARY_COLUMN(ColumnMultiplication, *)
+	BINARY_COLUMN(ColumnDivision, /)
+	BINARY_COLUMN(ColumnModulus, %)
+	BINARY_COLUMN(ColumnBitwiseAnd, &)
+	BINARY_COLUMN(ColumnBitwiseInclusiveOr, |)
+	BINARY_COLUMN(ColumnBitwiseExclusiveOr, ^)
+	BINARY_COLUMN(ColumnLeftShift, <<)
+	BINARY_COLUMN(ColumnRightShift, >>)
+
+#undef BINARY_COLUMN
+
+#define UNARY_COLUMN(name, op) \
+	template <typename T> \
+	static inline void name##Block(T * __restrict value, const T * __restrict first) \
+	{ \
+		for (size_t i = 0; i < Batch::kBlockSize; ++i) \
+			value[i] = op first[i]; \
+	} \
+	template <typename T> \
+	static void name(void** columns, const Instruction& instruction) \
+	{ \
+		name##Block(static_cast<T*>(columns[instruction.value]), \
+			static_cast<const T*>(columns[instruction.first])); \
+	}
+
+	UNARY_COLUMN(ColumnUnaryPlus, +)
+	UNARY_COLUMN(ColumnNegation, -)
+	UNARY_COLUMN(ColumnOnesComplement, ~)
+
+#undef UNARY_COLUMN
+
+	template <typename T, typename R>
+	static inline void ColumnCastBlock(R * __restrict value, const T * __restrict first)
+	{
+		for (size_t i = 0; i < Batch::kBlockSize; ++i)
+			value[i] = static_cast<R>(first[i]);
+	}
+	template <typename T, typename R>
+	static void ColumnCast(void** columns, const Instruction& instruction)
+	{
+		ColumnCastBlock(static_cast<R*>(columns[instruction.value]),
+			static_cast<const T*>(columns[instruction.first]));
+	}
+
+	ColumnPtr GetColumnKernel(Operator::Type type, bool binary, Value::Type operand_type)
+	{
+		// Only integer and float columns are supported
+		if (operand_type != Value::kInteger && operand_type != Value::kFloat)
+			return nullptr;
+		const bool integer = operand_type == Value::kInteger;
+
+#define NUMERIC_COLUMN(kernel) \
+		return integer ? &kernel<int> : &kernel<Float>;
+#define INTEGER_COLUMN(kernel) \
+		return integer ? &kernel<int> : nullptr;
+
+		switch (type)
+		{
+		case Operator::kAddition:
+			if (binary)
+				NUMERIC_COLUMN(ColumnAddition)
+			else
+				NUMERIC_COLUMN(ColumnUnaryPlus)
+		case Operator::kSubtraction:
+			if (binary)
+				NUMERIC_COLUMN(ColumnSubtraction)
+			else
+				NUMERIC_COLUMN(ColumnNegation)
+		case Operator::kMultiplication:		NUMERIC_COLUMN(ColumnMultiplication)
+		case Operator::kDivision:			NUMERIC_COLUMN(ColumnDivision)
+		case Operator::kModulus:			INTEGER_COLUMN(ColumnModulus)
+		case Operator::kBitwiseAnd:			INTEGER_COLUMN(ColumnBitwiseAnd)
+		case Operator::kBitwiseInclusiveOr:	INTEGER_COLUMN(ColumnBitwiseInclusiveOr)
+		case Operator::kBitwiseExclusiveOr:	INTEGER_COLUMN(ColumnBitwiseExclusiveOr)
+		case Operator::kLeftShift:			INTEGER_COLUMN(ColumnLeftShift)
+		case Operator::kRightShift:			INTEGER_COLUMN(ColumnRightShift)
+		case Operator::kOnesComplement:		INTEGER_COLUMN(ColumnOnesComplement)
+		case Operator::kCastInteger:		return integer ? &ColumnCast<int, int> : &ColumnCast<Float, int>;
+		case Operator::kCastFloat:			return integer ? &ColumnCast<int, Float> : &ColumnCast<Float, Float>;
+		default:							return nullptr;
+		}
+
+#undef INTEGER_COLUMN
+#undef NUMERIC_COLUMN
+	}
+
+	static size_t ColumnValueSize(Value::Type type)
+	{
+		return (type == Value::kInteger) ? sizeof(int) : sizeof(Float);
+	}
+	template <typename T, typename R>
+	static inline void ConvertBlock(R * __restrict value, const T * __restrict first, size_t count)
+	{
+		for (size_t i = 0; i < count; ++i)
+			value[i] = static_cast<R>(first[i]);
+	}
+	template <typename T, typename R>
+	static void ConvertColumn(const void * source, void * destination, size_t count)
+	{
+		ConvertBlock(static_cast<R*>(destination), static_cast<const T*>(source), count);
+	}
+	template <typename T>
+	static void PadColumn(const void * source, void * destination, size_t count)
+	{
+		// Tail is filled with the last value, so it is as safe to compute (like division) as inputs are
+		const T * first = static_cast<const T*>(source);
+		T * value = static_cast<T*>(destination);
+		std::copy(first, first + count, value);
+		std::fill(value + count, value + Batch::kBlockSize, first[count - 1]);
+	}
+	static void CopyColumn(Value::Type source_type, const void * source, Value::Type type, void * destination, size_t count)
+	{
+		if (source_type == Value::kInteger)
+		{
+			if (type == Value::kInteger)
+				ConvertColumn<int, int>(source, destination, count);
+			else
+				ConvertColumn<int, Float>(source, destination, count);
+		}
+		else
+		{
+			if (type == Value::kInteger)
+				ConvertColumn<Float, int>(source, destination, count);
+			else
+				ConvertColumn<Float, Float>(source, destination, count);
+		}
+	}
+
+	const size_t Batch::kBlockSize;
+
+	Batch::Batch() :
+		prepared_(false), vectorized_(false)
+	{
+	}
+	Batch::~Batch()
+	{
+	}
+	void Batch::Bind(const VariableInfo * info, const void * data)
+	{
+		for (auto it = bindings_.begin(); it != bindings_.end(); ++it)
+		{
+			if (it->info == info)
+			{
+				it->data = data;
+				return;
+			}
+		}
+		Binding binding;
+		binding.info = info;
+		binding.data = data;
+		bindings_.push_back(binding);
+	}
+	void Batch::Unbind(const VariableInfo * info)
+	{
+		for (auto it = bindings_.begin(); it != bindings_.end(); ++it)
+		{
+			if (it->info == info)
+			{
+				bindings_.erase(it);
+				return;
+			}
+		}
+	}
+	void Batch::Reset()
+	{
+		columns_.clear();
+		inputs_.clear();
+		storage_.reset();
+		prepared_ = false;
+		vectorized_ = false;
+	}
+	void * Batch::Block(int reg) const
+	{
+		return storage_.get() + kBlockSize * sizeof(Float) * reg;
+	}
+	const void * Batch::FindBinding(const VariableInfo * info) const
+	{
+		for (auto it = bindings_.begin(); it != bindings_.end(); ++it)
+			if (it->info == info)
+				return it->data;
+		return nullptr;
+	}
+	void Batch::Prepare(const Program& program)
+	{
+		prepared_ = true;
+		const int num_registers = program.num_registers_;
+
+		// Program is batched only if all values are numbers and all operations have column kernels
+		vectorized_ = true;
+		for (int i = 0; i < num_registers; ++i)
+		{
+			Value::Type type = program.registers_[i].type();
+			if (type != Value::kInteger && type != Value::kFloat)
+				vectorized_ = false;
+		}
+		for (auto it = program.instructions_.begin(); it != program.instructions_.end(); ++it)
+			if (it->column == nullptr)
+				vectorized_ = false;
+		inputs_.assign(num_registers, nullptr);
+		if (!vectorized_)
+			return;
+
+		// Every register has its own block, constants are broadcasted once
+		const size_t block_bytes = kBlockSize * sizeof(Float);
+		static_assert(sizeof(Float) >= sizeof(int), "float block should fit integers");
+		storage_.reset(new char[block_bytes * num_registers]);
+		columns_.resize(num_registers);
+		for (int i = 0; i < num_registers; ++i)
+		{
+			columns_[i] = Block(i);
+			const Value& value = program.registers_[i];
+			if (value.type() == Value::kInteger)
+				std::fill_n(static_cast<int*>(columns_[i]), kBlockSize, value.get<int>());
+			else
+				std::fill_n(static_cast<Float*>(columns_[i]), kBlockSize, value.get<Float>());
+		}
+	}
+	bool Batch::Execute(Program& program, size_t count, Value::Type output_type, void * output, String& error)
+	{
+		assert(output_type == Value::kInteger || output_type == Value::kFloat);
+		const Value * result = program.result();
+		if (result == nullptr || !result->valid())
+		{
+			error = CS_TEXT("expression has no result");
+			return false;
+		}
+		if (result->type() == Value::kString)
+		{
+			error = CS_TEXT("batch result can't be a string");
+			return false;
+		}
+		if (!prepared_)
+			Prepare(program);
+
+		// Resolve inputs of the program variables
+		for (auto it = program.variables_.begin(); it != program.variables_.end(); ++it)
+			inputs_[it->reg] = FindBinding(it->info);
+
+		if (vectorized_)
+			ExecuteColumns(program, count, output_type, output);
+		else
+			ExecuteScalar(program, count, output_type, output);
+		return true;
+	}
+	void Batch::ExecuteColumns(Program& program, size_t count, Value::Type output_type, void * output)
+	{
+		const int result = program.result_;
+		const Value::Type result_type = program.registers_[result].type();
+		const bool has_instructions = !program.instructions_.empty();
+		assert(!has_instructions || program.instructions_.back().value == result);
+
+		// Unbound variables are broadcasted with their current values
+		for (auto it = program.variables_.begin(); it != program.variables_.end(); ++it)
+		{
+			if (inputs_[it->reg])
+				continue;
+			columns_[it->reg] = Block(it->reg);
+			const Value& value = program.registers_[it->reg];
+			if (value.type() == Value::kInteger)
+				std::fill_n(static_cast<int*>(columns_[it->reg]), kBlockSize, value.get<int>());
+			else
+				std::fill_n(static_cast<Float*>(columns_[it->reg]), kBlockSize, value.get<Float>());
+		}
+
+		const Instruction * begin = program.instructions_.data();
+		const Instruction * end = begin + program.instructions_.size();
+		for (size_t start = 0; start < count; start += kBlockSize)
+		{
+			const size_t n = std::min(kBlockSize, count - start);
+			const bool full = n == kBlockSize;
+			for (auto it = program.variables_.begin(); it != program.variables_.end(); ++it)
+			{
+				const void * input = inputs_[it->reg];
+				if (input == nullptr)
+					continue;
+				Value::Type type = program.registers_[it->reg].type();
+				const char * data = static_cast<const char*>(input) + ColumnValueSize(type) * start;
+				if (full) // read inputs in place
+					columns_[it->reg] = const_cast<char*>(data);
+				else
+				{
+					columns_[it->reg] = Block(it->reg);
+					if (type == Value::kInteger)
+						PadColumn<int>(data, columns_[it->reg], n);
+					else
+						PadColumn<Float>(data, columns_[it->reg], n);
+				}
+			}
+			// Result of the last instruction is written directly to output when possible
+			const bool direct = full && has_instructions && result_type == output_type;
+			if (direct)
+				columns_[result] = static_cast<char*>(output) + ColumnValueSize(output_type) * start;
+			else if (has_instructions)
+				columns_[result] = Block(result);
+			for (const Instruction * it = begin; it != end; ++it)
+				it->column(columns_.data(), *it);
+			if (!direct)
+				CopyColumn(result_type, columns_[result], output_type,
+					static_cast<char*>(output) + ColumnValueSize(output_type) * start, n);
+		}
+		// Result column should not refer to user memory
+		if (has_instructions)
+			columns_[result] = Block(result);
+	}
+	void Batch::ExecuteScalar(Program& program, size_t count, Value::Type output_type, void * output)
+	{
+		const Value * result = program.result();
+		for (size_t i = 0; i < count; ++i)
+		{
+			for (auto it = program.variables_.begin(); it != program.variables_.end(); ++it)
+			{
+				const void * input = inputs_[it->reg];
+				if (input == nullptr)
+					continue;
+				Value& value = program.registers_[it->reg];
+				if (value.type() == Value::kInteger)
+					value.get<int>() = static_cast<const int*>(input)[i];
+				else
+					value.get<Float>() = static_cast<const Float*>(input)[i];
+			}
+			program.Execute();
+			if (output_type == Value::kInteger)
+				static_cast<int*>(output)[i] = result->AsInteger();
+			else
+				static_cast<Float*>(output)[i] = result->AsFloat();
+		}
+	}
+
+} // namespace console_script
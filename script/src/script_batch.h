@@ -0,0 +1,71 @@
+#pragma once
+#ifndef __CONSOLE_SCRIPT_BATCH_H__
+#define __CONSOLE_SCRIPT_BATCH_H__
+
+#include "script_kernels.h"
+#include "script_base.h"
+
+#include <vector>
+#include <memory> // for unique_ptr
+
+namespace console_script {
+
+	class Program;
+
+	// Returns batch kernel for the operator (nullptr if operation can't be batched)
+	ColumnPtr GetColumnKernel(Operator::Type type, bool binary, Value::Type operand_type);
+
+	/*
+	Structure-of-arrays evaluation of a compiled program.
+	Variables are bound to input arrays (one value per entity), the result is converted
+	to the output type like in Parser::Evaluate. Arithmetic-only programs
+	(integer and float operands) run column by column over blocks of entities:
+	every register becomes a column, bound variables are read directly from the inputs,
+	and kernels are fixed length loops the compiler can vectorize (the last partial block
+	is copied to the padded own storage, so inputs are never read out of bounds).
+	Other programs run the scalar program for every entity with bound variables copied in,
+	so after execution variables hold the values of the last entity.
+	Unbound variables keep their current values for all entities.
+	*/
+	class Batch {
+	public:
+		static const size_t kBlockSize = 256; //!< number of entities processed by every column kernel call
+
+		Batch();
+		~Batch();
+
+		void Bind(const VariableInfo * info, const void * data);
+		void Unbind(const VariableInfo * info);
+		void Reset(); //!< drops columns layout of the current program (bindings are kept)
+
+		bool Execute(Program& program, size_t count, Value::Type output_type, void * output, String& error);
+
+		bool vectorized() const { return vectorized_; }
+
+	private:
+		// Don't allow to copy
+		Batch(const Batch&);
+		void operator =(const Batch&);
+
+		struct Binding {
+			const VariableInfo * info;	//!< registered variable
+			const void * data;			//!< input array
+		};
+
+		void Prepare(const Program& program);
+		void * Block(int reg) const;
+		const void * FindBinding(const VariableInfo * info) const;
+		void ExecuteColumns(Program& program, size_t count, Value::Type output_type, void * output);
+		void ExecuteScalar(Program& program, size_t count, Value::Type output_type, void * output);
+
+		std::vector<Binding> bindings_;
+		std::vector<void*> columns_;			//!< current column of every register
+		std::vector<const void*> inputs_;		//!< bound input array of every register (nullptr if not bound)
+		std::unique_ptr<char[]> storage_;		//!< blocks for temporary and broadcast columns
+		bool prepared_;
+		bool vectorized_;
+	};
+
+} // namespace console_script
+
+#endif
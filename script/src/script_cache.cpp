@@ -0,0 +1,148 @@
+#include "script_cache.h"
+
+#include <assert.h>
+
+namespace console_script {
+
+	ProgramCache::ProgramCache(size_t capacity) :
+		capacity_(capacity), hits_(0), misses_(0)
+	{
+	}
+	ProgramCache::~ProgramCache()
+	{
+	}
+	std::shared_ptr<Program> ProgramCache::Find(const String& str, size_t version)
+	{
+		auto it = map_.find(str);
+		if (it == map_.end())
+		{
+			++misses_;
+			return nullptr;
+		}
+		EntryList::iterator entry = it->second;
+		if (entry->version != version) // symbols have been changed
+		{
+			entries_.erase(entry);
+			map_.erase(it);
+			++misses_;
+			return nullptr;
+		}
+		// Move to front
+		entries_.splice(entries_.begin(), entries_, entry);
+		++hits_;
+		return entry->program;
+	}
+	std::shared_ptr<Program> ProgramCache::Insert(const String& str, size_t version)
+	{
+		assert(capacity_ > 0);
+		Erase(str);
+		Shrink(capacity_ - 1);
+		entries_.emplace_front();
+		Entry& entry = entries_.front();
+		entry.str = str;
+		entry.version = version;
+		entry.program.reset(new Program());
+#ifdef PARSER_PROFILE
+		entry.program->set_source(str);
+#endif
+		map_[str] = entries_.begin();
+		return entry.program;
+	}
+	void ProgramCache::Erase(const String& str)
+	{
+		auto it = map_.find(str);
+		if (it != map_.end())
+		{
+			entries_.erase(it->second);
+			map_.erase(it);
+		}
+	}
+	void ProgramCache::Clear()
+	{
+		entries_.clear();
+		map_.clear();
+	}
+	void ProgramCache::Save(std::vector<unsigned char>& image) const
+	{
+		ImageWriter writer(image);
+		writer.WriteUint(kImageMagic);
+		writer.WriteUint(kImageVersion);
+		writer.WriteByte(static_cast<unsigned char>(sizeof(Float)));
+		writer.WriteByte(static_cast<unsigned char>(sizeof(CS_CHAR)));
+		writer.WriteUint(static_cast<uint32_t>(entries_.size()));
+		// Loading inserts to the front, so recency order is kept
+		for (auto it = entries_.rbegin(); it != entries_.rend(); ++it)
+		{
+			writer.WriteString(it->str);
+			size_t size_position = writer.position();
+			writer.WriteUint(0); // record size
+			it->program->Save(writer);
+			writer.PatchUint(size_position, static_cast<uint32_t>(writer.position() - size_position - 4));
+		}
+	}
+	bool ProgramCache::Load(const void * image, size_t size, const Base& base, String& error)
+	{
+		ImageReader reader(image, size);
+		uint32_t magic, version, count;
+		unsigned char float_size, char_size;
+		if (!reader.ReadUint(magic) || !reader.ReadUint(version) ||
+			!reader.ReadByte(float_size) || !reader.ReadByte(char_size) || !reader.ReadUint(count) ||
+			magic != kImageMagic)
+		{
+			error = CS_TEXT("not a program image");
+			return false;
+		}
+		if (version != kImageVersion || float_size != sizeof(Float) || char_size != sizeof(CS_CHAR))
+		{
+			error = CS_TEXT("program image version mismatch");
+			return false;
+		}
+		if (capacity_ < entries_.size() + count)
+			capacity_ = entries_.size() + count;
+		const size_t version_now = base.version();
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			String str;
+			uint32_t record_size;
+			ImageReader record(nullptr, 0);
+			if (!reader.ReadString(str) || !reader.ReadUint(record_size) || !reader.ReadBlock(record_size, record))
+			{
+				error = CS_TEXT("corrupted program image");
+				return false;
+			}
+			String load_error;
+			if (!Insert(str, version_now)->Load(record, base, load_error))
+				Erase(str);
+		}
+		return true;
+	}
+#ifdef PARSER_PROFILE
+	void ProgramCache::GetStats(std::vector<ProgramStats>& stats) const
+	{
+		for (auto it = entries_.begin(); it != entries_.end(); ++it)
+		{
+			stats.emplace_back();
+			it->program->GetStats(stats.back());
+		}
+	}
+	void ProgramCache::ResetProfile()
+	{
+		for (auto it = entries_.begin(); it != entries_.end(); ++it)
+			it->program->ResetProfile();
+	}
+#endif
+	void ProgramCache::set_capacity(size_t capacity)
+	{
+		capacity_ = capacity;
+		Shrink(capacity_);
+	}
+	void ProgramCache::Shrink(size_t size)
+	{
+		while (entries_.size() > size)
+		{
+			map_.erase(entries_.back().str);
+			entries_.pop_back();
+		}
+	}
+
+} // namespace console_script
@@ -0,0 +1,77 @@
+#pragma once
+#ifndef __CONSOLE_SCRIPT_CACHE_H__
+#define __CONSOLE_SCRIPT_CACHE_H__
+
+#include "script_program.h"
+
+#include <list>
+#include <unordered_map>
+#include <memory> // for shared_ptr
+
+namespace console_script {
+
+	/*
+	Bounded LRU cache of compiled programs keyed by the source text.
+	Programs don't reference the tree, so a cached one may be executed without
+	lexing and tree building. Every entry remembers the registry version it was
+	compiled with and is dropped on lookup if symbols have been changed since.
+	Programs are shared, so the one in use stays alive when the cache drops it.
+	Cache may be saved to the binary image and loaded back (to skip compilation at startup):
+	image has a versioned header and a record per program, every record keeps the source
+	text and the program with symbols referenced by name.
+	*/
+	class ProgramCache {
+		struct Entry {
+			String str;
+			size_t version;		//!< registry version at compile time
+			std::shared_ptr<Program> program;
+		};
+		typedef std::list<Entry> EntryList; // most recently used first
+		typedef std::unordered_map<String, EntryList::iterator> EntryMap;
+
+	public:
+		explicit ProgramCache(size_t capacity = 0);
+		~ProgramCache();
+
+		//! Returns cached program (nullptr on miss)
+		std::shared_ptr<Program> Find(const String& str, size_t version);
+		//! Creates an empty entry to build program into, evicting the least recently used one
+		std::shared_ptr<Program> Insert(const String& str, size_t version);
+		void Erase(const String& str);
+		void Clear();
+
+		//! Writes all entries to the image (the least recently used first)
+		void Save(std::vector<unsigned char>& image) const;
+		//! Adds entries of the image relinked against the registry, grows capacity to fit them.
+		//! Programs with missing or changed symbols are skipped (they'll be compiled on use).
+		bool Load(const void * image, size_t size, const Base& base, String& error);
+
+#ifdef PARSER_PROFILE
+		//! Appends statistics of every cached program
+		void GetStats(std::vector<ProgramStats>& stats) const;
+		void ResetProfile();
+#endif
+
+		void set_capacity(size_t capacity);
+		size_t capacity() const { return capacity_; }
+		size_t size() const { return entries_.size(); }
+		size_t hits() const { return hits_; }
+		size_t misses() const { return misses_; }
+
+	private:
+		// Don't allow to copy
+		ProgramCache(const ProgramCache&);
+		void operator =(const ProgramCache&);
+
+		void Shrink(size_t size);
+
+		EntryList entries_;
+		EntryMap map_;
+		size_t capacity_;	//!< maximum number of entries (0 disables cache)
+		size_t hits_;
+		size_t misses_;
+	};
+
+} // namespace console_script
+
+#endif
@@ -3,20 +3,20 @@
 namespace console_script {
 
 #define TWO_FUNC_PARAMS \
-	std::list<Node*>::const_iterator it = list.begin(); \
+	NodeList::const_iterator it = list.begin(); \
 	const Value& first = (*it)->data(); \
 	const Value& second = (*++it)->data();
 #define ASSIGNMENT_PARAMS \
-	std::list<Node*>::const_iterator it = list.begin(); \
+	NodeList::const_iterator it = list.begin(); \
 	Value& first = (*it)->data(); \
 	const Value& second = (*++it)->data();
 #define ONE_PARAM_FUNC \
-	std::list<Node*>::const_iterator it = list.begin(); \
+	NodeList::const_iterator it = list.begin(); \
 	const Value& first = (*it)->data();
 
-	void FuncAddition(const std::list<Node*>& list, Value* value)
+	void FuncAddition(const NodeList& list, Value* value)
 	{
-		std::list<Node*>::const_iterator it = list.begin();
+		NodeList::const_iterator it = list.begin();
 		const Value& first = (*it)->data();
 		if ((*it)->parent()->IsOperatorBinary())
 		{
@@ -41,9 +41,9 @@ namespace console_script {
 			*value = first;
 		}
 	}
-	void FuncSubtraction(const std::list<Node*>& list, Value* value)
+	void FuncSubtraction(const NodeList& list, Value* value)
 	{
-		std::list<Node*>::const_iterator it = list.begin();
+		NodeList::const_iterator it = list.begin();
 		const Value& first = (*it)->data();
 		if ((*it)->parent()->IsOperatorBinary())
 		{
@@ -75,7 +75,7 @@ namespace console_script {
 			}
 		}
 	}
-	void FuncMultiplication(const std::list<Node*>& list, Value* value)
+	void FuncMultiplication(const NodeList& list, Value* value)
 	{
 		TWO_FUNC_PARAMS;
 		switch (value->type())
@@ -90,7 +90,7 @@ namespace console_script {
 			break;
 		}
 	}
-	void FuncDivision(const std::list<Node*>& list, Value* value)
+	void FuncDivision(const NodeList& list, Value* value)
 	{
 		TWO_FUNC_PARAMS;
 		switch (value->type())
@@ -105,41 +105,44 @@ namespace console_script {
 			break;
 		}
 	}
-	void FuncModulus(const std::list<Node*>& list, Value* value)
+	void FuncModulus(const NodeList& list, Value* value)
 	{
 		TWO_FUNC_PARAMS;
 		*value = first.AsInteger() % second.AsInteger();
 	}
-	void FuncBitwiseAnd(const std::list<Node*>& list, Value* value)
+	void FuncBitwiseAnd(const NodeList& list, Value* value)
 	{
 		TWO_FUNC_PARAMS;
 		*value = first.AsInteger() & second.AsInteger();
 	}
-	void FuncBitwiseInclusiveOr(const std::list<Node*>& list, Value* value)
+	void FuncBitwiseInclusiveOr(const NodeList& list, Value* value)
 	{
 		TWO_FUNC_PARAMS;
 		*value = first.AsInteger() | second.AsInteger();
 	}
-	void FuncBitwiseExclusiveOr(const std::list<Node*>& list, Value* value)
+	void FuncBitwiseExclusiveOr(const NodeList& list, Value* value)
 	{
 		TWO_FUNC_PARAMS;
 		*value = first.AsInteger() ^ second.AsInteger();
 	}
-	void FuncLogicalAnd(const std::list<Node*>& list, Value* value)
+	void FuncLogicalAnd(const NodeList& list, Value* value)
 	{
 		TWO_FUNC_PARAMS;
 		*value = first.AsBool() && second.AsBool();
 	}
-	void FuncLogicalOr(const std::list<Node*>& list, Value* value)
+	void FuncLogicalOr(const NodeList& list, Value* value)
 	{
 		TWO_FUNC_PARAMS;
 		*value = first.AsBool() || second.AsBool();
 	}
-	void FuncEquality(const std::list<Node*>& list, Value* value)
+	void FuncEquality(const NodeList& list, Value* value)
 	{
 		TWO_FUNC_PARAMS;
 		switch (first.type())
 		{
+		case Value::kBoolean:
+			*value = first.AsBool() == second.AsBool();
+			break;
 		case Value::kInteger:
 			*value = first.AsInteger() == second.AsInteger();
 			break;
@@ -153,11 +156,14 @@ namespace console_script {
 			break;
 		}
 	}
-	void FuncNotEqual(const std::list<Node*>& list, Value* value)
+	void FuncNotEqual(const NodeList& list, Value* value)
 	{
 		TWO_FUNC_PARAMS;
 		switch (first.type())
 		{
+		case Value::kBoolean:
+			*value = first.AsBool() != second.AsBool();
+			break;
 		case Value::kInteger:
 			*value = first.AsInteger() != second.AsInteger();
 			break;
@@ -171,11 +177,14 @@ namespace console_script {
 			break;
 		}
 	}
-	void FuncLessThan(const std::list<Node*>& list, Value* value)
+	void FuncLessThan(const NodeList& list, Value* value)
 	{
 		TWO_FUNC_PARAMS;
 		switch (first.type())
 		{
+		case Value::kBoolean:
+			*value = first.AsBool() < second.AsBool();
+			break;
 		case Value::kInteger:
 			*value = first.AsInteger() < second.AsInteger();
 			break;
@@ -189,11 +198,14 @@ namespace console_script {
 			break;
 		}
 	}
-	void FuncLessThanOrEqual(const std::list<Node*>& list, Value* value)
+	void FuncLessThanOrEqual(const NodeList& list, Value* value)
 	{
 		TWO_FUNC_PARAMS;
 		switch (first.type())
 		{
+		case Value::kBoolean:
+			*value = first.AsBool() <= second.AsBool();
+			break;
 		case Value::kInteger:
 			*value = first.AsInteger() <= second.AsInteger();
 			break;
@@ -207,11 +219,14 @@ namespace console_script {
 			break;
 		}
 	}
-	void FuncGreaterThan(const std::list<Node*>& list, Value* value)
+	void FuncGreaterThan(const NodeList& list, Value* value)
 	{
 		TWO_FUNC_PARAMS;
 		switch (first.type())
 		{
+		case Value::kBoolean:
+			*value = first.AsBool() > second.AsBool();
+			break;
 		case Value::kInteger:
 			*value = first.AsInteger() > second.AsInteger();
 			break;
@@ -225,11 +240,14 @@ namespace console_script {
 			break;
 		}
 	}
-	void FuncGreaterThanOrEqual(const std::list<Node*>& list, Value* value)
+	void FuncGreaterThanOrEqual(const NodeList& list, Value* value)
 	{
 		TWO_FUNC_PARAMS;
 		switch (first.type())
 		{
+		case Value::kBoolean:
+			*value = first.AsBool() >= second.AsBool();
+			break;
 		case Value::kInteger:
 			*value = first.AsInteger() >= second.AsInteger();
 			break;
@@ -243,125 +261,125 @@ namespace console_script {
 			break;
 		}
 	}
-	void FuncLeftShift(const std::list<Node*>& list, Value* value)
+	void FuncLeftShift(const NodeList& list, Value* value)
 	{
 		TWO_FUNC_PARAMS;
 		*value = first.AsInteger() << second.AsInteger();
 	}
-	void FuncRightShift(const std::list<Node*>& list, Value* value)
+	void FuncRightShift(const NodeList& list, Value* value)
 	{
 		TWO_FUNC_PARAMS;
 		*value = first.AsInteger() >> second.AsInteger();
 	}
-	void FuncLogicalNegation(const std::list<Node*>& list, Value* value)
+	void FuncLogicalNegation(const NodeList& list, Value* value)
 	{
 		ONE_PARAM_FUNC;
 		*value = ! first.AsBool();
 	}
-	void FuncOnesComplement(const std::list<Node*>& list, Value* value)
+	void FuncOnesComplement(const NodeList& list, Value* value)
 	{
 		ONE_PARAM_FUNC;
 		*value = ~ first.AsInteger();
 	}
-	void FuncIncrement(const std::list<Node*>& list, Value* value)
+	void FuncIncrement(const NodeList& list, Value* value)
 	{
-		std::list<Node*>::const_iterator it = list.begin();
+		NodeList::const_iterator it = list.begin();
 		Value& first = (*it)->data();
 		if ((*it)->parent()->IsOperatorFormPrefix())
 			*value = ++first;
 		else
 			*value = first++;
 	}
-	void FuncDecrement(const std::list<Node*>& list, Value* value)
+	void FuncDecrement(const NodeList& list, Value* value)
 	{
-		std::list<Node*>::const_iterator it = list.begin();
+		NodeList::const_iterator it = list.begin();
 		Value& first = (*it)->data();
 		if ((*it)->parent()->IsOperatorFormPrefix())
 			*value = --first;
 		else
 			*value = first--;
 	}
-	void FuncCastBoolean(const std::list<Node*>& list, Value* value)
+	void FuncCastBoolean(const NodeList& list, Value* value)
 	{
 		ONE_PARAM_FUNC;
 		*value = first.AsBool();
 	}
-	void FuncCastInteger(const std::list<Node*>& list, Value* value)
+	void FuncCastInteger(const NodeList& list, Value* value)
 	{
 		ONE_PARAM_FUNC;
 		*value = first.AsInteger();
 	}
-	void FuncCastFloat(const std::list<Node*>& list, Value* value)
+	void FuncCastFloat(const NodeList& list, Value* value)
 	{
 		ONE_PARAM_FUNC;
 		*value = first.AsFloat();
 	}
-	void FuncCastString(const std::list<Node*>& list, Value* value)
+	void FuncCastString(const NodeList& list, Value* value)
 	{
 		ONE_PARAM_FUNC;
 		*value = first.AsString();
 	}
-	void FuncAssignment(const std::list<Node*>& list, Value* value)
+	void FuncAssignment(const NodeList& list, Value* value)
 	{
 		ASSIGNMENT_PARAMS;
 		first = second;
 		*value = first;
 	}
-	void FuncAdditionAssignment(const std::list<Node*>& list, Value* value)
+	void FuncAdditionAssignment(const NodeList& list, Value* value)
 	{
 		ASSIGNMENT_PARAMS;
 		first += second;
 		*value = first;
 	}
-	void FuncSubtractionAssignment(const std::list<Node*>& list, Value* value)
+	void FuncSubtractionAssignment(const NodeList& list, Value* value)
 	{
 		ASSIGNMENT_PARAMS;
 		first -= second;
 		*value = first;
 	}
-	void FuncMultiplicationAssignment(const std::list<Node*>& list, Value* value)
+	void FuncMultiplicationAssignment(const NodeList& list, Value* value)
 	{
 		ASSIGNMENT_PARAMS;
 		first *= second;
 		*value = first;
 	}
-	void FuncDivisionAssignment(const std::list<Node*>& list, Value* value)
+	void FuncDivisionAssignment(const NodeList& list, Value* value)
 	{
 		ASSIGNMENT_PARAMS;
 		first /= second;
 		*value = first;
 	}
-	void FuncModulusAssignment(const std::list<Node*>& list, Value* value)
+	void FuncModulusAssignment(const NodeList& list, Value* value)
 	{
 		ASSIGNMENT_PARAMS;
 		first %= second;
 		*value = first;
 	}
-	void FuncBitwiseInclusiveOrAssignment(const std::list<Node*>& list, Value* value)
+	void FuncBitwiseInclusiveOrAssignment(const NodeList& list, Value* value)
 	{
 		ASSIGNMENT_PARAMS;
 		first |= second;
 		*value = first;
 	}
-	void FuncBitwiseExclusiveOrAssignment(const std::list<Node*>& list, Value* value)
+	void FuncBitwiseExclusiveOrAssignment(const NodeList& list, Value* value)
 	{
 		ASSIGNMENT_PARAMS;
 		first ^= second;
 		*value = first;
 	}
-	void FuncBitwiseAndAssignment(const std::list<Node*>& list, Value* value)
+	void FuncBitwiseAndAssignment(const NodeList& list, Value* value)
 	{
 		ASSIGNMENT_PARAMS;
 		first &= second;
 		*value = first;
 	}
-	void FuncLeftShiftAssignment(const std::list<Node*>& list, Value* value)
+	void FuncLeftShiftAssignment(const NodeList& list, Value* value)
 	{
 		ASSIGNMENT_PARAMS;
 		first <<= second;
 		*value = first;
 	}
-	void FuncRightShiftAssignment(const std::list<Node*>& list, Value* value)
+	void FuncRightShiftAssignment(const NodeList& list, Value* value)
 	{
 		ASSIGNMENT_PARAMS;
 		first >>= second;
@@ -0,0 +1,116 @@
+#include "script_image.h"
+
+#include <cstring>
+
+namespace console_script {
+
+	// Floats are stored as integer of the same size
+#ifndef PARSER_HIGHP_FLOAT
+	typedef uint32_t FloatBits;
+#else
+	typedef uint64_t FloatBits;
+#endif
+	static_assert(sizeof(FloatBits) == sizeof(Float), "float size mismatch");
+
+	void ImageWriter::WriteUint(uint32_t value)
+	{
+		for (int i = 0; i < 4; ++i)
+			buffer_.push_back(static_cast<unsigned char>(value >> (8 * i)));
+	}
+	void ImageWriter::WriteFloat(Float value)
+	{
+		FloatBits bits;
+		memcpy(&bits, &value, sizeof(bits));
+		for (size_t i = 0; i < sizeof(bits); ++i)
+			buffer_.push_back(static_cast<unsigned char>(bits >> (8 * i)));
+	}
+	void ImageWriter::WriteString(const String& str)
+	{
+		WriteUint(static_cast<uint32_t>(str.size()));
+		for (String::const_iterator it = str.begin(); it != str.end(); ++it)
+		{
+			uint32_t c = static_cast<uint32_t>(*it);
+			for (size_t i = 0; i < sizeof(CS_CHAR); ++i)
+				buffer_.push_back(static_cast<unsigned char>(c >> (8 * i)));
+		}
+	}
+	void ImageWriter::PatchUint(size_t position, uint32_t value)
+	{
+		for (int i = 0; i < 4; ++i)
+			buffer_[position + i] = static_cast<unsigned char>(value >> (8 * i));
+	}
+
+	ImageReader::ImageReader(const void * data, size_t size) :
+		data_(static_cast<const unsigned char*>(data)),
+		end_(static_cast<const unsigned char*>(data) + size),
+		failed_(false)
+	{
+	}
+	bool ImageReader::Require(size_t size)
+	{
+		if (failed_ || remaining() < size)
+			failed_ = true;
+		return !failed_;
+	}
+	bool ImageReader::ReadByte(unsigned char& value)
+	{
+		if (!Require(1))
+			return false;
+		value = *data_++;
+		return true;
+	}
+	bool ImageReader::ReadUint(uint32_t& value)
+	{
+		if (!Require(4))
+			return false;
+		value = 0;
+		for (int i = 0; i < 4; ++i)
+			value |= static_cast<uint32_t>(data_[i]) << (8 * i);
+		data_ += 4;
+		return true;
+	}
+	bool ImageReader::ReadInt(int& value)
+	{
+		uint32_t bits;
+		if (!ReadUint(bits))
+			return false;
+		value = static_cast<int>(bits);
+		return true;
+	}
+	bool ImageReader::ReadFloat(Float& value)
+	{
+		if (!Require(sizeof(FloatBits)))
+			return false;
+		FloatBits bits = 0;
+		for (size_t i = 0; i < sizeof(bits); ++i)
+			bits |= static_cast<FloatBits>(data_[i]) << (8 * i);
+		data_ += sizeof(bits);
+		memcpy(&value, &bits, sizeof(value));
+		return true;
+	}
+	bool ImageReader::ReadString(String& str)
+	{
+		uint32_t length;
+		if (!ReadUint(length) || !Require(static_cast<size_t>(length) * sizeof(CS_CHAR)))
+			return false;
+		str.resize(length);
+		for (uint32_t n = 0; n < length; ++n)
+		{
+			uint32_t c = 0;
+			for (size_t i = 0; i < sizeof(CS_CHAR); ++i)
+				c |= static_cast<uint32_t>(data_[i]) << (8 * i);
+			data_ += sizeof(CS_CHAR);
+			str[n] = static_cast<CS_CHAR>(c);
+		}
+		return true;
+	}
+	bool ImageReader::ReadBlock(size_t size, ImageReader& block)
+	{
+		if (!Require(size))
+			return false;
+		block = ImageReader(data_, size);
+		data_ += size;
+		return true;
+	}
+
+} // namespace console_script
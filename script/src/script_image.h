@@ -0,0 +1,72 @@
+#pragma once
+#ifndef __CONSOLE_SCRIPT_IMAGE_H__
+#define __CONSOLE_SCRIPT_IMAGE_H__
+
+#include "script_defines.h"
+
+#include <vector>
+#include <cstdint>
+
+namespace console_script {
+
+	const uint32_t kImageMagic = 0x49505343;	// "CSPI" in little endian
+	const uint32_t kImageVersion = 1;			// should be increased on any format change
+
+	/*
+	Writer of the precompiled programs image.
+	Numbers are stored in little endian with fixed width, strings as length and characters,
+	so the image has no alignment requirements and may be loaded straight from the mapped file.
+	*/
+	class ImageWriter {
+	public:
+		explicit ImageWriter(std::vector<unsigned char>& buffer) : buffer_(buffer) {}
+
+		void WriteByte(unsigned char value) { buffer_.push_back(value); }
+		void WriteUint(uint32_t value);
+		void WriteInt(int value) { WriteUint(static_cast<uint32_t>(value)); }
+		void WriteFloat(Float value);
+		void WriteString(const String& str);
+
+		size_t position() const { return buffer_.size(); }
+		//! Overwrites previously written value (like size of the record)
+		void PatchUint(size_t position, uint32_t value);
+
+	private:
+		// Don't allow to copy
+		ImageWriter(const ImageWriter&);
+		void operator =(const ImageWriter&);
+
+		std::vector<unsigned char>& buffer_;
+	};
+
+	/*
+	Reader of the precompiled programs image with bounds checking.
+	Every read fails once the end of the data is reached, and failure is sticky,
+	so a sequence of reads may be checked once.
+	*/
+	class ImageReader {
+	public:
+		ImageReader(const void * data, size_t size);
+
+		bool ReadByte(unsigned char& value);
+		bool ReadUint(uint32_t& value);
+		bool ReadInt(int& value);
+		bool ReadFloat(Float& value);
+		bool ReadString(String& str);
+		//! Makes reader of the next size bytes and skips them
+		bool ReadBlock(size_t size, ImageReader& block);
+
+		bool failed() const { return failed_; }
+		size_t remaining() const { return static_cast<size_t>(end_ - data_); }
+
+	private:
+		bool Require(size_t size);
+
+		const unsigned char * data_;
+		const unsigned char * end_;
+		bool failed_;
+	};
+
+} // namespace console_script
+
+#endif
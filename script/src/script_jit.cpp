@@ -0,0 +1,472 @@
+#include "script_jit.h"
+#include "script_program.h"
+
+#include <cstring>
+#include <assert.h>
+
+#ifdef PARSER_JIT_SUPPORTED
+#include <sys/mman.h>
+#endif
+
+namespace console_script {
+
+#ifdef PARSER_JIT_SUPPORTED
+
+	/*
+	Minimal x86-64 assembler for the instruction emitters.
+	Operands are loaded to eax/ecx (xmm0/xmm1 for floats) thru r11 holding the absolute address,
+	result is always left in eax (al for booleans) or xmm0.
+	Only caller-saved registers are used and there are no calls, so the code needs no prologue.
+	*/
+	class JitAssembler {
+	public:
+		enum Operation {
+			kAdd, kSub, kMul, kDiv, kMod, kAnd, kOr, kXor, kShl, kShr,
+			kEqual, kNotEqual, kLess, kLessEqual, kGreater, kGreaterEqual,
+			kAssign
+		};
+
+		static bool IsComparison(Operation op) { return op >= kEqual && op <= kGreaterEqual; }
+
+		JitAssembler() : address_(nullptr) {}
+
+		const std::vector<unsigned char>& code() const { return code_; }
+
+		void Bytes(std::initializer_list<unsigned char> bytes)
+		{
+			code_.insert(code_.end(), bytes.begin(), bytes.end());
+		}
+		void Return()
+		{
+			Bytes({ 0xC3 }); // ret
+		}
+
+		// Loads data to the register (0 is eax or xmm0, 1 is ecx or xmm1)
+		void Load(int reg, const bool * data)
+		{
+			Address(data);
+			Bytes({ 0x41, 0x0F, 0xB6, ModRM(reg) }); // movzx r32, byte [r11]
+		}
+		void Load(int reg, const int * data)
+		{
+			Address(data);
+			Bytes({ 0x41, 0x8B, ModRM(reg) }); // mov r32, [r11]
+		}
+		void Load(int reg, const Float * data)
+		{
+			Address(data);
+			Bytes({ kFloatPrefix, 0x41, 0x0F, 0x10, ModRM(reg) }); // movss/movsd xmm, [r11]
+		}
+		// Stores the register (0 is al, eax or xmm0, 1 is cl, ecx or xmm1) to data
+		void Store(int reg, bool * data)
+		{
+			Address(data);
+			Bytes({ 0x41, 0x88, ModRM(reg) }); // mov [r11], r8
+		}
+		void Store(int reg, int * data)
+		{
+			Address(data);
+			Bytes({ 0x41, 0x89, ModRM(reg) }); // mov [r11], r32
+		}
+		void Store(int reg, Float * data)
+		{
+			Address(data);
+			Bytes({ kFloatPrefix, 0x41, 0x0F, 0x11, ModRM(reg) }); // movss/movsd [r11], xmm
+		}
+
+		// Computes operation of the first and the second registers, the result is in the first one
+		template <typename T>
+		void Compute(Operation op);
+
+		void Convert(Value::Type to, Value::Type from);
+		void Negate(const Float * source, Float * destination);
+
+	private:
+		static const unsigned char kFloatPrefix = (sizeof(Float) == 4) ? 0xF3 : 0xF2;
+
+		static unsigned char ModRM(int reg)
+		{
+			return static_cast<unsigned char>(0x03 | (reg << 3)); // [r11] addressing
+		}
+		void Address(const void * address)
+		{
+			// Straight-line code, so r11 still holds the last loaded address
+			if (address == address_)
+				return;
+			address_ = address;
+			Bytes({ 0x49, 0xBB }); // movabs r11, imm64
+			unsigned long long value = reinterpret_cast<unsigned long long>(address);
+			for (int i = 0; i < 8; ++i)
+				code_.push_back(static_cast<unsigned char>(value >> (8 * i)));
+		}
+		void Compare(Operation op);
+
+		std::vector<unsigned char> code_;
+		const void * address_; //!< current value of r11
+	};
+
+	void JitAssembler::Compare(Operation op)
+	{
+		// Flags are set by cmp or ucomis, setcc al
+		switch (op)
+		{
+		case kEqual:		Bytes({ 0x0F, 0x94, 0xC0 }); break; // sete
+		case kNotEqual:		Bytes({ 0x0F, 0x95, 0xC0 }); break; // setne
+		case kLess:			Bytes({ 0x0F, 0x9C, 0xC0 }); break; // setl
+		case kLessEqual:	Bytes({ 0x0F, 0x9E, 0xC0 }); break; // setle
+		case kGreater:		Bytes({ 0x0F, 0x9F, 0xC0 }); break; // setg
+		case kGreaterEqual:	Bytes({ 0x0F, 0x9D, 0xC0 }); break; // setge
+		default: assert(false);
+		}
+	}
+	template <>
+	void JitAssembler::Compute<int>(Operation op)
+	{
+		switch (op)
+		{
+		case kAdd: Bytes({ 0x01, 0xC8 }); break; // add eax, ecx
+		case kSub: Bytes({ 0x29, 0xC8 }); break; // sub eax, ecx
+		case kMul: Bytes({ 0x0F, 0xAF, 0xC1 }); break; // imul eax, ecx
+		case kDiv: Bytes({ 0x99, 0xF7, 0xF9 }); break; // cdq, idiv ecx
+		case kMod: Bytes({ 0x99, 0xF7, 0xF9, 0x89, 0xD0 }); break; // cdq, idiv ecx, mov eax, edx
+		case kAnd: Bytes({ 0x21, 0xC8 }); break; // and eax, ecx
+		case kOr:  Bytes({ 0x09, 0xC8 }); break; // or eax, ecx
+		case kXor: Bytes({ 0x31, 0xC8 }); break; // xor eax, ecx
+		case kShl: Bytes({ 0xD3, 0xE0 }); break; // shl eax, cl
+		case kShr: Bytes({ 0xD3, 0xF8 }); break; // sar eax, cl
+		default:
+			assert(IsComparison(op));
+			Bytes({ 0x39, 0xC8 }); // cmp eax, ecx
+			Compare(op);
+			break;
+		}
+	}
+	template <>
+	void JitAssembler::Compute<bool>(Operation op)
+	{
+		// Booleans are loaded as 0 or 1, so integer operations give the same results
+		Compute<int>(op);
+	}
+	template <>
+	void JitAssembler::Compute<Float>(Operation op)
+	{
+		const bool is_double = (sizeof(Float) == 8);
+		switch (op)
+		{
+		case kAdd: Bytes({ kFloatPrefix, 0x0F, 0x58, 0xC1 }); break; // addss/addsd xmm0, xmm1
+		case kSub: Bytes({ kFloatPrefix, 0x0F, 0x5C, 0xC1 }); break; // subss/subsd xmm0, xmm1
+		case kMul: Bytes({ kFloatPrefix, 0x0F, 0x59, 0xC1 }); break; // mulss/mulsd xmm0, xmm1
+		case kDiv: Bytes({ kFloatPrefix, 0x0F, 0x5E, 0xC1 }); break; // divss/divsd xmm0, xmm1
+		default:
+			{
+				assert(IsComparison(op));
+				// Unordered comparison sets ZF, PF and CF, so NaN operands give false like in C++
+				// (less is computed as greater with swapped operands)
+				const bool swap = (op == kLess || op == kLessEqual);
+				if (is_double)
+					Bytes({ 0x66 });
+				Bytes({ 0x0F, 0x2E, static_cast<unsigned char>(swap ? 0xC8 : 0xC1) }); // ucomiss/ucomisd
+				switch (op)
+				{
+				case kEqual:		Bytes({ 0x0F, 0x94, 0xC0, 0x0F, 0x9B, 0xC1, 0x20, 0xC8 }); break; // sete al, setnp cl, and al, cl
+				case kNotEqual:		Bytes({ 0x0F, 0x95, 0xC0, 0x0F, 0x9A, 0xC1, 0x08, 0xC8 }); break; // setne al, setp cl, or al, cl
+				case kLess:
+				case kGreater:		Bytes({ 0x0F, 0x97, 0xC0 }); break; // seta al
+				case kLessEqual:
+				case kGreaterEqual:	Bytes({ 0x0F, 0x93, 0xC0 }); break; // setae al
+				default: break;
+				}
+			}
+			break;
+		}
+	}
+	void JitAssembler::Convert(Value::Type to, Value::Type from)
+	{
+		// Value is in eax (booleans are 0 or 1) or xmm0, conversions match Value::As* ones
+		if (to == from)
+			return;
+		switch (to)
+		{
+		case Value::kBoolean:
+			if (from == Value::kFloat)
+				Bytes({ kFloatPrefix, 0x0F, 0x2C, 0xC0 }); // cvttss2si/cvttsd2si eax, xmm0
+			Bytes({ 0x85, 0xC0, 0x0F, 0x95, 0xC0 }); // test eax, eax, setne al
+			break;
+		case Value::kInteger:
+			if (from == Value::kFloat)
+				Bytes({ kFloatPrefix, 0x0F, 0x2C, 0xC0 }); // cvttss2si/cvttsd2si eax, xmm0
+			break;
+		case Value::kFloat:
+			Bytes({ kFloatPrefix, 0x0F, 0x2A, 0xC0 }); // cvtsi2ss/cvtsi2sd xmm0, eax
+			break;
+		default:
+			assert(false);
+			break;
+		}
+	}
+	void JitAssembler::Negate(const Float * source, Float * destination)
+	{
+		// Sign bit is flipped in the integer register, same as the sign mask used by compiler
+		Address(source);
+		if (sizeof(Float) == 4)
+			Bytes({ 0x41, 0x8B, 0x03, 0x35, 0x00, 0x00, 0x00, 0x80 }); // mov eax, [r11], xor eax, 0x80000000
+		else
+			Bytes({ 0x49, 0x8B, 0x03, 0x48, 0x0F, 0xBA, 0xF8, 0x3F }); // mov rax, [r11], btc rax, 63
+		Address(destination);
+		if (sizeof(Float) == 4)
+			Bytes({ 0x41, 0x89, 0x03 }); // mov [r11], eax
+		else
+			Bytes({ 0x49, 0x89, 0x03 }); // mov [r11], rax
+	}
+
+	template <typename T>
+	static T * Data(Value * registers, int reg)
+	{
+		return &registers[reg].get<T>();
+	}
+
+	template <typename T, JitAssembler::Operation op>
+	static void EmitBinary(JitAssembler& assembler, Value* registers, const Instruction& instruction)
+	{
+		assembler.Load(0, Data<T>(registers, instruction.first));
+		assembler.Load(1, Data<T>(registers, instruction.second));
+		assembler.Compute<T>(op);
+		if (JitAssembler::IsComparison(op))
+			assembler.Store(0, Data<bool>(registers, instruction.value));
+		else
+			assembler.Store(0, Data<T>(registers, instruction.value));
+	}
+	template <typename T, JitAssembler::Operation op>
+	static void EmitAssignment(JitAssembler& assembler, Value* registers, const Instruction& instruction)
+	{
+		if (op == JitAssembler::kAssign)
+			assembler.Load(0, Data<T>(registers, instruction.second));
+		else
+		{
+			assembler.Load(0, Data<T>(registers, instruction.first));
+			assembler.Load(1, Data<T>(registers, instruction.second));
+			assembler.Compute<T>(op);
+		}
+		assembler.Store(0, Data<T>(registers, instruction.first));
+		assembler.Store(0, Data<T>(registers, instruction.value));
+	}
+	template <typename T>
+	static void EmitUnaryPlus(JitAssembler& assembler, Value* registers, const Instruction& instruction)
+	{
+		assembler.Load(0, Data<T>(registers, instruction.first));
+		assembler.Store(0, Data<T>(registers, instruction.value));
+	}
+	static void EmitIntegerNegation(JitAssembler& assembler, Value* registers, const Instruction& instruction)
+	{
+		assembler.Load(0, Data<int>(registers, instruction.first));
+		assembler.Bytes({ 0xF7, 0xD8 }); // neg eax
+		assembler.Store(0, Data<int>(registers, instruction.value));
+	}
+	static void EmitFloatNegation(JitAssembler& assembler, Value* registers, const Instruction& instruction)
+	{
+		assembler.Negate(Data<Float>(registers, instruction.first), Data<Float>(registers, instruction.value));
+	}
+	static void EmitLogicalNegation(JitAssembler& assembler, Value* registers, const Instruction& instruction)
+	{
+		assembler.Load(0, Data<bool>(registers, instruction.first));
+		assembler.Bytes({ 0x83, 0xF0, 0x01 }); // xor eax, 1
+		assembler.Store(0, Data<bool>(registers, instruction.value));
+	}
+	static void EmitOnesComplement(JitAssembler& assembler, Value* registers, const Instruction& instruction)
+	{
+		assembler.Load(0, Data<int>(registers, instruction.first));
+		assembler.Bytes({ 0xF7, 0xD0 }); // not eax
+		assembler.Store(0, Data<int>(registers, instruction.value));
+	}
+	template <bool increment, bool prefix>
+	static void EmitIncrement(JitAssembler& assembler, Value* registers, const Instruction& instruction)
+	{
+		assembler.Load(0, Data<int>(registers, instruction.first));
+		assembler.Bytes({ 0x89, 0xC1 }); // mov ecx, eax
+		if (increment)
+			assembler.Bytes({ 0x83, 0xC1, 0x01 }); // add ecx, 1
+		else
+			assembler.Bytes({ 0x83, 0xE9, 0x01 }); // sub ecx, 1
+		assembler.Store(1, Data<int>(registers, instruction.first));
+		assembler.Store(prefix ? 1 : 0, Data<int>(registers, instruction.value));
+	}
+	template <typename R, typename T>
+	static void EmitCast(JitAssembler& assembler, Value* registers, const Instruction& instruction)
+	{
+		Value::Type to, from;
+		ValueTypeSetter<R>::Fill(to);
+		ValueTypeSetter<T>::Fill(from);
+		assembler.Load(0, Data<T>(registers, instruction.first));
+		assembler.Convert(to, from);
+		assembler.Store(0, Data<R>(registers, instruction.value));
+	}
+
+	// Selects emitter instantiation for the operand type (nullptr if operator doesn't support it)
+#define EMITTER_BOOLEAN(emitter, ...) \
+	case Value::kBoolean: return &emitter<bool, ##__VA_ARGS__>;
+#define EMITTER_INTEGER(emitter, ...) \
+	case Value::kInteger: return &emitter<int, ##__VA_ARGS__>;
+#define EMITTER_FLOAT(emitter, ...) \
+	case Value::kFloat: return &emitter<Float, ##__VA_ARGS__>;
+
+#define NUMERIC_EMITTER(emitter, ...) \
+	switch (operand_type) { EMITTER_INTEGER(emitter, ##__VA_ARGS__) EMITTER_FLOAT(emitter, ##__VA_ARGS__) default: return nullptr; }
+#define SCALAR_EMITTER(emitter, ...) \
+	switch (operand_type) { EMITTER_BOOLEAN(emitter, ##__VA_ARGS__) EMITTER_INTEGER(emitter, ##__VA_ARGS__) EMITTER_FLOAT(emitter, ##__VA_ARGS__) default: return nullptr; }
+
+	static EmitterPtr SelectInteger(EmitterPtr emitter, Value::Type type)
+	{
+		return (type == Value::kInteger) ? emitter : nullptr;
+	}
+	static EmitterPtr SelectBoolean(EmitterPtr emitter, Value::Type type)
+	{
+		return (type == Value::kBoolean) ? emitter : nullptr;
+	}
+	template <typename R>
+	static EmitterPtr SelectCast(Value::Type operand_type)
+	{
+		switch (operand_type)
+		{
+		case Value::kBoolean:	return &EmitCast<R, bool>;
+		case Value::kInteger:	return &EmitCast<R, int>;
+		case Value::kFloat:		return &EmitCast<R, Float>;
+		default:				return nullptr; // strings are converted by the interpreter only
+		}
+	}
+
+	EmitterPtr GetJitEmitter(Operator::Type type, bool binary, bool prefix, Value::Type operand_type)
+	{
+		typedef JitAssembler A;
+		switch (type)
+		{
+		// Binary or unary
+		case Operator::kAddition:
+			if (binary)
+				NUMERIC_EMITTER(EmitBinary, A::kAdd)
+			else
+				NUMERIC_EMITTER(EmitUnaryPlus)
+		case Operator::kSubtraction:
+			if (binary)
+				NUMERIC_EMITTER(EmitBinary, A::kSub)
+			else if (operand_type == Value::kInteger)
+				return &EmitIntegerNegation;
+			else if (operand_type == Value::kFloat)
+				return &EmitFloatNegation;
+			else
+				return nullptr;
+		// Binary
+		case Operator::kMultiplication:					NUMERIC_EMITTER(EmitBinary, A::kMul)
+		case Operator::kDivision:						NUMERIC_EMITTER(EmitBinary, A::kDiv)
+		case Operator::kModulus:						return SelectInteger(&EmitBinary<int, A::kMod>, operand_type);
+		case Operator::kBitwiseAnd:						return SelectInteger(&EmitBinary<int, A::kAnd>, operand_type);
+		case Operator::kBitwiseInclusiveOr:				return SelectInteger(&EmitBinary<int, A::kOr>, operand_type);
+		case Operator::kBitwiseExclusiveOr:				return SelectInteger(&EmitBinary<int, A::kXor>, operand_type);
+		case Operator::kLeftShift:						return SelectInteger(&EmitBinary<int, A::kShl>, operand_type);
+		case Operator::kRightShift:						return SelectInteger(&EmitBinary<int, A::kShr>, operand_type);
+		case Operator::kLogicalAnd:						return SelectBoolean(&EmitBinary<bool, A::kAnd>, operand_type);
+		case Operator::kLogicalOr:						return SelectBoolean(&EmitBinary<bool, A::kOr>, operand_type);
+		case Operator::kEquality:						SCALAR_EMITTER(EmitBinary, A::kEqual)
+		case Operator::kNotEqual:						SCALAR_EMITTER(EmitBinary, A::kNotEqual)
+		case Operator::kLessThan:						SCALAR_EMITTER(EmitBinary, A::kLess)
+		case Operator::kGreaterThan:					SCALAR_EMITTER(EmitBinary, A::kGreater)
+		case Operator::kLessThanOrEqual:				SCALAR_EMITTER(EmitBinary, A::kLessEqual)
+		case Operator::kGreaterThanOrEqual:				SCALAR_EMITTER(EmitBinary, A::kGreaterEqual)
+		// Unary
+		case Operator::kLogicalNegation:				return SelectBoolean(&EmitLogicalNegation, operand_type);
+		case Operator::kOnesComplement:					return SelectInteger(&EmitOnesComplement, operand_type);
+		case Operator::kIncrement:						return SelectInteger(prefix ? &EmitIncrement<true, true> : &EmitIncrement<true, false>, operand_type);
+		case Operator::kDecrement:						return SelectInteger(prefix ? &EmitIncrement<false, true> : &EmitIncrement<false, false>, operand_type);
+		case Operator::kCastBoolean:					return SelectCast<bool>(operand_type);
+		case Operator::kCastInteger:					return SelectCast<int>(operand_type);
+		case Operator::kCastFloat:						return SelectCast<Float>(operand_type);
+		// Assignment
+		case Operator::kAssignment:						SCALAR_EMITTER(EmitAssignment, A::kAssign)
+		case Operator::kAdditionAssignment:				NUMERIC_EMITTER(EmitAssignment, A::kAdd)
+		case Operator::kSubtractionAssignment:			NUMERIC_EMITTER(EmitAssignment, A::kSub)
+		case Operator::kMultiplicationAssignment:		NUMERIC_EMITTER(EmitAssignment, A::kMul)
+		case Operator::kDivisionAssignment:				NUMERIC_EMITTER(EmitAssignment, A::kDiv)
+		case Operator::kModulusAssignment:				return SelectInteger(&EmitAssignment<int, A::kMod>, operand_type);
+		case Operator::kBitwiseExclusiveOrAssignment:	return SelectInteger(&EmitAssignment<int, A::kXor>, operand_type);
+		case Operator::kBitwiseInclusiveOrAssignment:	return SelectInteger(&EmitAssignment<int, A::kOr>, operand_type);
+		case Operator::kBitwiseAndAssignment:			return SelectInteger(&EmitAssignment<int, A::kAnd>, operand_type);
+		case Operator::kLeftShiftAssignment:			return SelectInteger(&EmitAssignment<int, A::kShl>, operand_type);
+		case Operator::kRightShiftAssignment:			return SelectInteger(&EmitAssignment<int, A::kShr>, operand_type);
+		default:										return nullptr;
+		}
+	}
+
+#undef SCALAR_EMITTER
+#undef NUMERIC_EMITTER
+#undef EMITTER_FLOAT
+#undef EMITTER_INTEGER
+#undef EMITTER_BOOLEAN
+
+	JitCode::JitCode() :
+		memory_(nullptr), size_(0), function_(nullptr)
+	{
+	}
+	JitCode::~JitCode()
+	{
+		Clear();
+	}
+	bool JitCode::Compile(const std::vector<Instruction>& instructions, Value* registers)
+	{
+		Clear();
+		JitAssembler assembler;
+		for (auto it = instructions.begin(); it != instructions.end(); ++it)
+		{
+			if (it->emit == nullptr)
+				return false;
+			it->emit(assembler, registers, *it);
+		}
+		assembler.Return();
+		// Write code to the writable pages and then make them executable
+		const std::vector<unsigned char>& code = assembler.code();
+		void * memory = mmap(nullptr, code.size(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (memory == MAP_FAILED)
+			return false;
+		memcpy(memory, code.data(), code.size());
+		if (mprotect(memory, code.size(), PROT_READ | PROT_EXEC) != 0)
+		{
+			munmap(memory, code.size());
+			return false;
+		}
+		memory_ = memory;
+		size_ = code.size();
+		function_ = reinterpret_cast<FunctionPtr>(memory);
+		return true;
+	}
+	void JitCode::Clear()
+	{
+		if (memory_)
+			munmap(memory_, size_);
+		memory_ = nullptr;
+		size_ = 0;
+		function_ = nullptr;
+	}
+
+#else // PARSER_JIT_SUPPORTED
+
+	EmitterPtr GetJitEmitter(Operator::Type type, bool binary, bool prefix, Value::Type operand_type)
+	{
+		return nullptr;
+	}
+
+	JitCode::JitCode() :
+		memory_(nullptr), size_(0), function_(nullptr)
+	{
+	}
+	JitCode::~JitCode()
+	{
+	}
+	bool JitCode::Compile(const std::vector<Instruction>& instructions, Value* registers)
+	{
+		return false;
+	}
+	void JitCode::Clear()
+	{
+	}
+
+#endif // PARSER_JIT_SUPPORTED
+
+} // namespace console_script
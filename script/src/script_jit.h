@@ -0,0 +1,54 @@
+#pragma once
+#ifndef __CONSOLE_SCRIPT_JIT_H__
+#define __CONSOLE_SCRIPT_JIT_H__
+
+#include "script_kernels.h"
+
+#include <vector>
+
+// Native code is generated on x86-64 unix systems only, define PARSER_NO_JIT to disable it
+#if !defined(PARSER_NO_JIT) && defined(__x86_64__) && defined(__unix__)
+#define PARSER_JIT_SUPPORTED
+#endif
+
+namespace console_script {
+
+	// Returns native code emitter for the operator (nullptr if operation can't be compiled)
+	EmitterPtr GetJitEmitter(Operator::Type type, bool binary, bool prefix, Value::Type operand_type);
+
+	/*
+	Native x86-64 code of a whole program.
+	Every instruction is translated to loads of its operands from the register data,
+	the operation itself and stores of the result, so there is no kernel dispatch at all.
+	Register and variable addresses are embedded into the code, so it stays valid
+	only while the program registers aren't rebuilt.
+	*/
+	class JitCode {
+	public:
+		JitCode();
+		~JitCode();
+
+		//! Compiles instructions, every one of them should have an emitter
+		bool Compile(const std::vector<Instruction>& instructions, Value* registers);
+		void Clear();
+
+		void Execute() const { function_(); }
+
+		bool compiled() const { return function_ != nullptr; }
+		size_t size() const { return size_; } //!< size of the code in bytes
+
+	private:
+		// Don't allow to copy
+		JitCode(const JitCode&);
+		void operator =(const JitCode&);
+
+		typedef void (*FunctionPtr)();
+
+		void * memory_;			//!< executable pages
+		size_t size_;
+		FunctionPtr function_;
+	};
+
+} // namespace console_script
+
+#endif
@@ -0,0 +1,268 @@
+#include "script_kernels.h"
+#include "script_program.h"
+
+#include <assert.h>
+
+namespace console_script {
+
+#define BINARY_PARAMS \
+	Value& value = registers[instruction.value]; \
+	const Value& first = registers[instruction.first]; \
+	const Value& second = registers[instruction.second];
+#define ASSIGNMENT_PARAMS \
+	Value& value = registers[instruction.value]; \
+	Value& first = registers[instruction.first]; \
+	const Value& second = registers[instruction.second];
+#define UNARY_PARAMS \
+	Value& value = registers[instruction.value]; \
+	const Value& first = registers[instruction.first];
+#define UNARY_LVALUE_PARAMS \
+	Value& value = registers[instruction.value]; \
+	Value& first = registers[instruction.first];
+
+	/*
+	Kernels are instantiated per operand type T, which is known after the tree check
+	(both operands of binary operator have the same type), so they access typed data
+	directly without any type switch.
+	*/
+
+#define BINARY_KERNEL(name, op) \
+	template <typename T> \
+	static void name(Value* registers, const Instruction& instruction) \
+	{ \
+		BINARY_PARAMS; \
+		value.get<T>() = first.get<T>() op second.get<T>(); \
+	}
+
+	BINARY_KERNEL(KernelAddition, +)
+	BINARY_KERNEL(KernelSubtraction, -)
+	BINARY_KERNEL(KernelMultiplication, *)
+	BINARY_KERNEL(KernelDivision, /)
+	BINARY_KERNEL(KernelModulus, %)
+	BINARY_KERNEL(KernelBitwiseAnd, &)
+	BINARY_KERNEL(KernelBitwiseInclusiveOr, |)
+	BINARY_KERNEL(KernelBitwiseExclusiveOr, ^)
+	BINARY_KERNEL(KernelLogicalAnd, &&)
+	BINARY_KERNEL(KernelLogicalOr, ||)
+	BINARY_KERNEL(KernelLeftShift, <<)
+	BINARY_KERNEL(KernelRightShift, >>)
+
+#undef BINARY_KERNEL
+
+#define COMPARISON_KERNEL(name, op) \
+	template <typename T> \
+	static void name(Value* registers, const Instruction& instruction) \
+	{ \
+		BINARY_PARAMS; \
+		value.get<bool>() = first.get<T>() op second.get<T>(); \
+	}
+
+	COMPARISON_KERNEL(KernelEquality, ==)
+	COMPARISON_KERNEL(KernelNotEqual, !=)
+	COMPARISON_KERNEL(KernelLessThan, <)
+	COMPARISON_KERNEL(KernelLessThanOrEqual, <=)
+	COMPARISON_KERNEL(KernelGreaterThan, >)
+	COMPARISON_KERNEL(KernelGreaterThanOrEqual, >=)
+
+#undef COMPARISON_KERNEL
+
+	template <typename T>
+	static void KernelUnaryPlus(Value* registers, const Instruction& instruction)
+	{
+		UNARY_PARAMS;
+		value.get<T>() = first.get<T>();
+	}
+	template <typename T>
+	static void KernelNegation(Value* registers, const Instruction& instruction)
+	{
+		UNARY_PARAMS;
+		value.get<T>() = - first.get<T>();
+	}
+	template <typename T>
+	static void KernelLogicalNegation(Value* registers, const Instruction& instruction)
+	{
+		UNARY_PARAMS;
+		value.get<T>() = ! first.get<T>();
+	}
+	template <typename T>
+	static void KernelOnesComplement(Value* registers, const Instruction& instruction)
+	{
+		UNARY_PARAMS;
+		value.get<T>() = ~ first.get<T>();
+	}
+	template <typename T>
+	static void KernelPrefixIncrement(Value* registers, const Instruction& instruction)
+	{
+		UNARY_LVALUE_PARAMS;
+		value.get<T>() = ++first.get<T>();
+	}
+	template <typename T>
+	static void KernelPostfixIncrement(Value* registers, const Instruction& instruction)
+	{
+		UNARY_LVALUE_PARAMS;
+		value.get<T>() = first.get<T>()++;
+	}
+	template <typename T>
+	static void KernelPrefixDecrement(Value* registers, const Instruction& instruction)
+	{
+		UNARY_LVALUE_PARAMS;
+		value.get<T>() = --first.get<T>();
+	}
+	template <typename T>
+	static void KernelPostfixDecrement(Value* registers, const Instruction& instruction)
+	{
+		UNARY_LVALUE_PARAMS;
+		value.get<T>() = first.get<T>()--;
+	}
+
+	// Casts are specialized on the result type, conversion depends on the operand type
+	static void KernelCastBoolean(Value* registers, const Instruction& instruction)
+	{
+		UNARY_PARAMS;
+		value.get<bool>() = first.AsBool();
+	}
+	static void KernelCastInteger(Value* registers, const Instruction& instruction)
+	{
+		UNARY_PARAMS;
+		value.get<int>() = first.AsInteger();
+	}
+	static void KernelCastFloat(Value* registers, const Instruction& instruction)
+	{
+		UNARY_PARAMS;
+		value.get<Float>() = first.AsFloat();
+	}
+	static void KernelCastString(Value* registers, const Instruction& instruction)
+	{
+		UNARY_PARAMS;
+		value.get<String>() = first.AsString();
+	}
+
+#define ASSIGNMENT_KERNEL(name, op) \
+	template <typename T> \
+	static void name(Value* registers, const Instruction& instruction) \
+	{ \
+		ASSIGNMENT_PARAMS; \
+		first.get<T>() op second.get<T>(); \
+		value.get<T>() = first.get<T>(); \
+	}
+
+	ASSIGNMENT_KERNEL(KernelAssignment, =)
+	ASSIGNMENT_KERNEL(KernelAdditionAssignment, +=)
+	ASSIGNMENT_KERNEL(KernelSubtractionAssignment, -=)
+	ASSIGNMENT_KERNEL(KernelMultiplicationAssignment, *=)
+	ASSIGNMENT_KERNEL(KernelDivisionAssignment, /=)
+	ASSIGNMENT_KERNEL(KernelModulusAssignment, %=)
+	ASSIGNMENT_KERNEL(KernelBitwiseInclusiveOrAssignment, |=)
+	ASSIGNMENT_KERNEL(KernelBitwiseExclusiveOrAssignment, ^=)
+	ASSIGNMENT_KERNEL(KernelBitwiseAndAssignment, &=)
+	ASSIGNMENT_KERNEL(KernelLeftShiftAssignment, <<=)
+	ASSIGNMENT_KERNEL(KernelRightShiftAssignment, >>=)
+
+#undef ASSIGNMENT_KERNEL
+
+	void KernelCall(Value* registers, const Instruction& instruction)
+	{
+		const CallSite * call = instruction.call;
+		const Value * args[kMaxFunctionArguments];
+		for (int i = 0; i < call->num_arguments; ++i)
+			args[i] = &registers[call->arguments[i]];
+		call->func->Call(&registers[instruction.value], args);
+	}
+
+	// Selects kernel instantiation for the operand type (nullptr if operator doesn't support it)
+#define KERNEL_BOOLEAN(kernel) \
+	case Value::kBoolean: return &kernel<bool>;
+#define KERNEL_INTEGER(kernel) \
+	case Value::kInteger: return &kernel<int>;
+#define KERNEL_FLOAT(kernel) \
+	case Value::kFloat: return &kernel<Float>;
+#define KERNEL_STRING(kernel) \
+	case Value::kString: return &kernel<String>;
+
+	static InstructionPtr SelectInteger(InstructionPtr kernel, Value::Type type)
+	{
+		return (type == Value::kInteger) ? kernel : nullptr;
+	}
+	static InstructionPtr SelectBoolean(InstructionPtr kernel, Value::Type type)
+	{
+		return (type == Value::kBoolean) ? kernel : nullptr;
+	}
+
+#define NUMERIC_KERNEL(kernel) \
+	switch (operand_type) { KERNEL_INTEGER(kernel) KERNEL_FLOAT(kernel) default: return nullptr; }
+#define NUMERIC_STRING_KERNEL(kernel) \
+	switch (operand_type) { KERNEL_INTEGER(kernel) KERNEL_FLOAT(kernel) KERNEL_STRING(kernel) default: return nullptr; }
+#define ANY_KERNEL(kernel) \
+	switch (operand_type) { KERNEL_BOOLEAN(kernel) KERNEL_INTEGER(kernel) KERNEL_FLOAT(kernel) KERNEL_STRING(kernel) default: return nullptr; }
+
+	InstructionPtr GetOperatorKernel(Operator::Type type, bool binary, bool prefix, Value::Type operand_type)
+	{
+		switch (type)
+		{
+		// Binary or unary
+		case Operator::kAddition:
+			if (binary)
+				NUMERIC_STRING_KERNEL(KernelAddition)
+			else
+				NUMERIC_STRING_KERNEL(KernelUnaryPlus)
+		case Operator::kSubtraction:
+			if (binary)
+				NUMERIC_KERNEL(KernelSubtraction)
+			else
+				NUMERIC_KERNEL(KernelNegation)
+		// Binary
+		case Operator::kMultiplication:					NUMERIC_KERNEL(KernelMultiplication)
+		case Operator::kDivision:						NUMERIC_KERNEL(KernelDivision)
+		case Operator::kModulus:						return SelectInteger(&KernelModulus<int>, operand_type);
+		case Operator::kBitwiseAnd:						return SelectInteger(&KernelBitwiseAnd<int>, operand_type);
+		case Operator::kBitwiseInclusiveOr:				return SelectInteger(&KernelBitwiseInclusiveOr<int>, operand_type);
+		case Operator::kBitwiseExclusiveOr:				return SelectInteger(&KernelBitwiseExclusiveOr<int>, operand_type);
+		case Operator::kLeftShift:						return SelectInteger(&KernelLeftShift<int>, operand_type);
+		case Operator::kRightShift:						return SelectInteger(&KernelRightShift<int>, operand_type);
+		case Operator::kLogicalAnd:						return SelectBoolean(&KernelLogicalAnd<bool>, operand_type);
+		case Operator::kLogicalOr:						return SelectBoolean(&KernelLogicalOr<bool>, operand_type);
+		case Operator::kEquality:						ANY_KERNEL(KernelEquality)
+		case Operator::kNotEqual:						ANY_KERNEL(KernelNotEqual)
+		case Operator::kLessThan:						ANY_KERNEL(KernelLessThan)
+		case Operator::kGreaterThan:					ANY_KERNEL(KernelGreaterThan)
+		case Operator::kLessThanOrEqual:				ANY_KERNEL(KernelLessThanOrEqual)
+		case Operator::kGreaterThanOrEqual:				ANY_KERNEL(KernelGreaterThanOrEqual)
+		// Unary
+		case Operator::kLogicalNegation:				return SelectBoolean(&KernelLogicalNegation<bool>, operand_type);
+		case Operator::kOnesComplement:					return SelectInteger(&KernelOnesComplement<int>, operand_type);
+		case Operator::kIncrement:						return SelectInteger(prefix ? &KernelPrefixIncrement<int> : &KernelPostfixIncrement<int>, operand_type);
+		case Operator::kDecrement:						return SelectInteger(prefix ? &KernelPrefixDecrement<int> : &KernelPostfixDecrement<int>, operand_type);
+		case Operator::kCastBoolean:					return &KernelCastBoolean;
+		case Operator::kCastInteger:					return &KernelCastInteger;
+		case Operator::kCastFloat:						return &KernelCastFloat;
+		case Operator::kCastString:						return &KernelCastString;
+		// Assignment
+		case Operator::kAssignment:						ANY_KERNEL(KernelAssignment)
+		case Operator::kAdditionAssignment:				NUMERIC_STRING_KERNEL(KernelAdditionAssignment)
+		case Operator::kSubtractionAssignment:			NUMERIC_KERNEL(KernelSubtractionAssignment)
+		case Operator::kMultiplicationAssignment:		NUMERIC_KERNEL(KernelMultiplicationAssignment)
+		case Operator::kDivisionAssignment:				NUMERIC_KERNEL(KernelDivisionAssignment)
+		case Operator::kModulusAssignment:				return SelectInteger(&KernelModulusAssignment<int>, operand_type);
+		case Operator::kBitwiseExclusiveOrAssignment:	return SelectInteger(&KernelBitwiseExclusiveOrAssignment<int>, operand_type);
+		case Operator::kBitwiseInclusiveOrAssignment:	return SelectInteger(&KernelBitwiseInclusiveOrAssignment<int>, operand_type);
+		case Operator::kBitwiseAndAssignment:			return SelectInteger(&KernelBitwiseAndAssignment<int>, operand_type);
+		case Operator::kLeftShiftAssignment:			return SelectInteger(&KernelLeftShiftAssignment<int>, operand_type);
+		case Operator::kRightShiftAssignment:			return SelectInteger(&KernelRightShiftAssignment<int>, operand_type);
+		default:										return nullptr;
+		}
+	}
+
+#undef ANY_KERNEL
+#undef NUMERIC_STRING_KERNEL
+#undef NUMERIC_KERNEL
+#undef KERNEL_STRING
+#undef KERNEL_FLOAT
+#undef KERNEL_INTEGER
+#undef KERNEL_BOOLEAN
+
+#undef UNARY_LVALUE_PARAMS
+#undef UNARY_PARAMS
+#undef ASSIGNMENT_PARAMS
+#undef BINARY_PARAMS
+
+} // namespace console_script
@@ -0,0 +1,38 @@
+#pragma once
+#ifndef __CONSOLE_SCRIPT_KERNELS_H__
+#define __CONSOLE_SCRIPT_KERNELS_H__
+
+#include "script_lexem.h"
+
+namespace console_script {
+
+	struct Instruction;
+	class JitAssembler;
+
+	/*
+	Instruction kernels operate on the program register file directly,
+	so there is no children list traversal and no operator lookup at run time.
+	*/
+	typedef void (*InstructionPtr)(Value* registers, const Instruction& instruction);
+
+	/*
+	Column kernels process the same instruction for a block of entities at once,
+	every register is a column (array) of typed values.
+	*/
+	typedef void (*ColumnPtr)(void** columns, const Instruction& instruction);
+
+	/*
+	Emitters append native code of the instruction to the assembler,
+	registers are passed to resolve addresses of the operands data.
+	*/
+	typedef void (*EmitterPtr)(JitAssembler& assembler, Value* registers, const Instruction& instruction);
+
+	// Returns kernel for the operator in its resolved form and operand type (or nullptr if not supported)
+	InstructionPtr GetOperatorKernel(Operator::Type type, bool binary, bool prefix, Value::Type operand_type);
+
+	// Native function call kernel
+	void KernelCall(Value* registers, const Instruction& instruction);
+
+} // namespace console_script
+
+#endif
@@ -22,34 +22,9 @@ namespace console_script {
 	{
 		return type != Lexem::kOperator;
 	}
-	bool Lexem::SortPredicate(Lexem* first, Lexem* second)
-	{
-		if (first->priority == second->priority && first->type == Lexem::kOperator) // second will be operator too
-		{
-			// first and second have equal associativity, so we will use first's one
-			Operator * op_first = dynamic_cast<Operator*>(first);
-			Operator * op_second = dynamic_cast<Operator*>(second);
-			if (op_first->associativity) // left-to-right
-				return op_first->pos < op_second->pos;
-			else // right-to-left
-				return op_first->pos > op_second->pos;
-		}
-		else
-			return first->priority > second->priority;
-	}
-	bool Lexem::OperatorPredicate(Lexem* first)
-	{
-		return first->type == Lexem::kOperator;
-	}
-	bool Lexem::ReferencePredicate(Lexem* first)
-	{
-		return first->type == Lexem::kReference || first->type == Lexem::kFunction;
-	}
-	Operator::Operator(const String& str, int pos) :
+	Operator::Operator(const String& str, int pos, const OperatorInfo * op_info) :
 		Lexem(str, Lexem::kOperator), pos(pos)
 	{
-		Base& base = Base::GetInstance();
-		OperatorInfo *op_info = base.GetOperatorInfo(str);
 		assert(op_info);
 		priority = op_info->priority();
 		form = op_info->form();
@@ -69,22 +44,8 @@ namespace console_script {
 	{
 		return false;
 	}
-	Reference::Reference()
-	{
-		type = kReference;
-		priority = kLowestPriority;
-		list_ptr = new std::list<Lexem*>;
-	}
-	Reference::~Reference()
-	{
-		if (list_ptr)
-		{
-			delete list_ptr;
-			list_ptr = nullptr;
-		}
-	}
-	FunctionReference::FunctionReference(const String& str) :
-		Lexem(str, Lexem::kFunction), arguments()
+	FunctionReference::FunctionReference(const String& str, const FunctionInfo * func_info) :
+		Lexem(str, Lexem::kFunction), info(func_info)
 	{
 
 	}
@@ -92,11 +53,9 @@ namespace console_script {
 	{
 
 	}
-	Variable::Variable(const String& str) :
-		Lexem(str, Lexem::kVariable)
+	Variable::Variable(const String& str, const VariableInfo * var_info) :
+		Lexem(str, Lexem::kVariable), info(var_info)
 	{
-		Base& base = Base::GetInstance();
-		info = base.GetVariableInfo(str);
 	}
 
 } // namespace script
\ No newline at end of file
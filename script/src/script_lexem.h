@@ -6,7 +6,6 @@
 #include "script_value.h"
 
 #include <string>
-#include <list>
 
 namespace console_script {
 
@@ -19,8 +18,7 @@ namespace console_script {
 			kOperator,
 			kFunction,
 			kConstant,
-			kVariable,
-			kReference
+			kVariable
 		};
 
 		Lexem();
@@ -30,10 +28,6 @@ namespace console_script {
 		bool is_l_value() const;
 		bool is_evaluatable() const;
 
-		static bool SortPredicate(Lexem* first, Lexem* second);
-		static bool OperatorPredicate(Lexem* first);
-		static bool ReferencePredicate(Lexem* first);
-
 		String str;
 		int priority;
 		Type type;
@@ -89,41 +83,31 @@ namespace console_script {
 			kLValueOnly		= 0x08
 		};
 
-		Operator(const String& str, int pos);
+		Operator(const String& str, int pos, const class OperatorInfo * op_info);
 
 		bool is_indefinite_form() const;
 		static const int UnaryPriority();
 		static const bool UnaryAssociativity();
 
 		int form;
-		int pos; //!< for sorting
+		int pos; //!< position in expression
 		bool associativity;
-		class OperatorInfo * info;
-	};
-
-	class Reference : public Lexem {
-	public:
-		Reference();
-		virtual ~Reference();
-
-		std::list<Lexem*> *list_ptr;
+		const class OperatorInfo * info;
 	};
 
 	class FunctionReference : public Lexem {
-		typedef std::list<Lexem*> LexemList;
-
 	public:
-		FunctionReference(const String& str);
+		FunctionReference(const String& str, const class FunctionInfo * func_info);
 		virtual ~FunctionReference();
 
-		std::list<LexemList*> arguments;
+		const class FunctionInfo * info;
 	};
 
 	class Variable : public Lexem {
 	public:
-		Variable(const String& str);
+		Variable(const String& str, const class VariableInfo * var_info);
 
-		class VariableInfo *info;
+		const class VariableInfo *info;
 	};
 
 } // namespace console_script
@@ -166,7 +166,7 @@ namespace console_script {
 
 	bool Parser::ParseLexems(const String& str)
 	{
-		Base& base = Base::GetInstance();
+		const Base& base = *base_;
 
 		int i_pos = 0;
 		for (String::size_type i = 0; i < str.size(); ++i)
@@ -183,116 +183,19 @@ namespace console_script {
 				continue;
 			}
 
+			// Check for the longest operator match
+			size_t length;
+			const OperatorInfo * info = base.MatchOperator(str.data() + i, str.size() - i, length);
+			if (info)
+			{
+				AddOperator(str.substr(i, length), ++i_pos, info);
+				i += length - 1;
+				continue; // there wont be any other type (variable, function, constant)
+			}
+
 			String new_str;
 			new_str += str[i]; // just 1 symbol
 
-			// Check for operators match
-			MatchInfo new_info;
-			base.CountOperatorMatches(new_str, new_info);
-			if (new_info.count > 1)
-			{
-				String cur_str = new_str;
-				// try to find the only match further
-				bool try_other = false;
-				bool was_full_match = new_info.full_match;
-				String last_match_str = cur_str;
-				String::size_type last_match_j = i;
-				MatchInfo info;
-				bool pushed = false;
-				for (String::size_type j = i + 1; j < str.size(); ++j)
-				{
-					new_str += str[j];
-					base.CountOperatorMatches(new_str, info);
-					if (info.count > 1) // its still possible
-					{
-						if (info.full_match)
-						{
-							was_full_match = true;
-							last_match_str = new_str;
-							last_match_j = j;
-						}
-						continue;
-					}
-					else if (info.count == 1) // 1 match
-					{
-						if (info.full_match) // found the only match
-						{
-							pushed = true;
-							AddLexem(new_str, Lexem::Type::kOperator, ++i_pos);
-							i = j;
-							break;
-						}
-						else
-							continue;
-					}
-					else // 0 matches
-					{
-						if (was_full_match) // we still have full match
-						{
-							pushed = true;
-							AddLexem(last_match_str, Lexem::Type::kOperator, ++i_pos);
-							i = last_match_j;
-							break;
-						}
-						else // weird situation, try other naming rules (or error?)
-						{
-							try_other = true;
-							new_str = cur_str;
-							break;
-						}
-					}
-				}
-				if (!pushed && !try_other) // end of the string
-				{
-					AddLexem(new_str, Lexem::Type::kOperator, ++i_pos);
-					i = str.size() - 1;
-				}
-				if (!try_other)
-					continue; // there wont be any other type (variable, function, constant)
-			}
-			else if (new_info.count == 1) // found the only match
-			{
-				bool try_other = false;
-				if (new_info.full_match) // match has been found
-				{
-					AddLexem(new_str, Lexem::Type::kOperator, ++i_pos);
-				}
-				else // try to find it further
-				{
-					String cur_str = new_str;
-					MatchInfo info;
-					bool pushed = false;
-					for (String::size_type j = i + 1; j < str.size(); ++j)
-					{
-						new_str += str[j];
-						base.CountOperatorMatches(new_str, info);
-						if (info.count == 1) // still 1 match
-						{
-							if (info.full_match)
-							{
-								pushed = true;
-								AddLexem(new_str, Lexem::Type::kOperator, ++i_pos);
-								i = j;
-								break;
-							}
-							else
-								continue;
-						}
-						else // 0 matches
-						{
-							try_other = true;
-							new_str = cur_str;
-							break;
-						}
-					}
-					if (!pushed && !try_other) // end of the string
-					{
-						AddLexem(new_str, Lexem::Type::kOperator, ++i_pos);
-					}
-				}
-				if (!try_other)
-					continue;
-			}
 			// Variable/Function (same naming rule)
 			if (match_variable(new_str))
 			{
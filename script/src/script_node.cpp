@@ -2,37 +2,39 @@
 #include "script_lexem.h"
 #include "script_base.h"
 #include <assert.h>
+#include <climits>
 
 namespace console_script {
 
-	Node::Node() :
-		data_(), lexem_(nullptr), parent_(nullptr)
+	Node::Node(Arena * arena) :
+		data_(), lexem_(nullptr), parent_(nullptr), childs_(arena), height_(0)
 	{
 	}
-	Node::Node(Lexem* lexem) :
-		data_(lexem), lexem_(lexem), parent_(nullptr)
+	Node::Node(Lexem* lexem, Arena * arena) :
+		data_(lexem), lexem_(lexem), parent_(nullptr), childs_(arena), height_(0)
 	{
 		CreationCheck();
 	}
 	Node::Node(Lexem* lexem, Node * parent) :
-		data_(lexem), lexem_(lexem), parent_(parent)
+		data_(lexem), lexem_(lexem), parent_(parent), childs_(parent->arena()), height_(0)
 	{
 		parent_->Add(this);
 		CreationCheck();
 	}
 	Node::~Node()
 	{
-		if (lexem_)
-			delete lexem_;
+		// Lexem is owned by arena
 	}
 	void Node::Add(Node* node)
 	{
 		childs_.push_back(node);
 		node->parent_ = this;
+		if (height_ <= node->height_)
+			height_ = node->height_ + 1;
 	}
 	void Node::EvaluateTree()
 	{
-		for (std::list<Node*>::iterator it = childs_.begin(); it != childs_.end(); ++it)
+		for (NodeList::iterator it = childs_.begin(); it != childs_.end(); ++it)
 			(*it)->EvaluateTree();
 
 		if (lexem_ == nullptr) // root
@@ -45,67 +47,32 @@ namespace console_script {
 		}
 		else if (lexem_->type == Lexem::kOperator)
 		{
-			Base& base = Base::GetInstance();
 			Operator * op = dynamic_cast<Operator*>(lexem_);
 			// Load operator function pointer
-			OperatorPtr func = base.GetOperatorPtr(op->info->type()); // lookup
+			OperatorPtr func = op->info->func();
+			assert(func);
 			func(childs_, &data_);
 		}
 		else if (lexem_->type == Lexem::kFunction)
 		{
-			Base& base = Base::GetInstance();
 			FunctionReference *func_ref = dynamic_cast<FunctionReference*>(lexem_);
-			// Load operator function pointer
-			std::vector<Variant> args;
-			args.resize(childs_.size());
+			// Pass arguments thru the on-stack buffer
+			const Value * args[kMaxFunctionArguments];
 			size_t i = 0;
 			for (auto it = childs_.begin(); it != childs_.end(); ++it)
-			{
-				switch ((*it)->data().type())
-				{
-				case Value::kBoolean:
-					args[i].set<bool>((*it)->data().AsBool());
-					break;
-				case Value::kInteger:
-					args[i].set<int>((*it)->data().AsInteger());
-					break;
-				case Value::kFloat:
-					args[i].set<Float>((*it)->data().AsFloat());
-					break;
-				case Value::kString:
-					args[i].set<String>((*it)->data().AsString());
-					break;
-				default:
-					assert(false && "wrong function argument type");
-					break;
-				}
-				++i;
-			}
-			base.CallFunction(func_ref->str, args, &data_);
-		}
-		else if (lexem_->type == Lexem::kVariable)
-		{
-			Variable *var = dynamic_cast<Variable*>(lexem_);
-			data_.Assign(var->info->ptr()); // assign value
+				args[i++] = &(*it)->data();
+			func_ref->info->Call(&data_, args);
 		}
 	}
-	void Node::DeleteTree()
-	{
-		for (std::list<Node*>::iterator it = childs_.begin(); it != childs_.end(); ++it)
-			(*it)->DeleteTree();
-		delete this;
-	}
 	bool Node::CheckTree(String& error)
 	{
-		for (std::list<Node*>::iterator it = childs_.begin(); it != childs_.end(); ++it)
+		for (NodeList::iterator it = childs_.begin(); it != childs_.end(); ++it)
 		if (!(*it)->CheckTree(error))
 			return false;
 
 		if (lexem_ == nullptr) // root
 			return true;
 
-		assert(lexem_->type != Lexem::kReference && "a reference has been found during tree traverse");
-
 		if (lexem_->type == Lexem::kOperator)
 		{
 			Operator * op = dynamic_cast<Operator*>(lexem_);
@@ -118,7 +85,7 @@ namespace console_script {
 					error = CS_TEXT("wrong params count");
 					return false;
 				}
-				std::list<Node*>::const_iterator it = childs_.begin();
+				NodeList::const_iterator it = childs_.begin();
 				const Value& first = (*it)->data();
 				if ((first.type_ & op->info->value_types()) != first.type_)
 				{
@@ -148,7 +115,7 @@ namespace console_script {
 					error = CS_TEXT("wrong params count");
 					return false;
 				}
-				std::list<Node*>::const_iterator it = childs_.begin();
+				NodeList::const_iterator it = childs_.begin();
 				const Value& first = (*it)->data();
 				if ((first.type_ & op->info->value_types()) != first.type_)
 				{
@@ -163,10 +130,9 @@ namespace console_script {
 		}
 		else if (lexem_->type == Lexem::kFunction)
 		{
-			Base& base = Base::GetInstance();
 			FunctionReference * func = dynamic_cast<FunctionReference*>(lexem_);
 			assert(func);
-			FunctionInfo * info = base.GetFunctionInfo(func->str);
+			const FunctionInfo * info = func->info;
 			assert(info);
 			// Check function arity
 			if (childs_.size() != info->arguments_type().size())
@@ -239,12 +205,139 @@ namespace console_script {
 			return false;
 		}
 	}
+	void Node::FoldConstants()
+	{
+		for (NodeList::iterator it = childs_.begin(); it != childs_.end(); ++it)
+			(*it)->FoldConstants();
+
+		if (lexem_ == nullptr) // root
+			return;
+
+		if (CanFold())
+		{
+			// All childs are constants, so evaluate node once
+			EvaluateTree();
+			MakeConstant();
+		}
+		else if (Absorb())
+		{
+			// Result doesn't depend on the other (side effect free) subtree
+			MakeConstant();
+		}
+	}
+	bool Node::IsConstant() const
+	{
+		return lexem_ != nullptr && lexem_->type == Lexem::kConstant;
+	}
+	bool Node::HasSideEffects() const
+	{
+		if (lexem_ != nullptr)
+		{
+			if (lexem_->type == Lexem::kOperator)
+			{
+				const Operator * op = dynamic_cast<const Operator*>(lexem_);
+				// Operator form may have been changed during recognition, so use original one
+				if (op->info->form() & Operator::kLValueOnly)
+					return true;
+			}
+			else if (lexem_->type == Lexem::kFunction)
+			{
+				const FunctionReference * func = dynamic_cast<const FunctionReference*>(lexem_);
+				if (!func->info->pure())
+					return true;
+			}
+		}
+		for (NodeList::const_iterator it = childs_.begin(); it != childs_.end(); ++it)
+		if ((*it)->HasSideEffects())
+			return true;
+		return false;
+	}
+	bool Node::CanFold() const
+	{
+		for (NodeList::const_iterator it = childs_.begin(); it != childs_.end(); ++it)
+		if (!(*it)->IsConstant())
+			return false;
+
+		if (lexem_->type == Lexem::kOperator)
+		{
+			const Operator * op = dynamic_cast<const Operator*>(lexem_);
+			if ((op->info->form() & Operator::kLValueOnly) || op->info->func() == nullptr)
+				return false;
+			// Leave undefined integer division (by zero and INT_MIN by -1) to run time
+			if ((op->info->type() == Operator::kDivision || op->info->type() == Operator::kModulus) &&
+				childs_.back()->data_.type() == Value::kInteger)
+			{
+				const int divisor = childs_.back()->data_.AsInteger();
+				if (divisor == 0 || (divisor == -1 && childs_.front()->data_.AsInteger() == INT_MIN))
+					return false;
+			}
+			return true;
+		}
+		else if (lexem_->type == Lexem::kFunction)
+		{
+			const FunctionReference * func = dynamic_cast<const FunctionReference*>(lexem_);
+			return func->info->pure() && func->info->return_type() != Value::kVoid;
+		}
+		return false;
+	}
+	bool Node::Absorb()
+	{
+		if (lexem_->type != Lexem::kOperator || childs_.size() != 2)
+			return false;
+		const Operator * op = dynamic_cast<const Operator*>(lexem_);
+		for (NodeList::const_iterator it = childs_.begin(); it != childs_.end(); ++it)
+		{
+			const Node * node = *it;
+			const Node * other = (node == childs_.front()) ? childs_.back() : childs_.front();
+			if (!node->IsConstant() || other->HasSideEffects())
+				continue;
+			const Value& value = node->data_;
+			switch (op->info->type())
+			{
+			case Operator::kLogicalAnd: // false && x
+				if (!value.AsBool())
+				{
+					data_ = false;
+					return true;
+				}
+				break;
+			case Operator::kLogicalOr: // true || x
+				if (value.AsBool())
+				{
+					data_ = true;
+					return true;
+				}
+				break;
+			case Operator::kMultiplication: // 0 * x (integers only, floats may be inf or nan)
+			case Operator::kBitwiseAnd: // 0 & x
+				if (value.type() == Value::kInteger && value.AsInteger() == 0)
+				{
+					data_ = 0;
+					return true;
+				}
+				break;
+			default:
+				break;
+			}
+		}
+		return false;
+	}
+	void Node::MakeConstant()
+	{
+		// Childs are owned by arena, so just unlink them
+		childs_.clear();
+		String str = data_.AsString();
+		if (data_.type() == Value::kString)
+			str = CS_TEXT("\"") + str + CS_TEXT("\"");
+		lexem_ = arena()->Create<Lexem>(str, Lexem::kConstant);
+	}
 	inline void Node::CreationCheck()
 	{
 		if (lexem_->type == Lexem::kVariable)
 		{
 			Variable *var = dynamic_cast<Variable*>(lexem_);
 			data_.set_type(var->info->type()); // assign value type
+			data_.Assign(var->info->ptr()); // bind value once, so tree may be evaluated many times
 		}
 	}
 
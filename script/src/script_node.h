@@ -3,41 +3,57 @@
 #define __CONSOLE_SCRIPT_NODE_H__
 
 #include "script_value.h"
+#include "script_arena.h"
 
 #include <list>
 
 namespace console_script {
 
+	class Node;
+
+	typedef std::list<Node*, ArenaAllocator<Node*> > NodeList;
+
 	class Node {
 		friend class Parser;
+		friend class Program;
 
 	public:
-		Node();
-		Node(Lexem* lexem);
+		//! Nodes and their lexems are owned by arena
+		Node(Arena * arena);
+		Node(Lexem* lexem, Arena * arena);
 		Node(Lexem* lexem, Node * parent);
 		~Node();
 
 		void Add(Node* node);
 		void EvaluateTree();
-		void DeleteTree();
 		bool CheckTree(String& error);
+		void FoldConstants();
 
 		Value& data() { return data_; }
 		const Value& data() const { return data_; }
 		Node * parent() { return parent_; }
+		size_t height() const { return height_; }
+		Arena * arena() const { return childs_.get_allocator().arena(); }
 
 		bool IsOperatorBinary(class Operator * op);
 		bool IsOperatorBinary();
 		bool IsOperatorFormPrefix();
 
+		bool IsConstant() const;
+		bool HasSideEffects() const;
+
 	protected:
 		inline void CreationCheck();
+		bool CanFold() const;
+		bool Absorb();
+		void MakeConstant();
 
 	private:
 		Value data_;
 		Lexem * lexem_;
 		Node * parent_;
-		std::list<Node*> childs_;
+		NodeList childs_;
+		size_t height_;	//!< longest path down to a leaf, as built by the parser
 	};
 
 } // namespace console_script
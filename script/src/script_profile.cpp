@@ -0,0 +1,176 @@
+#include "script_profile.h"
+
+#ifdef PARSER_PROFILE
+
+#include "script_lexem.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdarg>
+
+namespace console_script {
+
+	// Indexed by Operator::Type
+	static const CS_CHAR * const kOperatorSymbols[] = {
+		CS_TEXT("+"), CS_TEXT("-"), CS_TEXT("="), CS_TEXT("+="), CS_TEXT("-="),
+		CS_TEXT("&="), CS_TEXT("^="), CS_TEXT("|="), CS_TEXT("*="), CS_TEXT("/="),
+		CS_TEXT("%="), CS_TEXT("<<="), CS_TEXT(">>="), CS_TEXT("&"), CS_TEXT("^"),
+		CS_TEXT("|"), CS_TEXT("&&"), CS_TEXT("||"), CS_TEXT(","), CS_TEXT(";"),
+		CS_TEXT("*"), CS_TEXT("/"), CS_TEXT("%"), CS_TEXT("=="), CS_TEXT("!="),
+		CS_TEXT(">="), CS_TEXT(">"), CS_TEXT("<="), CS_TEXT("<"), CS_TEXT("<<"),
+		CS_TEXT(">>"), CS_TEXT("!"), CS_TEXT("~"), CS_TEXT("++"), CS_TEXT("--"),
+		CS_TEXT("(bool)"), CS_TEXT("(int)"), CS_TEXT("(float)"), CS_TEXT("(string)")
+	};
+	static_assert(sizeof(kOperatorSymbols) / sizeof(kOperatorSymbols[0]) == Operator::kCastString + 1,
+		"operator symbols mismatch");
+
+	uint64_t ProfileOverhead()
+	{
+		// Minimum of back to back calls is a good estimate, it's measured once
+		static const uint64_t overhead = []() {
+			uint64_t best = ~uint64_t(0);
+			for (int i = 0; i < 1000; ++i)
+			{
+				uint64_t start = ProfileTime();
+				uint64_t end = ProfileTime();
+				best = std::min(best, end - start);
+			}
+			return best;
+		}();
+		return overhead;
+	}
+	String OperatorSymbol(int type, bool binary, bool prefix)
+	{
+		String symbol = kOperatorSymbols[type];
+		if (binary || type >= Operator::kCastBoolean)
+			return symbol;
+		// Show operand position for unary operators
+		return prefix ? symbol + CS_TEXT("x") : CS_TEXT("x") + symbol;
+	}
+
+	ProgramProfile::ProgramProfile()
+	{
+		Reset(0);
+	}
+	void ProgramProfile::Reset(size_t num_instructions)
+	{
+		executions_ = 0;
+		total_.time = 0;
+		total_.samples = 0;
+		Counter zero = { 0, 0 };
+		instructions_.assign(num_instructions, zero);
+	}
+	void ProgramProfile::AddSample(uint64_t time)
+	{
+		total_.time += time;
+		++total_.samples;
+	}
+	void ProgramProfile::AddInstructionSample(size_t index, uint64_t time)
+	{
+		instructions_[index].time += time;
+		++instructions_[index].samples;
+	}
+	double ProgramProfile::Scale() const
+	{
+		if (total_.samples == 0)
+			return 0.0;
+		return static_cast<double>(executions_) / static_cast<double>(total_.samples);
+	}
+	void ProgramProfile::GetStats(ProgramStats& stats) const
+	{
+		const double scale = Scale();
+		stats.source = source_;
+		stats.executions = executions_;
+		stats.time = static_cast<double>(total_.time) * scale;
+		stats.instructions.resize(instructions_.size());
+		for (size_t i = 0; i < instructions_.size(); ++i)
+		{
+			stats.instructions[i].count = static_cast<double>(instructions_[i].samples) * scale;
+			stats.instructions[i].time = static_cast<double>(instructions_[i].time) * scale;
+		}
+	}
+
+	void CollectFunctionStats(const std::vector<ProgramStats>& programs, std::vector<FunctionStats>& functions)
+	{
+		functions.clear();
+		for (auto program = programs.begin(); program != programs.end(); ++program)
+			for (auto it = program->instructions.begin(); it != program->instructions.end(); ++it)
+			{
+				if (!it->call)
+					continue;
+				auto function = std::find_if(functions.begin(), functions.end(),
+					[it](const FunctionStats& stats) { return stats.name == it->name; });
+				if (function == functions.end())
+				{
+					FunctionStats stats = { it->name, 0.0, 0.0 };
+					function = functions.insert(functions.end(), stats);
+				}
+				function->calls += it->count;
+				function->time += it->time;
+			}
+		std::stable_sort(functions.begin(), functions.end(),
+			[](const FunctionStats& a, const FunctionStats& b) { return a.time > b.time; });
+	}
+
+	// Formats numbers only, so the result is ASCII for any character type
+	static String Format(const char * format, ...)
+	{
+		char buffer[128];
+		va_list args;
+		va_start(args, format);
+		int length = vsnprintf(buffer, sizeof(buffer), format, args);
+		va_end(args);
+		if (length < 0)
+			return String();
+		length = std::min(length, static_cast<int>(sizeof(buffer)) - 1);
+		return String(buffer, buffer + length);
+	}
+	static double Average(double time, double count)
+	{
+		return (count > 0.0) ? time / count : 0.0;
+	}
+
+	String FormatProfile(const std::vector<ProgramStats>& programs, const std::vector<FunctionStats>& functions)
+	{
+		std::vector<const ProgramStats*> sorted;
+		for (auto it = programs.begin(); it != programs.end(); ++it)
+			sorted.push_back(&*it);
+		std::stable_sort(sorted.begin(), sorted.end(),
+			[](const ProgramStats * a, const ProgramStats * b) { return a->time > b->time; });
+
+		String report = CS_TEXT("programs:\n");
+		report += Format("%14s %12s %10s  %s\n", "executions", "total ms", "avg ns", "source");
+		for (auto program = sorted.begin(); program != sorted.end(); ++program)
+		{
+			const ProgramStats& stats = **program;
+			report += Format("%14llu %12.3f %10.1f  ", static_cast<unsigned long long>(stats.executions),
+				stats.time * 1e-6, Average(stats.time, static_cast<double>(stats.executions)));
+			report += stats.source + CS_TEXT("\n");
+			// Instructions are listed from the most expensive one
+			std::vector<const InstructionStats*> instructions;
+			for (auto it = stats.instructions.begin(); it != stats.instructions.end(); ++it)
+				instructions.push_back(&*it);
+			std::stable_sort(instructions.begin(), instructions.end(),
+				[](const InstructionStats * a, const InstructionStats * b) { return a->time > b->time; });
+			for (auto it = instructions.begin(); it != instructions.end(); ++it)
+			{
+				const InstructionStats& instruction = **it;
+				const double share = (stats.time > 0.0) ? 100.0 * instruction.time / stats.time : 0.0;
+				report += Format("%14.0f %12.3f %10.1f  %5.1f%%  ", instruction.count,
+					instruction.time * 1e-6, Average(instruction.time, instruction.count), share);
+				report += instruction.name + (instruction.call ? CS_TEXT("()\n") : CS_TEXT("\n"));
+			}
+		}
+		report += CS_TEXT("functions:\n");
+		report += Format("%14s %12s %10s  %s\n", "calls", "total ms", "avg ns", "name");
+		for (auto it = functions.begin(); it != functions.end(); ++it)
+		{
+			report += Format("%14.0f %12.3f %10.1f  ", it->calls, it->time * 1e-6, Average(it->time, it->calls));
+			report += it->name + CS_TEXT("\n");
+		}
+		return report;
+	}
+
+} // namespace console_script
+
+#endif // PARSER_PROFILE
@@ -0,0 +1,99 @@
+#pragma once
+#ifndef __CONSOLE_SCRIPT_PROFILE_H__
+#define __CONSOLE_SCRIPT_PROFILE_H__
+
+#include "script_defines.h"
+
+// Define PARSER_PROFILE to collect execution statistics of programs,
+// every PARSER_PROFILE_PERIOD-th execution of a program is timed per instruction
+#ifdef PARSER_PROFILE
+
+#ifndef PARSER_PROFILE_PERIOD
+#define PARSER_PROFILE_PERIOD 64
+#endif
+
+#include <vector>
+#include <chrono>
+#include <cstdint>
+
+namespace console_script {
+
+	//! Monotonic time in nanoseconds
+	inline uint64_t ProfileTime() {
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count());
+	}
+	//! Time of the ProfileTime call itself, it's subtracted from every measurement
+	uint64_t ProfileOverhead();
+
+	//! Returns source form of the operator
+	String OperatorSymbol(int type, bool binary, bool prefix);
+
+	struct InstructionStats {
+		String name;		//!< operator or function name
+		bool call;			//!< native function call
+		double count;		//!< estimated number of executions
+		double time;		//!< estimated total time in nanoseconds
+	};
+
+	struct ProgramStats {
+		String source;		//!< compiled text
+		uint64_t executions;
+		double time;		//!< estimated total time in nanoseconds
+		std::vector<InstructionStats> instructions;	//!< in execution order
+	};
+
+	struct FunctionStats {
+		String name;
+		double calls;		//!< estimated number of calls over all programs
+		double time;		//!< estimated total time in nanoseconds
+	};
+
+	/*
+	Execution statistics of a program.
+	Every execution is counted, but only every PARSER_PROFILE_PERIOD-th one is timed
+	(per instruction), so the totals are estimated from the samples. Timed executions
+	are interpreted even if the program has native code, the other ones run as usual.
+	*/
+	class ProgramProfile {
+		struct Counter {
+			uint64_t time;		//!< sum of sampled times
+			uint64_t samples;	//!< number of sampled executions
+		};
+
+	public:
+		ProgramProfile();
+
+		void Reset(size_t num_instructions);
+
+		//! Counts execution, returns true if it should be timed
+		bool Count() { return executions_++ % PARSER_PROFILE_PERIOD == 0; }
+		void AddSample(uint64_t time);
+		void AddInstructionSample(size_t index, uint64_t time);
+
+		//! Fills counters of the statistics, names of instructions are left to the program
+		void GetStats(ProgramStats& stats) const;
+
+		void set_source(const String& source) { source_ = source; }
+		const String& source() const { return source_; }
+		uint64_t executions() const { return executions_; }
+
+	private:
+		double Scale() const;
+
+		String source_;
+		uint64_t executions_;
+		Counter total_;
+		std::vector<Counter> instructions_;
+	};
+
+	//! Sums statistics of native function calls over programs
+	void CollectFunctionStats(const std::vector<ProgramStats>& programs, std::vector<FunctionStats>& functions);
+	//! Text report of programs, their instructions and native functions sorted by total time
+	String FormatProfile(const std::vector<ProgramStats>& programs, const std::vector<FunctionStats>& functions);
+
+} // namespace console_script
+
+#endif // PARSER_PROFILE
+
+#endif
@@ -0,0 +1,613 @@
+#include "script_program.h"
+#include "script_batch.h"
+#include "script_node.h"
+
+#include <algorithm>
+#include <assert.h>
+
+namespace console_script {
+
+	enum RegisterKind {
+		kRegisterComputed,	//!< value of an instruction
+		kRegisterConstant,
+		kRegisterVariable
+	};
+
+	// Type of the value produced by operator (checked against the register on load)
+	static Value::Type OperatorResultType(Operator::Type type, Value::Type operand_type)
+	{
+		switch (type)
+		{
+		case Operator::kEquality:
+		case Operator::kNotEqual:
+		case Operator::kLessThan:
+		case Operator::kGreaterThan:
+		case Operator::kLessThanOrEqual:
+		case Operator::kGreaterThanOrEqual:
+		case Operator::kCastBoolean:
+			return Value::kBoolean;
+		case Operator::kCastInteger:
+			return Value::kInteger;
+		case Operator::kCastFloat:
+			return Value::kFloat;
+		case Operator::kCastString:
+			return Value::kString;
+		default:
+			return operand_type;
+		}
+	}
+	static bool IsValueType(unsigned char type)
+	{
+		return type == Value::kBoolean || type == Value::kInteger || type == Value::kFloat ||
+			type == Value::kString || type == Value::kVoid;
+	}
+
+	Program::Program() :
+		num_registers_(0), result_(-1), any_dirty_(false), jit_threshold_(0), executions_(0), jittable_(false)
+	{
+	}
+	Program::~Program()
+	{
+	}
+	void Program::Clear()
+	{
+		jit_.Clear(); // code refers to the registers
+		executions_ = 0;
+		jittable_ = false;
+		instructions_.clear();
+		opcodes_.clear();
+		call_sites_.clear();
+		variables_.clear();
+		parents_.clear();
+		volatile_.clear();
+		dirty_.clear();
+		any_dirty_ = false;
+		registers_.reset();
+		num_registers_ = 0;
+		result_ = -1;
+#ifdef PARSER_PROFILE
+		profile_.Reset(0);
+#endif
+	}
+	bool Program::Build(Node * root, String& error)
+	{
+		Clear();
+		if (root->childs_.empty()) // nothing to execute
+			return true;
+		Node * node = root->childs_.front();
+		// Allocate registers once, so they won't be moved during emission
+		int count = CountNodes(node);
+		registers_.reset(new Value[count]);
+		instructions_.reserve(count);
+		opcodes_.reserve(count);
+		parents_.assign(count, -1);
+		int reg;
+		if (!Emit(node, reg, error))
+		{
+			Clear();
+			return false;
+		}
+		result_ = reg;
+		Finish();
+		return true;
+	}
+	void Program::Finish()
+	{
+		FindVolatile();
+		MarkAllDirty(); // nothing has been computed yet
+		jittable_ = !instructions_.empty();
+		for (auto it = instructions_.begin(); it != instructions_.end(); ++it)
+			jittable_ = jittable_ && (it->emit != nullptr);
+#ifdef PARSER_PROFILE
+		profile_.Reset(instructions_.size());
+#endif
+	}
+	void Program::Execute()
+	{
+#ifdef PARSER_PROFILE
+		if (profile_.Count())
+		{
+			ExecuteProfiled(false);
+			return;
+		}
+#endif
+		if (jit_.compiled())
+		{
+			jit_.Execute();
+			return;
+		}
+		if (jittable_ && jit_threshold_ != 0 && ++executions_ >= jit_threshold_)
+		{
+			TierUp();
+			if (jit_.compiled())
+			{
+				jit_.Execute();
+				return;
+			}
+		}
+		Value * registers = registers_.get();
+		const Instruction * it = instructions_.data();
+		const Instruction * end = it + instructions_.size();
+		for (; it != end; ++it)
+			it->func(registers, *it);
+	}
+	void Program::ExecuteDirty()
+	{
+		for (auto it = volatile_.begin(); it != volatile_.end(); ++it)
+			MarkInstruction(*it);
+#ifdef PARSER_PROFILE
+		if (profile_.Count())
+		{
+			ExecuteProfiled(true);
+			return;
+		}
+#endif
+		if (!any_dirty_)
+			return;
+		any_dirty_ = false;
+		// Post order keeps operands computed before their readers
+		Value * registers = registers_.get();
+		const size_t n_instructions = instructions_.size();
+		for (size_t i = 0; i < n_instructions; ++i)
+		{
+			if (dirty_[i])
+			{
+				dirty_[i] = 0;
+				instructions_[i].func(registers, instructions_[i]);
+			}
+		}
+	}
+#ifdef PARSER_PROFILE
+	void Program::ExecuteProfiled(bool dirty_only)
+	{
+		// Timed execution is always interpreted to attribute time to instructions
+		const uint64_t overhead = ProfileOverhead();
+		Value * registers = registers_.get();
+		const size_t n_instructions = instructions_.size();
+		uint64_t total = 0;
+		uint64_t last = ProfileTime();
+		for (size_t i = 0; i < n_instructions; ++i)
+		{
+			if (dirty_only)
+			{
+				if (!dirty_[i])
+					continue;
+				dirty_[i] = 0;
+			}
+			instructions_[i].func(registers, instructions_[i]);
+			const uint64_t now = ProfileTime();
+			const uint64_t time = (now - last > overhead) ? now - last - overhead : 0;
+			profile_.AddInstructionSample(i, time);
+			total += time;
+			last = now;
+		}
+		if (dirty_only)
+			any_dirty_ = false;
+		profile_.AddSample(total);
+	}
+	void Program::GetStats(ProgramStats& stats) const
+	{
+		profile_.GetStats(stats);
+		for (size_t i = 0; i < instructions_.size(); ++i)
+		{
+			const Opcode& opcode = opcodes_[i];
+			InstructionStats& instruction = stats.instructions[i];
+			instruction.call = (opcode.kind == Opcode::kCall);
+			if (instruction.call)
+				instruction.name = instructions_[i].call->name;
+			else
+				instruction.name = OperatorSymbol(opcode.type,
+					(opcode.flags & Opcode::kBinary) != 0, (opcode.flags & Opcode::kPrefix) != 0);
+		}
+	}
+#endif
+	void Program::MarkDirty(const VariableInfo * info)
+	{
+		// Every occurrence of the variable has its own register
+		for (auto it = variables_.begin(); it != variables_.end(); ++it)
+			if (it->info == info)
+				MarkInstruction(parents_[it->reg]);
+	}
+	void Program::MarkAllDirty()
+	{
+		dirty_.assign(instructions_.size(), 1);
+		any_dirty_ = !instructions_.empty();
+	}
+	void Program::MarkInstruction(int index)
+	{
+		// Tree has the only path to the root, and once instruction is dirty its readers are too
+		while (index >= 0 && !dirty_[index])
+		{
+			dirty_[index] = 1;
+			any_dirty_ = true;
+			index = parents_[instructions_[index].value];
+		}
+	}
+	void Program::FindVolatile()
+	{
+		// Instructions with side effects are marked in Emit, then readers of the written variables are added
+		std::vector<const VariableInfo*> written;
+		for (auto it = volatile_.begin(); it != volatile_.end(); ++it)
+		{
+			const Instruction& instruction = instructions_[*it];
+			if (instruction.call != nullptr)
+				continue;
+			for (auto slot = variables_.begin(); slot != variables_.end(); ++slot)
+				if (slot->reg == instruction.first)
+					written.push_back(slot->info);
+		}
+		for (auto slot = variables_.begin(); slot != variables_.end(); ++slot)
+		{
+			if (parents_[slot->reg] >= 0 &&
+				std::find(written.begin(), written.end(), slot->info) != written.end())
+				volatile_.push_back(parents_[slot->reg]);
+		}
+	}
+	void Program::TierUp()
+	{
+		// Don't try again if code can't be generated
+		if (!jit_.Compile(instructions_, registers_.get()))
+			jittable_ = false;
+	}
+	bool Program::empty() const
+	{
+		return result_ < 0;
+	}
+	const Value * Program::result() const
+	{
+		return (result_ < 0) ? nullptr : &registers_[result_];
+	}
+	int Program::CountNodes(Node * node)
+	{
+		int count = 1;
+		for (auto it = node->childs_.begin(); it != node->childs_.end(); ++it)
+			count += CountNodes(*it);
+		return count;
+	}
+	bool Program::Emit(Node * node, int& reg, String& error)
+	{
+		Lexem * lexem = node->lexem_;
+
+		// Emit childs first, so their values are ready before the node is executed
+		CallSite * call = nullptr;
+		if (lexem->type == Lexem::kFunction)
+		{
+			call = new CallSite();
+			call_sites_.emplace_back(call);
+			call->num_arguments = 0;
+		}
+		int operands[2] = { -1, -1 };
+		size_t n_childs = 0;
+		for (auto it = node->childs_.begin(); it != node->childs_.end(); ++it, ++n_childs)
+		{
+			int child;
+			if (!Emit(*it, child, error))
+				return false;
+			if (call)
+				call->arguments[call->num_arguments++] = child;
+			else if (n_childs < 2)
+				operands[n_childs] = child;
+		}
+
+		reg = num_registers_++;
+		Value& value = registers_[reg];
+		// Instruction of this node (if any) will be the next one
+		const int index = static_cast<int>(instructions_.size());
+		for (int i = 0; call && i < call->num_arguments; ++i)
+			parents_[call->arguments[i]] = index;
+		for (size_t i = 0; !call && i < n_childs && i < 2u; ++i)
+			parents_[operands[i]] = index;
+
+		Instruction instruction;
+		instruction.column = nullptr;
+		instruction.emit = nullptr;
+		instruction.value = reg;
+		instruction.first = -1;
+		instruction.second = -1;
+		instruction.call = nullptr;
+
+		switch (lexem->type)
+		{
+		case Lexem::kConstant:
+			// Evaluated at compile stage
+			value = node->data_;
+			break;
+		case Lexem::kVariable:
+			{
+				Variable * var = dynamic_cast<Variable*>(lexem);
+				// Bind register to the variable only once
+				value.set_type(var->info->type());
+				value.Assign(var->info->ptr());
+				VariableSlot slot;
+				slot.reg = reg;
+				slot.info = var->info;
+				slot.name = var->str;
+				variables_.push_back(slot);
+			}
+			break;
+		case Lexem::kOperator:
+			{
+				Operator * op = dynamic_cast<Operator*>(lexem);
+				bool binary = node->IsOperatorBinary(op);
+				Opcode opcode;
+				opcode.kind = Opcode::kOperator;
+				opcode.type = static_cast<unsigned char>(op->info->type());
+				opcode.operand_type = static_cast<unsigned char>(node->childs_.front()->data_.type());
+				opcode.flags = (binary ? Opcode::kBinary : 0) |
+					(node->IsOperatorFormPrefix() ? Opcode::kPrefix : 0) |
+					((op->info->form() & Operator::kLValueOnly) ? Opcode::kWrites : 0);
+				if (!Link(opcode, instruction))
+				{
+					error = CS_TEXT("operator ") + op->str + CS_TEXT(" is not supported");
+					return false;
+				}
+				assert(n_childs == (binary ? 2u : 1u));
+				instruction.first = operands[0];
+				if (binary)
+					instruction.second = operands[1];
+				value.set_type(node->data_.type());
+				if (opcode.flags & Opcode::kWrites)
+					volatile_.push_back(index);
+				instructions_.push_back(instruction);
+				opcodes_.push_back(opcode);
+			}
+			break;
+		case Lexem::kFunction:
+			{
+				const FunctionInfo * info = dynamic_cast<FunctionReference*>(lexem)->info;
+				call->func = info->func();
+				call->name = lexem->str;
+				Opcode opcode = { Opcode::kCall, 0, 0, 0 };
+				Link(opcode, instruction);
+				instruction.call = call;
+				value.set_type(node->data_.type()); // stays invalid for void functions
+				if (!info->pure()) // may have side effects or depend on the outer state
+					volatile_.push_back(index);
+				instructions_.push_back(instruction);
+				opcodes_.push_back(opcode);
+			}
+			break;
+		default:
+			assert(false && "unexpected lexem during program emission");
+			error = CS_TEXT("syntax error");
+			return false;
+		}
+		return true;
+	}
+
+	bool Program::Link(const Opcode& opcode, Instruction& instruction)
+	{
+		if (opcode.kind == Opcode::kCall)
+		{
+			instruction.func = &KernelCall;
+			return true;
+		}
+		const Operator::Type type = static_cast<Operator::Type>(opcode.type);
+		const Value::Type operand_type = static_cast<Value::Type>(opcode.operand_type);
+		const bool binary = (opcode.flags & Opcode::kBinary) != 0;
+		const bool prefix = (opcode.flags & Opcode::kPrefix) != 0;
+		instruction.func = GetOperatorKernel(type, binary, prefix, operand_type);
+		instruction.column = GetColumnKernel(type, binary, operand_type);
+		instruction.emit = GetJitEmitter(type, binary, prefix, operand_type);
+		return instruction.func != nullptr;
+	}
+	void Program::Save(ImageWriter& writer) const
+	{
+		// Registers neither computed by instructions nor bound to variables are constants
+		std::vector<unsigned char> kinds(num_registers_, kRegisterConstant);
+		for (auto it = instructions_.begin(); it != instructions_.end(); ++it)
+			kinds[it->value] = kRegisterComputed;
+		for (auto it = variables_.begin(); it != variables_.end(); ++it)
+			kinds[it->reg] = kRegisterVariable;
+
+		writer.WriteUint(static_cast<uint32_t>(num_registers_));
+		writer.WriteInt(result_);
+		for (int i = 0; i < num_registers_; ++i)
+		{
+			const Value& value = registers_[i];
+			writer.WriteByte(static_cast<unsigned char>(value.type()));
+			writer.WriteByte(kinds[i]);
+			if (kinds[i] != kRegisterConstant)
+				continue;
+			switch (value.type())
+			{
+			case Value::kBoolean:	writer.WriteByte(value.get<bool>() ? 1 : 0); break;
+			case Value::kInteger:	writer.WriteInt(value.get<int>()); break;
+			case Value::kFloat:		writer.WriteFloat(value.get<Float>()); break;
+			case Value::kString:	writer.WriteString(value.get<String>()); break;
+			default: break;
+			}
+		}
+		writer.WriteUint(static_cast<uint32_t>(variables_.size()));
+		for (auto it = variables_.begin(); it != variables_.end(); ++it)
+		{
+			writer.WriteInt(it->reg);
+			writer.WriteString(it->name);
+		}
+		writer.WriteUint(static_cast<uint32_t>(instructions_.size()));
+		for (size_t i = 0; i < instructions_.size(); ++i)
+		{
+			const Instruction& instruction = instructions_[i];
+			const Opcode& opcode = opcodes_[i];
+			writer.WriteByte(opcode.kind);
+			writer.WriteByte(opcode.type);
+			writer.WriteByte(opcode.operand_type);
+			writer.WriteByte(opcode.flags);
+			writer.WriteInt(instruction.value);
+			writer.WriteInt(instruction.first);
+			writer.WriteInt(instruction.second);
+			if (opcode.kind == Opcode::kCall)
+			{
+				const CallSite * call = instruction.call;
+				writer.WriteString(call->name);
+				writer.WriteByte(static_cast<unsigned char>(call->num_arguments));
+				for (int j = 0; j < call->num_arguments; ++j)
+					writer.WriteInt(call->arguments[j]);
+			}
+		}
+	}
+	bool Program::Load(ImageReader& reader, const Base& base, String& error)
+	{
+		Clear();
+		auto fail = [&](const String& message) {
+			error = message;
+			Clear();
+			return false;
+		};
+		const String corrupted = CS_TEXT("corrupted program image");
+
+		// Registers
+		uint32_t n_registers;
+		int result;
+		if (!reader.ReadUint(n_registers) || !reader.ReadInt(result))
+			return fail(corrupted);
+		// Every register takes 2 bytes at least, so the image size bounds allocation
+		if (n_registers > reader.remaining() / 2 || result < -1 || result >= static_cast<int>(n_registers))
+			return fail(corrupted);
+		const int count = static_cast<int>(n_registers);
+		registers_.reset(new Value[count]);
+		parents_.assign(count, -1);
+		num_registers_ = count;
+		std::vector<unsigned char> kinds(count);
+		for (int i = 0; i < count; ++i)
+		{
+			unsigned char type;
+			if (!reader.ReadByte(type) || !reader.ReadByte(kinds[i]) ||
+				!IsValueType(type) || kinds[i] > kRegisterVariable)
+				return fail(corrupted);
+			Value& value = registers_[i];
+			value.set_type(static_cast<Value::Type>(type));
+			if (kinds[i] != kRegisterConstant)
+				continue;
+			switch (value.type())
+			{
+			case Value::kBoolean:
+				{
+					unsigned char b = 0;
+					reader.ReadByte(b);
+					value.get<bool>() = (b != 0);
+				}
+				break;
+			case Value::kInteger:	reader.ReadInt(value.get<int>()); break;
+			case Value::kFloat:		reader.ReadFloat(value.get<Float>()); break;
+			case Value::kString:	reader.ReadString(value.get<String>()); break;
+			default:				return fail(corrupted);
+			}
+			if (reader.failed())
+				return fail(corrupted);
+		}
+
+		// Variables are relinked by name
+		uint32_t n_variables;
+		if (!reader.ReadUint(n_variables) || n_variables > reader.remaining() / 8)
+			return fail(corrupted);
+		variables_.reserve(n_variables);
+		for (uint32_t i = 0; i < n_variables; ++i)
+		{
+			VariableSlot slot;
+			if (!reader.ReadInt(slot.reg) || !reader.ReadString(slot.name) ||
+				slot.reg < 0 || slot.reg >= count || kinds[slot.reg] != kRegisterVariable)
+				return fail(corrupted);
+			slot.info = base.GetVariableInfo(slot.name);
+			if (slot.info == nullptr)
+				return fail(CS_TEXT("unknown variable ") + slot.name);
+			Value& value = registers_[slot.reg];
+			if (slot.info->type() != value.type())
+				return fail(CS_TEXT("variable type mismatch"));
+			value.Assign(slot.info->ptr());
+			variables_.push_back(slot);
+		}
+
+		// Instructions, operand types are checked to match the kernels
+		uint32_t n_instructions;
+		if (!reader.ReadUint(n_instructions) || n_instructions > reader.remaining() / 16)
+			return fail(corrupted);
+		instructions_.reserve(n_instructions);
+		opcodes_.reserve(n_instructions);
+		for (uint32_t i = 0; i < n_instructions; ++i)
+		{
+			const int index = static_cast<int>(i);
+			Opcode opcode;
+			Instruction instruction;
+			instruction.column = nullptr;
+			instruction.emit = nullptr;
+			instruction.call = nullptr;
+			reader.ReadByte(opcode.kind);
+			reader.ReadByte(opcode.type);
+			reader.ReadByte(opcode.operand_type);
+			reader.ReadByte(opcode.flags);
+			reader.ReadInt(instruction.value);
+			reader.ReadInt(instruction.first);
+			reader.ReadInt(instruction.second);
+			if (reader.failed() || instruction.value < 0 || instruction.value >= count ||
+				kinds[instruction.value] != kRegisterComputed)
+				return fail(corrupted);
+			const int value = instruction.value;
+			if (opcode.kind == Opcode::kCall)
+			{
+				String name;
+				unsigned char n_arguments;
+				if (!reader.ReadString(name) || !reader.ReadByte(n_arguments) ||
+					n_arguments > kMaxFunctionArguments)
+					return fail(corrupted);
+				const FunctionInfo * info = base.GetFunctionInfo(name);
+				if (info == nullptr)
+					return fail(CS_TEXT("unknown function ") + name);
+				if (info->arguments_type().size() != n_arguments)
+					return fail(CS_TEXT("wrong arity in function '") + name + CS_TEXT("'"));
+				if (info->return_type() != registers_[value].type())
+					return fail(CS_TEXT("function return type mismatch"));
+				CallSite * call = new CallSite();
+				call_sites_.emplace_back(call);
+				call->func = info->func();
+				call->name = name;
+				call->num_arguments = n_arguments;
+				for (int j = 0; j < call->num_arguments; ++j)
+				{
+					int& argument = call->arguments[j];
+					if (!reader.ReadInt(argument) || argument < 0 || argument >= value)
+						return fail(corrupted);
+					if (registers_[argument].type() != info->arguments_type()[j])
+						return fail(CS_TEXT("function argument type mismatch"));
+					parents_[argument] = index;
+				}
+				Link(opcode, instruction);
+				instruction.call = call;
+				if (!info->pure())
+					volatile_.push_back(index);
+			}
+			else if (opcode.kind == Opcode::kOperator)
+			{
+				const bool binary = (opcode.flags & Opcode::kBinary) != 0;
+				const Value::Type operand_type = static_cast<Value::Type>(opcode.operand_type);
+				if (opcode.type > Operator::kCastString ||
+					instruction.first < 0 || instruction.first >= value ||
+					registers_[instruction.first].type() != operand_type)
+					return fail(corrupted);
+				if (binary)
+				{
+					if (instruction.second < 0 || instruction.second >= value ||
+						registers_[instruction.second].type() != operand_type)
+						return fail(corrupted);
+					parents_[instruction.second] = index;
+				}
+				else
+					instruction.second = -1;
+				parents_[instruction.first] = index;
+				if (!Link(opcode, instruction) ||
+					registers_[value].type() != OperatorResultType(static_cast<Operator::Type>(opcode.type), operand_type))
+					return fail(corrupted);
+				if (opcode.flags & Opcode::kWrites)
+					volatile_.push_back(index);
+			}
+			else
+				return fail(corrupted);
+			instructions_.push_back(instruction);
+			opcodes_.push_back(opcode);
+		}
+		result_ = result;
+		Finish();
+		return true;
+	}
+
+} // namespace console_script
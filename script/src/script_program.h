@@ -0,0 +1,144 @@
+#pragma once
+#ifndef __CONSOLE_SCRIPT_PROGRAM_H__
+#define __CONSOLE_SCRIPT_PROGRAM_H__
+
+#include "script_kernels.h"
+#include "script_base.h"
+#include "script_jit.h"
+#include "script_image.h"
+#include "script_profile.h"
+
+#include <vector>
+#include <memory> // for unique_ptr
+
+namespace console_script {
+
+	class Node;
+
+	struct VariableSlot {
+		int reg;					//!< register bound to the variable
+		const VariableInfo * info;	//!< registered variable
+		String name;				//!< name to relink saved program with
+	};
+
+	struct CallSite {
+		const BaseFunc * func;					//!< function resolved at compile stage
+		int arguments[kMaxFunctionArguments];	//!< argument registers
+		int num_arguments;						//!< number of arguments
+		String name;							//!< name to relink saved program with
+	};
+
+	//! Operation of the instruction, kernels are resolved from it at build and load
+	struct Opcode {
+		enum Kind {
+			kOperator,
+			kCall
+		};
+		enum Flags {
+			kBinary		= 0x01,
+			kPrefix		= 0x02,
+			kWrites		= 0x04	//!< writes to the first operand
+		};
+		unsigned char kind;
+		unsigned char type;			//!< Operator::Type
+		unsigned char operand_type;	//!< Value::Type of the first operand
+		unsigned char flags;
+	};
+
+	struct Instruction {
+		InstructionPtr func;	//!< kernel to execute
+		ColumnPtr column;		//!< batch kernel (nullptr if operation can't be batched)
+		EmitterPtr emit;		//!< native code emitter (nullptr if operation can't be compiled)
+		int value;				//!< destination register
+		int first;				//!< first operand register
+		int second;				//!< second operand register
+		CallSite * call;		//!< call site (function calls only)
+	};
+
+	/*
+	Compiled form of a checked tree.
+	Every tree node owns a register, constants are stored once and variables are
+	bound to their registers once, so execution is a flat loop over instructions
+	in post order with no allocations for scalar types.
+	Programs that stay hot are tiered up to native code: after jit_threshold executions
+	the whole program is compiled if every instruction has an emitter (int, Float and
+	boolean operators), otherwise (strings, native calls) it stays interpreted.
+	In reactive execution only instructions on the path from variables marked dirty
+	to the result are recomputed, other registers keep the results of the last execution.
+	Side effects (assignments, increments and impure function calls) and
+	reads of variables written by the program are recomputed every time.
+	*/
+	class Program {
+		friend class Batch;
+
+	public:
+		Program();
+		~Program();
+
+		bool Build(Node * root, String& error);
+		//! Writes program in the binary form, symbols are stored by name
+		void Save(ImageWriter& writer) const;
+		//! Loads saved program, symbols are relinked against the registry
+		bool Load(ImageReader& reader, const Base& base, String& error);
+		void Execute();
+		//! Executes instructions depending on variables marked dirty since the last execution only
+		void ExecuteDirty();
+		void MarkDirty(const VariableInfo * info);
+		void MarkAllDirty();
+		void Clear();
+
+		bool empty() const;
+		size_t size() const { return instructions_.size(); }
+		const Value * result() const;
+
+		//! Number of executions before compilation to native code (0 disables it)
+		void set_jit_threshold(size_t threshold) { jit_threshold_ = threshold; }
+		size_t jit_threshold() const { return jit_threshold_; }
+		bool jitted() const { return jit_.compiled(); }
+
+#ifdef PARSER_PROFILE
+		//! Estimated times of the program and its instructions
+		void GetStats(ProgramStats& stats) const;
+		void ResetProfile() { profile_.Reset(instructions_.size()); }
+		void set_source(const String& source) { profile_.set_source(source); }
+#endif
+
+	private:
+		// Don't allow to copy
+		Program(const Program&);
+		void operator =(const Program&);
+
+		void Finish();
+		void TierUp();
+#ifdef PARSER_PROFILE
+		void ExecuteProfiled(bool dirty_only);
+#endif
+		void MarkInstruction(int index);
+		void FindVolatile();
+		int CountNodes(Node * node);
+		bool Emit(Node * node, int& reg, String& error);
+		static bool Link(const Opcode& opcode, Instruction& instruction);
+
+		std::unique_ptr<Value[]> registers_;
+		std::vector<Instruction> instructions_;
+		std::vector<Opcode> opcodes_;	//!< operation of every instruction
+		std::vector< std::unique_ptr<CallSite> > call_sites_;
+		std::vector<VariableSlot> variables_;
+		int num_registers_;
+		int result_;	//!< result register (-1 if there is no result)
+		std::vector<int> parents_;		//!< instruction reading the register (-1 if there is none)
+		std::vector<int> volatile_;		//!< instructions executed on every reactive execution
+		std::vector<char> dirty_;		//!< instruction should be recomputed on the next reactive execution
+		bool any_dirty_;
+		JitCode jit_;			//!< native code of the program (if compiled)
+		size_t jit_threshold_;
+		size_t executions_;		//!< number of interpreted executions
+		bool jittable_;			//!< every instruction may be compiled
+#ifdef PARSER_PROFILE
+		ProgramProfile profile_;	//!< execution statistics
+#endif
+	};
+
+} // namespace console_script
+
+#endif
@@ -1,22 +1,22 @@
 #include "script_value.h"
 #include "script_lexem.h"
-#include "script_value_data.h"
 #include <assert.h>
+#include <new>
 #include <regex> // requires C++11
 
 namespace console_script {
 
 	Value::Value() :
-		data_(nullptr), type_(kUnknown)
+		data_(&storage_), type_(kUnknown), is_reference_(false)
 	{
 	}
 	Value::Value(const Value& value) :
-		data_(nullptr), type_(kUnknown)
+		data_(&storage_), type_(kUnknown), is_reference_(false)
 	{
 		operator =(value);
 	}
 	Value::Value(Lexem* lexem) :
-		data_(nullptr), type_(kUnknown)
+		data_(&storage_), type_(kUnknown), is_reference_(false)
 	{
 		switch (lexem->type)
 		{
@@ -29,167 +29,302 @@ namespace console_script {
 	}
 	Value::~Value()
 	{
-		if (data_)
-			delete data_;
+		Release();
 	}
-	void Value::Assign(void *data)
-	{
-		data_->Assign(data);
-	}
-	Value& Value::operator = (bool b)
-	{
-		assert(data_);
-		*data_ = b;
-		return *this;
-	}
-	Value& Value::operator = (int i)
-	{
-		assert(data_);
-		*data_ = i;
-		return *this;
-	}
-	Value& Value::operator = (Float d)
+	void Value::Release()
 	{
-		assert(data_);
-		*data_ = d;
-		return *this;
+		if (type_ == kString && !is_reference_)
+			get<String>().~String();
 	}
-	Value& Value::operator = (const String& str)
+	void Value::Assign(void *data)
 	{
-		assert(data_);
-		*data_ = str;
-		return *this;
+		Release();
+		is_reference_ = true;
+		data_ = data;
 	}
 	Value& Value::operator = (const Value& value)
 	{
-		if (!data_ || !data_->is_reference())
+		if (!is_reference_ && type_ != value.type_)
 			set_type(value.type_);
-		*data_ = *value.data_;
+		switch (type_)
+		{
+		case kBoolean:
+			get<bool>() = value.get<bool>();
+			break;
+		case kInteger:
+			get<int>() = value.get<int>();
+			break;
+		case kFloat:
+			get<Float>() = value.get<Float>();
+			break;
+		case kString:
+			get<String>() = value.get<String>();
+			break;
+		default:
+			break;
+		}
 		return *this;
 	}
 	Value& Value::operator += (const Value& value)
 	{
-		*data_ += *value.data_;
+		switch (type_)
+		{
+		case kInteger:
+			get<int>() += value.get<int>();
+			break;
+		case kFloat:
+			get<Float>() += value.get<Float>();
+			break;
+		case kString:
+			get<String>() += value.get<String>();
+			break;
+		default:
+			assert(false);
+			break;
+		}
 		return *this;
 	}
 	Value& Value::operator -= (const Value& value)
 	{
-		*data_ -= *value.data_;
+		switch (type_)
+		{
+		case kInteger:
+			get<int>() -= value.get<int>();
+			break;
+		case kFloat:
+			get<Float>() -= value.get<Float>();
+			break;
+		default:
+			assert(false);
+			break;
+		}
 		return *this;
 	}
 	Value& Value::operator *= (const Value& value)
 	{
-		*data_ *= *value.data_;
+		switch (type_)
+		{
+		case kInteger:
+			get<int>() *= value.get<int>();
+			break;
+		case kFloat:
+			get<Float>() *= value.get<Float>();
+			break;
+		default:
+			assert(false);
+			break;
+		}
 		return *this;
 	}
 	Value& Value::operator /= (const Value& value)
 	{
-		*data_ /= *value.data_;
+		switch (type_)
+		{
+		case kInteger:
+			get<int>() /= value.get<int>();
+			break;
+		case kFloat:
+			get<Float>() /= value.get<Float>();
+			break;
+		default:
+			assert(false);
+			break;
+		}
 		return *this;
 	}
 	Value& Value::operator %= (const Value& value)
 	{
-		*data_ %= *value.data_;
+		assert(type_ == kInteger);
+		get<int>() %= value.get<int>();
 		return *this;
 	}
 	Value& Value::operator |= (const Value& value)
 	{
-		*data_ |= *value.data_;
+		assert(type_ == kInteger);
+		get<int>() |= value.get<int>();
 		return *this;
 	}
 	Value& Value::operator ^= (const Value& value)
 	{
-		*data_ ^= *value.data_;
+		assert(type_ == kInteger);
+		get<int>() ^= value.get<int>();
 		return *this;
 	}
 	Value& Value::operator &= (const Value& value)
 	{
-		*data_ &= *value.data_;
+		assert(type_ == kInteger);
+		get<int>() &= value.get<int>();
 		return *this;
 	}
 	Value& Value::operator <<= (const Value& value)
 	{
-		*data_ <<= *value.data_;
+		assert(type_ == kInteger);
+		get<int>() <<= value.get<int>();
 		return *this;
 	}
 	Value& Value::operator >>= (const Value& value)
 	{
-		*data_ >>= *value.data_;
+		assert(type_ == kInteger);
+		get<int>() >>= value.get<int>();
 		return *this;
 	}
 	Value& Value::operator ++()
 	{
-		++(*data_);
+		assert(type_ == kInteger);
+		++get<int>();
 		return *this;
 	}
 	Value Value::operator ++(int)
 	{
 		Value temp(*this);
-		++(*data_);
+		operator ++();
 		return temp;
 	}
 	Value& Value::operator --()
 	{
-		--(*data_);
+		assert(type_ == kInteger);
+		--get<int>();
 		return *this;
 	}
 	Value Value::operator --(int)
 	{
 		Value temp(*this);
-		--(*data_);
+		operator --();
 		return temp;
 	}
 	Value Value::operator -()
 	{
 		Value temp(*this);
-		-*temp.data_;
+		switch (type_)
+		{
+		case kInteger:
+			temp.get<int>() = -get<int>();
+			break;
+		case kFloat:
+			temp.get<Float>() = -get<Float>();
+			break;
+		default:
+			assert(false);
+			break;
+		}
 		return temp;
 	}
 	void Value::set_type(Type type)
 	{
+		Release();
 		type_ = type;
-		if (data_) delete data_;
+		is_reference_ = false;
+		data_ = &storage_;
 		switch (type_)
 		{
 		case kBoolean:
-			data_ = new BooleanValueData();
+			storage_.boolean = false;
 			break;
 		case kInteger:
-			data_ = new IntegerValueData();
+			storage_.integer = 0;
 			break;
 		case kFloat:
-			data_ = new FloatValueData();
+			storage_.real = static_cast<Float>(0.0);
 			break;
 		case kString:
-			data_ = new StringValueData();
+			new (&storage_.string) String();
 			break;
 		default:
 			break;
 		}
 	}
-	Value::Type Value::type() const
-	{
-		return type_;
-	}
 	bool Value::valid() const
 	{
-		return data_ != nullptr;
+		switch (type_)
+		{
+		case kBoolean:
+		case kInteger:
+		case kFloat:
+		case kString:
+			return true;
+		default:
+			return false;
+		}
 	}
 	bool Value::AsBool() const
 	{
-		return data_->AsBool();
+		switch (type_)
+		{
+		case kBoolean:
+			return get<bool>();
+		case kInteger:
+			return get<int>() != 0;
+		case kFloat:
+			return static_cast<int>(get<Float>()) != 0;
+		case kString:
+			return get<String>() == CS_TEXT("true");
+		default:
+			assert(false);
+			return false;
+		}
 	}
 	int Value::AsInteger() const
 	{
-		return data_->AsInteger();
+		switch (type_)
+		{
+		case kBoolean:
+			return get<bool>() ? 1 : 0;
+		case kInteger:
+			return get<int>();
+		case kFloat:
+			return static_cast<int>(get<Float>());
+		case kString:
+			return std::stoi(get<String>());
+		default:
+			assert(false);
+			return 0;
+		}
 	}
 	Float Value::AsFloat() const
 	{
-		return data_->AsFloat();
+		switch (type_)
+		{
+		case kBoolean:
+			return get<bool>() ? static_cast<Float>(1.0) : static_cast<Float>(0.0);
+		case kInteger:
+			return static_cast<Float>(get<int>());
+		case kFloat:
+			return get<Float>();
+		case kString:
+#ifndef PARSER_HIGHP_FLOAT
+			return std::stof(get<String>());
+#else
+			return std::stod(get<String>());
+#endif
+		default:
+			assert(false);
+			return static_cast<Float>(0.0);
+		}
 	}
 	String Value::AsString() const
 	{
-		return data_->AsString();
+		switch (type_)
+		{
+		case kBoolean:
+			return get<bool>() ? CS_TEXT("true") : CS_TEXT("false");
+		case kInteger:
+#ifndef PARSER_WIDE_STRING
+			return std::to_string(get<int>());
+#else
+			return std::to_wstring(get<int>());
+#endif
+		case kFloat:
+#ifndef PARSER_WIDE_STRING
+			return std::to_string(get<Float>());
+#else
+			return std::to_wstring(get<Float>());
+#endif
+		case kString:
+			return get<String>();
+		default:
+			assert(false);
+			return String();
+		}
 	}
 	void Value::Evaluate(const String& str)
 	{
@@ -203,9 +338,8 @@ namespace console_script {
 	{
 		if (str.size() >= 2 && str.front() == CS_TEXT('\"') && str.back() == CS_TEXT('\"'))
 		{
-			String s = str.substr(1, str.length() - 2);
-			type_ = kString;
-			data_ = new StringValueData(s);
+			set_type(kString);
+			get<String>() = str.substr(1, str.length() - 2);
 			return true;
 		}
 		else
@@ -226,8 +360,8 @@ namespace console_script {
 		if (*p == 0)
 		{
 			// We do not check out of range statement
-			type_ = kInteger;
-			data_ = new IntegerValueData(val);
+			set_type(kInteger);
+			get<int>() = val;
 			return true;
 		}
 		else
@@ -248,8 +382,8 @@ namespace console_script {
 		if (*p == 0)
 		{
 			// We do not check out of range statement
-			type_ = kFloat;
-			data_ = new FloatValueData(d);
+			set_type(kFloat);
+			get<Float>() = d;
 			return true;
 		}
 		else
@@ -260,8 +394,8 @@ namespace console_script {
 		bool b = str == CS_TEXT("true");
 		if (b || str == CS_TEXT("false"))
 		{
-			type_ = kBoolean;
-			data_ = new BooleanValueData(b);
+			set_type(kBoolean);
+			get<bool>() = b;
 			return true;
 		}
 		else
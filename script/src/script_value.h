@@ -5,12 +5,18 @@
 #include "script_defines.h"
 
 #include <string>
+#include <type_traits>
 
 namespace console_script {
 
 	class Lexem;
-	class ValueData;
 
+	/*
+	Tagged value slot.
+	Scalars and strings are stored in place (strings use the small string buffer of String),
+	or the slot refers to the outer data (like variable). Typed data is accessed thru get<T>,
+	which is a plain load after the tree check has fixed the slot type.
+	*/
 	class Value {
 		friend class Node;
 
@@ -32,10 +38,10 @@ namespace console_script {
 
 		void Assign(void *data);
 
-		Value& operator = (bool b);
-		Value& operator = (int i);
-		Value& operator = (Float d);
-		Value& operator = (const String& str);
+		Value& operator = (bool b) { get<bool>() = b; return *this; }
+		Value& operator = (int i) { get<int>() = i; return *this; }
+		Value& operator = (Float d) { get<Float>() = d; return *this; }
+		Value& operator = (const String& str) { get<String>() = str; return *this; }
 
 		// lvalue operators
 		Value& operator = (const Value& value);
@@ -57,9 +63,15 @@ namespace console_script {
 		Value operator -(); // unary
 
 		void set_type(Type type);
-		Type type() const;
+		Type type() const { return type_; }
 		bool valid() const;
 
+		// Data of known type (no conversion)
+		template <typename T>
+		T& get() { return *static_cast<T*>(data_); }
+		template <typename T>
+		const T& get() const { return *static_cast<const T*>(data_); }
+
 		bool AsBool() const;
 		int AsInteger() const;
 		Float AsFloat() const;
@@ -69,6 +81,7 @@ namespace console_script {
 		static bool IsGoodVariableName(const String& str);
 
 	private:
+		void Release();
 		void Evaluate(const String& str); // for constants
 		bool FromString(const String& str);
 		bool FromInteger(const String& str);
@@ -76,8 +89,17 @@ namespace console_script {
 		bool FromBool(const String& str);
 
 	private:
-		ValueData * data_;
+		union Storage {
+			bool boolean;
+			int integer;
+			Float real;
+			std::aligned_storage<sizeof(String), alignof(String)>::type string;
+		};
+
+		void * data_;		//!< points to the own storage or to the outer data
 		Type type_;
+		bool is_reference_;	//!< is it just a reference to the outer value (like variable)
+		Storage storage_;
 	};
 
 	template <typename T>
@@ -132,6 +154,38 @@ namespace console_script {
 		}
 	};
 
+	// Gets native value of known type (type is checked at compile stage)
+	template <typename T>
+	class ValueGetter;
+	template <>
+	class ValueGetter <bool> {
+	public:
+		static bool Get(const Value& v) {
+			return v.get<bool>();
+		}
+	};
+	template <>
+	class ValueGetter <int> {
+	public:
+		static int Get(const Value& v) {
+			return v.get<int>();
+		}
+	};
+	template <>
+	class ValueGetter <Float> {
+	public:
+		static Float Get(const Value& v) {
+			return v.get<Float>();
+		}
+	};
+	template <>
+	class ValueGetter <String> {
+	public:
+		static const String& Get(const Value& v) {
+			return v.get<String>();
+		}
+	};
+
 } // namespace console_script
 
 #endif
\ No newline at end of file
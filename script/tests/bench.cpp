@@ -0,0 +1,247 @@
+/*
+Benchmark of the script engine over a corpus of typical expressions.
+Every expression is measured for compile latency (full pipeline and cache hit) and
+execution latency of the tree walker, the interpreter, native code and idle reactive execution.
+Batch throughput and loading of the precompiled image are measured for the whole corpus.
+Tree walk, interpreter and compilation of an expression with constant subtrees are measured
+with and without constant folding. Compilation of chains of increasing length (up to the
+maximum tree depth) is reported per token to show how it grows with the length.
+
+Usage: bench [milliseconds per measurement]
+*/
+#include "../src/script.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using console_script::Parser;
+using console_script::String;
+using console_script::Float;
+
+static Float clamp(Float x, Float low, Float high) {
+	return (x < low) ? low : ((x > high) ? high : x);
+}
+static Float lerp(Float a, Float b, Float t) {
+	return a + (b - a) * t;
+}
+static int maximum(int a, int b) {
+	return (a > b) ? a : b;
+}
+static int minimum(int a, int b) {
+	return (a < b) ? a : b;
+}
+
+static String ToString(const std::string& str) {
+	return String(str.begin(), str.end());
+}
+
+// Long expressions of the corpus
+static std::string Nested(int depth) {
+	std::string str = "x";
+	for (int i = 0; i < depth; ++i)
+		str = "((" + str + " + 1.5) * 0.5 - y)";
+	return str;
+}
+static std::string Chain(int length) {
+	std::string str = "a";
+	for (int i = 1; i < length; ++i)
+		str += (i % 2) ? " + b" : " - c";
+	return str;
+}
+
+struct Expression {
+	const char * category;
+	std::string text;
+};
+
+static std::vector<Expression> MakeCorpus() {
+	std::vector<Expression> corpus;
+	Expression expressions[] = {
+		{ "arithmetic", "x * 2.0 + y" },
+		{ "arithmetic", "(a + b) * c - a / (b + 1)" },
+		{ "arithmetic", "x * x + y * y < 100.0" },
+		{ "arithmetic", "(a << 2 | b & 15) ^ c" },
+		{ "arithmetic", "health = health - damage * (1.0 - armor)" },
+		{ "string", "name + \" \" + title" },
+		{ "string", "(string)a + \":\" + (string)b" },
+		{ "string", "title = name + \"!\"" },
+		{ "call", "clamp(x, 0.0, 1.0) * 2.0" },
+		{ "call", "maximum(a, b) + minimum(a, c)" },
+		{ "call", "lerp(x, y, 0.25) + lerp(y, x, 0.75)" },
+		{ "nested", Nested(16) },
+		{ "nested", Chain(64) },
+	};
+	for (size_t i = 0; i < sizeof(expressions) / sizeof(expressions[0]); ++i)
+		corpus.push_back(expressions[i]);
+	return corpus;
+}
+
+class Bench {
+public:
+	explicit Bench(double milliseconds) : duration_(milliseconds * 1e6) {
+		a = 7; b = 3; c = 2;
+		x = Float(0.25); y = Float(4);
+		health = Float(100); damage = Float(0.1); armor = Float(0.5);
+		name = CS_TEXT("Sir"); title = CS_TEXT("Knight");
+		parser.AddVariable(CS_TEXT("a"), &a);
+		parser.AddVariable(CS_TEXT("b"), &b);
+		parser.AddVariable(CS_TEXT("c"), &c);
+		parser.AddVariable(CS_TEXT("x"), &x);
+		parser.AddVariable(CS_TEXT("y"), &y);
+		parser.AddVariable(CS_TEXT("health"), &health);
+		parser.AddVariable(CS_TEXT("damage"), &damage);
+		parser.AddVariable(CS_TEXT("armor"), &armor);
+		parser.AddVariable(CS_TEXT("name"), &name);
+		parser.AddVariable(CS_TEXT("title"), &title);
+		parser.AddFunction(CS_TEXT("clamp"), &clamp, true);
+		parser.AddFunction(CS_TEXT("lerp"), &lerp, true);
+		parser.AddFunction(CS_TEXT("maximum"), &maximum, true);
+		parser.AddFunction(CS_TEXT("minimum"), &minimum, true);
+	}
+
+	//! Runs function in batches until duration is reached, returns nanoseconds per call
+	template <typename F>
+	double Measure(F function) {
+		typedef std::chrono::steady_clock Clock;
+		function(); // warm up
+		size_t calls = 0;
+		size_t batch = 1;
+		const Clock::time_point start = Clock::now();
+		double elapsed = 0.0;
+		while (elapsed < duration_)
+		{
+			for (size_t i = 0; i < batch; ++i)
+				function();
+			calls += batch;
+			batch *= 2;
+			elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+		}
+		return elapsed / static_cast<double>(calls);
+	}
+
+	Parser parser;
+	int a, b, c;
+	Float x, y, health, damage, armor;
+	String name, title;
+
+private:
+	double duration_;	//!< nanoseconds per measurement
+};
+
+int main(int argc, char* argv[])
+{
+	const double milliseconds = (argc > 1) ? atof(argv[1]) : 100.0;
+	const std::vector<Expression> corpus = MakeCorpus();
+	Bench bench(milliseconds);
+	Parser& parser = bench.parser;
+
+	printf("%-10s %12s %12s %12s %12s %12s %12s  %s\n", "category", "compile us", "cached us",
+		"tree ns", "interp ns", "native ns", "reactive ns", "expression");
+	for (size_t i = 0; i < corpus.size(); ++i)
+	{
+		const String str = ToString(corpus[i].text);
+		parser.SetCacheCapacity(0);
+		parser.SetJitThreshold(0);
+		parser.SetReactive(false);
+		if (!parser.Compile(str))
+		{
+			printf("failed to compile %s\n", corpus[i].text.c_str());
+			return EXIT_FAILURE;
+		}
+		const double compile = bench.Measure([&]() { parser.Compile(str); });
+		const double tree = bench.Measure([&]() { parser.ExecuteTree(); }); // tree isn't kept by the cache
+		const double interpreted = bench.Measure([&]() { parser.Execute(); });
+
+		parser.SetCacheCapacity(corpus.size());
+		const double cached = bench.Measure([&]() { parser.Compile(str); });
+
+		parser.SetJitThreshold(1);
+		parser.Compile(str);
+		parser.Execute();
+		const bool jitted = parser.program().jitted();
+		const double native = bench.Measure([&]() { parser.Execute(); });
+		parser.SetJitThreshold(0);
+
+		parser.SetReactive(true);
+		const double reactive = bench.Measure([&]() { parser.Execute(); });
+		parser.SetReactive(false);
+
+		std::string text = corpus[i].text;
+		if (text.size() > 40)
+			text = text.substr(0, 37) + "...";
+		char native_text[32];
+		if (jitted)
+			snprintf(native_text, sizeof(native_text), "%12.1f", native);
+		else
+			snprintf(native_text, sizeof(native_text), "%12s", "-");
+		printf("%-10s %12.2f %12.2f %12.1f %12.1f %s %12.1f  %s\n", corpus[i].category,
+			compile * 1e-3, cached * 1e-3, tree, interpreted, native_text, reactive, text.c_str());
+	}
+
+	// Tree walk and program of the expression with constant subtrees, with and without folding
+	const String constants = ToString("x * (2.0 * 3.0 + 1.0) - lerp(1.0, 3.0, 0.25) * y + (float)(a * (4 * 8 - 2) + (16 >> 2))");
+	parser.SetCacheCapacity(0);
+	for (int folding = 1; folding >= 0; --folding)
+	{
+		parser.SetFolding(folding != 0);
+		parser.Compile(constants);
+		const double compile = bench.Measure([&]() { parser.Compile(constants); });
+		const double tree = bench.Measure([&]() { parser.ExecuteTree(); });
+		const double program = bench.Measure([&]() { parser.Execute(); });
+		printf("folding %-3s: compile %.2f us, tree %.1f ns, interp %.1f ns\n", folding ? "on" : "off",
+			compile * 1e-3, tree, program);
+	}
+	parser.SetFolding(true);
+
+	// Compile time per token (operands and operators) of chains of increasing length
+	parser.SetCacheCapacity(0);
+	for (int length = 16; length <= static_cast<int>(console_script::kMaxTreeDepth); length *= 4)
+	{
+		const String chain = ToString(Chain(length));
+		const double compile = bench.Measure([&]() { parser.Compile(chain); });
+		const int tokens = 2 * length - 1;
+		printf("chain %4d: compile %.2f us, %.1f ns per token\n", length, compile * 1e-3,
+			compile / static_cast<double>(tokens));
+	}
+
+	// Batch throughput of the arithmetic expression over entities
+	const size_t kEntities = 4096;
+	std::vector<Float> xs(kEntities), ys(kEntities), output(kEntities);
+	for (size_t i = 0; i < kEntities; ++i)
+	{
+		xs[i] = Float(i) * Float(0.01);
+		ys[i] = Float(1) - Float(i) * Float(0.002);
+	}
+	parser.SetCacheCapacity(0);
+	parser.BindArray(CS_TEXT("x"), xs.data());
+	parser.BindArray(CS_TEXT("y"), ys.data());
+	parser.Compile(ToString(Nested(4)));
+	const double batch = bench.Measure([&]() { parser.ExecuteBatch(kEntities, output.data()); });
+	parser.BindArray(CS_TEXT("x"), static_cast<const Float*>(nullptr));
+	parser.BindArray(CS_TEXT("y"), static_cast<const Float*>(nullptr));
+	printf("batch: %.2f ns per entity (%zu entities)\n", batch / static_cast<double>(kEntities), kEntities);
+
+	// Image of the whole corpus against compilation of it
+	parser.SetCacheCapacity(corpus.size());
+	parser.ClearCache();
+	for (size_t i = 0; i < corpus.size(); ++i)
+		parser.Compile(ToString(corpus[i].text));
+	std::vector<unsigned char> image;
+	parser.SaveCache(image);
+	const double load = bench.Measure([&]() {
+		parser.ClearCache();
+		parser.LoadCache(image.data(), image.size());
+	});
+	const double compile_all = bench.Measure([&]() {
+		parser.ClearCache();
+		for (size_t i = 0; i < corpus.size(); ++i)
+			parser.Compile(ToString(corpus[i].text));
+	});
+	printf("image: %zu bytes, load %.2f us, compile %.2f us (%zu expressions)\n",
+		image.size(), load * 1e-3, compile_all * 1e-3, corpus.size());
+
+	return EXIT_SUCCESS;
+}
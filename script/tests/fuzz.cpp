@@ -0,0 +1,442 @@
+/*
+Differential fuzzer of the script engine.
+Random expressions are run by every execution path (interpreter, native code, reactive
+execution, programs loaded from the image, batch execution and the tree walker of the folded tree)
+and checked against the reference tree walker of the unfolded tree: results and variables should be
+bitwise equal after every execution (except NaN, whose sign and payload depend on the order of operands).
+Malformed expressions (unbalanced brackets, dangling operators, unknown symbols and truncated text)
+should fail to compile on every path with an error message.
+
+Usage: fuzz [iterations] [seed]
+*/
+#include "../src/script.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using console_script::Parser;
+using console_script::String;
+using console_script::Float;
+
+static int mix(int a, int b) {
+	return a * 31 + b;
+}
+static Float scale(Float a, Float b) {
+	return a * b + Float(0.5);
+}
+
+// Any NaN matches any other one
+static bool SameFloat(Float a, Float b) {
+	if (std::isnan(a) || std::isnan(b))
+		return std::isnan(a) && std::isnan(b);
+	return memcmp(&a, &b, sizeof(Float)) == 0;
+}
+
+static String ToString(const std::string& str) {
+	return String(str.begin(), str.end());
+}
+
+// Expressions are built of ASCII only, so they may be converted to any string type
+class Generator {
+public:
+	explicit Generator(unsigned int seed) : rng_(seed), pure_(false) {}
+
+	int Random(int n) { return static_cast<int>(rng_() % static_cast<unsigned int>(n)); }
+
+	//! Expression with side effects storing its result to the variable of its type
+	std::string Statement() {
+		pure_ = false;
+		const int depth = 1 + Random(5);
+		switch (Random(12))
+		{
+		case 0: return "a = " + Int(depth);
+		case 1: { const char* ops[] = { "+=", "-=", "*=", "&=", "|=", "^=" }; return std::string("b ") + ops[Random(6)] + " " + Int(depth); }
+		case 2: return "c <<= (" + Int(depth) + " & 7)";
+		case 3: { const char* ops[] = { "=", "+=", "-=", "*=", "/=" }; return std::string("x ") + ops[Random(5)] + " " + Real(depth); }
+		case 4: return "p = " + Bool(depth);
+		case 5: return "s = " + Str(depth);
+		case 6: return "rs = " + Str(depth);
+		case 7: case 8: return "rf = " + Real(depth);
+		case 9: return "rb = " + Bool(depth);
+		default: return "ri = " + Int(depth);
+		}
+	}
+	//! Statement broken so that it can't be compiled
+	std::string Malformed() {
+		const std::string text = Statement();
+		switch (Random(5))
+		{
+		case 0: return Random(2) ? "(" + text : text + ")";
+		case 1: { const char* ops[] = { "*", "/", "&&", "<<", "=" }; return text + " " + ops[Random(5)]; }
+		case 2: return "(" + text + ") + zz";
+		case 3: return "zz(" + text + ")";
+		default:
+			{
+				// Cut right after an opening bracket, so it's never closed
+				const size_t cut = text.find('(', static_cast<size_t>(Random(static_cast<int>(text.size()))));
+				if (cut == std::string::npos)
+					return text + " (";
+				return text.substr(0, cut + 1);
+			}
+		}
+	}
+	//! Integer or float expression without side effects (for batch execution)
+	std::string Pure(bool integer) {
+		pure_ = true;
+		const int depth = 1 + Random(5);
+		return integer ? Int(depth) : Real(depth);
+	}
+
+private:
+	std::string Variable(const char* names) {
+		return std::string(1, names[Random(static_cast<int>(strlen(names)))]);
+	}
+	std::string Int(int d) {
+		if (d <= 0 || Random(5) == 0)
+			return Random(4) == 0 ? std::to_string(Random(200) - 100) : Variable("abc");
+		switch (Random(18))
+		{
+		case 0: return "(" + Int(d - 1) + " + " + Int(d - 1) + ")";
+		case 1: return "(" + Int(d - 1) + " - " + Int(d - 1) + ")";
+		case 2: return "(" + Int(d - 1) + " * " + Int(d - 1) + ")";
+		case 3: return "(" + Int(d - 1) + " / ((" + Int(d - 1) + " & 15) + 1))";
+		case 4: return "(" + Int(d - 1) + " % ((" + Int(d - 1) + " & 15) + 1))";
+		case 5: return "(" + Int(d - 1) + " & " + Int(d - 1) + ")";
+		case 6: return "(" + Int(d - 1) + " | " + Int(d - 1) + ")";
+		case 7: return "(" + Int(d - 1) + " ^ " + Int(d - 1) + ")";
+		case 8: return "(" + Int(d - 1) + " << (" + Int(d - 1) + " & 7))";
+		case 9: return "(" + Int(d - 1) + " >> (" + Int(d - 1) + " & 7))";
+		case 10: return "(-" + Int(d - 1) + ")";
+		case 11: return "(~" + Int(d - 1) + ")";
+		case 12: return "((int)" + Real(d - 1) + ")";
+		case 13: return "((int)" + Bool(d - 1) + ")";
+		case 14: return "mix(" + Int(d - 1) + ", " + Int(d - 1) + ")";
+		case 15:
+			if (!pure_)
+			{
+				const char* ops[] = { "++", "--" };
+				return Random(2) ? "(" + std::string(ops[Random(2)]) + Variable("abc") + ")"
+					: "(" + Variable("abc") + ops[Random(2)] + ")";
+			}
+			return "(+" + Int(d - 1) + ")";
+		case 16:
+			if (!pure_)
+				return "tick(" + Int(d - 1) + ")";
+			return "(+" + Int(d - 1) + ")";
+		default: return "(+" + Int(d - 1) + ")";
+		}
+	}
+	std::string Real(int d) {
+		if (d <= 0 || Random(5) == 0)
+		{
+			if (Random(4) == 0)
+				return std::to_string(Random(20)) + "." + std::to_string(Random(10));
+			return Variable("xy");
+		}
+		switch (Random(9))
+		{
+		case 0: return "(" + Real(d - 1) + " + " + Real(d - 1) + ")";
+		case 1: return "(" + Real(d - 1) + " - " + Real(d - 1) + ")";
+		case 2: return "(" + Real(d - 1) + " * " + Real(d - 1) + ")";
+		case 3: return "(" + Real(d - 1) + " / " + Real(d - 1) + ")";
+		case 4: return "(-" + Real(d - 1) + ")";
+		case 5: return "((float)" + Int(d - 1) + ")";
+		case 6: return "((float)" + Bool(d - 1) + ")";
+		case 7: return "scale(" + Real(d - 1) + ", " + Real(d - 1) + ")";
+		default: return "(+" + Real(d - 1) + ")";
+		}
+	}
+	std::string Bool(int d) {
+		if (d <= 0 || Random(5) == 0)
+			return Variable("pq");
+		const char* comparisons[] = { "==", "!=", "<", "<=", ">", ">=" };
+		switch (Random(8))
+		{
+		case 0: return "(" + Int(d - 1) + " " + comparisons[Random(6)] + " " + Int(d - 1) + ")";
+		case 1: return "(" + Real(d - 1) + " " + comparisons[Random(6)] + " " + Real(d - 1) + ")";
+		case 2: return "(" + Bool(d - 1) + " " + comparisons[Random(6)] + " " + Bool(d - 1) + ")";
+		case 3: return "(" + Bool(d - 1) + " && " + Bool(d - 1) + ")";
+		case 4: return "(" + Bool(d - 1) + " || " + Bool(d - 1) + ")";
+		case 5: return "(!" + Bool(d - 1) + ")";
+		case 6: return "((bool)" + Int(d - 1) + ")";
+		default: return "((bool)" + Real(d - 1) + ")";
+		}
+	}
+	std::string Str(int d) {
+		if (d <= 0 || Random(4) == 0)
+			return Random(2) ? "s" : "\"ab\"";
+		switch (Random(4))
+		{
+		case 0: return "(" + Str(d - 1) + " + " + Str(d - 1) + ")";
+		case 1: return "((string)" + Int(d - 1) + ")";
+		case 2: return "((string)" + Bool(d - 1) + ")";
+		default: return "(" + Str(d - 1) + " + \"c\")";
+		}
+	}
+
+	std::mt19937 rng_;
+	bool pure_;	//!< no side effects (assignments, increments and impure calls)
+};
+
+// Variables and functions of one execution path
+class Context {
+public:
+	Context() {
+		parser.AddVariable(CS_TEXT("a"), &a);
+		parser.AddVariable(CS_TEXT("b"), &b);
+		parser.AddVariable(CS_TEXT("c"), &c);
+		parser.AddVariable(CS_TEXT("x"), &x);
+		parser.AddVariable(CS_TEXT("y"), &y);
+		parser.AddVariable(CS_TEXT("p"), &p);
+		parser.AddVariable(CS_TEXT("q"), &q);
+		parser.AddVariable(CS_TEXT("s"), &s);
+		parser.AddVariable(CS_TEXT("ri"), &ri);
+		parser.AddVariable(CS_TEXT("rf"), &rf);
+		parser.AddVariable(CS_TEXT("rb"), &rb);
+		parser.AddVariable(CS_TEXT("rs"), &rs);
+		parser.AddFunction(CS_TEXT("mix"), &mix, true);
+		parser.AddFunction(CS_TEXT("scale"), &scale, true);
+		parser.AddClassFunction(CS_TEXT("tick"), &Context::Tick, this);
+	}
+	int Tick(int value) {
+		++ticks;
+		return value + ticks;
+	}
+	void Reset(int seed) {
+		a = seed % 97 - 40;
+		b = seed % 13 - 6;
+		c = seed % 7 + 1;
+		x = Float(seed % 31) * Float(0.37) - Float(3);
+		y = Float(seed % 11) * Float(-1.3) + Float(0.5);
+		p = (seed & 1) != 0;
+		q = (seed & 2) != 0;
+		s = CS_TEXT("s");
+		ri = 0;
+		rf = 0;
+		rb = false;
+		rs.clear();
+		ticks = 0;
+	}
+	//! Changes one variable, returns its name
+	const CS_CHAR * Change(int seed) {
+		switch (seed % 4)
+		{
+		case 0: a += seed; return CS_TEXT("a");
+		case 1: x = x * Float(0.5) + Float(seed); return CS_TEXT("x");
+		case 2: q = !q; return CS_TEXT("q");
+		default: s += CS_TEXT("t"); return CS_TEXT("s");
+		}
+	}
+	bool Equals(const Context& other) const {
+		return a == other.a && b == other.b && c == other.c &&
+			SameFloat(x, other.x) && SameFloat(y, other.y) &&
+			p == other.p && q == other.q && s == other.s &&
+			ri == other.ri && SameFloat(rf, other.rf) && rb == other.rb && rs == other.rs &&
+			ticks == other.ticks;
+	}
+
+	Parser parser;
+	int a, b, c;
+	Float x, y;
+	bool p, q;
+	String s;
+	int ri;
+	Float rf;
+	bool rb;
+	String rs;
+	int ticks;
+};
+
+enum Path {
+	kInterpreter,
+	kNative,
+	kReactive,
+	kImage,
+	kNumPaths
+};
+static const char * const kPathNames[kNumPaths] = { "interpreter", "native", "reactive", "image" };
+
+static const int kRepeats = 4;			// executions of every expression
+static const size_t kBatchSize = 37;	// not a multiple of the block size
+
+int main(int argc, char* argv[])
+{
+	const int iterations = (argc > 1) ? atoi(argv[1]) : 20000;
+	const unsigned int seed = (argc > 2) ? static_cast<unsigned int>(atoi(argv[2])) : 12345u;
+	Generator generator(seed);
+
+	Context reference;	// tree walker of the unfolded tree, doesn't use the cache
+	reference.parser.SetFolding(false);
+	Context folded;		// tree walker of the folded tree
+	Context paths[kNumPaths];
+	paths[kInterpreter].parser.SetCacheCapacity(1); // its cache is saved to the image
+	paths[kNative].parser.SetJitThreshold(1);
+	paths[kReactive].parser.SetReactive(true);
+	paths[kImage].parser.SetCacheCapacity(1);
+
+	// Batch execution binds arrays to a and x, other variables are broadcasted
+	Context batch;
+	int array_a[kBatchSize];
+	Float array_x[kBatchSize];
+	for (size_t i = 0; i < kBatchSize; ++i)
+	{
+		array_a[i] = static_cast<int>(i * 7) - 100;
+		array_x[i] = Float(i) * Float(0.75) - Float(9);
+	}
+	batch.parser.BindArray(CS_TEXT("a"), array_a);
+	batch.parser.BindArray(CS_TEXT("x"), array_x);
+
+	int compiled = 0, jitted = 0, batched = 0, rejected = 0, failures = 0;
+
+	// Too deep expressions are rejected instead of overflowing the stack in the recursive passes
+	const size_t kDeep = 100000;
+	std::string chain = "a", prefixed;
+	for (size_t k = 0; k < kDeep; ++k)
+	{
+		chain += " + b";
+		prefixed += "- ";
+	}
+	const std::string deep[] = { chain, std::string(kDeep, '(') + "a" + std::string(kDeep, ')'), prefixed + "a" };
+	for (size_t k = 0; k < sizeof(deep) / sizeof(deep[0]); ++k)
+		if (reference.parser.Compile(ToString(deep[k])) || reference.parser.error().empty())
+		{
+			printf("too deep expression accepted (%d)\n", static_cast<int>(k));
+			++failures;
+		}
+
+	std::vector<unsigned char> image;
+	for (int i = 0; i < iterations && failures < 10; ++i)
+	{
+		// Malformed expression is rejected by every path (twice, so cache doesn't keep it)
+		const std::string broken = generator.Malformed();
+		bool accepted = false;
+		for (int n = 0; n <= kNumPaths && !accepted; ++n)
+		{
+			Parser& parser = (n < kNumPaths) ? paths[n].parser : reference.parser;
+			for (int rep = 0; rep < 2 && !accepted; ++rep)
+				accepted = parser.Compile(ToString(broken)) || parser.error().empty();
+			if (accepted)
+			{
+				printf("malformed expression accepted (%s): %s\n", (n < kNumPaths) ? kPathNames[n] : "reference", broken.c_str());
+				++failures;
+			}
+		}
+		if (!accepted)
+			++rejected;
+
+		const std::string text = generator.Statement();
+		const String str = ToString(text);
+		bool ok = reference.parser.Compile(str);
+		if (folded.parser.Compile(str) != ok)
+		{
+			printf("compile mismatch (folded): %s\n", text.c_str());
+			++failures;
+		}
+		for (int n = 0; n < kImage; ++n)
+			if (paths[n].parser.Compile(str) != ok)
+			{
+				printf("compile mismatch (%s): %s\n", kPathNames[n], text.c_str());
+				++failures;
+			}
+		if (!ok)
+			continue;
+		++compiled;
+		// Program of the interpreter is relinked from the image
+		image.clear();
+		paths[kInterpreter].parser.SaveCache(image);
+		paths[kImage].parser.ClearCache();
+		if (!paths[kImage].parser.LoadCache(image.data(), image.size()) ||
+			!paths[kImage].parser.Compile(str) || paths[kImage].parser.cache().hits() == 0)
+		{
+			printf("image load failed: %s\n", text.c_str());
+			++failures;
+			continue;
+		}
+		for (int rep = 0; rep < kRepeats; ++rep)
+		{
+			if (rep == 0)
+			{
+				reference.Reset(i);
+				folded.Reset(i);
+				for (int n = 0; n < kNumPaths; ++n)
+					paths[n].Reset(i);
+			}
+			else
+			{
+				const CS_CHAR * name = reference.Change(i + rep);
+				folded.Change(i + rep);
+				for (int n = 0; n < kNumPaths; ++n)
+					paths[n].Change(i + rep);
+				paths[kReactive].parser.MarkDirty(name);
+				// Program of the interpreter stays valid when the cache drops it
+				if (rep == 1)
+					paths[kInterpreter].parser.ClearCache();
+				// Loading the image replaces the cached program in use by the image path
+				if (rep == 2 && !paths[kImage].parser.LoadCache(image.data(), image.size()))
+				{
+					printf("image reload failed: %s\n", text.c_str());
+					++failures;
+				}
+			}
+			reference.parser.ExecuteTree();
+			folded.parser.ExecuteTree();
+			if (!folded.Equals(reference))
+			{
+				printf("mismatch (folded, execution %d): %s\n", rep, text.c_str());
+				++failures;
+				break;
+			}
+			for (int n = 0; n < kNumPaths; ++n)
+			{
+				paths[n].parser.Execute();
+				if (!paths[n].Equals(reference))
+				{
+					printf("mismatch (%s, execution %d): %s\n", kPathNames[n], rep, text.c_str());
+					++failures;
+					rep = kRepeats;
+					break;
+				}
+			}
+		}
+		if (paths[kNative].parser.program().jitted())
+			++jitted;
+
+		// Pure expression per entity of the batch against the tree walker
+		const bool integer = generator.Random(2) == 0;
+		const std::string pure = generator.Pure(integer);
+		if (!batch.parser.Compile(ToString(pure)) ||
+			!reference.parser.Compile(ToString((integer ? "ri = " : "rf = ") + pure)))
+			continue;
+		batch.Reset(i);
+		reference.Reset(i);
+		int output_int[kBatchSize];
+		Float output_float[kBatchSize];
+		const bool executed = integer ? batch.parser.ExecuteBatch(kBatchSize, output_int)
+			: batch.parser.ExecuteBatch(kBatchSize, output_float);
+		if (!executed)
+			continue;
+		++batched;
+		for (size_t k = 0; k < kBatchSize; ++k)
+		{
+			reference.a = array_a[k];
+			reference.x = array_x[k];
+			reference.parser.ExecuteTree();
+			const bool same = integer ? (output_int[k] == reference.ri)
+				: SameFloat(output_float[k], reference.rf);
+			if (!same)
+			{
+				printf("mismatch (batch, entity %d): %s\n", static_cast<int>(k), pure.c_str());
+				++failures;
+				break;
+			}
+		}
+	}
+	printf("expressions: %d, compiled: %d, native: %d, batched: %d, rejected: %d, failures: %d\n",
+		iterations, compiled, jitted, batched, rejected, failures);
+	return (failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -1,2 +1,4 @@
 #!/bin/sh
-clang++ main.cpp -g -std=c++14 -lscript -o app
\ No newline at end of file
+clang++ main.cpp -g -std=c++14 -lscript -o app
+clang++ bench.cpp -O2 -std=c++14 -lscript -o bench
+clang++ fuzz.cpp -O2 -std=c++14 -lscript -o fuzz